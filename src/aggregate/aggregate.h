@@ -216,6 +216,12 @@ void Grouper_Free(Grouper *g);
  */
 ResultProcessor *Grouper_GetRP(Grouper *gr);
 
+/**
+ * Replies with the description of the grouper for FT.PROFILE: the memory held by its reducers,
+ * and whether any of them estimated their results to stay within their memory budget
+ */
+void Grouper_Reply(RedisModuleCtx *ctx, const ResultProcessor *rp);
+
 /**
  * Adds a reducer to the grouper. This must be called before any results are
  * processed by the grouper.
@@ -7,6 +7,7 @@
 #include "score_explain.h"
 #include "commands.h"
 #include "profile.h"
+#include "rwlock.h"
 
 typedef enum { COMMAND_AGGREGATE, COMMAND_SEARCH, COMMAND_EXPLAIN } CommandType;
 static void runCursor(RedisModuleCtx *outputCtx, Cursor *cursor, size_t num);
@@ -21,7 +22,7 @@ static const RSValue *getSortKey(AREQ *req, const SearchResult *r, const PLN_Arr
   }
   const RLookupKey *kk = astp->sortkeysLK[0];
   if ((kk->flags & RLOOKUP_F_SVSRC) && (r->rowdata.sv && r->rowdata.sv->len > kk->svidx)) {
-    return r->rowdata.sv->values[kk->svidx];
+    return RSSortingColumns_Get(r->rowdata.sv, r->rowdata.svDocId, kk->svidx);
   } else {
     return RLookup_GetItem(astp->sortkeysLK[0], &r->rowdata);
   }
@@ -296,13 +297,8 @@ static void parseProfile(AREQ *r, int withProfile) {
   }
 }
 
-static int execCommandCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                             CommandType type, int withProfile) {
-  // Index name is argv[1]
-  if (argc < 2) {
-    return RedisModule_WrongArity(ctx);
-  }
-
+static int execCommandSync(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                           CommandType type, int withProfile) {
   const char *indexname = RedisModule_StringPtrLen(argv[1], NULL);
   AREQ *r = AREQ_New();
   QueryError status = {0};
@@ -332,6 +328,81 @@ error:
   return QueryError_ReplyAndClear(ctx, &status);
 }
 
+/**
+ * Run a query on the search thread pool in concurrent read mode. The request is built under the
+ * GIL, after which the query only holds the index lock for reading, and takes the GIL back just
+ * for loading documents from the keyspace. Cursors and legacy indexes, whose data lives in the
+ * keyspace, keep the GIL until the first chunk is sent.
+ */
+static void execCommandConcurrent(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                  CommandType type) {
+  AREQ *r = AREQ_New();
+  QueryError status = {0};
+
+  RedisModule_ThreadSafeContextLock(ctx);
+  RWLOCK_ACQUIRE_READ();
+
+  if (buildRequest(ctx, argv, argc, type, &status, &r) != REDISMODULE_OK) {
+    goto error;
+  }
+
+  if (r->reqflags & QEXEC_F_IS_CURSOR) {
+    if (AREQ_StartCursor(r, ctx, r->sctx->spec->name, &status) != REDISMODULE_OK) {
+      goto error;
+    }
+  } else if (r->sctx->spec->keysDict) {
+    ConcurrentSearchCtx_SetReadMode(&r->conc);
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    AREQ_Execute(r, ctx);
+    RWLOCK_RELEASE();
+    return;
+  } else {
+    AREQ_Execute(r, ctx);
+  }
+  RWLOCK_RELEASE();
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  return;
+
+error:
+  if (r) {
+    AREQ_Free(r);
+  }
+  RWLOCK_RELEASE();
+  QueryError_ReplyAndClear(ctx, &status);
+  RedisModule_ThreadSafeContextUnlock(ctx);
+}
+
+static void searchCommandConcurrent(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                    struct ConcurrentCmdCtx *cmdCtx) {
+  execCommandConcurrent(ctx, argv, argc, COMMAND_SEARCH);
+}
+
+static void aggregateCommandConcurrent(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                       struct ConcurrentCmdCtx *cmdCtx) {
+  execCommandConcurrent(ctx, argv, argc, COMMAND_AGGREGATE);
+}
+
+static int execCommandCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                             CommandType type, int withProfile) {
+  // Index name is argv[1]
+  if (argc < 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+
+  // Profiling measures the process' cpu time, so it is only meaningful when running alone
+  if (withProfile == NO_PROFILE && CheckConcurrentReadSupport(ctx)) {
+    return ConcurrentSearch_HandleRedisCommandEx(
+        CONCURRENT_POOL_SEARCH, CMDCTX_NO_GIL,
+        type == COMMAND_SEARCH ? searchCommandConcurrent : aggregateCommandConcurrent, ctx, argv,
+        argc);
+  }
+
+  ConcurrentSearch_IndexWriteLock();
+  int rc = execCommandSync(ctx, argv, argc, type, withProfile);
+  ConcurrentSearch_IndexWriteUnlock();
+  return rc;
+}
+
 int RSAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return execCommandCommon(ctx, argv, argc, COMMAND_AGGREGATE, NO_PROFILE);
 }
@@ -9,6 +9,7 @@
 #include "ext/default.h"
 #include "extension.h"
 #include "profile.h"
+#include "numeric_index.h"
 
 /**
  * Ensures that the user has not requested one of the 'extended' features. Extended
@@ -757,7 +758,9 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
     }
   }
 
-  ConcurrentSearchCtx_Init(sctx->redisCtx, &req->conc);
+  QAST_Plan(ast, sctx, opts);
+
+  ConcurrentSearchCtx_Init(sctx->redisCtx, &req->conc, sctx->spec);
   req->rootiter = QAST_Iterate(ast, opts, sctx, &req->conc);
   RS_LOG_ASSERT(req->rootiter, "QAST_Iterate failed");
   if (IsProfile(req)) {
@@ -862,6 +865,12 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
 
 #define DEFAULT_LIMIT 10
 
+/* The number of results the sorter of an arrange step keeps */
+static size_t arrangeLimit(const PLN_ArrangeStep *astp) {
+  size_t limit = astp->offset + astp->limit;
+  return limit ? limit : DEFAULT_LIMIT;
+}
+
 static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep *stp,
                                      QueryError *status, ResultProcessor *up) {
   ResultProcessor *rp = NULL;
@@ -872,10 +881,7 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
     astp = &astp_s;
   }
 
-  size_t limit = astp->offset + astp->limit;
-  if (!limit) {
-    limit = DEFAULT_LIMIT;
-  }
+  size_t limit = arrangeLimit(astp);
 
   if (astp->sortKeys) {
     size_t nkeys = array_len(astp->sortKeys);
@@ -927,6 +933,13 @@ static ResultProcessor *getScorerRP(AREQ *req) {
   scargs.qdata = req->ast.udata;
   scargs.qdatalen = req->ast.udatalen;
   ResultProcessor *rp = RPScorer_New(fns, &scargs);
+
+  // results are sorted by score, so the sorter's threshold can be used to skip hopeless documents
+  if (RSGlobalConfig.blockMaxPruning && fns->bf && !(req->reqflags & QEXEC_F_NOROWS)) {
+    UnionIterator_EnableBlockMaxPruning(req->rootiter, &req->qiter.minScore,
+                                        req->sctx->spec->docs.maxScore, fns->bf,
+                                        &scargs.indexStats);
+  }
   return rp;
 }
 
@@ -945,6 +958,36 @@ static int hasQuerySortby(const AGGPlan *pln) {
   return 0;
 }
 
+/**
+ * If the search is sorted by a single SORTABLE numeric field, read the results in the order of the
+ * field's numeric index, so that the sorter only sees the results which may make it to the top.
+ * Returns NULL if the query does not qualify
+ */
+static ResultProcessor *getNumericSortedRP(AREQ *req) {
+  if (!(req->reqflags & QEXEC_F_IS_SEARCH) || !req->rootiter) {
+    return NULL;
+  }
+  const PLN_ArrangeStep *astp =
+      (PLN_ArrangeStep *)AGPLN_FindStep(&req->ap, NULL, NULL, PLN_T_ARRANGE);
+  if (!astp || !astp->sortKeys || array_len(astp->sortKeys) != 1) {
+    return NULL;
+  }
+
+  RedisSearchCtx *sctx = req->sctx;
+  const char *name = astp->sortKeys[0];
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, name, strlen(name));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsSortable(fs)) {
+    return NULL;
+  }
+  NumericRangeTree *t = OpenNumericIndexForRead(sctx, fs);
+  if (!t) {
+    return NULL;
+  }
+  return RPNumericSortedIterator_New(req->rootiter, req->timeoutTime, sctx, t, fs,
+                                     SORTASCMAP_GETASC(astp->sortAscMap, 0) != 0,
+                                     arrangeLimit(astp));
+}
+
 #define PUSH_RP()                           \
   rpUpstream = pushRP(req, rp, rpUpstream); \
   rp = NULL;
@@ -965,7 +1008,10 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPIndexIterator_New(req->rootiter, req->timeoutTime);
+  ResultProcessor *rp = getNumericSortedRP(req);
+  if (!rp) {
+    rp = RPIndexIterator_New(req->rootiter, req->timeoutTime);
+  }
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
   PUSH_RP();
@@ -51,6 +51,7 @@ RSExpr *RS_NewStringLiteral(const char *str, size_t len) {
 
 RSExpr *RS_NewNullLiteral() {
   RSExpr *e = newExpr(RSExpr_Literal);
+  e->literal = RS_StaticValue(RSValue_Undef);
   RSValue_MakeReference(&e->literal, RS_NullVal());
   return e;
 }
@@ -2,6 +2,7 @@
 #include "result_processor.h"
 #include "rlookup.h"
 #include "profile.h"
+#include "util/arr.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -44,6 +45,25 @@ cleanup:
   return rc;
 }
 
+static double evalArith(unsigned char op, double n1, double n2) {
+  switch (op) {
+    case '+':
+      return n1 + n2;
+    case '/':
+      return n1 / n2;
+    case '-':
+      return n1 - n2;
+    case '*':
+      return n1 * n2;
+    case '%':
+      return (long long)n1 % (long long)n2;
+    case '^':
+      return pow(n1, n2);
+    default:
+      return NAN;
+  }
+}
+
 static int evalOp(ExprEval *eval, const RSExprOp *op, RSValue *result) {
   RSValue l = RSVALUE_STATIC, r = RSVALUE_STATIC;
   int rc = EXPR_EVAL_ERR;
@@ -63,30 +83,7 @@ static int evalOp(ExprEval *eval, const RSExprOp *op, RSValue *result) {
     goto cleanup;
   }
 
-  double res;
-  switch (op->op) {
-    case '+':
-      res = n1 + n2;
-      break;
-    case '/':
-      res = n1 / n2;
-      break;
-    case '-':
-      res = n1 - n2;
-      break;
-    case '*':
-      res = n1 * n2;
-      break;
-    case '%':
-      res = (long long)n1 % (long long)n2;
-      break;
-    case '^':
-      res = pow(n1, n2);
-      break;
-    default:
-      res = NAN;  // todo : we can not really reach here
-  }
-
+  double res = evalArith(op->op, n1, n2);
   result->numval = res;
   result->t = RSValue_Number;
   rc = EXPR_EVAL_OK;
@@ -232,6 +229,350 @@ int ExprEval_Eval(ExprEval *evaluator, RSValue *result) {
   return evalInternal(evaluator, evaluator->root, result);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+  // reference a literal or a constant folded at compile time
+  EXPR_INS_CONST,
+  // reference the value of a property in the row
+  EXPR_INS_PROPERTY,
+  // call a function on the values of the following slots
+  EXPR_INS_CALL,
+  // arithmetic operator, and the same for operands known to be numbers
+  EXPR_INS_OP,
+  EXPR_INS_OP_NUM,
+  // predicate, and the same for operands known to be numbers
+  EXPR_INS_PRED,
+  EXPR_INS_PRED_NUM,
+  // decide && and || by their left side, jumping over the right side
+  EXPR_INS_SHORTCUT,
+  EXPR_INS_NOT,
+} ExprInsType;
+
+typedef struct {
+  uint8_t type;
+  // the operator or condition. For properties and constants, whether they are arguments of
+  // exists(), which allows missing values
+  uint8_t arg;
+  // the slot the result is written to. The operands are in the slots following it, and slot 0 is
+  // the result of the program
+  uint16_t dst;
+  // the instruction following the predicate, for shortcuts
+  uint32_t jump;
+  union {
+    const RSValue *value;
+    const RLookupKey *key;
+    const RSFunctionExpr *func;
+  };
+} ExprInstruction;
+
+struct ExprProgram {
+  ExprInstruction *ins;
+  // constants folded at compile time
+  RSValue **consts;
+  // the values read by the instructions: either their own storage, or values they reference
+  RSValue **regs;
+  RSValue *storage;
+  size_t nslots;
+};
+
+/* Same as getPredicateBoolean for two numbers */
+static int getNumericPredicateBoolean(double n1, double n2, RSCondition cond) {
+  int cmp = n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
+  switch (cond) {
+    case RSCondition_Eq:
+      return cmp == 0;
+    case RSCondition_Lt:
+      return cmp < 0;
+    case RSCondition_Le:
+      return cmp <= 0;
+    case RSCondition_Gt:
+      return cmp > 0;
+    case RSCondition_Ge:
+      return cmp >= 0;
+    case RSCondition_Ne:
+      return cmp != 0;
+    case RSCondition_And:
+      return n1 && n2;
+    case RSCondition_Or:
+      return n1 || n2;
+  }
+  return 0;
+}
+
+/* Evaluate operators, predicates and negations of numeric literals at compile time. Returns 0 if
+ * the expression is not such a constant */
+static int foldConstant(const RSExpr *e, double *n) {
+  double l, r;
+  switch (e->t) {
+    case RSExpr_Literal:
+      if (e->literal.t != RSValue_Number) {
+        return 0;
+      }
+      *n = e->literal.numval;
+      return 1;
+    case RSExpr_Op:
+      if (!foldConstant(e->op.left, &l) || !foldConstant(e->op.right, &r)) {
+        return 0;
+      }
+      *n = evalArith(e->op.op, l, r);
+      return 1;
+    case RSExpr_Predicate:
+      if (!foldConstant(e->pred.left, &l) || !foldConstant(e->pred.right, &r)) {
+        return 0;
+      }
+      *n = getNumericPredicateBoolean(l, r, e->pred.cond);
+      return 1;
+    case RSExpr_Inverted:
+      if (!foldConstant(e->inverted.child, &l)) {
+        return 0;
+      }
+      *n = !l;
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static ExprInstruction *emit(ExprProgram *p, ExprInsType type, size_t dst) {
+  ExprInstruction ins = {.type = type, .dst = dst};
+  p->ins = array_append(p->ins, ins);
+  p->nslots = MAX(p->nslots, dst + 1);
+  return &p->ins[array_len(p->ins) - 1];
+}
+
+/* Compile the expression to write its value to slot `dst`. Returns 1 if the value is always a
+ * number */
+static int compileExpr(ExprProgram *p, const RSExpr *e, size_t dst, int nullable) {
+  double n;
+  if (e->t != RSExpr_Literal && foldConstant(e, &n)) {
+    RSValue *v = RS_NumVal(n);
+    p->consts = array_append(p->consts, v);
+    emit(p, EXPR_INS_CONST, dst)->value = v;
+    return 1;
+  }
+
+  ExprInstruction *ins;
+  int lnum, rnum;
+  switch (e->t) {
+    case RSExpr_Literal:
+      ins = emit(p, EXPR_INS_CONST, dst);
+      ins->value = &e->literal;
+      ins->arg = nullable;
+      return e->literal.t == RSValue_Number && !nullable;
+
+    case RSExpr_Property:
+      ins = emit(p, EXPR_INS_PROPERTY, dst);
+      ins->key = e->property.lookupObj;
+      ins->arg = nullable;
+      return 0;
+
+    case RSExpr_Function: {
+      // exists() is the only function which accepts missing values
+      int argsNullable = e->func.Call == func_exists;
+      for (size_t ii = 0; ii < e->func.args->len; ++ii) {
+        compileExpr(p, e->func.args->args[ii], dst + 1 + ii, argsNullable);
+      }
+      emit(p, EXPR_INS_CALL, dst)->func = &e->func;
+      return 0;
+    }
+
+    case RSExpr_Op:
+      lnum = compileExpr(p, e->op.left, dst + 1, 0);
+      rnum = compileExpr(p, e->op.right, dst + 2, 0);
+      emit(p, lnum && rnum ? EXPR_INS_OP_NUM : EXPR_INS_OP, dst)->arg = e->op.op;
+      return 1;
+
+    case RSExpr_Predicate: {
+      lnum = compileExpr(p, e->pred.left, dst + 1, 0);
+      size_t shortcut = array_len(p->ins);
+      if (e->pred.cond == RSCondition_And || e->pred.cond == RSCondition_Or) {
+        emit(p, EXPR_INS_SHORTCUT, dst)->arg = e->pred.cond;
+      }
+      rnum = compileExpr(p, e->pred.right, dst + 2, 0);
+      emit(p, lnum && rnum ? EXPR_INS_PRED_NUM : EXPR_INS_PRED, dst)->arg = e->pred.cond;
+      if (shortcut < array_len(p->ins) && p->ins[shortcut].type == EXPR_INS_SHORTCUT) {
+        p->ins[shortcut].jump = array_len(p->ins);
+      }
+      return 1;
+    }
+
+    case RSExpr_Inverted:
+      compileExpr(p, e->inverted.child, dst + 1, 0);
+      emit(p, EXPR_INS_NOT, dst);
+      return 1;
+  }
+  return 0;
+}
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root) {
+  ExprProgram *p = rm_calloc(1, sizeof(*p));
+  p->ins = array_new(ExprInstruction, 8);
+  p->consts = array_new(RSValue *, 1);
+  // a missing property is allowed as the result of the expression
+  compileExpr(p, root, 0, 1);
+  p->regs = rm_calloc(p->nslots, sizeof(*p->regs));
+  p->storage = rm_calloc(p->nslots, sizeof(*p->storage));
+  return p;
+}
+
+void ExprProgram_Free(ExprProgram *p) {
+  for (size_t ii = 0; ii < p->nslots; ++ii) {
+    RSValue_Clear(&p->storage[ii]);
+  }
+  for (size_t ii = 0; ii < array_len(p->consts); ++ii) {
+    RSValue_Decref(p->consts[ii]);
+  }
+  array_free(p->consts);
+  array_free(p->ins);
+  rm_free(p->regs);
+  rm_free(p->storage);
+  rm_free(p);
+}
+
+/* Release the values computed into the operand slots of an instruction */
+static void releaseOperands(ExprProgram *p, size_t dst, size_t n) {
+  for (size_t ii = dst + 1; ii <= dst + n; ++ii) {
+    RSValue_Clear(&p->storage[ii]);
+  }
+}
+
+/* Point the slot of a constant or a property at its value. The result of the program and the
+ * arguments of exists() - which tells a missing value from a null one by its type - reference the
+ * value like the tree evaluator does, the other slots read it in place */
+static void setSlotValue(ExprProgram *p, const ExprInstruction *ins, RSValue *result,
+                         RSValue *value) {
+  if (!ins->dst) {
+    RSValue_MakeReference(result, value);
+  } else if (ins->arg) {
+    RSValue_MakeReference(&p->storage[ins->dst], value);
+    p->regs[ins->dst] = &p->storage[ins->dst];
+  } else {
+    p->regs[ins->dst] = value;
+  }
+}
+
+/* Write the result of a predicate, unless an error was raised while evaluating it */
+static int setPredicateResult(ExprEval *eval, RSValue *out, int res) {
+  if (eval->err && eval->err->code != QUERY_OK) {
+    out->t = RSValue_Undef;
+    return EXPR_EVAL_ERR;
+  }
+  RSValue_Clear(out);
+  out->t = RSValue_Number;
+  out->numval = res;
+  return EXPR_EVAL_OK;
+}
+
+int ExprProgram_Eval(ExprProgram *p, ExprEval *eval, RSValue *result) {
+  RSValue **regs = p->regs;
+  size_t nins = array_len(p->ins);
+  for (size_t pc = 0; pc < nins; ++pc) {
+    const ExprInstruction *ins = &p->ins[pc];
+    size_t dst = ins->dst;
+    // the result of the program is written to `result`, the others to the slot's storage
+    RSValue *out = dst ? &p->storage[dst] : result;
+    RSValue **args = regs + dst + 1;
+    int rc = EXPR_EVAL_OK;
+    double n1, n2;
+
+    switch (ins->type) {
+      case EXPR_INS_CONST:
+        setSlotValue(p, ins, result, (RSValue *)ins->value);
+        continue;
+
+      case EXPR_INS_PROPERTY: {
+        if (!ins->key) {
+          if (eval->err) {
+            QueryError_SetError(eval->err, QUERY_ENOPROPKEY, NULL);
+          }
+          return EXPR_EVAL_ERR;
+        }
+        RSValue *value = RLookup_GetItem(ins->key, eval->srcrow);
+        if (!value) {
+          if (eval->err) {
+            QueryError_SetError(eval->err, QUERY_ENOPROPVAL, NULL);
+          }
+          if (!ins->arg) {
+            return EXPR_EVAL_ERR;
+          } else if (!dst) {
+            RSValue_Clear(result);
+            result->t = RSValue_Null;
+            return EXPR_EVAL_NULL;
+          }
+          regs[dst] = RS_NullVal();
+          continue;
+        }
+        setSlotValue(p, ins, result, value);
+        continue;
+      }
+
+      case EXPR_INS_CALL: {
+        size_t nargs = ins->func->args->len;
+        RSValue_Clear(out);
+        rc = ins->func->Call(eval, out, args, nargs, eval->err);
+        releaseOperands(p, dst, nargs);
+        break;
+      }
+
+      case EXPR_INS_OP:
+        if (!RSValue_ToNumber(args[0], &n1) || !RSValue_ToNumber(args[1], &n2)) {
+          QueryError_SetError(eval->err, QUERY_ENOTNUMERIC, NULL);
+          return EXPR_EVAL_ERR;
+        }
+        releaseOperands(p, dst, 2);
+        RSValue_Clear(out);
+        out->t = RSValue_Number;
+        out->numval = evalArith(ins->arg, n1, n2);
+        break;
+
+      case EXPR_INS_OP_NUM:
+        RSValue_Clear(out);
+        out->t = RSValue_Number;
+        out->numval = evalArith(ins->arg, args[0]->numval, args[1]->numval);
+        break;
+
+      case EXPR_INS_PRED:
+        rc = getPredicateBoolean(eval, args[0], args[1], ins->arg);
+        releaseOperands(p, dst, 2);
+        rc = setPredicateResult(eval, out, rc);
+        break;
+
+      case EXPR_INS_PRED_NUM:
+        rc = getNumericPredicateBoolean(args[0]->numval, args[1]->numval, ins->arg);
+        rc = setPredicateResult(eval, out, rc);
+        break;
+
+      case EXPR_INS_SHORTCUT: {
+        int lval = RSValue_BoolTest(args[0]);
+        if (ins->arg == RSCondition_Or ? !lval : lval) {
+          // the right side decides
+          continue;
+        }
+        releaseOperands(p, dst, 1);
+        rc = setPredicateResult(eval, out, lval);
+        pc = ins->jump - 1;
+        break;
+      }
+
+      case EXPR_INS_NOT: {
+        int val = RSValue_BoolTest(args[0]);
+        releaseOperands(p, dst, 1);
+        RSValue_Clear(out);
+        out->t = RSValue_Number;
+        out->numval = !val;
+        break;
+      }
+    }
+
+    if (rc != EXPR_EVAL_OK) {
+      return rc;
+    }
+    regs[dst] = out;
+  }
+  return EXPR_EVAL_OK;
+}
+
 int ExprAST_GetLookupKeys(RSExpr *expr, RLookup *lookup, QueryError *err) {
 #define RECURSE(v)                                                                             \
   if (!v) {                                                                                    \
@@ -395,6 +736,7 @@ typedef struct RPEvaluator RPEvaluator;
 struct RPEvaluator {
   ResultProcessor base;
   ExprEval eval;
+  ExprProgram *prog;
   RSValue *val;
   const RLookupKey *outkey;
   int isFilter;
@@ -402,13 +744,8 @@ struct RPEvaluator {
 
 #define RESULT_EVAL_ERR RS_RESULT_MAX + 1
 
-static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
-  /** Get the upstream result */
-  int rc = pc->base.upstream->Next(pc->base.upstream, r);
-  if (rc != RS_RESULT_OK) {
-    return rc;
-  }
-
+/* Evaluate the expression for a result, into pc->val */
+static int rpevalResult(RPEvaluator *pc, SearchResult *r) {
   pc->eval.res = r;
   pc->eval.srcrow = &r->rowdata;
 
@@ -419,13 +756,32 @@ static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
     pc->val = RS_NewValue(RSValue_Undef);
   }
 
-  rc = ExprEval_Eval(&pc->eval, pc->val);
+  int rc = ExprProgram_Eval(pc->prog, &pc->eval, pc->val);
   if (rc != EXPR_EVAL_OK) {
     return RS_RESULT_ERROR;
   }
   return RS_RESULT_OK;
 }
 
+static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
+  /** Get the upstream result */
+  int rc = pc->base.upstream->Next(pc->base.upstream, r);
+  if (rc != RS_RESULT_OK) {
+    return rc;
+  }
+  return rpevalResult(pc, r);
+}
+
+/* End a batch with an evaluation error, which happened at result `pos`. The results before it
+ * are still returned */
+static int rpevalBatchError(SearchResult *results, size_t pos, size_t *nread) {
+  for (size_t ii = pos; ii < *nread; ++ii) {
+    SearchResult_Clear(&results[ii]);
+  }
+  *nread = pos;
+  return RS_RESULT_ERROR;
+}
+
 static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc = rpevalCommon(pc, r);
@@ -438,6 +794,20 @@ static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   return RS_RESULT_OK;
 }
 
+static int rpevalNextBatch_project(ResultProcessor *rp, SearchResult *results, size_t n,
+                                   size_t *nread) {
+  RPEvaluator *pc = (RPEvaluator *)rp;
+  int rc = RP_NextBatch(rp->upstream, results, n, nread);
+  for (size_t ii = 0; ii < *nread; ++ii) {
+    if (rpevalResult(pc, &results[ii]) != RS_RESULT_OK) {
+      return rpevalBatchError(results, ii, nread);
+    }
+    RLookup_WriteOwnKey(pc->outkey, &results[ii].rowdata, pc->val);
+    pc->val = NULL;
+  }
+  return rc;
+}
+
 static int rpevalNext_filter(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc;
@@ -456,11 +826,40 @@ static int rpevalNext_filter(ResultProcessor *rp, SearchResult *r) {
   return rc;
 }
 
+static int rpevalNextBatch_filter(ResultProcessor *rp, SearchResult *results, size_t n,
+                                  size_t *nread) {
+  RPEvaluator *pc = (RPEvaluator *)rp;
+  int rc = RP_NextBatch(rp->upstream, results, n, nread);
+  size_t nkept = 0;
+  for (size_t ii = 0; ii < *nread; ++ii) {
+    SearchResult *r = &results[ii];
+    if (rpevalResult(pc, r) != RS_RESULT_OK) {
+      return rpevalBatchError(results, nkept, nread);
+    }
+    int boolrv = RSValue_BoolTest(pc->val);
+    RSValue_Clear(pc->val);
+    if (!boolrv) {
+      SearchResult_Clear(r);
+      continue;
+    }
+    if (ii != nkept) {
+      // keep the results which passed first, swapping so that no row is leaked
+      SearchResult tmp = results[nkept];
+      results[nkept] = *r;
+      *r = tmp;
+    }
+    nkept++;
+  }
+  *nread = nkept;
+  return rc;
+}
+
 static void rpevalFree(ResultProcessor *rp) {
   RPEvaluator *ee = (RPEvaluator *)rp;
   if (ee->val) {
     RSValue_Decref(ee->val);
   }
+  ExprProgram_Free(ee->prog);
   BlkAlloc_FreeAll(&ee->eval.stralloc, NULL, NULL, 0);
   rm_free(ee);
 }
@@ -468,10 +867,12 @@ static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *
                                               const RLookupKey *dstkey, int isFilter) {
   RPEvaluator *rp = rm_calloc(1, sizeof(*rp));
   rp->base.Next = isFilter ? rpevalNext_filter : rpevalNext_project;
+  rp->base.NextBatch = isFilter ? rpevalNextBatch_filter : rpevalNextBatch_project;
   rp->base.Free = rpevalFree;
   rp->base.type = isFilter ? RP_FILTER : RP_PROJECTOR;
   rp->eval.lookup = lookup;
   rp->eval.root = ast;
+  rp->prog = ExprProgram_Compile(ast);
   rp->outkey = dstkey;
   BlkAlloc_Init(&rp->eval.stralloc);
   return &rp->base;
@@ -149,6 +149,21 @@ int EvalCtx_EvalExprStr(EvalCtx *r, const char *exprstr);
 int ExprAST_GetLookupKeys(RSExpr *root, RLookup *lookup, QueryError *err);
 int ExprEval_Eval(ExprEval *evaluator, RSValue *result);
 
+/**
+ * An expression compiled into a flat sequence of instructions, so that evaluating it for every row
+ * does not walk the tree. Constant sub-expressions are folded, operators on values known to be
+ * numbers skip the type conversions, and the values of properties and literals are read in place
+ * rather than referenced. The lookup keys of the expression must be resolved before it is compiled
+ */
+typedef struct ExprProgram ExprProgram;
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root);
+
+/* Evaluate the program on the row of `evaluator`, with the same results as ExprEval_Eval */
+int ExprProgram_Eval(ExprProgram *p, ExprEval *evaluator, RSValue *result);
+
+void ExprProgram_Free(ExprProgram *p);
+
 void ExprAST_Free(RSExpr *expr);
 void ExprAST_Print(const RSExpr *expr);
 RSExpr * ExprAST_Parse(const char *e, size_t n, QueryError *status);
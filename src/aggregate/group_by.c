@@ -2,7 +2,10 @@
 #include <result_processor.h>
 #include <util/block_alloc.h>
 #include <util/khash.h>
+#include <pthread.h>
 #include "reducer.h"
+#include "concurrent_ctx.h"
+#include "config.h"
 
 /**
  * A group represents the allocated context of all reducers in a group, and the
@@ -39,15 +42,27 @@ KHASH_MAP_INIT_INT64(khid, Group *);
 #define GROUPS_PER_BLOCK 1024
 #define GROUPER_NSRCKEYS(g) ((g)->nkeys)
 
-typedef struct Grouper {
-  // Result processor base, for use in row processing
-  ResultProcessor base;
+// Rows read from upstream before they are grouped. If the upstream has more rows than that, the
+// rows of each chunk are grouped in parallel
+#define GROUPER_CHUNK_SIZE 4096
+// Maximal number of partitions grouping a chunk in parallel
+#define GROUPER_MAX_PARTITIONS 8
 
+/* A table of groups, built by a single thread */
+typedef struct {
   // Map of group_name => `Group` structure
   khash_t(khid) * groups;
 
   // Backing store for the groups themselves
   BlkAlloc groupsAlloc;
+} GroupTable;
+
+typedef struct Grouper {
+  // Result processor base, for use in row processing
+  ResultProcessor base;
+
+  // The groups yielded by the grouper
+  GroupTable table;
 
   /**
    * Keys to group by. Both srckeys and dstkeys are used because different lookups
@@ -64,6 +79,21 @@ typedef struct Grouper {
 
   // Used for maintaining state when yielding groups
   khiter_t iter;
+
+  // Rows read from the upstream processor, grouped a chunk at a time
+  SearchResult *chunk;
+  size_t chunkLen;
+
+  /**
+   * Partial groups built in parallel, each partition over a range of the rows of every chunk.
+   * They are merged into `table` once the upstream is done. nparts is 0 until the first chunk is
+   * grouped, and 1 if the rows are grouped serially into `table`.
+   */
+  GroupTable *parts;
+  size_t nparts;
+
+  // Guards the reducers' allocators while groups are created in parallel
+  pthread_mutex_t lock;
 } Grouper;
 
 /**
@@ -73,15 +103,24 @@ typedef struct Grouper {
  *
  * These will be placed in the output row.
  */
-static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
+static Group *createGroup(Grouper *g, GroupTable *t, const RSValue **groupvals,
+                          size_t ngrpvals) {
   size_t numReducers = array_len(g->reducers);
   size_t elemSize = GROUP_BYTESIZE(g);
-  Group *group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
+  Group *group = BlkAlloc_Alloc(&t->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
   memset(group, 0, elemSize);
 
+  // the instances are allocated from the reducers, which are shared by the partitions
+  int parallel = t != &g->table;
+  if (parallel) {
+    pthread_mutex_lock(&g->lock);
+  }
   for (size_t ii = 0; ii < numReducers; ++ii) {
     group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
   }
+  if (parallel) {
+    pthread_mutex_unlock(&g->lock);
+  }
 
   /** Initialize the row data! */
   for (size_t ii = 0; ii < ngrpvals; ++ii) {
@@ -107,13 +146,13 @@ static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r)
 static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
   Grouper *g = (Grouper *)base;
 
-  while (g->iter != kh_end(g->groups)) {
-    if (!kh_exist(g->groups, g->iter)) {
+  while (g->iter != kh_end(g->table.groups)) {
+    if (!kh_exist(g->table.groups, g->iter)) {
       g->iter++;
       continue;
     }
 
-    Group *gr = kh_value(g->groups, g->iter);
+    Group *gr = kh_value(g->table.groups, g->iter);
     // no reducers; just a terminal GROUPBY...
 
     if (!GROUPER_NREDUCERS(g)) {
@@ -151,6 +190,7 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
  * Add() for each cartesian product of the current row.
  *
  * @param g the grouper
+ * @param t the table the groups are looked up and created in
  * @param xarr the array of 'x' values - i.e. the raw results received from the
  *  upstream result processor. The number of results can be found via
  *  the `GROUPER_NSRCKEYS(g)` macro
@@ -162,19 +202,19 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
  *  are not hashed together.
  * @param res the row is passed to each reducer
  */
-static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t xlen, size_t arridx,
-                          uint64_t hval, RLookupRow *res) {
+static void extractGroups(Grouper *g, GroupTable *t, const RSValue **xarr, size_t xpos,
+                          size_t xlen, size_t arridx, uint64_t hval, RLookupRow *res) {
   // end of the line - create/add to group
   if (xpos == xlen) {
     Group *group = NULL;
 
     // Get or create the group
-    khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
-    if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
-      group = createGroup(g, xarr, xlen);
-      kh_set(khid, g->groups, hval, group);
+    khiter_t k = kh_get(khid, t->groups, hval);  // first have to get ieter
+    if (k == kh_end(t->groups)) {                // k will be equal to kh_end if key not present
+      group = createGroup(g, t, xarr, xlen);
+      kh_set(khid, t->groups, hval, group);
     } else {
-      group = kh_value(g->groups, k);
+      group = kh_value(t->groups, k);
     }
 
     // send the result to the group and its reducers
@@ -187,7 +227,7 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
   // regular value - just move one step -- increment XPOS
   if (v->t != RSValue_Array) {
     hval = RSValue_Hash(v, hval);
-    extractGroups(g, xarr, xpos + 1, xlen, 0, hval, res);
+    extractGroups(g, t, xarr, xpos + 1, xlen, 0, hval, res);
   } else {
     // Array value. Replace current XPOS with child temporarily
     const RSValue *array = xarr[xpos];
@@ -205,17 +245,17 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
     uint64_t hh = RSValue_Hash(elem, hval);
 
     xarr[xpos] = elem;
-    extractGroups(g, xarr, xpos, xlen, arridx, hh, res);
+    extractGroups(g, t, xarr, xpos, xlen, arridx, hh, res);
     xarr[xpos] = array;
 
     // Replace the value back, and proceed to the next value of the array
     if (++arridx < RSValue_ArrayLen(v)) {
-      extractGroups(g, xarr, xpos, xlen, arridx, hval, res);
+      extractGroups(g, t, xarr, xpos, xlen, arridx, hval, res);
     }
   }
 }
 
-static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
+static void invokeGroupReducers(Grouper *g, GroupTable *t, RLookupRow *srcrow) {
   uint64_t hval = 0;
   size_t nkeys = GROUPER_NSRCKEYS(g);
   const RSValue *groupvals[nkeys];
@@ -228,7 +268,151 @@ static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
     }
     groupvals[ii] = v;
   }
-  extractGroups(g, groupvals, 0, nkeys, 0, 0, srcrow);
+  extractGroups(g, t, groupvals, 0, nkeys, 0, 0, srcrow);
+}
+
+/**
+ * The grouping of a chunk's rows in parallel. Each partition groups a range of the rows into its
+ * own table. The partitions are claimed by workers of the search thread pool and by the query's
+ * own thread, so that the chunk is done even if no worker is free.
+ */
+typedef struct {
+  Grouper *g;
+  size_t nrows;
+  size_t nparts;
+  // next partition to claim, and the number of partitions done
+  size_t next;
+  size_t ndone;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  // held by the query's thread and by every task, which may run after the chunk is done
+  int refcount;
+} GroupChunkJob;
+
+static void groupChunkRun(GroupChunkJob *job) {
+  Grouper *g = job->g;
+  size_t p;
+  while ((p = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->nparts) {
+    size_t begin = job->nrows * p / job->nparts;
+    size_t end = job->nrows * (p + 1) / job->nparts;
+    for (size_t ii = begin; ii < end; ++ii) {
+      invokeGroupReducers(g, &g->parts[p], &g->chunk[ii].rowdata);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    if (++job->ndone == job->nparts) {
+      pthread_cond_signal(&job->cond);
+    }
+    pthread_mutex_unlock(&job->lock);
+  }
+}
+
+static void groupChunkJobDecref(GroupChunkJob *job) {
+  if (__atomic_sub_fetch(&job->refcount, 1, __ATOMIC_SEQ_CST)) {
+    return;
+  }
+  pthread_mutex_destroy(&job->lock);
+  pthread_cond_destroy(&job->cond);
+  rm_free(job);
+}
+
+static void groupChunkTask(void *arg) {
+  groupChunkRun(arg);
+  groupChunkJobDecref(arg);
+}
+
+static void groupChunkParallel(Grouper *g) {
+  GroupChunkJob *job = rm_calloc(1, sizeof(*job));
+  job->g = g;
+  job->nrows = g->chunkLen;
+  job->nparts = g->nparts;
+  job->refcount = g->nparts;
+  pthread_mutex_init(&job->lock, NULL);
+  pthread_cond_init(&job->cond, NULL);
+
+  for (size_t ii = 1; ii < g->nparts; ++ii) {
+    ConcurrentSearch_ThreadPoolRun(groupChunkTask, job, CONCURRENT_POOL_SEARCH);
+  }
+  groupChunkRun(job);
+
+  pthread_mutex_lock(&job->lock);
+  while (job->ndone < job->nparts) {
+    pthread_cond_wait(&job->cond, &job->lock);
+  }
+  pthread_mutex_unlock(&job->lock);
+  groupChunkJobDecref(job);
+}
+
+/* Number of partitions to group the rows by, if there is more than a chunk of them */
+static size_t grouperPartitions(const Grouper *g) {
+  if (CONCURRENT_POOL_SEARCH == -1) {
+    return 1;
+  }
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->Merge) {
+      return 1;
+    }
+  }
+  size_t n = RSGlobalConfig.searchPoolSize;
+  return n < GROUPER_MAX_PARTITIONS ? (n ? n : 1) : GROUPER_MAX_PARTITIONS;
+}
+
+static void groupTableInit(GroupTable *t) {
+  t->groups = kh_init(khid);
+  BlkAlloc_Init(&t->groupsAlloc);
+}
+
+/* Group the rows read so far. `more` tells whether the upstream may have more rows */
+static void groupChunk(Grouper *g, int more) {
+  if (!g->nparts) {
+    g->nparts = more ? grouperPartitions(g) : 1;
+    if (g->nparts > 1) {
+      g->parts = rm_calloc(g->nparts, sizeof(*g->parts));
+      for (size_t ii = 0; ii < g->nparts; ++ii) {
+        groupTableInit(&g->parts[ii]);
+      }
+    }
+  }
+
+  if (g->nparts > 1) {
+    groupChunkParallel(g);
+  } else {
+    for (size_t ii = 0; ii < g->chunkLen; ++ii) {
+      invokeGroupReducers(g, &g->table, &g->chunk[ii].rowdata);
+    }
+  }
+  for (size_t ii = 0; ii < g->chunkLen; ++ii) {
+    SearchResult_Clear(&g->chunk[ii]);
+  }
+  g->chunkLen = 0;
+}
+
+/* Merge the groups built in parallel into the grouper's table */
+static void mergePartitions(Grouper *g) {
+  for (size_t p = 0; p < g->nparts && g->parts; ++p) {
+    khash_t(khid) *src = g->parts[p].groups;
+    for (khiter_t it = kh_begin(src); it != kh_end(src); ++it) {
+      if (!kh_exist(src, it)) {
+        continue;
+      }
+      Group *gr = kh_value(src, it);
+      khiter_t k = kh_get(khid, g->table.groups, kh_key(src, it));
+      if (k == kh_end(g->table.groups)) {
+        kh_set(khid, g->table.groups, kh_key(src, it), gr);
+        continue;
+      }
+
+      Group *dst = kh_value(g->table.groups, k);
+      for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+        Reducer *rd = g->reducers[ii];
+        rd->Merge(rd, dst->accumdata[ii], gr->accumdata[ii]);
+      }
+      // the reducer instances are freed along with the partition
+      RLookupRow_Cleanup(&gr->rowdata);
+    }
+    kh_destroy(khid, src);
+    g->parts[p].groups = NULL;
+  }
 }
 
 static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
@@ -236,13 +420,22 @@ static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
 
   int rc;
 
-  while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
-    invokeGroupReducers(g, &res->rowdata);
-    SearchResult_Clear(res);
+  if (!g->chunk) {
+    g->chunk = rm_calloc(GROUPER_CHUNK_SIZE, sizeof(*g->chunk));
   }
+  do {
+    size_t n, room = GROUPER_CHUNK_SIZE - g->chunkLen;
+    rc = RP_NextBatch(base->upstream, g->chunk + g->chunkLen,
+                      room < RP_BATCH_SIZE ? room : RP_BATCH_SIZE, &n);
+    g->chunkLen += n;
+    if (g->chunkLen == GROUPER_CHUNK_SIZE || rc != RS_RESULT_OK) {
+      groupChunk(g, rc == RS_RESULT_OK);
+    }
+  } while (rc == RS_RESULT_OK);
   if (rc == RS_RESULT_EOF) {
+    mergePartitions(g);
     base->Next = Grouper_rpYield;
-    base->parent->totalResults = kh_size(g->groups);
+    base->parent->totalResults = kh_size(g->table.groups);
     g->iter = kh_begin(khid);
     return Grouper_rpYield(base, res);
   } else {
@@ -262,17 +455,27 @@ static void cleanCallback(void *ptr, void *arg) {
   }
 }
 
+static void groupTableFree(Grouper *g, GroupTable *t) {
+  if (t->groups) {
+    for (khiter_t it = kh_begin(t->groups); it != kh_end(t->groups); ++it) {
+      if (!kh_exist(t->groups, it)) {
+        continue;
+      }
+      Group *gr = kh_value(t->groups, it);
+      RLookupRow_Cleanup(&gr->rowdata);
+    }
+    kh_destroy(khid, t->groups);
+  }
+  BlkAlloc_FreeAll(&t->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+}
+
 static void Grouper_rpFree(ResultProcessor *grrp) {
   Grouper *g = (Grouper *)grrp;
-  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
-    if (!kh_exist(g->groups, it)) {
-      continue;
-    }
-    Group *gr = kh_value(g->groups, it);
-    RLookupRow_Cleanup(&gr->rowdata);
+  groupTableFree(g, &g->table);
+  for (size_t ii = 0; ii < g->nparts && g->parts; ++ii) {
+    groupTableFree(g, &g->parts[ii]);
   }
-  kh_destroy(khid, g->groups);
-  BlkAlloc_FreeAll(&g->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+  rm_free(g->parts);
 
   for (size_t i = 0; i < GROUPER_NREDUCERS(g); i++) {
     g->reducers[i]->Free(g->reducers[i]);
@@ -280,6 +483,13 @@ static void Grouper_rpFree(ResultProcessor *grrp) {
   if (g->reducers) {
     array_free(g->reducers);
   }
+  if (g->chunk) {
+    for (size_t ii = 0; ii < GROUPER_CHUNK_SIZE; ++ii) {
+      SearchResult_Destroy(&g->chunk[ii]);
+    }
+    rm_free(g->chunk);
+  }
+  pthread_mutex_destroy(&g->lock);
   rm_free(g->srckeys);
   rm_free(g->dstkeys);
   rm_free(g);
@@ -291,8 +501,8 @@ void Grouper_Free(Grouper *g) {
 
 Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, size_t nkeys) {
   Grouper *g = rm_calloc(1, sizeof(*g));
-  BlkAlloc_Init(&g->groupsAlloc);
-  g->groups = kh_init(khid);
+  groupTableInit(&g->table);
+  pthread_mutex_init(&g->lock, NULL);
 
   g->srckeys = rm_calloc(nkeys, sizeof(*g->srckeys));
   g->dstkeys = rm_calloc(nkeys, sizeof(*g->dstkeys));
@@ -317,3 +527,20 @@ void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dstkey) {
 ResultProcessor *Grouper_GetRP(Grouper *g) {
   return &g->base;
 }
+
+void Grouper_Reply(RedisModuleCtx *ctx, const ResultProcessor *rp) {
+  RS_LOG_ASSERT(rp->type == RP_GROUP, "Error");
+  const Grouper *g = (const Grouper *)rp;
+  size_t memory = 0;
+  int approximate = 0;
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    memory += g->reducers[ii]->memory;
+    approximate |= g->reducers[ii]->approximate;
+  }
+  if (!memory) {
+    RedisModule_ReplyWithSimpleString(ctx, RPTypeToString(rp->type));
+  } else {
+    RedisModule_ReplyWithPrintf(ctx, "%s - Reducers memory %zu%s", RPTypeToString(rp->type), memory,
+                                approximate ? ", approximate" : "");
+  }
+}
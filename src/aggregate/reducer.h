@@ -50,6 +50,15 @@ typedef struct Reducer {
   /** Numeric ID identifying this reducer */
   uint32_t reducerId;
 
+  /**
+   * Bytes held by the instances of this reducer outside of `alloc`, for reducers which keep track
+   * of it. Reported by FT.PROFILE
+   */
+  size_t memory;
+
+  /** Set once some of the results are estimated, to stay within the reducer's memory budget */
+  int approximate;
+
   /**
    * Creates a new per-group instance of this reducer. This is used to create
    * actual data. The reducer structure itself, on the other hand, may be
@@ -75,6 +84,13 @@ typedef struct Reducer {
   /** Frees the object created by NewInstance() */
   void (*FreeInstance)(struct Reducer *parent, void *instance);
 
+  /**
+   * Optional. Folds the instance `src` into `dst`, as if the rows passed to `src` had been passed
+   * to `dst` as well. This lets groups be built in parallel over parts of the rows, and merged
+   * before they are finalized. `src` is still freed by FreeInstance() afterwards.
+   */
+  void (*Merge)(struct Reducer *parent, void *dst, void *src);
+
   /**
    * Frees the global reducer struct (this object)
    */
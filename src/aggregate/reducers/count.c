@@ -18,6 +18,10 @@ static int counterAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void counterMerge(Reducer *r, void *dst, void *src) {
+  ((counterData *)dst)->count += ((counterData *)src)->count;
+}
+
 static RSValue *counterFinalize(Reducer *r, void *instance) {
   counterData *dd = instance;
   return RS_NumVal(dd->count);
@@ -31,6 +35,7 @@ Reducer *RDCRCount_New(const ReducerOptions *options) {
   Reducer *r = rm_calloc(1, sizeof(*r));
   r->Add = counterAdd;
   r->Finalize = counterFinalize;
+  r->Merge = counterMerge;
   r->Free = Reducer_GenericFree;
   r->NewInstance = counterNewInstance;
   return r;
@@ -4,19 +4,51 @@
 #include <util/fnv.h>
 #include <dep/hll/hll.h>
 #include <rmutil/sds.h>
+#include "config.h"
 
 #define HLL_PRECISION_BITS 8
 #define INSTANCE_BLOCK_NUM 1024
+// Precision of the counters which replace the sets of COUNT_DISTINCT once it runs out of memory.
+// This is about 1.6% error, at 4KB per group. Smaller sets are replaced by counters of lower
+// precision which take no more memory than they did, down to 8 bits (256 bytes, about 6.5% error).
+// Sets smaller than that are kept
+#define DISTINCT_ESCALATE_BITS 12
+#define DISTINCT_ESCALATE_MIN_BITS 8
 
 static const int khid = 35;
 KHASH_SET_INIT_INT64(khid);
 
+typedef struct {
+  Reducer base;
+  // Memory the sets of all groups may take before they are replaced by estimating counters.
+  // 0 means unlimited
+  size_t maxMemory;
+} distinctReducer;
+
 typedef struct {
   size_t count;
   const RLookupKey *srckey;
+  // Hashes of the values seen so far. NULL once the counter is estimated by `hll`
   khash_t(khid) * dedup;
+  struct HLL hll;
 } distinctCounter;
 
+// Bytes taken by a set: a key per bucket and 2 flag bits per bucket
+static size_t distinctSetMemory(const khash_t(khid) * h) {
+  return h->n_buckets * sizeof(khint64_t) + h->n_buckets / 4;
+}
+
+// The high bits of FNV hashes of short values are not mixed well enough for the HLL registers, so
+// the hashes are finalized as in MurmurHash3 first
+static inline uint32_t distinctHash32(uint64_t hval) {
+  hval ^= hval >> 33;
+  hval *= 0xff51afd7ed558ccdULL;
+  hval ^= hval >> 33;
+  hval *= 0xc4ceb9fe1a85ec53ULL;
+  hval ^= hval >> 33;
+  return (uint32_t)(hval >> 32);
+}
+
 static void *distinctNewInstance(Reducer *r) {
   BlkAlloc *ba = &r->alloc;
   distinctCounter *ctr =
@@ -24,9 +56,93 @@ static void *distinctNewInstance(Reducer *r) {
   ctr->count = 0;
   ctr->dedup = kh_init(khid);
   ctr->srckey = r->srckey;
+  ctr->hll.bits = 0;
+  ctr->hll.registers = NULL;
   return ctr;
 }
 
+/* The highest precision of a counter taking no more than `memory` bytes */
+static uint8_t distinctEscalateBits(size_t memory) {
+  uint8_t bits = DISTINCT_ESCALATE_MIN_BITS;
+  while (bits < DISTINCT_ESCALATE_BITS && ((size_t)2 << bits) <= memory) {
+    bits++;
+  }
+  return bits;
+}
+
+/* Merge `src` into `dst` of the same or a lower precision. The low index bits of `src` registers
+ * become the high bits of the hash part whose trailing zeros are ranked by `dst` */
+static void distinctFoldHLL(struct HLL *dst, const struct HLL *src) {
+  uint8_t shift = src->bits - dst->bits;
+  uint8_t maxRank = 32 - src->bits + 1;
+  for (uint32_t i = 0; i < src->size; ++i) {
+    uint8_t rank = src->registers[i];
+    if (rank == maxRank && shift) {
+      // no set bit in the hash part of `src`, continue counting in the index bits it loses
+      uint32_t low = i & ((1 << shift) - 1);
+      rank = low ? 32 - src->bits + __builtin_ctz(low) + 1 : 32 - dst->bits + 1;
+    }
+    uint32_t index = i >> shift;
+    if (rank > dst->registers[index]) {
+      dst->registers[index] = rank;
+    }
+  }
+}
+
+/* Lower the precision of an estimated counter */
+static void distinctShrink(Reducer *r, distinctCounter *ctr, uint8_t bits) {
+  struct HLL hll;
+  hll_init(&hll, bits);
+  distinctFoldHLL(&hll, &ctr->hll);
+  __atomic_sub_fetch(&r->memory, ctr->hll.size - hll.size, __ATOMIC_RELAXED);
+  hll_destroy(&ctr->hll);
+  ctr->hll = hll;
+}
+
+/* Replace the set of the counter by a HyperLogLog of the same values. Its precision is the
+ * highest one for which it takes no more memory than the set, so that the memory of many small
+ * groups is reduced as well, rather than multiplied */
+static void distinctEscalate(Reducer *r, distinctCounter *ctr) {
+  hll_init(&ctr->hll, distinctEscalateBits(distinctSetMemory(ctr->dedup)));
+  for (khiter_t it = kh_begin(ctr->dedup); it != kh_end(ctr->dedup); ++it) {
+    if (kh_exist(ctr->dedup, it)) {
+      hll_add_hash(&ctr->hll, distinctHash32(kh_key(ctr->dedup, it)));
+    }
+  }
+  __atomic_sub_fetch(&r->memory, distinctSetMemory(ctr->dedup), __ATOMIC_RELAXED);
+  __atomic_add_fetch(&r->memory, ctr->hll.size, __ATOMIC_RELAXED);
+  __atomic_store_n(&r->approximate, 1, __ATOMIC_RELAXED);
+  kh_destroy(khid, ctr->dedup);
+  ctr->dedup = NULL;
+}
+
+/* Add the hash of a value to the counter. If its set grows past the memory left to the reducer,
+ * the counter is estimated from then on */
+static void distinctAddHash(Reducer *r, distinctCounter *ctr, uint64_t hval) {
+  if (!ctr->dedup) {
+    hll_add_hash(&ctr->hll, distinctHash32(hval));
+    return;
+  }
+
+  size_t before = distinctSetMemory(ctr->dedup);
+  int ret;
+  kh_put(khid, ctr->dedup, hval, &ret);
+  if (!ret) {
+    return;
+  }
+  ctr->count++;
+
+  size_t after = distinctSetMemory(ctr->dedup);
+  if (after == before) {
+    return;
+  }
+  size_t total = __atomic_add_fetch(&r->memory, after - before, __ATOMIC_RELAXED);
+  size_t maxMemory = ((distinctReducer *)r)->maxMemory;
+  if (maxMemory && total > maxMemory && after >= (size_t)1 << DISTINCT_ESCALATE_MIN_BITS) {
+    distinctEscalate(r, ctr);
+  }
+}
+
 static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   distinctCounter *ctr = ctx;
   const RSValue *val = RLookup_GetItem(ctr->srckey, srcrow);
@@ -34,19 +150,34 @@ static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
     return 1;
   }
 
-  uint64_t hval = RSValue_Hash(val, 0);
+  distinctAddHash(r, ctr, RSValue_Hash(val, 0));
+  return 1;
+}
 
-  khiter_t k = kh_get(khid, ctr->dedup, hval);  // first have to get ieter
-  if (k == kh_end(ctr->dedup)) {
-    ctr->count++;
-    int ret;
-    kh_put(khid, ctr->dedup, hval, &ret);
+static void distinctMerge(Reducer *r, void *dst, void *src) {
+  distinctCounter *d = dst, *s = src;
+  if (!s->dedup) {
+    if (d->dedup) {
+      distinctEscalate(r, d);
+    }
+    if (d->hll.bits > s->hll.bits) {
+      distinctShrink(r, d, s->hll.bits);
+    }
+    distinctFoldHLL(&d->hll, &s->hll);
+    return;
+  }
+  for (khiter_t it = kh_begin(s->dedup); it != kh_end(s->dedup); ++it) {
+    if (kh_exist(s->dedup, it)) {
+      distinctAddHash(r, d, kh_key(s->dedup, it));
+    }
   }
-  return 1;
 }
 
 static RSValue *distinctFinalize(Reducer *parent, void *ctx) {
   distinctCounter *ctr = ctx;
+  if (!ctr->dedup) {
+    return RS_NumVal((uint64_t)hll_count(&ctr->hll));
+  }
   return RS_NumVal(ctr->count);
 }
 
@@ -54,20 +185,29 @@ static void distinctFreeInstance(Reducer *r, void *p) {
   distinctCounter *ctr = p;
   // we only destroy the hash table. The object itself is allocated from a block and needs no
   // freeing
-  kh_destroy(khid, ctr->dedup);
+  if (ctr->dedup) {
+    __atomic_sub_fetch(&r->memory, distinctSetMemory(ctr->dedup), __ATOMIC_RELAXED);
+    kh_destroy(khid, ctr->dedup);
+  } else {
+    __atomic_sub_fetch(&r->memory, ctr->hll.size, __ATOMIC_RELAXED);
+    hll_destroy(&ctr->hll);
+  }
 }
 
 Reducer *RDCRCountDistinct_New(const ReducerOptions *options) {
-  Reducer *r = rm_calloc(1, sizeof(*r));
+  distinctReducer *dr = rm_calloc(1, sizeof(*dr));
+  Reducer *r = &dr->base;
   if (!ReducerOpts_GetKey(options, &r->srckey)) {
-    rm_free(r);
+    rm_free(dr);
     return NULL;
   }
+  dr->maxMemory = RSGlobalConfig.maxDistinctMemory;
   r->Add = distinctAdd;
   r->Finalize = distinctFinalize;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctFreeInstance;
   r->NewInstance = distinctNewInstance;
+  r->Merge = distinctMerge;
   r->reducerId = REDUCER_T_DISTINCT;
   return r;
 }
@@ -99,6 +239,11 @@ static int distinctishAdd(Reducer *parent, void *instance, const RLookupRow *src
   return 1;
 }
 
+static void distinctishMerge(Reducer *parent, void *dst, void *src) {
+  distinctishCounter *d = dst, *s = src;
+  hll_merge(&d->hll, &s->hll);
+}
+
 static RSValue *distinctishFinalize(Reducer *parent, void *instance) {
   distinctishCounter *ctr = instance;
   return RS_NumVal((uint64_t)hll_count(&ctr->hll));
@@ -139,6 +284,7 @@ static Reducer *newHllCommon(const ReducerOptions *options, int isRaw) {
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctishFreeInstance;
   r->NewInstance = distinctishNewInstance;
+  r->Merge = distinctishMerge;
 
   if (isRaw) {
     r->reducerId = REDUCER_T_HLL;
@@ -214,6 +360,18 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void hllsumMerge(Reducer *r, void *dst, void *src) {
+  hllSumCtx *d = dst, *s = src;
+  if (!s->hll.bits) {
+    return;
+  } else if (!d->hll.bits) {
+    hll_init(&d->hll, s->hll.bits);
+    memcpy(d->hll.registers, s->hll.registers, s->hll.size);
+  } else if (d->hll.bits == s->hll.bits) {
+    hll_merge(&d->hll, &s->hll);
+  }
+}
+
 static RSValue *hllsumFinalize(Reducer *parent, void *ctx) {
   hllSumCtx *ctr = ctx;
   return RS_NumVal(ctr->hll.bits ? (uint64_t)hll_count(&ctr->hll) : 0);
@@ -243,6 +401,7 @@ Reducer *RDCRHLLSum_New(const ReducerOptions *options) {
   r->Finalize = hllsumFinalize;
   r->NewInstance = hllsumNewInstance;
   r->FreeInstance = hllsumFreeInstance;
+  r->Merge = hllsumMerge;
   r->Free = Reducer_GenericFree;
   return r;
 }
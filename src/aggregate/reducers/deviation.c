@@ -53,6 +53,26 @@ static int stddevAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void stddevMerge(Reducer *r, void *dst, void *src) {
+  devCtx *d = dst, *s = src;
+  if (!s->n) {
+    return;
+  } else if (!d->n) {
+    d->n = s->n;
+    d->oldM = d->newM = s->newM;
+    d->oldS = d->newS = s->newS;
+    return;
+  }
+  // combine the means and the sums of squared differences of both parts (Chan et al.)
+  size_t n = d->n + s->n;
+  double delta = s->newM - d->newM;
+  d->newM += delta * s->n / n;
+  d->newS += s->newS + delta * delta * d->n * s->n / n;
+  d->oldM = d->newM;
+  d->oldS = d->newS;
+  d->n = n;
+}
+
 static RSValue *stddevFinalize(Reducer *parent, void *instance) {
   devCtx *dctx = instance;
   double variance = ((dctx->n > 1) ? dctx->newS / (dctx->n - 1) : 0.0);
@@ -68,6 +88,7 @@ Reducer *RDCRStdDev_New(const ReducerOptions *options) {
   }
   r->Add = stddevAdd;
   r->Finalize = stddevFinalize;
+  r->Merge = stddevMerge;
   r->Free = Reducer_GenericFree;
   r->NewInstance = stddevNewInstance;
   r->reducerId = REDUCER_T_STDDEV;
@@ -49,6 +49,18 @@ static int minmaxAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void minmaxMerge(Reducer *r, void *dst, void *src) {
+  minmaxCtx *d = dst, *s = src;
+  if (!s->numMatches) {
+    return;
+  }
+  if (!d->numMatches || (d->mode == Minmax_Max && s->val > d->val) ||
+      (d->mode == Minmax_Min && s->val < d->val)) {
+    d->val = s->val;
+  }
+  d->numMatches += s->numMatches;
+}
+
 static RSValue *minmaxFinalize(Reducer *parent, void *instance) {
   minmaxCtx *ctx = instance;
   return RS_NumVal(ctx->numMatches ? ctx->val : 0);
@@ -63,6 +75,7 @@ static Reducer *newMinMax(const ReducerOptions *options, MinmaxMode mode) {
   r->base.NewInstance = minmaxNewInstance;
   r->base.Add = minmaxAdd;
   r->base.Finalize = minmaxFinalize;
+  r->base.Merge = minmaxMerge;
   r->base.Free = Reducer_GenericFree;
   r->mode = mode;
   return &r->base;
@@ -1,10 +1,13 @@
 #include <aggregate/reducer.h>
 #include "util/quantile.h"
+#include "util/tdigest.h"
 
 typedef struct {
   Reducer base;
   double pct;
   unsigned resolution;
+  // Summarize the values with a t-digest of this compression rather than a quantile stream
+  unsigned compression;
 } QTLReducer;
 
 static void *quantileNewInstance(Reducer *parent) {
@@ -12,10 +15,22 @@ static void *quantileNewInstance(Reducer *parent) {
   return NewQuantileStream(&qt->pct, 0, qt->resolution);
 }
 
+static void *tdigestNewInstance(Reducer *parent) {
+  QTLReducer *qt = (QTLReducer *)parent;
+  return NewTDigest(qt->compression);
+}
+
+static inline void quantileInsert(QTLReducer *qt, void *ctx, double d) {
+  if (qt->compression) {
+    TD_Add(ctx, d);
+  } else {
+    QS_Insert(ctx, d);
+  }
+}
+
 static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
   double d;
   QTLReducer *qt = (QTLReducer *)rbase;
-  QuantStream *qs = ctx;
   RSValue *v = RLookup_GetItem(rbase->srckey, row);
   if (!v) {
     return 1;
@@ -23,19 +38,23 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
 
   if (v->t != RSValue_Array) {
     if (RSValue_ToNumber(v, &d)) {
-      QS_Insert(qs, d);
+      quantileInsert(qt, ctx, d);
     }
   } else {
     uint32_t sz = RSValue_ArrayLen(v);
     for (uint32_t i = 0; i < sz; i++) {
       if (RSValue_ToNumber(RSValue_ArrayItem(v, i), &d)) {
-        QS_Insert(qs, d);
+        quantileInsert(qt, ctx, d);
       }
     }
   }
   return 1;
 }
 
+static void quantileMerge(Reducer *r, void *dst, void *src) {
+  QS_Merge(dst, src);
+}
+
 static RSValue *quantileFinalize(Reducer *r, void *ctx) {
   QuantStream *qs = ctx;
   QTLReducer *qt = (QTLReducer *)r;
@@ -47,6 +66,19 @@ static void quantileFreeInstance(Reducer *unused, void *p) {
   QS_Free(p);
 }
 
+static void tdigestMerge(Reducer *r, void *dst, void *src) {
+  TD_Merge(dst, src);
+}
+
+static RSValue *tdigestFinalize(Reducer *r, void *ctx) {
+  QTLReducer *qt = (QTLReducer *)r;
+  return RS_NumVal(TD_Quantile(ctx, qt->pct));
+}
+
+static void tdigestFreeInstance(Reducer *unused, void *p) {
+  TD_Free(p);
+}
+
 Reducer *RDCRQuantile_New(const ReducerOptions *options) {
   QTLReducer *r = rm_calloc(1, sizeof(*r));
   r->resolution = 500;  // Fixed, i guess?
@@ -64,7 +96,19 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
     goto error;
   }
 
-  if (!AC_IsAtEnd(options->args)) {
+  if (AC_AdvanceIfMatch(options->args, "TDIGEST")) {
+    r->compression = TDIGEST_DEFAULT_COMPRESSION;
+    if (!AC_IsAtEnd(options->args)) {
+      if ((rv = AC_GetUnsigned(options->args, &r->compression, 0)) != AC_OK) {
+        QERR_MKBADARGS_AC(options->status, "<compression>", rv);
+        goto error;
+      }
+      if (r->compression < 1 || r->compression > MAX_SAMPLE_SIZE) {
+        QERR_MKBADARGS_FMT(options->status, "Invalid compression");
+        goto error;
+      }
+    }
+  } else if (!AC_IsAtEnd(options->args)) {
     if ((rv = AC_GetUnsigned(options->args, &r->resolution, 0)) != AC_OK) {
       QERR_MKBADARGS_AC(options->status, "<resolution>", rv);
       goto error;
@@ -84,6 +128,13 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
   r->base.Free = Reducer_GenericFree;
   r->base.FreeInstance = quantileFreeInstance;
   r->base.Finalize = quantileFinalize;
+  r->base.Merge = quantileMerge;
+  if (r->compression) {
+    r->base.NewInstance = tdigestNewInstance;
+    r->base.FreeInstance = tdigestFreeInstance;
+    r->base.Finalize = tdigestFinalize;
+    r->base.Merge = tdigestMerge;
+  }
   return &r->base;
 
 error:
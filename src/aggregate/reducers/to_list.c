@@ -61,6 +61,20 @@ static RSValue *tolistFinalize(Reducer *rbase, void *ctx) {
   return ret;
 }
 
+static void tolistMerge(Reducer *rbase, void *dst, void *src) {
+  tolistCtx *d = dst, *s = src;
+  TrieMapIterator *it = TrieMap_Iterate(s->values, "", 0);
+  char *c;
+  tm_len_t l;
+  void *ptr;
+  while (TrieMapIterator_Next(it, &c, &l, &ptr)) {
+    if (ptr && TrieMap_Find(d->values, c, l) == TRIEMAP_NOTFOUND) {
+      TrieMap_Add(d->values, c, l, RSValue_IncrRef(ptr), NULL);
+    }
+  }
+  TrieMapIterator_Free(it);
+}
+
 static void freeValues(void *ptr) {
   RSValue_Decref((RSValue *)ptr);
 }
@@ -80,6 +94,7 @@ Reducer *RDCRToList_New(const ReducerOptions *opts) {
   r->Finalize = tolistFinalize;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = tolistFreeInstance;
+  r->Merge = tolistMerge;
   r->NewInstance = tolistNewInstance;
   return r;
 }
@@ -0,0 +1,262 @@
+#include "async_index.h"
+#include "spec.h"
+#include "document.h"
+#include "indexer.h"
+#include "concurrent_ctx.h"
+#include "util/arr.h"
+#include "rmalloc.h"
+#include <sched.h>
+#include <string.h>
+#include <sys/param.h>
+
+// value of an in-flight key whose document must not be written
+#define ASYNC_KEY_STALE 1
+
+static long long elapsedMS(const struct timespec *since) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000 + (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static AsyncIndexQueue *AsyncIndexQueue_New(IndexSpec *spec) {
+  AsyncIndexQueue *q = rm_calloc(1, sizeof(*q));
+  q->spec = spec;
+  q->entries = array_new(AsyncIndexEntry, 64);
+  q->pending = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  q->inflight = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  pthread_mutex_init(&q->lock, NULL);
+  return q;
+}
+
+static void AsyncIndexQueue_Free(AsyncIndexQueue *q) {
+  for (size_t i = q->head; i < array_len(q->entries); ++i) {
+    RedisModule_FreeString(NULL, q->entries[i].key);
+  }
+  array_free(q->entries);
+  dictRelease(q->pending);
+  dictRelease(q->inflight);
+  pthread_mutex_destroy(&q->lock);
+  rm_free(q);
+}
+
+/* Drop the entries which were already handled from the front of the queue */
+static void AsyncIndexQueue_Compact(AsyncIndexQueue *q) {
+  size_t left = array_len(q->entries) - q->head;
+  if (!dictSize(q->pending)) {
+    // the remaining entries were all invalidated
+    for (size_t i = q->head; i < array_len(q->entries); ++i) {
+      RedisModule_FreeString(NULL, q->entries[i].key);
+    }
+    left = 0;
+  } else if (q->head) {
+    memmove(q->entries, q->entries + q->head, left * sizeof(*q->entries));
+  }
+  q->entries = array_trimm_len(q->entries, left);
+  q->head = 0;
+}
+
+/**
+ * Read the documents of the next keys in the queue. Keys which are not indexable anymore are
+ * removed from the index right away. Returns the number of contexts set in `actxs`
+ */
+static size_t AsyncIndexQueue_LoadBatch(AsyncIndexQueue *q, RedisSearchCtx *sctx, Document *docs,
+                                        RSAddDocumentCtx **actxs) {
+  IndexSpec *spec = q->spec;
+  size_t n = 0;
+  bool first = true;
+  while (n < ASYNC_INDEX_BATCH_SIZE && q->head < array_len(q->entries)) {
+    AsyncIndexEntry *e = q->entries + q->head++;
+    if (dictDelete(q->pending, e->key) != DICT_OK) {
+      // invalidated, or queued again and already handled
+      goto next;
+    }
+    if (first) {
+      q->lastBatchLagMS = elapsedMS(&e->enqueued);
+      first = false;
+    }
+
+    Document *doc = docs + n;
+    memset(doc, 0, sizeof(*doc));
+    Document_Init(doc, e->key, 1.0, DEFAULT_LANGUAGE);
+    if (Document_LoadSchemaFields(doc, sctx) != REDISMODULE_OK) {
+      IndexSpec_DeleteHash(spec, sctx->redisCtx, e->key);
+      Document_Free(doc);
+      goto next;
+    }
+
+    QueryError status = {0};
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, doc, &status);
+    if (!aCtx) {
+      ++spec->stats.indexingFailures;
+      QueryError_ClearError(&status);
+      Document_Free(doc);
+      goto next;
+    }
+    aCtx->stateFlags |= ACTX_F_NOBLOCK | ACTX_F_NOFREEDOC;
+    aCtx->options = DOCUMENT_ADD_REPLACE;
+    aCtx->donecb = NULL;
+    aCtx->client.sctx = sctx;
+    Document_MakeStringsOwner(doc);
+
+    dictAdd(q->inflight, e->key, NULL);
+    actxs[n++] = aCtx;
+
+  next:
+    RedisModule_FreeString(NULL, e->key);
+  }
+  AsyncIndexQueue_Compact(q);
+  return n;
+}
+
+/**
+ * Index a single batch of documents: read them with the GIL held, tokenize them without it, and
+ * write them to the index once the GIL is acquired again.
+ */
+static void AsyncIndexQueue_RunBatch(AsyncIndexQueue *q, RedisModuleCtx *ctx) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, q->spec);
+  Document docs[ASYNC_INDEX_BATCH_SIZE];
+  RSAddDocumentCtx *actxs[ASYNC_INDEX_BATCH_SIZE];
+  size_t n = AsyncIndexQueue_LoadBatch(q, &sctx, docs, actxs);
+  if (!n) {
+    return;
+  }
+
+  // the spec cannot be freed while we tokenize, see AsyncIndexQueue_Cancel
+  pthread_mutex_lock(&q->lock);
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
+  for (size_t i = 0; i < n; ++i) {
+    if (AddDocumentCtx_Preprocess(actxs[i]) != REDISMODULE_OK) {
+      actxs[i]->stateFlags |= ACTX_F_ERRORED;
+    }
+  }
+  pthread_mutex_unlock(&q->lock);
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
+
+  if (q->spec) {
+    RSAddDocumentCtx *head = NULL, *tail = NULL;
+    for (size_t i = 0; i < n; ++i) {
+      RSAddDocumentCtx *aCtx = actxs[i];
+      if (aCtx->stateFlags & ACTX_F_ERRORED) {
+        ++q->spec->stats.indexingFailures;
+        continue;
+      }
+      dictEntry *entry = dictFind(q->inflight, aCtx->doc->docKey);
+      if (entry && entry->v.u64 == ASYNC_KEY_STALE) {
+        continue;
+      }
+      aCtx->next = NULL;
+      if (tail) {
+        tail->next = aCtx;
+      } else {
+        head = aCtx;
+      }
+      tail = aCtx;
+      ++q->totalIndexed;
+    }
+    if (head) {
+      Indexer_ProcessBatch(head, &sctx);
+    }
+    ++q->numBatches;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    AddDocumentCtx_Finish(actxs[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    Document_Free(docs + i);
+  }
+  dictEmpty(q->inflight, NULL);
+}
+
+static void AsyncIndexQueue_Process(void *arg) {
+  AsyncIndexQueue *q = arg;
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
+
+  while (q->spec && dictSize(q->pending)) {
+    AsyncIndexQueue_RunBatch(q, ctx);
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx);
+    sched_yield();
+    ConcurrentSearch_ThreadSafeContextLock(ctx);
+  }
+
+  q->scheduled = false;
+  if (!q->spec) {
+    AsyncIndexQueue_Free(q);
+  }
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
+  RedisModule_FreeThreadSafeContext(ctx);
+}
+
+void AsyncIndexQueue_Enqueue(IndexSpec *spec, RedisModuleString *key) {
+  if (!spec->asyncQueue) {
+    spec->asyncQueue = AsyncIndexQueue_New(spec);
+  }
+  AsyncIndexQueue *q = spec->asyncQueue;
+
+  // keyspace notifications may pass a key we cannot keep, so hold a copy of it
+  RedisModuleString *k = RedisModule_CreateStringFromString(NULL, key);
+  if (dictAdd(q->pending, k, NULL) != DICT_OK) {
+    // already queued; its document is read when it is indexed, so it will be up to date
+    RedisModule_FreeString(NULL, k);
+    return;
+  }
+  AsyncIndexEntry e = {.key = k};
+  clock_gettime(CLOCK_MONOTONIC, &e.enqueued);
+  q->entries = array_append(q->entries, e);
+
+  if (!q->scheduled) {
+    // the pools are only started at load time in concurrent mode
+    ConcurrentSearch_ThreadPoolStart();
+    q->scheduled = true;
+    ConcurrentSearch_ThreadPoolRun(AsyncIndexQueue_Process, q, CONCURRENT_POOL_INDEX);
+  }
+}
+
+bool AsyncIndexQueue_Invalidate(AsyncIndexQueue *q, RedisModuleString *key) {
+  bool found = dictDelete(q->pending, key) == DICT_OK;
+  dictEntry *entry = dictFind(q->inflight, key);
+  if (entry) {
+    entry->v.u64 = ASYNC_KEY_STALE;
+    found = true;
+  }
+  return found;
+}
+
+void AsyncIndexQueue_Cancel(AsyncIndexQueue *q) {
+  pthread_mutex_lock(&q->lock);
+  q->spec = NULL;
+  pthread_mutex_unlock(&q->lock);
+  if (!q->scheduled) {
+    AsyncIndexQueue_Free(q);
+  }
+}
+
+size_t AsyncIndexQueue_Depth(const AsyncIndexQueue *q) {
+  return dictSize(q->pending);
+}
+
+long long AsyncIndexQueue_LagMS(const AsyncIndexQueue *q) {
+  for (size_t i = q->head; i < array_len(q->entries); ++i) {
+    if (dictFind((dict *)q->pending, q->entries[i].key)) {
+      return elapsedMS(&q->entries[i].enqueued);
+    }
+  }
+  return 0;
+}
+
+void AsyncIndexQueue_RenderStats(AsyncIndexQueue *q, RedisModuleCtx *ctx) {
+#define REPLY_KVNUM(n, k, v)                   \
+  RedisModule_ReplyWithSimpleString(ctx, k);   \
+  RedisModule_ReplyWithDouble(ctx, (double)v); \
+  n += 2
+
+  int n = 0;
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  REPLY_KVNUM(n, "queue_depth", AsyncIndexQueue_Depth(q));
+  REPLY_KVNUM(n, "lag_ms", AsyncIndexQueue_LagMS(q));
+  REPLY_KVNUM(n, "last_batch_lag_ms", q->lastBatchLagMS);
+  REPLY_KVNUM(n, "docs_indexed", q->totalIndexed);
+  REPLY_KVNUM(n, "batches", q->numBatches);
+  RedisModule_ReplySetArrayLength(ctx, n);
+}
@@ -0,0 +1,71 @@
+#ifndef SRC_ASYNC_INDEX_H_
+#define SRC_ASYNC_INDEX_H_
+
+#include "redismodule.h"
+#include "util/dict.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+// Maximal number of documents read, tokenized and merged into the index at once
+#define ASYNC_INDEX_BATCH_SIZE 256
+
+typedef struct {
+  RedisModuleString *key;
+  struct timespec enqueued;
+} AsyncIndexEntry;
+
+/**
+ * Queue of keys whose documents are waiting to be (re)indexed by the index thread pool.
+ * The queue itself is only accessed with the GIL held. `lock` is held by the worker while it
+ * tokenizes documents without the GIL, so that the spec is not freed under its feet.
+ */
+typedef struct AsyncIndexQueue {
+  struct IndexSpec *spec;  // NULL once the spec is freed
+  AsyncIndexEntry *entries;
+  size_t head;
+
+  // keys waiting in the queue, so that every key is queued at most once
+  dict *pending;
+  // keys of the batch being tokenized. A key which is updated or deleted meanwhile is marked as
+  // stale, and its document is not written to the index
+  dict *inflight;
+
+  pthread_mutex_t lock;
+  bool scheduled;
+
+  size_t totalIndexed;
+  size_t numBatches;
+  long long lastBatchLagMS;
+} AsyncIndexQueue;
+
+/* Queue a key for indexing, creating the spec's queue if needed. Must be called with the GIL */
+void AsyncIndexQueue_Enqueue(struct IndexSpec *spec, RedisModuleString *key);
+
+/**
+ * Forget a queued key, after its document was updated or deleted synchronously. Returns true if
+ * the key was waiting in the queue or being indexed
+ */
+bool AsyncIndexQueue_Invalidate(AsyncIndexQueue *q, RedisModuleString *key);
+
+/* Called when the spec is freed. The queue is released once the worker, if any, is done with it */
+void AsyncIndexQueue_Cancel(AsyncIndexQueue *q);
+
+size_t AsyncIndexQueue_Depth(const AsyncIndexQueue *q);
+
+/* The time the oldest key in the queue is waiting, in milliseconds */
+long long AsyncIndexQueue_LagMS(const AsyncIndexQueue *q);
+
+void AsyncIndexQueue_RenderStats(AsyncIndexQueue *q, RedisModuleCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_ASYNC_INDEX_H_ */
@@ -3,6 +3,8 @@
 #include <unistd.h>
 #include <util/arr.h>
 #include "rmutil/rm_assert.h"
+#include "rwlock.h"
+#include "spec.h"
 
 static threadpool *threadpools_g = NULL;
 
@@ -153,12 +155,23 @@ void ConcurrentSearchCtx_ResetClock(ConcurrentSearchCtx *ctx) {
   ctx->ticker = 0;
 }
 
+// The number of queries in concurrent read mode, which may read the indexes without the GIL
+static size_t readModeQueries = 0;
+
 /** Initialize a concurrent context */
-void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx) {
+void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx, IndexSpec *sp) {
   ctx->ctx = rctx;
   ctx->isLocked = 0;
   ctx->numOpenKeys = 0;
   ctx->openKeys = NULL;
+  ctx->spec = sp;
+  ctx->idsVersion = 0;
+  ctx->readMode = 0;
+  ctx->writeCount = 0;
+  if (sp) {
+    IndexSpec_IncrActiveQueries(sp);
+    ctx->idsVersion = sp->docs.idsVersion;
+  }
   ConcurrentSearchCtx_ResetClock(ctx);
 }
 
@@ -168,6 +181,10 @@ void ConcurrentSearchCtx_InitSingle(ConcurrentSearchCtx *ctx, RedisModuleCtx *rc
   ctx->numOpenKeys = 1;
   ctx->openKeys = rm_calloc(1, sizeof(*ctx->openKeys));
   ctx->openKeys->cb = cb;
+  ctx->spec = NULL;
+  ctx->idsVersion = 0;
+  ctx->readMode = 0;
+  ctx->writeCount = 0;
 }
 
 void ConcurrentSearchCtx_Free(ConcurrentSearchCtx *ctx) {
@@ -183,6 +200,15 @@ void ConcurrentSearchCtx_Free(ConcurrentSearchCtx *ctx) {
 
   rm_free(ctx->openKeys);
   ctx->numOpenKeys = 0;
+
+  if (ctx->readMode) {
+    __atomic_sub_fetch(&readModeQueries, 1, __ATOMIC_RELEASE);
+    ctx->readMode = 0;
+  }
+  if (ctx->spec) {
+    IndexSpec_DecrActiveQueries(ctx->spec);
+    ctx->spec = NULL;
+  }
 }
 
 /* Add a "monitored" key to the context. When keys are open during concurrent execution, they need
@@ -207,14 +233,106 @@ void ConcurrentSearch_AddKey(ConcurrentSearchCtx *ctx, ConcurrentReopenCallback
                                                            .freePrivData = freePrivDataCallback};
 }
 
+void ConcurrentSearch_IndexWriteLock(void) {
+  if (RSGlobalConfig.concurrentReadMode) {
+    RWLOCK_ACQUIRE_WRITE();
+  }
+}
+
+void ConcurrentSearch_IndexWriteUnlock(void) {
+  if (RSGlobalConfig.concurrentReadMode) {
+    RWLOCK_RELEASE();
+  }
+}
+
+int ConcurrentSearch_HasReadModeQueries(void) {
+  return __atomic_load_n(&readModeQueries, __ATOMIC_ACQUIRE) > 0;
+}
+
+void ConcurrentSearch_ThreadSafeContextLock(RedisModuleCtx *ctx) {
+  RedisModule_ThreadSafeContextLock(ctx);
+  ConcurrentSearch_IndexWriteLock();
+}
+
+void ConcurrentSearch_ThreadSafeContextUnlock(RedisModuleCtx *ctx) {
+  ConcurrentSearch_IndexWriteUnlock();
+  RedisModule_ThreadSafeContextUnlock(ctx);
+}
+
+void ConcurrentSearchCtx_SetReadMode(ConcurrentSearchCtx *ctx) {
+  __atomic_add_fetch(&readModeQueries, 1, __ATOMIC_RELAXED);
+  ctx->readMode = 1;
+  ctx->writeCount = RediSearch_LockWriteCount();
+  ctx->isLocked = 1;
+  ConcurrentSearchCtx_ResetClock(ctx);
+}
+
+/* Called with the GIL and the index lock held for reading, after the index lock was released */
+static void concurrentReadReopen(ConcurrentSearchCtx *ctx) {
+  if (RediSearch_LockWriteCount() == ctx->writeCount) {
+    // nothing was written since we released the lock, our iterators are still valid
+    return;
+  }
+  ctx->writeCount = RediSearch_LockWriteCount();
+  if (!ctx->spec->isDropped) {
+    ConcurrentSearchCtx_ReopenKeys(ctx);
+  }
+}
+
+static void concurrentReadLock(ConcurrentSearchCtx *ctx) {
+  RWLOCK_ACQUIRE_READ();
+  if (RediSearch_LockWriteCount() == ctx->writeCount) {
+    return;
+  }
+  // Reopening looks up the keys dictionary which may rehash, so it is done under the GIL. Writers
+  // hold the GIL while waiting for the index lock, so it must be taken first
+  RWLOCK_RELEASE();
+  RedisModule_ThreadSafeContextLock(ctx->ctx);
+  RWLOCK_ACQUIRE_READ();
+  concurrentReadReopen(ctx);
+  RedisModule_ThreadSafeContextUnlock(ctx->ctx);
+}
+
+int ConcurrentSearchCtx_LockGIL(ConcurrentSearchCtx *ctx) {
+  if (!ConcurrentSearchCtx_IsReadMode(ctx)) {
+    return REDISMODULE_OK;
+  }
+  RWLOCK_RELEASE();
+  RedisModule_ThreadSafeContextLock(ctx->ctx);
+  RWLOCK_ACQUIRE_READ();
+  concurrentReadReopen(ctx);
+  if (ctx->spec->isDropped) {
+    RedisModule_ThreadSafeContextUnlock(ctx->ctx);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+void ConcurrentSearchCtx_UnlockGIL(ConcurrentSearchCtx *ctx) {
+  if (ConcurrentSearchCtx_IsReadMode(ctx)) {
+    // accessing the keyspace may modify the indexes, e.g. if it expired a key
+    concurrentReadReopen(ctx);
+    RedisModule_ThreadSafeContextUnlock(ctx->ctx);
+  }
+}
+
 void ConcurrentSearchCtx_Lock(ConcurrentSearchCtx *ctx) {
   RS_LOG_ASSERT(!ctx->isLocked, "Redis GIL shouldn't be locked");
-  RedisModule_ThreadSafeContextLock(ctx->ctx);
+  if (ConcurrentSearchCtx_IsReadMode(ctx)) {
+    concurrentReadLock(ctx);
+    ctx->isLocked = 1;
+    return;
+  }
+  ConcurrentSearch_ThreadSafeContextLock(ctx->ctx);
   ctx->isLocked = 1;
   ConcurrentSearchCtx_ReopenKeys(ctx);
 }
 
 void ConcurrentSearchCtx_Unlock(ConcurrentSearchCtx *ctx) {
-  RedisModule_ThreadSafeContextUnlock(ctx->ctx);
+  if (ConcurrentSearchCtx_IsReadMode(ctx)) {
+    RWLOCK_RELEASE();
+  } else {
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx->ctx);
+  }
   ctx->isLocked = 0;
 }
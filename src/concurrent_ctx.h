@@ -11,6 +11,10 @@
 #define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Concurrent Search Exection Context.
  *
  * We allow queries to run concurrently, each running on its own thread, locking the redis GIL
@@ -44,6 +48,8 @@ typedef struct {
   void (*freePrivData)(void *);
 } ConcurrentKeyCtx;
 
+struct IndexSpec;
+
 /* The concurrent execution context struct itself. See above for details */
 typedef struct {
   long long ticker;
@@ -52,6 +58,15 @@ typedef struct {
   ConcurrentKeyCtx *openKeys;
   uint32_t numOpenKeys;
   uint32_t isLocked;
+  // The index being queried. The query holds on to it until the context is freed, so that it is not
+  // freed nor its documents renumbered meanwhile
+  struct IndexSpec *spec;
+  // the document ids version of the index when the query started
+  uint32_t idsVersion;
+  // In concurrent read mode the context holds the index lock for reading instead of the GIL
+  uint32_t readMode;
+  // the index lock's write count when it was last taken, see RediSearch_LockWriteCount
+  uint64_t writeCount;
 } ConcurrentSearchCtx;
 
 /** The maximal size of the concurrent query thread pool. Since only one thread is operational at a
@@ -122,8 +137,9 @@ void ConcurrentSearch_ThreadPoolRun(void (*func)(void *), void *arg, int type);
  */
 int ConcurrentSearch_CheckTimer(ConcurrentSearchCtx *ctx);
 
-/** Initialize and reset a concurrent search ctx */
-void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx);
+/** Initialize and reset a concurrent search ctx, of a query running on the index `sp` */
+void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx,
+                              struct IndexSpec *sp);
 
 /**
  * Initialize a concurrent context to contain a single key. This key can be swapped
@@ -143,6 +159,36 @@ void ConcurrentSearchCtx_Unlock(ConcurrentSearchCtx *ctx);
 
 void ConcurrentSearchCtx_ReopenKeys(ConcurrentSearchCtx *ctx);
 
+/* Switch a context holding the GIL and the index lock for reading to concurrent read mode. The
+ * GIL should be released by the caller. From now on the context yields the index lock when ticking
+ * rather than the GIL */
+void ConcurrentSearchCtx_SetReadMode(ConcurrentSearchCtx *ctx);
+
+static inline int ConcurrentSearchCtx_IsReadMode(const ConcurrentSearchCtx *ctx) {
+  return ctx && ctx->readMode;
+}
+
+/* Take the GIL in concurrent read mode, for accessing the keyspace. The keys are reopened if the
+ * indexes were modified meanwhile. Returns REDISMODULE_ERR if the index was dropped, in which case
+ * the GIL is not held. Does nothing if the context is not in read mode */
+int ConcurrentSearchCtx_LockGIL(ConcurrentSearchCtx *ctx);
+void ConcurrentSearchCtx_UnlockGIL(ConcurrentSearchCtx *ctx);
+
+/* Take the index lock for writing in concurrent read mode. Everything that modifies the indexes
+ * holds both the GIL and the index lock, so queries running without the GIL never see them
+ * change. Does nothing if concurrent read mode is off */
+void ConcurrentSearch_IndexWriteLock(void);
+void ConcurrentSearch_IndexWriteUnlock(void);
+
+/* Whether any query is running in concurrent read mode. Queries switch to read mode holding the
+ * GIL, so while it is held and this returns 0 no query can read the indexes */
+int ConcurrentSearch_HasReadModeQueries(void);
+
+/* Lock the GIL from a thread which may modify the indexes, taking the index lock for writing as
+ * well in concurrent read mode */
+void ConcurrentSearch_ThreadSafeContextLock(RedisModuleCtx *ctx);
+void ConcurrentSearch_ThreadSafeContextUnlock(RedisModuleCtx *ctx);
+
 struct ConcurrentCmdCtx;
 typedef void (*ConcurrentCmdHandler)(RedisModuleCtx *, RedisModuleString **, int,
                                      struct ConcurrentCmdCtx *);
@@ -201,4 +247,20 @@ static inline int CheckConcurrentSupport(RedisModuleCtx *ctx) {
   return 1;
 }
 
+// Check if a query can run on the search threads without holding the GIL
+static inline int CheckConcurrentReadSupport(RedisModuleCtx *ctx) {
+  if (!RSGlobalConfig.concurrentReadMode) {
+    return 0;
+  }
+  // Blocking the client is not possible in lua and multi, see above
+  if (RedisModule_GetContextFlags && (RedisModule_GetContextFlags(ctx) &
+                                      (REDISMODULE_CTX_FLAGS_LUA | REDISMODULE_CTX_FLAGS_MULTI))) {
+    return 0;
+  }
+  return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
 #endif
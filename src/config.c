@@ -85,6 +85,14 @@ CONFIG_SETTER(setConcurentWriteMode) {
 
 CONFIG_BOOLEAN_GETTER(getConcurentWriteMode, concurrentMode, 0)
 
+// CONCURRENT_READ_MODE
+CONFIG_SETTER(setConcurrentReadMode) {
+  config->concurrentReadMode = 1;
+  return REDISMODULE_OK;
+}
+
+CONFIG_BOOLEAN_GETTER(getConcurrentReadMode, concurrentReadMode, 0)
+
 // NOGC
 CONFIG_SETTER(setNoGc) {
   config->enableGC = 0;
@@ -179,6 +187,20 @@ CONFIG_GETTER(getMaxAggregateResults) {
   return sdscatprintf(ss, "%lu", config->maxAggregateResults);
 }
 
+// MAXDISTINCTMEMORY
+CONFIG_SETTER(setMaxDistinctMemory) {
+  int acrc = AC_GetSize(ac, &config->maxDistinctMemory, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getMaxDistinctMemory) {
+  sds ss = sdsempty();
+  if (!config->maxDistinctMemory) {
+    return sdscatprintf(ss, "unlimited");
+  }
+  return sdscatprintf(ss, "%lu", config->maxDistinctMemory);
+}
+
 // MAXEXPANSIONS MAXPREFIXEXPANSIONS
 CONFIG_SETTER(setMaxExpansions) {
   int acrc = AC_GetLongLong(ac, &config->maxPrefixExpansions, AC_F_GE1);
@@ -264,6 +286,39 @@ CONFIG_GETTER(getGcScanSize) {
   return sdscatprintf(ss, "%lu", config->gcScanSize);
 }
 
+// GC_SLICE_TIME_US
+CONFIG_SETTER(setGcSliceTime) {
+  int acrc = AC_GetSize(ac, &config->gcSliceTimeUS, AC_F_GE1);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getGcSliceTime) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcSliceTimeUS);
+}
+
+// DOCID_COMPACTION_RATIO
+CONFIG_SETTER(setDocIdCompactionRatio) {
+  int acrc = AC_GetSize(ac, &config->docIdCompactionRatio, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getDocIdCompactionRatio) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->docIdCompactionRatio);
+}
+
+// TRIE_FREEZE_THRESHOLD
+CONFIG_SETTER(setTrieFreezeThreshold) {
+  int acrc = AC_GetSize(ac, &config->trieFreezeThreshold, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getTrieFreezeThreshold) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->trieFreezeThreshold);
+}
+
 // MIN_PHONETIC_TERM_LEN
 CONFIG_SETTER(setForkGcInterval) {
   int acrc = AC_GetSize(ac, &config->forkGcRunIntervalSec, AC_F_GE1);
@@ -343,6 +398,18 @@ CONFIG_BOOLEAN_GETTER(getNumericCompress, numericCompress, 0)
 CONFIG_BOOLEAN_SETTER(setPrintProfileClock, printProfileClock)
 CONFIG_BOOLEAN_GETTER(getPrintProfileClock, printProfileClock, 0)
 
+// PERSIST_INDEXES
+CONFIG_BOOLEAN_SETTER(setPersistIndexes, persistIndexes)
+CONFIG_BOOLEAN_GETTER(getPersistIndexes, persistIndexes, 0)
+
+// BLOCK_MAX_PRUNING
+CONFIG_BOOLEAN_SETTER(setBlockMaxPruning, blockMaxPruning)
+CONFIG_BOOLEAN_GETTER(getBlockMaxPruning, blockMaxPruning, 0)
+
+// ASYNC_INDEXING
+CONFIG_BOOLEAN_SETTER(setAsyncIndexing, asyncIndexing)
+CONFIG_BOOLEAN_GETTER(getAsyncIndexing, asyncIndexing, 0)
+
 CONFIG_SETTER(setNumericTreeMaxDepthRange) {
   size_t maxDepthRange;
   int acrc = AC_GetSize(ac, &maxDepthRange, AC_F_GE0);
@@ -369,6 +436,8 @@ CONFIG_SETTER(setGcPolicy) {
     config->gcPolicy = GCPolicy_Fork;
   } else if (!strcasecmp(policy, "LEGACY")) {
     config->gcPolicy = GCPolicy_Sync;
+  } else if (!strcasecmp(policy, "INCREMENTAL")) {
+    config->gcPolicy = GCPolicy_Incremental;
   } else {
     RETURN_ERROR("Invalid GC Policy value");
     return REDISMODULE_ERR;
@@ -529,6 +598,11 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setConcurentWriteMode,
          .getValue = getConcurentWriteMode,
          .flags = RSCONFIGVAR_F_FLAG | RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "CONCURRENT_READ_MODE",
+         .helpText = "Run queries on the search threads without holding the global lock.",
+         .setValue = setConcurrentReadMode,
+         .getValue = getConcurrentReadMode,
+         .flags = RSCONFIGVAR_F_FLAG | RSCONFIGVAR_F_IMMUTABLE},
         {.name = "NOGC",
          .helpText = "Disable garbage collection (for this process)",
          .setValue = setNoGc,
@@ -556,6 +630,11 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "Maximum number of results from ft.aggregate command",
          .setValue = setMaxAggregateResults,
          .getValue = getMaxAggregateResults},
+        {.name = "MAXDISTINCTMEMORY",
+         .helpText = "Memory in bytes a COUNT_DISTINCT reducer may use before it estimates its "
+                     "counts, 0 for unlimited",
+         .setValue = setMaxDistinctMemory,
+         .getValue = getMaxDistinctMemory},
         {.name = "MAXEXPANSIONS",
          .helpText = "Maximum prefix expansions to be used in a query",
          .setValue = setMaxExpansions,
@@ -600,7 +679,7 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setMinPhoneticTermLen,
          .getValue = getMinPhoneticTermLen},
         {.name = "GC_POLICY",
-         .helpText = "gc policy to use (DEFAULT/LEGACY)",
+         .helpText = "gc policy to use (DEFAULT/LEGACY/INCREMENTAL)",
          .setValue = setGcPolicy,
          .getValue = getGcPolicy,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
@@ -618,6 +697,22 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "interval (in seconds) in which to retry running the forkgc after failure.",
          .setValue = setForkGcRetryInterval,
          .getValue = getForkGcRetryInterval},
+        {.name = "GC_SLICE_TIME_US",
+         .helpText = "maximal time (in microseconds) the incremental gc may run at once (relevant "
+                     "only when the incremental gc is used)",
+         .setValue = setGcSliceTime,
+         .getValue = getGcSliceTime},
+        {.name = "DOCID_COMPACTION_RATIO",
+         .helpText = "renumber the documents of an index once its highest document id exceeds this "
+                     "many times the number of documents, 0 to never do it",
+         .setValue = setDocIdCompactionRatio,
+         .getValue = getDocIdCompactionRatio},
+        {.name = "TRIE_FREEZE_THRESHOLD",
+         .helpText = "freeze the term and suggestion tries holding at least this many strings not "
+                     "frozen yet into a compact form, on load or once they stop changing, 0 to "
+                     "never do it",
+         .setValue = setTrieFreezeThreshold,
+         .getValue = getTrieFreezeThreshold},
         {.name = "_MAX_RESULTS_TO_UNSORTED_MODE",
          .helpText = "max results for union interator in which the interator will switch to "
                      "unsorted mode, should be used for debug only.",
@@ -662,6 +757,21 @@ RSConfigOptions RSGlobalConfigOptions = {
                      "for `x` generations.",
          .setValue = setNumericTreeMaxDepthRange,
          .getValue = getNumericTreeMaxDepthRange},
+        {.name = "PERSIST_INDEXES",
+         .helpText = "Save the index contents to rdb so loading does not need to reindex the "
+                     "keyspace.",
+         .setValue = setPersistIndexes,
+         .getValue = getPersistIndexes},
+        {.name = "BLOCK_MAX_PRUNING",
+         .helpText = "Skip index blocks which cannot contain top scoring results of full-text "
+                     "queries. The total number of results becomes a lower bound.",
+         .setValue = setBlockMaxPruning,
+         .getValue = getBlockMaxPruning},
+        {.name = "ASYNC_INDEXING",
+         .helpText = "Index updated hashes in the background, in batches, instead of while "
+                     "the writing command runs.",
+         .setValue = setAsyncIndexing,
+         .getValue = getAsyncIndexing},
         {.name = NULL}}};
 
 void RSConfigOptions_AddConfigs(RSConfigOptions *src, RSConfigOptions *dst) {
@@ -676,6 +786,7 @@ sds RSConfig_GetInfoString(const RSConfig *config) {
   sds ss = sdsempty();
 
   ss = sdscatprintf(ss, "concurrent writes: %s, ", config->concurrentMode ? "ON" : "OFF");
+  ss = sdscatprintf(ss, "concurrent reads: %s, ", config->concurrentReadMode ? "ON" : "OFF");
   ss = sdscatprintf(ss, "gc: %s, ", config->enableGC ? "ON" : "OFF");
   ss = sdscatprintf(ss, "prefix min length: %lld, ", config->minTermPrefix);
   ss = sdscatprintf(ss, "prefix max expansions: %lld, ", config->maxPrefixExpansions);
@@ -11,7 +11,7 @@ typedef enum {
   TimeoutPolicy_Invalid       // Not a real value
 } RSTimeoutPolicy;
 
-typedef enum { GCPolicy_Fork = 0, GCPolicy_Sync } GCPolicy;
+typedef enum { GCPolicy_Fork = 0, GCPolicy_Sync, GCPolicy_Incremental } GCPolicy;
 
 const char *TimeoutPolicy_ToString(RSTimeoutPolicy);
 
@@ -26,6 +26,8 @@ static inline const char *GCPolicy_ToString(GCPolicy policy) {
       return "sync";
     case GCPolicy_Fork:
       return "fork";
+    case GCPolicy_Incremental:
+      return "incremental";
     default:          // LCOV_EXCL_LINE cannot be reached
       return "huh?";  // LCOV_EXCL_LINE cannot be reached
   }
@@ -38,6 +40,8 @@ typedef struct {
   int serverVersion;
   // Use concurrent serach (default: 1, disable with SAFEMODE)
   int concurrentMode;
+  // Run queries on the search thread pool without holding the GIL (default: 0)
+  int concurrentReadMode;
   // If not null, this points at a .so file of an extension we try to load (default: NULL)
   const char *extLoad;
   // Path to friso.ini for chinese dictionary file
@@ -67,6 +71,8 @@ typedef struct {
   size_t maxDocTableSize;
   size_t maxSearchResults;
   size_t maxAggregateResults;
+  // Memory a COUNT_DISTINCT reducer may use before it estimates its counts. 0 means unlimited
+  size_t maxDistinctMemory;
   size_t searchPoolSize;
   size_t indexPoolSize;
   int poolSizeNoAuto;  // Don't auto-detect pool size
@@ -80,6 +86,13 @@ typedef struct {
   size_t forkGcCleanThreshold;
   size_t forkGcRetryInterval;
   size_t forkGcSleepBeforeExit;
+  size_t gcSliceTimeUS;
+  // The GC renumbers the documents of an index once its highest document id exceeds this many
+  // times the number of documents. 0 means never
+  size_t docIdCompactionRatio;
+  // Tries holding at least this many strings in their nodes are frozen on load, and by the GC once
+  // they stop changing. 0 means never
+  size_t trieFreezeThreshold;
 
   // Chained configuration data
   void *chainedConfig;
@@ -97,6 +110,12 @@ typedef struct {
   size_t numericTreeMaxDepthRange;
   // reply with time on profile
   int printProfileClock;
+  // save the index contents to rdb instead of rebuilding them from the keyspace on load
+  int persistIndexes;
+  // skip index blocks which cannot make it into the top results of scored queries
+  int blockMaxPruning;
+  // index hashes updated by keyspace notifications in the background, in batches
+  int asyncIndexing;
 } RSConfig;
 
 typedef enum {
@@ -160,27 +179,33 @@ sds RSConfig_GetInfoString(const RSConfig *config);
 #define CONCURRENT_INDEX_POOL_DEFAULT_SIZE 8
 #define CONCURRENT_INDEX_MAX_POOL_SIZE 200  // Maximum number of threads to create
 #define GC_SCANSIZE 100
+#define DEFAULT_GC_SLICE_TIME_US 1000
 #define DEFAULT_MIN_PHONETIC_TERM_LEN 3
 #define DEFAULT_FORK_GC_RUN_INTERVAL 30
 #define DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE 1000
 #define SEARCH_REQUEST_RESULTS_MAX 1000000
+#define DEFAULT_MAX_DISTINCT_MEMORY (64 << 20)
 #define NR_MAX_DEPTH_BALANCE 2
 
 // default configuration
 #define RS_DEFAULT_CONFIG                                                                         \
   {                                                                                               \
-    .concurrentMode = 0, .extLoad = NULL, .enableGC = 1, .minTermPrefix = 2,                      \
-    .maxPrefixExpansions = 200, .queryTimeoutMS = 500, .timeoutPolicy = TimeoutPolicy_Return,     \
+    .concurrentMode = 0, .concurrentReadMode = 0, .extLoad = NULL, .enableGC = 1,                 \
+    .minTermPrefix = 2, .maxPrefixExpansions = 200, .queryTimeoutMS = 500,                        \
+    .timeoutPolicy = TimeoutPolicy_Return,                                                        \
     .cursorReadSize = 1000, .cursorMaxIdle = 300000, .maxDocTableSize = DEFAULT_DOC_TABLE_SIZE,   \
     .searchPoolSize = CONCURRENT_SEARCH_POOL_DEFAULT_SIZE,                                        \
     .indexPoolSize = CONCURRENT_INDEX_POOL_DEFAULT_SIZE, .poolSizeNoAuto = 0,                     \
     .gcScanSize = GC_SCANSIZE, .minPhoneticTermLen = DEFAULT_MIN_PHONETIC_TERM_LEN,               \
     .gcPolicy = GCPolicy_Fork, .forkGcRunIntervalSec = DEFAULT_FORK_GC_RUN_INTERVAL,              \
-    .forkGcSleepBeforeExit = 0, .maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE, \
+    .forkGcSleepBeforeExit = 0, .gcSliceTimeUS = DEFAULT_GC_SLICE_TIME_US,                        \
+    .docIdCompactionRatio = 0, .trieFreezeThreshold = 0,                                          \
+    .maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE,                             \
     .forkGcRetryInterval = 5, .forkGcCleanThreshold = 100, .noMemPool = 0, .filterCommands = 0,   \
     .maxSearchResults = SEARCH_REQUEST_RESULTS_MAX, .maxAggregateResults = -1,                    \
+    .maxDistinctMemory = DEFAULT_MAX_DISTINCT_MEMORY,                                             \
     .minUnionIterHeap = 20, .numericCompress = false, .numericTreeMaxDepthRange = 0,              \
-    .printProfileClock = 1,                                                                       \
+    .printProfileClock = 1, .persistIndexes = 0, .blockMaxPruning = 0, .asyncIndexing = 0,        \
   }
 
 #define REDIS_ARRAY_LIMIT 7
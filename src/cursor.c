@@ -331,6 +331,14 @@ void Cursors_PurgeWithName(CursorList *cl, const char *lookupName) {
   Cursors_ForEach(cl, purgeCb, info);
 }
 
+size_t Cursors_NumOpen(CursorList *cl, const char *lookupName) {
+  CursorList_Lock(cl);
+  CursorSpecInfo *info = findInfo(cl, lookupName, NULL);
+  size_t used = info ? info->used : 0;
+  CursorList_Unlock(cl);
+  return used;
+}
+
 void CursorList_Destroy(CursorList *cl) {
   Cursors_GCInternal(cl, 1);
   for (khiter_t ii = 0; ii != kh_end(cl->lookup); ++ii) {
@@ -167,6 +167,9 @@ int Cursors_CollectIdle(CursorList *cl);
 /** Remove all cursors with the given lookup name */
 void Cursors_PurgeWithName(CursorList *cl, const char *lookupName);
 
+/** Number of cursors open on the index with the given lookup name */
+size_t Cursors_NumOpen(CursorList *cl, const char *lookupName);
+
 void Cursors_RenderStats(CursorList *cl, const char *key, RedisModuleCtx *ctx);
 
 void Cursor_FreeExecState(void *);
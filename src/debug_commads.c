@@ -6,6 +6,7 @@
 #include "numeric_index.h"
 #include "phonetic_manager.h"
 #include "gc.h"
+#include "docid_compaction.h"
 #include "module.h"
 
 #define DUMP_PHONETIC_HASH "DUMP_PHONETIC_HASH"
@@ -363,6 +364,37 @@ DEBUG_COMMAND(GCForceBGInvoke) {
   return REDISMODULE_OK;
 }
 
+DEBUG_COMMAND(CompactDocIds) {
+  if (argc < 1) {
+    return RedisModule_WrongArity(ctx);
+  }
+  IndexSpec *sp = IndexSpec_Load(ctx, RedisModule_StringPtrLen(argv[0], NULL), 0);
+  if (!sp) {
+    RedisModule_ReplyWithError(ctx, "Unknown index name");
+    return REDISMODULE_OK;
+  }
+  if (!DocIdCompaction_CanRun(sp)) {
+    RedisModule_ReplyWithError(ctx, "Index is in use");
+    return REDISMODULE_OK;
+  }
+  RedisModule_ReplyWithLongLong(ctx, DocIdCompaction_Run(sp));
+  return REDISMODULE_OK;
+}
+
+DEBUG_COMMAND(SetContentEncver) {
+  if (argc < 1) {
+    return RedisModule_WrongArity(ctx);
+  }
+  long long encver;
+  if (RedisModule_StringToLongLong(argv[0], &encver) != REDISMODULE_OK || encver <= 0) {
+    RedisModule_ReplyWithError(ctx, "Bad contents version");
+    return REDISMODULE_OK;
+  }
+  IndexSpec_SetContentEncver(encver);
+  RedisModule_ReplyWithSimpleString(ctx, "OK");
+  return REDISMODULE_OK;
+}
+
 DEBUG_COMMAND(ttl) {
   if (argc < 1) {
     return RedisModule_WrongArity(ctx);
@@ -550,13 +582,10 @@ static void replyDocFlags(const RSDocumentMetadata *dmd, RedisModuleCtx *ctx) {
 }
 
 static void replySortVector(const RSDocumentMetadata *dmd, RedisSearchCtx *sctx) {
-  RSSortingVector *sv = dmd->sortVector;
+  const RSSortingColumns *cols = dmd->sortCols;
   RedisModule_ReplyWithArray(sctx->redisCtx, REDISMODULE_POSTPONED_ARRAY_LEN);
   size_t nelem = 0;
-  for (size_t ii = 0; ii < sv->len; ++ii) {
-    if (!sv->values[ii]) {
-      continue;
-    }
+  for (size_t ii = 0; ii < cols->len; ++ii) {
     RedisModule_ReplyWithArray(sctx->redisCtx, 6);
     RedisModule_ReplyWithSimpleString(sctx->redisCtx, "index");
     RedisModule_ReplyWithLongLong(sctx->redisCtx, ii);
@@ -564,7 +593,8 @@ static void replySortVector(const RSDocumentMetadata *dmd, RedisSearchCtx *sctx)
     const FieldSpec *fs = IndexSpec_GetFieldBySortingIndex(sctx->spec, ii);
     RedisModule_ReplyWithSimpleString(sctx->redisCtx, fs ? fs->name : "!!!???");
     RedisModule_ReplyWithSimpleString(sctx->redisCtx, "value");
-    RSValue_SendReply(sctx->redisCtx, sv->values[ii], 0);
+    RSValue *v = RSSortingColumns_Get(cols, dmd->id, ii);
+    RSValue_SendReply(sctx->redisCtx, v ? v : RS_NullVal(), 0);
     nelem++;
   }
   RedisModule_ReplySetArrayLength(sctx->redisCtx, nelem);
@@ -605,7 +635,7 @@ DEBUG_COMMAND(DocInfo) {
   RedisModule_ReplyWithSimpleString(ctx, "refcount");
   RedisModule_ReplyWithLongLong(ctx, dmd->ref_count);
   nelem += 2;
-  if (dmd->sortVector) {
+  if (dmd->sortCols) {
     RedisModule_ReplyWithSimpleString(ctx, "sortables");
     replySortVector(dmd, sctx);
     nelem += 2;
@@ -633,6 +663,8 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex},
                                {"NUMIDX_SUMMARY", NumericIndexSummary},
                                {"GC_FORCEINVOKE", GCForceInvoke},
                                {"GC_FORCEBGINVOKE", GCForceBGInvoke},
+                               {"COMPACT_DOCIDS", CompactDocIds},
+                               {"SET_CONTENT_ENCVER", SetContentEncver},
                                {"GIT_SHA", GitSha},
                                {"TTL", ttl},
                                {NULL, NULL}};
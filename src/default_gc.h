@@ -33,7 +33,7 @@ typedef struct GarbageCollectorCtx GarbageCollectorCtx;
 GarbageCollectorCtx* NewGarbageCollector(const RedisModuleString *k, float initial_hz, uint64_t spec_unique_id, GCCallbacks* callbacks);
 
 // called externally when the user deletes a document to hint at increasing the HZ
-void GC_OnDelete(void *ctx);
+void GC_OnDelete(void *ctx, t_docId docId);
 
 void GC_OnTerm(void *privdata);
 
@@ -4,32 +4,29 @@
 #include <stdio.h>
 #include "redismodule.h"
 #include "util/fnv.h"
-#include "dep/triemap/triemap.h"
 #include "sortable.h"
 #include "rmalloc.h"
 #include "spec.h"
 #include "config.h"
 #include "rmutil/rm_assert.h"
+#include "rwlock.h"
 
-/* Creates a new DocTable with a given capacity */
+/* Creates a new DocTable with room for `cap` document ids */
 DocTable NewDocTable(size_t cap, size_t max_size) {
   DocTable ret = {
       .size = 1,
-      .cap = cap,
       .maxDocId = 0,
       .memsize = 0,
-      .sortablesSize = 0,
+      .sortables = NULL,
       .maxSize = max_size,
       .dim = NewDocIdMap(),
   };
-  ret.buckets = rm_calloc(cap, sizeof(*ret.buckets));
+  ret.nchunks = (cap >> DOCTABLE_CHUNK_BITS) + 1;
+  ret.chunks = rm_calloc(ret.nchunks, sizeof(*ret.chunks));
+  DocIdBitmap_Init(&ret.live);
   return ret;
 }
 
-static inline uint32_t DocTable_GetBucket(const DocTable *t, t_docId docId) {
-  return docId < t->maxSize ? docId : docId % t->maxSize;
-}
-
 static inline int DocTable_ValidateDocId(const DocTable *t, t_docId docId) {
   return docId != 0 && docId <= t->maxDocId;
 }
@@ -38,39 +35,16 @@ RSDocumentMetadata *DocTable_Get(const DocTable *t, t_docId docId) {
   if (!DocTable_ValidateDocId(t, docId)) {
     return NULL;
   }
-  uint32_t bucketIndex = DocTable_GetBucket(t, docId);
-  if (bucketIndex >= t->cap) {
+  size_t ci = docId >> DOCTABLE_CHUNK_BITS;
+  if (ci >= t->nchunks || !t->chunks[ci]) {
     return NULL;
   }
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  DLLIST2_FOREACH(it, &dmdChain->lroot) {
-    RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (dmd->id == docId) {
-      return dmd;
-    }
-  }
-  return NULL;
+  return t->chunks[ci]->dmds[docId & (DOCTABLE_CHUNK_SIZE - 1)];
 }
 
 int DocTable_Exists(const DocTable *t, t_docId docId) {
-  if (!docId || docId > t->maxDocId) {
-    return 0;
-  }
-  uint32_t ix = DocTable_GetBucket(t, docId);
-  if (ix >= t->cap) {
-    return 0;
-  }
-  const DMDChain *chain = t->buckets + ix;
-  if (chain == NULL) {
-    return 0;
-  }
-  DLLIST2_FOREACH(it, &chain->lroot) {
-    const RSDocumentMetadata *md = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (md->id == docId && !(md->flags & Document_Deleted)) {
-      return 1;
-    }
-  }
-  return 0;
+  const RSDocumentMetadata *md = DocTable_Get(t, docId);
+  return md && !(md->flags & Document_Deleted);
 }
 
 RSDocumentMetadata *DocTable_GetByKeyR(const DocTable *t, RedisModuleString *s) {
@@ -82,29 +56,38 @@ RSDocumentMetadata *DocTable_GetByKeyR(const DocTable *t, RedisModuleString *s)
 }
 
 static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *dmd) {
-  uint32_t bucket = DocTable_GetBucket(t, docId);
-  if (bucket >= t->cap && t->cap < t->maxSize) {
-    /* We have to grow the array capacity.
-     * We only grow till we reach maxSize, then we starts to add the dmds to
-     * the already existing chains.
-     */
-    size_t oldcap = t->cap;
-    // We grow by half of the current capacity with maximum of 1m
-    t->cap += 1 + (t->cap ? MIN(t->cap / 2, 1024 * 1024) : 1);
-    t->cap = MIN(t->cap, t->maxSize);  // make sure we do not excised maxSize
-    t->cap = MAX(t->cap, bucket + 1);  // docs[bucket] needs to be valid, so t->cap > bucket
-    t->buckets = rm_realloc(t->buckets, t->cap * sizeof(DMDChain));
-    
-    // We clear new extra allocation to Null all list pointers
-    size_t memsetSize = (t->cap - oldcap) * sizeof(DMDChain);
-    memset(&t->buckets[oldcap], 0, memsetSize);
-  }
-
-  DMDChain *chain = &t->buckets[bucket];
+  size_t ci = docId >> DOCTABLE_CHUNK_BITS;
+  if (ci >= t->nchunks) {
+    // We grow the chunk pointers by half, so that they are not reallocated too often
+    size_t oldcap = t->nchunks;
+    t->nchunks = MAX(ci + 1, t->nchunks + t->nchunks / 2);
+    t->chunks = rm_realloc(t->chunks, t->nchunks * sizeof(*t->chunks));
+    memset(t->chunks + oldcap, 0, (t->nchunks - oldcap) * sizeof(*t->chunks));
+  }
+  DocTableChunk *chunk = t->chunks[ci];
+  if (!chunk) {
+    chunk = t->chunks[ci] = rm_calloc(1, sizeof(*chunk));
+    t->memsize += sizeof(*chunk);
+  }
+
   DMD_Incref(dmd);
+  if (dmd->score > t->maxScore) {
+    t->maxScore = dmd->score;
+  }
+  chunk->dmds[docId & (DOCTABLE_CHUNK_SIZE - 1)] = dmd;
+  chunk->count++;
+}
 
-  // Adding the dmd to the chain
-  dllist2_append(&chain->lroot, &dmd->llnode);
+/* Remove the document from its chunk, freeing the chunk if it was the last one in it */
+static void DocTable_Unset(DocTable *t, t_docId docId) {
+  size_t ci = docId >> DOCTABLE_CHUNK_BITS;
+  DocTableChunk *chunk = t->chunks[ci];
+  chunk->dmds[docId & (DOCTABLE_CHUNK_SIZE - 1)] = NULL;
+  if (!--chunk->count) {
+    rm_free(chunk);
+    t->chunks[ci] = NULL;
+    t->memsize -= sizeof(*chunk);
+  }
 }
 
 /** Get the docId of a key if it exists in the table, or 0 if it doesnt */
@@ -141,6 +124,17 @@ int DocTable_SetPayload(DocTable *t, t_docId docId, const char *data, size_t len
   return 1;
 }
 
+/* Make the document reference the table's sortable columns, creating them if needed */
+static void DocTable_AttachSortables(DocTable *t, RSDocumentMetadata *dmd) {
+  if (!t->sortables) {
+    t->sortables = NewSortingColumns();
+  }
+  if (!dmd->sortCols) {
+    dmd->sortCols = SortingColumns_Incref(t->sortables);
+  }
+  dmd->flags |= Document_HasSortVector;
+}
+
 /* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done
  */
@@ -149,28 +143,19 @@ int DocTable_SetSortingVector(DocTable *t, t_docId docId, RSSortingVector *v) {
   if (!dmd) {
     return 0;
   }
-
-  // LCOV_EXCL_START
-  /* Null vector means remove the current vector if it exists */
-  /*if (!v) {
-    if (dmd->sortVector) {
-      SortingVector_Free(dmd->sortVector);
-    }
-    dmd->sortVector = NULL;
-    dmd->flags &= ~Document_HasSortVector;
-    return 1;
-  }*/
-  // LCOV_EXCL_STOP
   RS_LOG_ASSERT(v, "Sorting vector does not exist");  // tested in doAssignIds()
 
-  /* Set th new vector and the flags accordingly */
-  dmd->sortVector = v;
-  dmd->flags |= Document_HasSortVector;
-  t->sortablesSize += RSSortingVector_GetMemorySize(v);
-
+  DocTable_AttachSortables(t, dmd);
+  RSSortingColumns_PutVector(dmd->sortCols, docId, v);
+  SortingVector_Free(v);
   return 1;
 }
 
+void DocTable_SetSortable(DocTable *t, RSDocumentMetadata *dmd, int idx, const void *p, int type) {
+  DocTable_AttachSortables(t, dmd);
+  RSSortingColumns_PutRaw(dmd->sortCols, dmd->id, idx, p, type);
+}
+
 int DocTable_SetByteOffsets(DocTable *t, t_docId docId, RSByteOffsets *v) {
   RSDocumentMetadata *dmd = DocTable_Get(t, docId);
   if (!dmd) {
@@ -219,13 +204,14 @@ t_docId DocTable_Put(DocTable *t, const char *s, size_t n, double score, u_char
     dmd->payload = dpl;
     dmd->maxFreq = 1;
     dmd->id = docId;
-    dmd->sortVector = NULL;
+    dmd->sortCols = NULL;
   }
 
   DocTable_Set(t, docId, dmd);
+  DocIdBitmap_Add(&t->live, docId);
   ++t->size;
   t->memsize += sizeof(RSDocumentMetadata) + sdsAllocSize(keyPtr);
-  DocIdMap_Put(&t->dim, s, n, docId);
+  DocIdMap_Put(&t->dim, dmd);
   return docId;
 }
 
@@ -257,16 +243,18 @@ inline float DocTable_GetScore(DocTable *t, t_docId docId) {
   return dmd ? dmd->score : 0;
 }
 
-void DMD_Free(RSDocumentMetadata *md) {
+static void dmdFree(void *p) {
+  RSDocumentMetadata *md = p;
   if (md->payload) {
     rm_free(md->payload->data);
     rm_free(md->payload);
     md->flags &= ~Document_HasPayload;
     md->payload = NULL;
   }
-  if (md->sortVector) {
-    SortingVector_Free(md->sortVector);
-    md->sortVector = NULL;
+  if (md->sortCols) {
+    RSSortingColumns_Clear(md->sortCols, md->id);
+    SortingColumns_Decref(md->sortCols);
+    md->sortCols = NULL;
     md->flags &= ~Document_HasSortVector;
   }
   if (md->byteOffsets) {
@@ -278,27 +266,31 @@ void DMD_Free(RSDocumentMetadata *md) {
   rm_free(md);
 }
 
+void DMD_Free(RSDocumentMetadata *md) {
+  // Clearing the sortable values writes to the index's columns, which other queries may be reading
+  // when running without the GIL
+  RediSearch_LockDeferFree(dmdFree, md);
+}
+
 void DocTable_Free(DocTable *t) {
-  for (int i = 0; i < t->cap; ++i) {
-    DMDChain *chain = &t->buckets[i];
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {
+  for (size_t ci = 0; ci < t->nchunks; ++ci) {
+    DocTableChunk *chunk = t->chunks[ci];
+    if (!chunk) {
       continue;
     }
-    DLLIST2_node *nn = chain->lroot.head;
-    while (nn) {
-      RSDocumentMetadata *md = DLLIST2_ITEM(nn, RSDocumentMetadata, llnode);
-      nn = nn->next;
-      DMD_Free(md);
+    for (size_t ii = 0; ii < DOCTABLE_CHUNK_SIZE; ++ii) {
+      if (chunk->dmds[ii]) {
+        DMD_Free(chunk->dmds[ii]);
+      }
     }
+    rm_free(chunk);
   }
-  rm_free(t->buckets);
+  rm_free(t->chunks);
   DocIdMap_Free(&t->dim);
-}
-
-static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
-  uint32_t bucketIndex = DocTable_GetBucket(t, md->id);
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  dllist2_delete(&dmdChain->lroot, &md->llnode);
+  DocIdBitmap_Free(&t->live);
+  if (t->sortables) {
+    SortingColumns_Decref(t->sortables);
+  }
 }
 
 int DocTable_Delete(DocTable *t, const char *s, size_t n) {
@@ -321,9 +313,13 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
     }
 
     md->flags |= Document_Deleted;
+    if (md->sortCols) {
+      RSSortingColumns_MarkDeleted(md->sortCols, docId);
+    }
 
-    DocTable_DmdUnchain(t, md);
+    DocTable_Unset(t, docId);
     DocIdMap_Delete(&t->dim, s, n);
+    DocIdBitmap_Remove(&t->live, docId);
     --t->size;
 
     return md;
@@ -338,25 +334,94 @@ int DocTable_Replace(DocTable *t, const char *from_str, size_t from_len, const c
     return REDISMODULE_ERR;
   }
   DocIdMap_Delete(&t->dim, from_str, from_len);
-  DocIdMap_Put(&t->dim, to_str, to_len, id);
   RSDocumentMetadata *dmd = DocTable_Get(t, id);
   sdsfree(dmd->keyPtr);
   dmd->keyPtr = sdsnewlen(to_str, to_len);
+  DocIdMap_Put(&t->dim, dmd);
   return REDISMODULE_OK;
 }
 
+void DocTable_Compact(DocTable *t, DocIdRemap *remap) {
+  remap->chunks = t->chunks;
+  remap->nchunks = t->nchunks;
+  RSSortingColumns *oldSortables = t->sortables;
+  t->sortables = NULL;
+  t->nchunks = ((t->size - 1) >> DOCTABLE_CHUNK_BITS) + 1;
+  t->chunks = rm_calloc(t->nchunks, sizeof(*t->chunks));
+  DocIdBitmap_Free(&t->live);
+  DocIdBitmap_Init(&t->live);
+
+  t_docId docId = 0;
+  for (size_t ci = 0; ci < remap->nchunks; ++ci) {
+    DocTableChunk *oldChunk = remap->chunks[ci];
+    if (!oldChunk) {
+      continue;
+    }
+    t->memsize -= sizeof(*oldChunk);
+    for (size_t ii = 0; ii < DOCTABLE_CHUNK_SIZE; ++ii) {
+      RSDocumentMetadata *dmd = oldChunk->dmds[ii];
+      if (!dmd) {
+        continue;
+      }
+      t_docId oldId = dmd->id;
+      dmd->id = ++docId;
+      DocTableChunk **chunk = t->chunks + (docId >> DOCTABLE_CHUNK_BITS);
+      if (!*chunk) {
+        *chunk = rm_calloc(1, sizeof(**chunk));
+        t->memsize += sizeof(**chunk);
+      }
+      (*chunk)->dmds[docId & (DOCTABLE_CHUNK_SIZE - 1)] = dmd;
+      (*chunk)->count++;
+      DocIdBitmap_Add(&t->live, docId);
+
+      if (dmd->sortCols) {
+        // The values are copied to new columns rather than moved, since deleted documents which
+        // are still referenced keep reading theirs from the old columns by their old ids
+        RSSortingColumns *cols = dmd->sortCols;
+        dmd->sortCols = NULL;
+        DocTable_AttachSortables(t, dmd);
+        for (size_t i = 0; i < cols->len; ++i) {
+          RSValue *v = RSSortingColumns_Get(cols, oldId, i);
+          if (v) {
+            RSSortingColumns_Put(dmd->sortCols, docId, i, v);
+          }
+        }
+        RSSortingColumns_Clear(cols, oldId);
+        SortingColumns_Decref(cols);
+      }
+    }
+  }
+  if (oldSortables) {
+    SortingColumns_Decref(oldSortables);
+  }
+  t->maxDocId = docId;
+  ++t->idsVersion;
+}
+
+void DocIdRemap_Free(DocIdRemap *m) {
+  for (size_t ci = 0; ci < m->nchunks; ++ci) {
+    rm_free(m->chunks[ci]);
+  }
+  rm_free(m->chunks);
+  m->chunks = NULL;
+  m->nchunks = 0;
+}
+
 void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
 
   RedisModule_SaveUnsigned(rdb, t->size);
+  RedisModule_SaveUnsigned(rdb, t->maxDocId);
 
   uint32_t elements_written = 0;
-  for (uint32_t i = 0; i < t->cap; ++i) {
-    if (DLLIST2_IS_EMPTY(&t->buckets[i].lroot)) {
-      continue;
-    }
-    DLLIST2_FOREACH(it, &t->buckets[i].lroot) {
-      const RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
+  for (size_t ci = 0; ci < t->nchunks; ++ci) {
+    const DocTableChunk *chunk = t->chunks[ci];
+    for (size_t ii = 0; chunk && ii < DOCTABLE_CHUNK_SIZE; ++ii) {
+      const RSDocumentMetadata *dmd = chunk->dmds[ii];
+      if (!dmd) {
+        continue;
+      }
       RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
+      RedisModule_SaveUnsigned(rdb, dmd->id);
       RedisModule_SaveUnsigned(rdb, dmd->flags);
       RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
       RedisModule_SaveUnsigned(rdb, dmd->len);
@@ -370,9 +435,9 @@ void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
         }
       }
 
-      //      if (dmd->flags & Document_HasSortVector) {
-      //        SortingVector_RdbSave(rdb, dmd->sortVector);
-      //      }
+      if (dmd->flags & Document_HasSortVector) {
+        SortingColumns_RdbSave(rdb, dmd->sortCols, dmd->id);
+      }
 
       if (dmd->flags & Document_HasOffsetVector) {
         Buffer tmp;
@@ -387,6 +452,16 @@ void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
   RS_LOG_ASSERT((elements_written + 1 == t->size), "Wrong number of written elements");
 }
 
+static void DocTable_LoadSortables(DocTable *t, RSDocumentMetadata *dmd, RedisModuleIO *rdb,
+                                   int encver) {
+  DocTable_AttachSortables(t, dmd);
+  if (!SortingColumns_RdbLoad(rdb, dmd->sortCols, dmd->id, encver)) {
+    SortingColumns_Decref(dmd->sortCols);
+    dmd->sortCols = NULL;
+    dmd->flags &= ~Document_HasSortVector;
+  }
+}
+
 void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
   long long deletedElements = 0;
   t->size = RedisModule_LoadUnsigned(rdb);
@@ -397,20 +472,6 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     t->maxSize = MIN(RSGlobalConfig.maxDocTableSize, t->maxDocId);
   }
 
-  if (t->maxDocId > t->maxSize) {
-    /**
-     * If the maximum doc id is greater than the maximum cap size
-     * then it means there is a possibility that any index under maxId can
-     * be accessed. However, it is possible that this bucket does not have
-     * any documents inside it (and thus might not be populated below), but
-     * could still be accessed for simple queries (e.g. get, exist). Ensure
-     * we don't have to rely on Set/Put to ensure the doc table array.
-     */
-    t->cap = t->maxSize;
-    rm_free(t->buckets);
-    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
-  }
-
   for (size_t i = 1; i < t->size; i++) {
     size_t len;
 
@@ -454,10 +515,8 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
         RedisModule_Free(RedisModule_LoadStringBuffer(rdb, NULL));  // throw this string to garbage
       }
     }
-    dmd->sortVector = NULL;
     if (dmd->flags & Document_HasSortVector) {
-      dmd->sortVector = SortingVector_RdbLoad(rdb, encver);
-      t->sortablesSize += RSSortingVector_GetMemorySize(dmd->sortVector);
+      DocTable_LoadSortables(t, dmd, rdb, encver);
     }
 
     if (dmd->flags & Document_HasOffsetVector) {
@@ -473,8 +532,9 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
       ++deletedElements;
       DMD_Free(dmd);
     } else {
-      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
       DocTable_Set(t, dmd->id, dmd);
+      DocIdMap_Put(&t->dim, dmd);
+      DocIdBitmap_Add(&t->live, dmd->id);
       t->memsize += sizeof(RSDocumentMetadata) + len;
     }
   }
@@ -482,78 +542,38 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
 }
 
 void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
-  long long deletedElements = 0;
   size_t size = RedisModule_LoadUnsigned(rdb);
-  //  t->maxDocId = RedisModule_LoadUnsigned(rdb);
-  //  if (encver >= INDEX_MIN_COMPACTED_DOCTABLE_VERSION) {
-  //    t->maxSize = RedisModule_LoadUnsigned(rdb);
-  //  } else {
-  //    t->maxSize = MIN(RSGlobalConfig.maxDocTableSize, t->maxDocId);
-  //  }
-
-  //  if (t->maxDocId > t->maxSize) {
-  //    /**
-  //     * If the maximum doc id is greater than the maximum cap size
-  //     * then it means there is a possibility that any index under maxId can
-  //     * be accessed. However, it is possible that this bucket does not have
-  //     * any documents inside it (and thus might not be populated below), but
-  //     * could still be accessed for simple queries (e.g. get, exist). Ensure
-  //     * we don't have to rely on Set/Put to ensure the doc table array.
-  //     */
-  //    t->cap = t->maxSize;
-  //    rm_free(t->buckets);
-  //    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
-  //  }
+  t->maxDocId = RedisModule_LoadUnsigned(rdb);
 
   for (size_t i = 1; i < size; i++) {
     size_t len;
 
     RSDocumentMetadata *dmd = rm_calloc(1, sizeof(RSDocumentMetadata));
     char *tmpPtr = RedisModule_LoadStringBuffer(rdb, &len);
-    if (encver < INDEX_MIN_BINKEYS_VERSION) {
-      // Previous versions would encode the NUL byte
-      len--;
-    }
-    //    dmd->id = encver < INDEX_MIN_COMPACTED_DOCTABLE_VERSION ? i :
-    //    RedisModule_LoadUnsigned(rdb);
     dmd->keyPtr = sdsnewlen(tmpPtr, len);
     RedisModule_Free(tmpPtr);
 
+    dmd->id = RedisModule_LoadUnsigned(rdb);
     dmd->flags = RedisModule_LoadUnsigned(rdb);
-    dmd->maxFreq = 1;
-    dmd->len = 1;
-    if (encver > 1) {
-      dmd->maxFreq = RedisModule_LoadUnsigned(rdb);
-    }
-    if (encver >= INDEX_MIN_DOCLEN_VERSION) {
-      dmd->len = RedisModule_LoadUnsigned(rdb);
-    } else {
-      // In older versions, default the len to max freq to avoid division by zero.
-      dmd->len = dmd->maxFreq;
-    }
-
+    dmd->maxFreq = RedisModule_LoadUnsigned(rdb);
+    dmd->len = RedisModule_LoadUnsigned(rdb);
     dmd->score = RedisModule_LoadFloat(rdb);
     dmd->payload = NULL;
     // read payload if set
-    if ((dmd->flags & Document_HasPayload)) {
-      if (!(dmd->flags & Document_Deleted)) {
-        dmd->payload = rm_malloc(sizeof(RSPayload));
-        dmd->payload->data = RedisModule_LoadStringBuffer(rdb, &dmd->payload->len);
-        char *buf = rm_malloc(dmd->payload->len);
-        memcpy(buf, dmd->payload->data, dmd->payload->len);
-        RedisModule_Free(dmd->payload->data);
-        dmd->payload->data = buf;
-        dmd->payload->len--;
-        t->memsize += dmd->payload->len + sizeof(RSPayload);
-      } else if ((dmd->flags & Document_Deleted) && (encver == INDEX_MIN_EXPIRE_VERSION)) {
-        RedisModule_Free(RedisModule_LoadStringBuffer(rdb, NULL));  // throw this string to garbage
-      }
+    if (dmd->flags & Document_HasPayload) {
+      dmd->payload = rm_malloc(sizeof(RSPayload));
+      dmd->payload->data = RedisModule_LoadStringBuffer(rdb, &dmd->payload->len);
+      char *buf = rm_malloc(dmd->payload->len);
+      memcpy(buf, dmd->payload->data, dmd->payload->len);
+      RedisModule_Free(dmd->payload->data);
+      dmd->payload->data = buf;
+      dmd->payload->len--;
+      t->memsize += dmd->payload->len + sizeof(RSPayload);
+    }
+
+    if (dmd->flags & Document_HasSortVector) {
+      DocTable_LoadSortables(t, dmd, rdb, encver);
     }
-    dmd->sortVector = NULL;
-    //    if (dmd->flags & Document_HasSortVector) {
-    //      dmd->sortVector = SortingVector_RdbLoad(rdb, encver);
-    //      t->sortablesSize += RSSortingVector_GetMemorySize(dmd->sortVector);
-    //    }
 
     if (dmd->flags & Document_HasOffsetVector) {
       size_t nTmp = 0;
@@ -564,52 +584,107 @@ void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
       RedisModule_Free(tmp);
     }
 
-    if (dmd->flags & Document_Deleted) {
-      DMD_Free(dmd);
-    } else {
-      RedisModuleString *keyRedisStr =
-          RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr));
-      RedisModule_FreeString(NULL, keyRedisStr);
-      //      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
-      //      DocTable_Set(t, dmd->id, dmd);
-      //      t->memsize += sizeof(RSDocumentMetadata) + len;
-    }
+    DocTable_Set(t, dmd->id, dmd);
+    DocIdMap_Put(&t->dim, dmd);
+    DocIdBitmap_Add(&t->live, dmd->id);
+    t->memsize += sizeof(RSDocumentMetadata) + len;
+    ++t->size;
   }
 }
 
-DocIdMap NewDocIdMap() {
+#define DOCIDMAP_MIN_CAP 16
 
-  TrieMap *m = NewTrieMap();
-  return (DocIdMap){m};
+static inline uint32_t DocIdMap_Hash(const char *s, size_t n) {
+  uint64_t h = fnv_64a_buf((void *)s, n, 0);
+  return (uint32_t)(h ^ (h >> 32));
 }
 
-t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
-
-  void *val = TrieMap_Find(m->tm, (char *)s, n);
-  if (val && val != TRIEMAP_NOTFOUND) {
-    return *((t_docId *)val);
+/* The slot holding the key, or the empty slot where it belongs */
+static size_t DocIdMap_Find(const DocIdMap *m, const char *s, size_t n, uint32_t h) {
+  size_t mask = m->cap - 1;
+  for (size_t ii = h & mask;; ii = (ii + 1) & mask) {
+    const RSDocumentMetadata *dmd = m->slots[ii];
+    if (!dmd || (m->hashes[ii] == h && sdslen(dmd->keyPtr) == n && !memcmp(dmd->keyPtr, s, n))) {
+      return ii;
+    }
   }
-  return 0;
 }
 
-void *_docIdMap_replace(void *oldval, void *newval) {
-  if (oldval) {
-    rm_free(oldval);
+static void DocIdMap_Grow(DocIdMap *m) {
+  DocIdMap old = *m;
+  m->cap = old.cap ? old.cap * 2 : DOCIDMAP_MIN_CAP;
+  m->slots = rm_calloc(m->cap, sizeof(*m->slots));
+  m->hashes = rm_malloc(m->cap * sizeof(*m->hashes));
+  size_t mask = m->cap - 1;
+  for (size_t ii = 0; ii < old.cap; ++ii) {
+    if (!old.slots[ii]) {
+      continue;
+    }
+    size_t jj = old.hashes[ii] & mask;
+    while (m->slots[jj]) {
+      jj = (jj + 1) & mask;
+    }
+    m->slots[jj] = old.slots[ii];
+    m->hashes[jj] = old.hashes[ii];
   }
-  return newval;
+  rm_free(old.slots);
+  rm_free(old.hashes);
 }
 
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId) {
+DocIdMap NewDocIdMap() {
+  return (DocIdMap){0};
+}
+
+t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+  if (!m->size) {
+    return 0;
+  }
+  const RSDocumentMetadata *dmd = m->slots[DocIdMap_Find(m, s, n, DocIdMap_Hash(s, n))];
+  return dmd ? dmd->id : 0;
+}
 
-  t_docId *pd = rm_malloc(sizeof(t_docId));
-  *pd = docId;
-  TrieMap_Add(m->tm, (char *)s, n, pd, _docIdMap_replace);
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd) {
+  // keep the load factor under 3/4
+  if ((m->size + 1) * 4 > m->cap * 3) {
+    DocIdMap_Grow(m);
+  }
+  size_t n = sdslen(dmd->keyPtr);
+  uint32_t h = DocIdMap_Hash(dmd->keyPtr, n);
+  size_t ii = DocIdMap_Find(m, dmd->keyPtr, n, h);
+  if (!m->slots[ii]) {
+    m->size++;
+  }
+  m->slots[ii] = dmd;
+  m->hashes[ii] = h;
 }
 
 void DocIdMap_Free(DocIdMap *m) {
-  TrieMap_Free(m->tm, rm_free);
+  rm_free(m->slots);
+  rm_free(m->hashes);
+  *m = (DocIdMap){0};
 }
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n) {
-  return TrieMap_Delete(m->tm, (char *)s, n, rm_free);
+  if (!m->size) {
+    return 0;
+  }
+  size_t ii = DocIdMap_Find(m, s, n, DocIdMap_Hash(s, n));
+  if (!m->slots[ii]) {
+    return 0;
+  }
+  // Shift back the entries after the deleted one which are not in their own slot, so that no
+  // entry is ever separated from its slot by an empty one
+  size_t mask = m->cap - 1;
+  for (size_t jj = (ii + 1) & mask; m->slots[jj]; jj = (jj + 1) & mask) {
+    size_t home = m->hashes[jj] & mask;
+    int between = ii <= jj ? (home > ii && home <= jj) : (home > ii || home <= jj);
+    if (!between) {
+      m->slots[ii] = m->slots[jj];
+      m->hashes[ii] = m->hashes[jj];
+      ii = jj;
+    }
+  }
+  m->slots[ii] = NULL;
+  m->size--;
+  return 1;
 }
@@ -7,6 +7,7 @@
 #include "redisearch.h"
 #include "sortable.h"
 #include "byte_offsets.h"
+#include "docid_bitmap.h"
 #include "rmutil/sds.h"
 #include "util/dict.h"
 
@@ -27,22 +28,35 @@ static inline RedisModuleString *DMD_CreateKeyString(const RSDocumentMetadata *d
   return RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
 }
 
-/* Map between external id an incremental id */
+/* Map between the keys of the documents and their incremental ids. This is an open addressing
+ * hash table of the documents' metadata: the keys are compared with the documents' own keys, so
+ * they are not stored twice */
 typedef struct {
-  TrieMap *tm;
+  // the documents, NULL for empty slots
+  RSDocumentMetadata **slots;
+  // the hash of every document's key, compared before the key itself
+  uint32_t *hashes;
+  // number of slots, a power of 2
+  size_t cap;
+  size_t size;
 } DocIdMap;
 
 DocIdMap NewDocIdMap();
 /* Get docId from a did-map. Returns 0  if the key is not in the map */
 t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n);
 
-/* Put a new doc id in the map if it does not already exist */
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId);
+/* Map the key of the document to its id, replacing any document with the same key. The document's
+ * key must not change while it is in the map */
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd);
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n);
 /* Free the doc id map */
 void DocIdMap_Free(DocIdMap *m);
 
+static inline size_t DocIdMap_MemUsage(const DocIdMap *m) {
+  return m->cap * (sizeof(*m->slots) + sizeof(*m->hashes));
+}
+
 /* The DocTable is a simple mapping between incremental ids and the original document key and
  * metadata. It is also responsible for storing the id incrementor for the index and assigning
  * new
@@ -52,40 +66,55 @@ void DocIdMap_Free(DocIdMap *m);
  * the
  * same key. This may result in document duplication in results  */
 
+#define DOCTABLE_CHUNK_BITS 10
+#define DOCTABLE_CHUNK_SIZE (1 << DOCTABLE_CHUNK_BITS)
+
+/* The documents of DOCTABLE_CHUNK_SIZE consecutive ids */
 typedef struct {
-  DLLIST2 lroot;
-} DMDChain;
+  size_t count;
+  RSDocumentMetadata *dmds[DOCTABLE_CHUNK_SIZE];
+} DocTableChunk;
 
 typedef struct {
   size_t size;
-  // the maximum size this table is allowed to grow to
+  // the maximum size of the legacy hash table layout, only read from old rdb files
   t_docId maxSize;
   t_docId maxDocId;
-  size_t cap;
   size_t memsize;
-  size_t sortablesSize;
-
-  DMDChain *buckets;
+  // sortable values of all the documents, created with the first document which has any
+  RSSortingColumns *sortables;
+  // the highest score any document in the table was given. It never decreases, so it can be used
+  // as an upper bound on document scores
+  float maxScore;
+
+  // the documents indexed by their ids, in chunks. A chunk is freed once all of its documents are
+  // deleted, so the ids of updated documents leave no more than a NULL chunk pointer behind
+  DocTableChunk **chunks;
+  size_t nchunks;
   DocIdMap dim;
+  // the ids of the documents in the table
+  DocIdBitmap live;
+  // incremented whenever DocTable_Compact() renumbers the documents
+  uint32_t idsVersion;
 } DocTable;
 
-/* increasing the ref count of the given dmd */
+/* increasing the ref count of the given dmd. The count is atomic, since queries running without the
+ * GIL in concurrent read mode share the documents */
 #define DMD_Incref(md) \
-  if (md) ++md->ref_count;
-
-#define DOCTABLE_FOREACH(dt, code)                                           \
-  for (size_t i = 0; i < dt->cap; ++i) {                                     \
-    DMDChain *chain = &dt->buckets[i];                                       \
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {                                   \
-      continue;                                                              \
-    }                                                                        \
-    DLLIST2_FOREACH(it, &chain->lroot) {                                     \
-      RSDocumentMetadata *dmd = DLLIST_ITEM(it, RSDocumentMetadata, llnode); \
-      code;                                                                  \
-    }                                                                        \
+  if (md) __atomic_add_fetch(&md->ref_count, 1, __ATOMIC_RELAXED);
+
+#define DOCTABLE_FOREACH(dt, code)                                   \
+  for (size_t ci = 0; ci < (dt)->nchunks; ++ci) {                    \
+    DocTableChunk *chunk = (dt)->chunks[ci];                         \
+    for (size_t i = 0; chunk && i < DOCTABLE_CHUNK_SIZE; ++i) {      \
+      RSDocumentMetadata *dmd = chunk->dmds[i];                      \
+      if (dmd) {                                                     \
+        code;                                                        \
+      }                                                              \
+    }                                                                \
   }
 
-/* Creates a new DocTable with a given capacity */
+/* Creates a new DocTable with room for `cap` document ids */
 DocTable NewDocTable(size_t cap, size_t max_size);
 
 #define DocTable_New(cap) NewDocTable(cap, RSGlobalConfig.maxDocTableSize)
@@ -119,10 +148,18 @@ int DocTable_SetPayload(DocTable *t, t_docId docId, const char *data, size_t len
 
 int DocTable_Exists(const DocTable *t, t_docId docId);
 
-/* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
- * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done */
+/* Set the sortable values of a document from its sorting vector, which is consumed. Returns 1 on
+ * success, 0 if the document does not exist. No further validation is done */
 int DocTable_SetSortingVector(DocTable *t, t_docId docId, RSSortingVector *v);
 
+/* Set a single sortable value of a document, see RSSortingVector_Put */
+void DocTable_SetSortable(DocTable *t, RSDocumentMetadata *dmd, int idx, const void *p, int type);
+
+/* The memory used by the sortable values of the documents in the table */
+static inline size_t DocTable_SortablesSize(const DocTable *t) {
+  return t->sortables ? t->sortables->memsize : 0;
+}
+
 /* Set the offset vector for a document. This contains the byte offsets of each token found in
  * the document. This is used for highlighting
  */
@@ -159,6 +196,31 @@ static inline RSDocumentMetadata *DocTable_PopR(DocTable *t, RedisModuleString *
   return DocTable_Pop(t, s, n);
 }
 
+/* The ids the documents had before DocTable_Compact() renumbered them: the chunks of the table as
+ * they were, still pointing at the documents, which now carry their new ids */
+typedef struct {
+  DocTableChunk **chunks;
+  size_t nchunks;
+} DocIdRemap;
+
+/* Get the new id of a document by its id before the compaction. Returns 0 if it was not in the
+ * table */
+static inline t_docId DocIdRemap_Get(const DocIdRemap *m, t_docId oldId) {
+  size_t ci = oldId >> DOCTABLE_CHUNK_BITS;
+  if (ci >= m->nchunks || !m->chunks[ci]) {
+    return 0;
+  }
+  const RSDocumentMetadata *dmd = m->chunks[ci]->dmds[oldId & (DOCTABLE_CHUNK_SIZE - 1)];
+  return dmd ? dmd->id : 0;
+}
+
+/* Renumber the documents with consecutive ids from 1, in the order of their current ids, and move
+ * their sortable values along. The old ids are kept in `remap` for rewriting the indexes with the
+ * new ones, after which it is released with DocIdRemap_Free() */
+void DocTable_Compact(DocTable *t, DocIdRemap *remap);
+
+void DocIdRemap_Free(DocIdRemap *m);
+
 static inline RSDocumentMetadata *DocTable_GetByKey(DocTable *dt, const char *key) {
   t_docId id = DocTable_GetId(dt, key, strlen(key));
   if (id == 0) {
@@ -176,7 +238,7 @@ void DMD_Free(RSDocumentMetadata *);
 
 /* Decrement the refcount of the DMD object, freeing it if we're the last reference */
 static inline void DMD_Decref(RSDocumentMetadata *dmd) {
-  if (dmd && !--dmd->ref_count) {
+  if (dmd && !__atomic_sub_fetch(&dmd->ref_count, 1, __ATOMIC_ACQ_REL)) {
     DMD_Free(dmd);
   }
 }
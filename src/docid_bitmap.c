@@ -0,0 +1,242 @@
+#include "docid_bitmap.h"
+#include "rmalloc.h"
+#include <string.h>
+#include <sys/param.h>
+
+#define CONTAINER_BITS 16
+#define CONTAINER_WORDS ((1 << CONTAINER_BITS) / 64)
+#define LOW_BITS(docId) ((uint16_t)((docId) & ((1 << CONTAINER_BITS) - 1)))
+
+// a bitset container is turned back into an array once it is this sparse
+#define BITSET_MIN (DOCID_BITMAP_ARRAY_MAX / 2)
+
+void DocIdBitmap_Init(DocIdBitmap *b) {
+  memset(b, 0, sizeof(*b));
+}
+
+void DocIdBitmap_Free(DocIdBitmap *b) {
+  for (size_t i = 0; i < b->len; ++i) {
+    rm_free(b->containers[i].array);
+  }
+  rm_free(b->containers);
+  DocIdBitmap_Init(b);
+}
+
+/* Index of the first container whose key is >= key */
+static size_t findContainer(const DocIdBitmap *b, uint64_t key) {
+  // ids are mostly added in ascending order, so check the last container first
+  if (b->len && b->containers[b->len - 1].key < key) {
+    return b->len;
+  }
+  size_t lo = 0, hi = b->len;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (b->containers[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Index of the first value in an array container which is >= low */
+static uint32_t arrayLowerBound(const DocIdContainer *c, uint16_t low) {
+  if (c->card && c->array[c->card - 1] < low) {
+    return c->card;
+  }
+  uint32_t lo = 0, hi = c->card;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (c->array[mid] < low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static bool containerContains(const DocIdContainer *c, uint16_t low) {
+  if (!c->cap) {
+    return c->bits[low / 64] & (1ULL << (low % 64));
+  }
+  uint32_t i = arrayLowerBound(c, low);
+  return i < c->card && c->array[i] == low;
+}
+
+/* The smallest value in the container which is >= low, or -1 if there is none */
+static int containerNext(const DocIdContainer *c, uint16_t low) {
+  if (c->cap) {
+    uint32_t i = arrayLowerBound(c, low);
+    return i < c->card ? c->array[i] : -1;
+  }
+  size_t w = low / 64;
+  uint64_t word = c->bits[w] & (~0ULL << (low % 64));
+  while (!word) {
+    if (++w == CONTAINER_WORDS) {
+      return -1;
+    }
+    word = c->bits[w];
+  }
+  return w * 64 + __builtin_ctzll(word);
+}
+
+static void arrayToBitset(DocIdContainer *c) {
+  uint64_t *bits = rm_calloc(CONTAINER_WORDS, sizeof(*bits));
+  for (uint32_t i = 0; i < c->card; ++i) {
+    bits[c->array[i] / 64] |= 1ULL << (c->array[i] % 64);
+  }
+  rm_free(c->array);
+  c->bits = bits;
+  c->cap = 0;
+}
+
+static void bitsetToArray(DocIdContainer *c) {
+  uint16_t *array = rm_malloc(BITSET_MIN * sizeof(*array));
+  uint32_t n = 0;
+  for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+    for (uint64_t word = c->bits[w]; word; word &= word - 1) {
+      array[n++] = w * 64 + __builtin_ctzll(word);
+    }
+  }
+  rm_free(c->bits);
+  c->array = array;
+  c->cap = BITSET_MIN;
+}
+
+/* Add a value to a container. Returns false if it was already there */
+static bool containerAdd(DocIdContainer *c, uint16_t low) {
+  if (!c->cap) {
+    uint64_t mask = 1ULL << (low % 64);
+    if (c->bits[low / 64] & mask) {
+      return false;
+    }
+    c->bits[low / 64] |= mask;
+    ++c->card;
+    return true;
+  }
+
+  uint32_t i = arrayLowerBound(c, low);
+  if (i < c->card && c->array[i] == low) {
+    return false;
+  }
+  if (c->card == DOCID_BITMAP_ARRAY_MAX) {
+    arrayToBitset(c);
+    return containerAdd(c, low);
+  }
+  if (c->card == c->cap) {
+    c->cap = MIN(c->cap * 2, DOCID_BITMAP_ARRAY_MAX);
+    c->array = rm_realloc(c->array, c->cap * sizeof(*c->array));
+  }
+  memmove(c->array + i + 1, c->array + i, (c->card - i) * sizeof(*c->array));
+  c->array[i] = low;
+  ++c->card;
+  return true;
+}
+
+/* Remove a value from a container. Returns false if it was not there */
+static bool containerRemove(DocIdContainer *c, uint16_t low) {
+  if (!c->cap) {
+    uint64_t mask = 1ULL << (low % 64);
+    if (!(c->bits[low / 64] & mask)) {
+      return false;
+    }
+    c->bits[low / 64] &= ~mask;
+    if (--c->card < BITSET_MIN) {
+      bitsetToArray(c);
+    }
+    return true;
+  }
+
+  uint32_t i = arrayLowerBound(c, low);
+  if (i == c->card || c->array[i] != low) {
+    return false;
+  }
+  memmove(c->array + i, c->array + i + 1, (c->card - i - 1) * sizeof(*c->array));
+  --c->card;
+  return true;
+}
+
+void DocIdBitmap_Add(DocIdBitmap *b, t_docId docId) {
+  uint64_t key = docId >> CONTAINER_BITS;
+  size_t i = findContainer(b, key);
+  if (i == b->len || b->containers[i].key != key) {
+    if (b->len == b->cap) {
+      b->cap = b->cap ? b->cap * 2 : 4;
+      b->containers = rm_realloc(b->containers, b->cap * sizeof(*b->containers));
+    }
+    memmove(b->containers + i + 1, b->containers + i, (b->len - i) * sizeof(*b->containers));
+    ++b->len;
+    DocIdContainer *c = b->containers + i;
+    c->key = key;
+    c->card = 0;
+    c->cap = 4;
+    c->array = rm_malloc(c->cap * sizeof(*c->array));
+  }
+  if (containerAdd(b->containers + i, LOW_BITS(docId))) {
+    ++b->card;
+  }
+}
+
+void DocIdBitmap_Remove(DocIdBitmap *b, t_docId docId) {
+  uint64_t key = docId >> CONTAINER_BITS;
+  size_t i = findContainer(b, key);
+  if (i == b->len || b->containers[i].key != key) {
+    return;
+  }
+  DocIdContainer *c = b->containers + i;
+  if (!containerRemove(c, LOW_BITS(docId))) {
+    return;
+  }
+  --b->card;
+  if (!c->card) {
+    rm_free(c->array);
+    memmove(c, c + 1, (b->len - i - 1) * sizeof(*c));
+    --b->len;
+  }
+}
+
+bool DocIdBitmap_Contains(const DocIdBitmap *b, t_docId docId) {
+  uint64_t key = docId >> CONTAINER_BITS;
+  size_t i = findContainer(b, key);
+  return i < b->len && b->containers[i].key == key &&
+         containerContains(b->containers + i, LOW_BITS(docId));
+}
+
+t_docId DocIdBitmap_Next(const DocIdBitmap *b, t_docId docId, size_t *hint) {
+  uint64_t key = docId >> CONTAINER_BITS;
+  size_t i = *hint;
+  // the hint is only used if it is the right container. Containers may have been added or removed
+  // since it was set, but their keys tell whether it is
+  if (i >= b->len || b->containers[i].key != key) {
+    i = findContainer(b, key);
+  }
+
+  int low = -1;
+  if (i < b->len && b->containers[i].key == key) {
+    low = containerNext(b->containers + i, LOW_BITS(docId));
+    if (low < 0) {
+      ++i;
+    }
+  }
+  if (low < 0) {
+    if (i >= b->len) {
+      *hint = b->len;
+      return 0;
+    }
+    // the first value of the next container
+    low = containerNext(b->containers + i, 0);
+  }
+  *hint = i;
+  return (b->containers[i].key << CONTAINER_BITS) | low;
+}
+
+size_t DocIdBitmap_MemorySize(const DocIdBitmap *b) {
+  size_t sz = b->cap * sizeof(*b->containers);
+  for (size_t i = 0; i < b->len; ++i) {
+    const DocIdContainer *c = b->containers + i;
+    sz += c->cap ? c->cap * sizeof(*c->array) : CONTAINER_WORDS * sizeof(*c->bits);
+  }
+  return sz;
+}
@@ -0,0 +1,67 @@
+#ifndef SRC_DOCID_BITMAP_H_
+#define SRC_DOCID_BITMAP_H_
+
+#include "redisearch.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A compressed set of document ids, used to keep the ids of the documents which are alive in an
+ * index. Like a roaring bitmap, the ids are split by their upper bits into containers of 64K ids.
+ * A container holds a sorted array of the lower 16 bits of its ids while it is sparse, and a
+ * bitset of 8KB once it has more than DOCID_BITMAP_ARRAY_MAX ids.
+ */
+
+#define DOCID_BITMAP_ARRAY_MAX 4096
+
+typedef struct {
+  // the upper bits of the ids in the container
+  uint64_t key;
+  uint32_t card;
+  // capacity of the array, or 0 for a bitset container
+  uint32_t cap;
+  union {
+    uint16_t *array;
+    uint64_t *bits;
+  };
+} DocIdContainer;
+
+typedef struct {
+  // sorted by key. Containers are never empty
+  DocIdContainer *containers;
+  size_t len;
+  size_t cap;
+  size_t card;
+} DocIdBitmap;
+
+void DocIdBitmap_Init(DocIdBitmap *b);
+
+void DocIdBitmap_Free(DocIdBitmap *b);
+
+void DocIdBitmap_Add(DocIdBitmap *b, t_docId docId);
+
+void DocIdBitmap_Remove(DocIdBitmap *b, t_docId docId);
+
+bool DocIdBitmap_Contains(const DocIdBitmap *b, t_docId docId);
+
+/**
+ * Returns the smallest id in the set which is >= docId, or 0 if there is none. `hint` is the index
+ * of the container the previous call ended at. It is kept by the caller between calls so that
+ * consecutive lookups do not search the containers, and it remains valid when the set changes.
+ */
+t_docId DocIdBitmap_Next(const DocIdBitmap *b, t_docId docId, size_t *hint);
+
+static inline size_t DocIdBitmap_Cardinality(const DocIdBitmap *b) {
+  return b->card;
+}
+
+size_t DocIdBitmap_MemorySize(const DocIdBitmap *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_DOCID_BITMAP_H_ */
@@ -0,0 +1,113 @@
+#include <sys/param.h>
+#include "docid_compaction.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "cursor.h"
+#include "config.h"
+#include "time_sample.h"
+#include "util/dict.h"
+
+bool DocIdCompaction_IsDue(const IndexSpec *sp) {
+  size_t ratio = RSGlobalConfig.docIdCompactionRatio;
+  size_t ndocs = sp->docs.size - 1;
+  t_docId maxDocId = sp->docs.maxDocId;
+  return ratio && maxDocId >= ndocs + DOCID_COMPACTION_MIN_RECLAIMED && maxDocId > ratio * ndocs;
+}
+
+bool DocIdCompaction_CanRun(const IndexSpec *sp) {
+  // indexes kept in the keyspace are not reachable from the spec
+  if (!sp->keysDict) {
+    return false;
+  }
+  // every query holds on to the index through its concurrent context, whether or not it yields
+  return __atomic_load_n(&sp->activeQueries, __ATOMIC_SEQ_CST) <= 0 &&
+         !Cursors_NumOpen(&RSCursors, sp->name);
+}
+
+/* Renumber a single inverted index, adding what was collected from it to `total` */
+static IndexRepairParams renumberIndex(InvertedIndex *idx, const DocIdRemap *remap,
+                                       IndexRepairParams *total) {
+  IndexRepairParams params = {0};
+  InvertedIndex_Renumber(idx, remap, &params);
+  total->docsCollected += params.docsCollected;
+  total->bytesBeforFix += params.bytesBeforFix;
+  total->bytesAfterFix += params.bytesAfterFix;
+  return params;
+}
+
+static void renumberNumericTree(NumericRangeTree *rt, const DocIdRemap *remap, t_docId maxDocId,
+                                IndexRepairParams *total) {
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    if (!node->range) {
+      continue;
+    }
+    IndexRepairParams params = renumberIndex(node->range->entries, remap, total);
+    node->range->invertedIndexSize += params.bytesAfterFix - params.bytesBeforFix;
+    rt->numEntries -= params.docsCollected;
+  }
+  NumericRangeTreeIterator_Free(iter);
+
+  // the cached bitmaps hold the old ids, and iterators paused over the tree must stop
+  NumericRangeTree_ClearBitmaps(rt);
+  ++rt->revisionId;
+  rt->lastDocId = MIN(rt->lastDocId, maxDocId);
+}
+
+static void renumberTagIndex(TagIndex *tagIdx, const DocIdRemap *remap, IndexRepairParams *total) {
+  TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+  char *ptr;
+  tm_len_t len;
+  void *value;
+  while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+    renumberIndex(value, remap, total);
+  }
+  TrieMapIterator_Free(iter);
+}
+
+size_t DocIdCompaction_Run(IndexSpec *sp) {
+  DocTable *dt = &sp->docs;
+  t_docId oldMaxDocId = dt->maxDocId;
+  DocIdRemap remap;
+  DocTable_Compact(dt, &remap);
+
+  IndexRepairParams total = {0};
+  dictIterator *iter = dictGetIterator(sp->keysDict);
+  dictEntry *entry;
+  while ((entry = dictNext(iter))) {
+    KeysDictValue *kdv = dictGetVal(entry);
+    if (kdv->dtor == InvertedIndex_Free) {
+      renumberIndex(kdv->p, &remap, &total);
+    } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+      renumberNumericTree(kdv->p, &remap, dt->maxDocId, &total);
+    } else if (kdv->dtor == TagIndex_Free) {
+      renumberTagIndex(kdv->p, &remap, &total);
+    }
+  }
+  dictReleaseIterator(iter);
+  DocIdRemap_Free(&remap);
+
+  sp->stats.numRecords -= total.docsCollected;
+  sp->stats.invertedSize += total.bytesAfterFix - total.bytesBeforFix;
+  // the records of the deleted documents were dropped along the way
+  if (sp->gc) {
+    GCContext_OnCompact(sp->gc);
+  }
+  return oldMaxDocId - dt->maxDocId;
+}
+
+void DocIdCompaction_RunIfDue(RedisModuleCtx *ctx, IndexSpec *sp) {
+  if (!DocIdCompaction_IsDue(sp) || !DocIdCompaction_CanRun(sp)) {
+    return;
+  }
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  size_t reclaimed = DocIdCompaction_Run(sp);
+  TimeSampler_End(&ts);
+  RedisModule_Log(ctx, "notice",
+                  "Compacted the document ids of index %s: %zu ids reclaimed for %zu documents "
+                  "in %lldms",
+                  sp->name, reclaimed, sp->docs.size - 1, TimeSampler_DurationMS(&ts));
+}
@@ -0,0 +1,44 @@
+#ifndef SRC_DOCID_COMPACTION_H_
+#define SRC_DOCID_COMPACTION_H_
+
+#include "redismodule.h"
+#include "spec.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Document ids are never reused: an updated document is given a new id, so the ids of an index
+ * which is updated often grow with the number of updates rather than with the number of documents,
+ * and so does the work of the iterators walking the id space.
+ *
+ * Compaction renumbers the documents of an index with consecutive ids, keeping their order, and
+ * rewrites the inverted indexes of its terms, numeric and tag fields with the new ids, dropping the
+ * records of deleted documents along the way. It runs at once with the GIL and the index lock
+ * held, so that queries never see the index half renumbered. Paused readers could not resume
+ * from their positions, so compaction does not start while any query uses the index, including
+ * those paused in cursors. A query which finds the ids renumbered anyway fails with an error.
+ */
+
+// an index is not compacted for less than this many ids
+#define DOCID_COMPACTION_MIN_RECLAIMED 1024
+
+/* Whether the ids of the index are sparse enough to be compacted, per DOCID_COMPACTION_RATIO */
+bool DocIdCompaction_IsDue(const IndexSpec *sp);
+
+/* Whether nothing holds on to the current ids of the documents of the index */
+bool DocIdCompaction_CanRun(const IndexSpec *sp);
+
+/* Renumber the documents of the index and rewrite its inverted indexes with the new ids. The caller
+ * checks DocIdCompaction_CanRun() first. Returns the number of ids reclaimed */
+size_t DocIdCompaction_Run(IndexSpec *sp);
+
+/* Compact the index if it is due and nothing prevents it. Called by the GC, with the GIL held */
+void DocIdCompaction_RunIfDue(RedisModuleCtx *ctx, IndexSpec *sp);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
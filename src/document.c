@@ -560,9 +560,8 @@ void IndexerBulkCleanup(IndexBulkData *cur, RedisSearchCtx *sctx) {
   }
 }
 
-int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
+int AddDocumentCtx_Preprocess(RSAddDocumentCtx *aCtx) {
   Document *doc = aCtx->doc;
-  int ourRv = REDISMODULE_OK;
 
   for (size_t i = 0; i < doc->numFields; i++) {
     const FieldSpec *fs = aCtx->fspecs + i;
@@ -581,21 +580,30 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
 
       PreprocessorFunc pp = preprocessorMap[ii];
       if (pp(aCtx, &doc->fields[i], fs, fdata, &aCtx->status) != 0) {
-        if (!AddDocumentCtx_IsBlockable(aCtx)) {
-          ++aCtx->spec->stats.indexingFailures;
-        } else {
-          RedisModule_ThreadSafeContextLock(RSDummyContext);
-          IndexSpec *spec = IndexSpec_Load(RSDummyContext, aCtx->specName, 0);
-          if (spec && aCtx->specId == spec->uniqueId) {
-            ++spec->stats.indexingFailures;
-          }
-          RedisModule_ThreadSafeContextUnlock(RSDummyContext);
-        }
-        ourRv = REDISMODULE_ERR;
-        goto cleanup;
+        return REDISMODULE_ERR;
       }
     }
   }
+  return REDISMODULE_OK;
+}
+
+int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
+  int ourRv = REDISMODULE_OK;
+
+  if (AddDocumentCtx_Preprocess(aCtx) != REDISMODULE_OK) {
+    if (!AddDocumentCtx_IsBlockable(aCtx)) {
+      ++aCtx->spec->stats.indexingFailures;
+    } else {
+      ConcurrentSearch_ThreadSafeContextLock(RSDummyContext);
+      IndexSpec *spec = IndexSpec_Load(RSDummyContext, aCtx->specName, 0);
+      if (spec && aCtx->specId == spec->uniqueId) {
+        ++spec->stats.indexingFailures;
+      }
+      ConcurrentSearch_ThreadSafeContextUnlock(RSDummyContext);
+    }
+    ourRv = REDISMODULE_ERR;
+    goto cleanup;
+  }
 
   if (Indexer_Add(aCtx->indexer, aCtx) != 0) {
     ourRv = REDISMODULE_ERR;
@@ -693,6 +701,9 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
 
   // Update the score
   md->score = doc->score;
+  if (md->score > sctx->spec->docs.maxScore) {
+    sctx->spec->docs.maxScore = md->score;
+  }
   // Set the payload if needed
   if (doc->payload) {
     DocTable_SetPayload(&sctx->spec->docs, docId, doc->payload, doc->payloadSize);
@@ -717,24 +728,20 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
       int idx = IndexSpec_GetFieldSortingIndex(sctx->spec, f->name, strlen(f->name));
       if (idx < 0) continue;
 
-      if (!md->sortVector) {
-        md->sortVector = NewSortingVector(sctx->spec->sortables->len);
-      }
-
       RS_LOG_ASSERT((fs->options & FieldSpec_Dynamic) == 0, "Dynamic field cannot use PARTIAL");
 
       switch (fs->types) {
         case INDEXFLD_T_FULLTEXT:
         case INDEXFLD_T_TAG:
-          RSSortingVector_Put(md->sortVector, idx, (void *)RedisModule_StringPtrLen(f->text, NULL),
-                              RS_SORTABLE_STR);
+          DocTable_SetSortable(&sctx->spec->docs, md, idx,
+                               (void *)RedisModule_StringPtrLen(f->text, NULL), RS_SORTABLE_STR);
           break;
         case INDEXFLD_T_NUMERIC: {
           double numval;
           if (RedisModule_StringToDouble(f->text, &numval) == REDISMODULE_ERR) {
             BAIL("Could not parse numeric index value");
           }
-          RSSortingVector_Put(md->sortVector, idx, &numval, RS_SORTABLE_NUM);
+          DocTable_SetSortable(&sctx->spec->docs, md, idx, &numval, RS_SORTABLE_NUM);
           break;
         }
         default:
@@ -291,6 +291,13 @@ void AddDocumentCtx_Finish(RSAddDocumentCtx *aCtx);
  */
 int Document_AddToIndexes(RSAddDocumentCtx *ctx);
 
+/**
+ * Run the field preprocessors on the document: tokenize the text fields into the forward index
+ * and parse the other fields. Nothing is written to the index, so this can be called without
+ * holding the GIL. Returns REDISMODULE_ERR (and sets the context's status) if a field is invalid
+ */
+int AddDocumentCtx_Preprocess(RSAddDocumentCtx *aCtx);
+
 /**
  * Free the AddDocumentCtx. Should be done once AddToIndexes() completes; or
  * when the client is unblocked.
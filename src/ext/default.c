@@ -13,6 +13,8 @@
 #include "../stemmer.h"
 #include "../phonetic_manager.h"
 #include "../score_explain.h"
+#include "../extension.h"
+#include "../inverted_index.h"
 
 /******************************************************************************************
  *
@@ -114,6 +116,12 @@ static inline double tfIdfInternal(const ScoringFunctionArgs *ctx, const RSIndex
   return tfidf;
 }
 
+/* Upper bound of a single term's TF-IDF. TF is normalized by a value which is never smaller than the
+ * term's frequency in the document (max frequency or document length), so it is at most 1 */
+static double TFIDFBound(const RSIndexStats *stats, double idf, double weight, uint32_t maxFreq) {
+  return weight * idf;
+}
+
 /* Calculate sum(TF-IDF)*document score for each result, where TF is normalized by maximum frequency
  * in this document*/
 static double TFIDFScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *h,
@@ -202,6 +210,18 @@ static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
   return score;
 }
 
+/* Upper bound of a single term's BM25, which grows with the term frequency. The term weight is
+ * not part of the per-term score */
+static double BM25Bound(const RSIndexStats *stats, double idf, double weight, uint32_t maxFreq) {
+  static const float b = 0.5;
+  static const float k1 = 1.2;
+  if (maxFreq == INDEX_BLOCK_MAXFREQ_UNKNOWN) {
+    return idf;
+  }
+  double f = (double)maxFreq;
+  return idf * f / (f + k1 * (1.0f - b + b * stats->avgDocLen));
+}
+
 /******************************************************************************************
  *
  * Raw document-score scorer. Just returns the document score
@@ -519,6 +539,10 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
     return REDISEARCH_ERR;
   }
 
+  if (Ext_SetScoreBoundFunction(DEFAULT_SCORER_NAME, TFIDFBound) == REDISEARCH_ERR) {
+    return REDISEARCH_ERR;
+  }
+
   /* DisMax-alike scorer */
   if (ctx->RegisterScoringFunction(DISMAX_SCORER_NAME, DisMaxScorer, NULL, NULL) ==
       REDISEARCH_ERR) {
@@ -529,6 +553,9 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
   if (ctx->RegisterScoringFunction(BM25_SCORER_NAME, BM25Scorer, NULL, NULL) == REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
+  if (Ext_SetScoreBoundFunction(BM25_SCORER_NAME, BM25Bound) == REDISEARCH_ERR) {
+    return REDISEARCH_ERR;
+  }
 
   /* Register HAMMING scorer */
   if (ctx->RegisterScoringFunction(HAMMINGDISTANCE_SCORER, HammingDistanceScorer, NULL, NULL) ==
@@ -540,6 +567,9 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
       REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
+  if (Ext_SetScoreBoundFunction(TFIDF_DOCNORM_SCORER_NAME, TFIDFBound) == REDISEARCH_ERR) {
+    return REDISEARCH_ERR;
+  }
 
   /* Register DOCSCORE scorer */
   if (ctx->RegisterScoringFunction(DOCSCORE_SCORER, DocScoreScorer, NULL, NULL) == REDISEARCH_ERR) {
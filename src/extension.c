@@ -53,6 +53,7 @@ int Ext_RegisterScoringFunction(const char *alias, RSScoringFunction func, RSFre
   ctx->privdata = privdata;
   ctx->ff = ff;
   ctx->sf = func;
+  ctx->bf = NULL;
 
   /* Make sure that two scorers are never registered under the same name */
   if (TrieMap_Find(scorers_g, (char *)alias, strlen(alias)) != TRIEMAP_NOTFOUND) {
@@ -64,6 +65,19 @@ int Ext_RegisterScoringFunction(const char *alias, RSScoringFunction func, RSFre
   return REDISEARCH_OK;
 }
 
+/* Set the score bound function of a registered scorer */
+int Ext_SetScoreBoundFunction(const char *alias, ExtScoreBoundFunction bf) {
+  if (scorers_g == NULL) {
+    return REDISEARCH_ERR;
+  }
+  ExtScoringFunctionCtx *ctx = TrieMap_Find(scorers_g, (char *)alias, strlen(alias));
+  if (!ctx || (void *)ctx == TRIEMAP_NOTFOUND) {
+    return REDISEARCH_ERR;
+  }
+  ctx->bf = bf;
+  return REDISEARCH_OK;
+}
+
 /* Register a aquery expander */
 int Ext_RegisterQueryExpander(const char *alias, RSQueryTokenExpander exp, RSFreeFunction ff,
                               void *privdata) {
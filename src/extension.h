@@ -11,11 +11,19 @@ void Extensions_Init();
 /* clear the extensions list */
 void Extensions_Free();
 
+/* An upper bound on the score a single query term with the given idf and weight can contribute to
+ * a document, given that the term appears in it at most maxFreq times. The bound must hold before
+ * the document score and the slop are applied. Used for dynamic pruning of top-k queries */
+typedef double (*ExtScoreBoundFunction)(const RSIndexStats *stats, double idf, double weight,
+                                        uint32_t maxFreq);
+
 /* Context for saving a scoring function and its private data and free */
 typedef struct {
   RSScoringFunction sf;
   RSFreeFunction ff;
   void *privdata;
+  // optional, NULL if the scorer cannot be bounded
+  ExtScoreBoundFunction bf;
 } ExtScoringFunctionCtx;
 
 /* Context for saving the a token expander and its free / privdata */
@@ -25,6 +33,10 @@ typedef struct {
   void *privdata;
 } ExtQueryExpanderCtx;
 
+/* Set the score bound function of a registered scorer. Returns REDISEARCH_ERR if no such scorer
+ * exists */
+int Ext_SetScoreBoundFunction(const char *alias, ExtScoreBoundFunction bf);
+
 /* Get a scoring function by name. Returns NULL if no such scoring function exists */
 ExtScoringFunctionCtx *Extensions_GetScoringFunction(ScoringFunctionArgs *fnargs, const char *name);
 
@@ -44,9 +44,9 @@ static int __attribute__((warn_unused_result)) FGC_lock(ForkGC *gc, RedisModuleC
       return 0;
     }
   } else {
-    RedisModule_ThreadSafeContextLock(ctx);
+    ConcurrentSearch_ThreadSafeContextLock(ctx);
     if (gc->deleting) {
-      RedisModule_ThreadSafeContextUnlock(ctx);
+      ConcurrentSearch_ThreadSafeContextUnlock(ctx);
       return 0;
     }
   }
@@ -57,7 +57,7 @@ static void FGC_unlock(ForkGC *gc, RedisModuleCtx *ctx) {
   if (gc->type == FGC_TYPE_NOKEYSPACE) {
     RWLOCK_RELEASE();
   } else {
-    RedisModule_ThreadSafeContextUnlock(ctx);
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx);
   }
 }
 
@@ -72,6 +72,12 @@ static RedisSearchCtx *FGC_getSctx(ForkGC *gc, RedisModuleCtx *ctx) {
   return sctx;
 }
 
+/* Whether the index is the one the child scanned, with the same document ids */
+static bool FGC_isScannedSpec(ForkGC *gc, RedisSearchCtx *sctx) {
+  return sctx && sctx->spec->uniqueId == gc->specUniqueId &&
+         sctx->spec->docs.idsVersion == gc->idsVersion;
+}
+
 static void FGC_updateStats(RedisSearchCtx *sctx, ForkGC *gc, size_t recordsRemoved,
                             size_t bytesCollected) {
   sctx->spec->stats.numRecords -= recordsRemoved;
@@ -184,6 +190,7 @@ typedef struct {
 
 typedef struct {
   void *ptr;       // Address of the buffer to free
+  void *skips;     // Address of the skip pointers to free
   uint32_t oldix;  // Old index of deleted block
   uint32_t _pad;   // Uninitialized reads, otherwise
 } MSG_DeletedBlock;
@@ -220,9 +227,10 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
       continue;
     }
 
-    // Capture the pointer address before the block is cleared; otherwise
-    // the pointer might be freed!
+    // Capture the pointer addresses before the block is cleared; otherwise
+    // the pointers might be freed!
     void *bufptr = blk->buf.data;
+    void *skipsptr = blk->skips;
     int nrepaired = IndexBlock_Repair(blk, &sctx->spec->docs, idx->flags, params);
     // We couldn't repair the block - return 0
     if (nrepaired == -1) {
@@ -236,7 +244,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     if (blk->numDocs == 0) {
       // this block should be removed
       MSG_DeletedBlock *delmsg = array_ensure_tail(&deleted, MSG_DeletedBlock);
-      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .oldix = i};
+      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .skips = skipsptr, .oldix = i};
     } else {
       blocklist = array_append(blocklist, *blk);
       MSG_RepairedBlock *fixmsg = array_ensure_tail(&fixed, MSG_RepairedBlock);
@@ -277,6 +285,8 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     const IndexBlock *blk = blocklist + msg->newix;
     FGC_sendFixed(gc, msg, sizeof(*msg));
     FGC_sendBuffer(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    // the skip pointers were rebuilt by the child, so they are sent along with the data
+    FGC_sendBuffer(gc, blk->skips, blk->numSkips * sizeof(*blk->skips));
   }
   rv = true;
 
@@ -511,11 +521,19 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
 
 static void FGC_childScanIndexes(ForkGC *gc) {
   RedisSearchCtx *sctx = FGC_getSctx(gc, gc->ctx);
-  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
-    // write log here
+  // several indexes share the pipe, so tell the parent whether this one was scanned at all
+  int scanned = sctx && sctx->spec->uniqueId == gc->specUniqueId;
+  FGC_SEND_VAR(gc, scanned);
+  if (!scanned) {
+    if (sctx) {
+      SearchCtx_Free(sctx);
+    }
     return;
   }
 
+  uint32_t idsVersion = sctx->spec->docs.idsVersion;
+  FGC_SEND_VAR(gc, idsVersion);
+
   FGC_childCollectTerms(gc, sctx);
   FGC_childCollectNumeric(gc, sctx);
   FGC_childCollectTags(gc, sctx);
@@ -544,6 +562,11 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
     return REDISMODULE_ERR;
   }
   b->cap = b->offset;
+  size_t skipsLen;
+  if (FGC_recvBuffer(gc, (void **)&binfo->blk.skips, &skipsLen) != REDISMODULE_OK) {
+    rm_free(b->data);
+    return REDISMODULE_ERR;
+  }
   return REDISMODULE_OK;
 }
 
@@ -576,7 +599,7 @@ FGC_recvInvIdx(ForkGC *gc, InvIdxBuffers *bufs, MSG_IndexInfo *info) {
 error:
   rm_free(bufs->newBlocklist);
   for (size_t ii = 0; ii < nblocksRecvd; ++ii) {
-    rm_free(bufs->changedBlocks[ii].blk.buf.data);
+    indexBlock_Free(&bufs->changedBlocks[ii].blk);
   }
   rm_free(bufs->changedBlocks);
   memset(bufs, 0, sizeof(*bufs));
@@ -590,7 +613,7 @@ static void freeInvIdx(InvIdxBuffers *bufs, MSG_IndexInfo *info) {
   if (bufs->changedBlocks) {
     // could be null because of pipe error
     for (size_t ii = 0; ii < info->nblocksRepaired; ++ii) {
-      rm_free(bufs->changedBlocks[ii].blk.buf.data);
+      indexBlock_Free(&bufs->changedBlocks[ii].blk);
     }
   }
   rm_free(bufs->changedBlocks);
@@ -654,6 +677,7 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
     // Blocks that were deleted entirely:
     MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
     rm_free(delinfo->ptr);
+    rm_free(delinfo->skips);
   }
   rm_free(idxData->delBlocks);
 
@@ -743,7 +767,7 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
 
   hasLock = 1;
   sctx = FGC_getSctx(gc, rctx);
-  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+  if (!FGC_isScannedSpec(gc, sctx)) {
     status = FGC_PARENT_ERROR;
     goto cleanup;
   }
@@ -942,7 +966,7 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc, RedisModuleCtx *rctx) {
 
     hasLock = 1;
     sctx = FGC_getSctx(gc, rctx);
-    if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    if (!FGC_isScannedSpec(gc, sctx)) {
       status = FGC_PARENT_ERROR;
       goto loop_cleanup;
     }
@@ -961,6 +985,7 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc, RedisModuleCtx *rctx) {
     }
 
     applyNumIdx(gc, sctx, &ninfo);
+    NumericRangeTree_ClearBitmaps(rt);
 
   loop_cleanup:
     if (sctx) {
@@ -1025,7 +1050,7 @@ static FGCError FGC_parentHandleTags(ForkGC *gc, RedisModuleCtx *rctx) {
 
     hasLock = 1;
     sctx = FGC_getSctx(gc, rctx);
-    if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    if (!FGC_isScannedSpec(gc, sctx)) {
       status = FGC_PARENT_ERROR;
       goto loop_cleanup;
     }
@@ -1064,6 +1089,16 @@ static FGCError FGC_parentHandleTags(ForkGC *gc, RedisModuleCtx *rctx) {
 
 int FGC_parentHandleFromChild(ForkGC *gc) {
   FGCError status = FGC_COLLECTED;
+  int scanned;
+  if (FGC_recvFixed(gc, &scanned, sizeof scanned) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if (!scanned) {
+    return REDISMODULE_OK;
+  }
+  if (FGC_recvFixed(gc, &gc->idsVersion, sizeof gc->idsVersion) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
 
 #define COLLECT_FROM_CHILD(e)               \
   while ((status = (e)) == FGC_COLLECTED) { \
@@ -1095,12 +1130,50 @@ static int FGC_fork(ForkGC *gc, RedisModuleCtx *ctx) {
   }
 }
 
+static int periodicCb(RedisModuleCtx *ctx, void *privdata);
+
+static bool FGC_isDue(const ForkGC *gc) {
+  return gc->deletedDocsFromLastRun >= RSGlobalConfig.forkGcCleanThreshold;
+}
+
+/**
+ * Collect the fork GCs of all the other indexes in the keyspace which are due for a run, so that
+ * a single fork scans them all. Must be called with the GIL held.
+ * All the GCs run on the same thread, so the ones collected cannot be freed before the batch is
+ * done; a GC which is killed meanwhile is skipped by FGC_lock when the results are applied.
+ */
+static ForkGC **FGC_collectBatch(ForkGC *gc) {
+  ForkGC **batch = array_new(ForkGC *, 1);
+  batch = array_append(batch, gc);
+  if (gc->type != FGC_TYPE_INKEYSPACE) {
+    return batch;
+  }
+
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry;
+  while ((entry = dictNext(iter))) {
+    IndexSpec *sp = dictGetVal(entry);
+    if (!sp->gc || sp->gc->stopped || sp->gc->callbacks.periodicCallback != periodicCb) {
+      continue;
+    }
+    ForkGC *other = sp->gc->gcCtx;
+    if (other == gc || other->type != FGC_TYPE_INKEYSPACE || other->deleting ||
+        other->pauseState != FGC_PAUSED_UNPAUSED || !other->deletedDocsFromLastRun ||
+        !FGC_isDue(other)) {
+      continue;
+    }
+    batch = array_append(batch, other);
+  }
+  dictReleaseIterator(iter);
+  return batch;
+}
+
 static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
   ForkGC *gc = privdata;
   if (gc->deleting) {
     return 0;
   }
-  if (gc->deletedDocsFromLastRun < RSGlobalConfig.forkGcCleanThreshold) {
+  if (!FGC_isDue(gc)) {
     return 1;
   }
 
@@ -1111,16 +1184,16 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
   // Check if RDB is loading - not needed after the first time we find out that rdb is not
   // reloading
   if (gc->rdbPossiblyLoading && !gc->sp) {
-    RedisModule_ThreadSafeContextLock(ctx);
+    ConcurrentSearch_ThreadSafeContextLock(ctx);
     if (isRdbLoading(ctx)) {
       RedisModule_Log(ctx, "notice", "RDB Loading in progress, not performing GC");
-      RedisModule_ThreadSafeContextUnlock(ctx);
+      ConcurrentSearch_ThreadSafeContextUnlock(ctx);
       return 1;
     } else {
       // the RDB will not load again, so it's safe to ignore the info check in the next cycles
       gc->rdbPossiblyLoading = 0;
     }
-    RedisModule_ThreadSafeContextUnlock(ctx);
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx);
   }
 
   pid_t cpid;
@@ -1139,13 +1212,13 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
 
   if (gc->type == FGC_TYPE_NOKEYSPACE) {
     // If we are not in key space we still need to acquire the GIL to use the fork api
-    RedisModule_ThreadSafeContextLock(ctx);
+    ConcurrentSearch_ThreadSafeContextLock(ctx);
   }
 
   if (!FGC_lock(gc, ctx)) {
 
     if (gc->type == FGC_TYPE_NOKEYSPACE) {
-      RedisModule_ThreadSafeContextUnlock(ctx);
+      ConcurrentSearch_ThreadSafeContextUnlock(ctx);
     }
 
     close(gc->pipefd[GC_READERFD]);
@@ -1156,27 +1229,36 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
 
   gc->execState = FGC_STATE_SCANNING;
 
+  ForkGC **batch = FGC_collectBatch(gc);
+
   cpid = FGC_fork(gc, ctx);  // duplicate the current process
 
   if (cpid == -1) {
     gc->retryInterval.tv_sec = RSGlobalConfig.forkGcRetryInterval;
 
     if (gc->type == FGC_TYPE_NOKEYSPACE) {
-      RedisModule_ThreadSafeContextUnlock(ctx);
+      ConcurrentSearch_ThreadSafeContextUnlock(ctx);
     }
 
     FGC_unlock(gc, ctx);
 
     close(gc->pipefd[GC_READERFD]);
     close(gc->pipefd[GC_WRITERFD]);
+    array_free(batch);
 
     return 1;
   }
 
-  gc->deletedDocsFromLastRun = 0;
+  // the deletions each index is collected for, taken off its count once it is actually collected
+  size_t *deleted = array_new(size_t, array_len(batch));
+  for (size_t i = 0; i < array_len(batch); ++i) {
+    deleted = array_append(deleted, batch[i]->deletedDocsFromLastRun);
+    batch[i]->pipefd[GC_READERFD] = gc->pipefd[GC_READERFD];
+    batch[i]->pipefd[GC_WRITERFD] = gc->pipefd[GC_WRITERFD];
+  }
 
   if (gc->type == FGC_TYPE_NOKEYSPACE) {
-    RedisModule_ThreadSafeContextUnlock(ctx);
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx);
   }
 
   FGC_unlock(gc, ctx);
@@ -1199,7 +1281,9 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
       if (getppid() != ppid_before_fork) exit(1);
     }
 #endif
-    FGC_childScanIndexes(gc);
+    for (size_t i = 0; i < array_len(batch); ++i) {
+      FGC_childScanIndexes(batch[i]);
+    }
     close(gc->pipefd[GC_WRITERFD]);
     sleep(RSGlobalConfig.forkGcSleepBeforeExit);
     _exit(EXIT_SUCCESS);
@@ -1213,21 +1297,34 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
     }
 
     gc->execState = FGC_STATE_APPLYING;
-    if (FGC_parentHandleFromChild(gc) == REDISMODULE_ERR) {
-      gcrv = 1;
+    size_t ncollected = 0;
+    for (; ncollected < array_len(batch); ++ncollected) {
+      // the rest of the pipe cannot be parsed after an error
+      if (FGC_parentHandleFromChild(batch[ncollected]) == REDISMODULE_ERR) {
+        break;
+      }
+    }
+    if (FGC_lock(gc, ctx)) {
+      // documents deleted while the fork ran are left for the next run
+      for (size_t i = 0; i < ncollected; ++i) {
+        batch[i]->deletedDocsFromLastRun -= MIN(deleted[i], batch[i]->deletedDocsFromLastRun);
+      }
+      FGC_unlock(gc, ctx);
     }
     close(gc->pipefd[GC_READERFD]);
     if (FGC_haveRedisFork()) {
 
       if (gc->type == FGC_TYPE_NOKEYSPACE) {
         // If we are not in key space we still need to acquire the GIL to use the fork api
-        RedisModule_ThreadSafeContextLock(ctx);
+        ConcurrentSearch_ThreadSafeContextLock(ctx);
       }
 
       if (!FGC_lock(gc, ctx)) {
         if (gc->type == FGC_TYPE_NOKEYSPACE) {
-          RedisModule_ThreadSafeContextUnlock(ctx);
+          ConcurrentSearch_ThreadSafeContextUnlock(ctx);
         }
+        array_free(batch);
+        array_free(deleted);
 
         return 0;
       }
@@ -1238,7 +1335,7 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
       RedisModule_KillForkChild(cpid);
 
       if (gc->type == FGC_TYPE_NOKEYSPACE) {
-        RedisModule_ThreadSafeContextUnlock(ctx);
+        ConcurrentSearch_ThreadSafeContextUnlock(ctx);
       }
 
       FGC_unlock(gc, ctx);
@@ -1255,9 +1352,17 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
 
   long long msRun = TimeSampler_DurationMS(&ts);
 
-  gc->stats.numCycles++;
-  gc->stats.totalMSRun += msRun;
-  gc->stats.lastRunTimeMs = msRun;
+  for (size_t i = 0; i < array_len(batch); ++i) {
+    ForkGC *cur = batch[i];
+    cur->stats.numCycles++;
+    cur->stats.totalMSRun += msRun;
+    cur->stats.lastRunTimeMs = msRun;
+    if (cur != gc) {
+      cur->stats.numBatchedCycles++;
+    }
+  }
+  array_free(batch);
+  array_free(deleted);
 
   return gcrv;
 }
@@ -1325,6 +1430,7 @@ static void statsCb(RedisModuleCtx *ctx, void *gcCtx) {
     REPLY_KVNUM(n, "last_run_time_ms", (double)gc->stats.lastRunTimeMs);
     REPLY_KVNUM(n, "gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
     REPLY_KVNUM(n, "gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+    REPLY_KVNUM(n, "gc_batched_cycles", (double)gc->stats.numBatchedCycles);
   }
   RedisModule_ReplySetArrayLength(ctx, n);
 }
@@ -1334,7 +1440,7 @@ static void killCb(void *ctx) {
   gc->deleting = 1;
 }
 
-static void deleteCb(void *ctx) {
+static void deleteCb(void *ctx, t_docId docId) {
   ForkGC *gc = ctx;
   ++gc->deletedDocsFromLastRun;
 }
@@ -22,6 +22,8 @@ typedef struct {
 
   uint64_t gcNumericNodesMissed;
   uint64_t gcBlocksDenied;
+  // number of cycles in which the index was collected by the fork of another index
+  uint64_t numBatchedCycles;
 } ForkGCStats;
 
 typedef enum FGCType { FGC_TYPE_INKEYSPACE, FGC_TYPE_NOKEYSPACE } FGCType;
@@ -40,6 +42,9 @@ typedef struct ForkGC {
   FGCType type;
 
   uint64_t specUniqueId;
+  // version of the document ids of the index the child scanned. Its results do not apply once the
+  // documents are renumbered
+  uint32_t idsVersion;
 
   // statistics for reporting
   ForkGCStats stats;
@@ -5,11 +5,15 @@
 #include "gc.h"
 #include "fork_gc.h"
 #include "default_gc.h"
+#include "incremental_gc.h"
+#include "docid_compaction.h"
+#include "search_ctx.h"
 #include "config.h"
 #include "redismodule.h"
 #include "rmalloc.h"
 #include "module.h"
 #include "spec.h"
+#include "concurrent_ctx.h"
 #include "dep/thpool/thpool.h"
 #include "rmutil/rm_assert.h"
 
@@ -42,10 +46,15 @@ GCContext* GCContext_CreateGCFromSpec(IndexSpec* sp, float initialHZ, uint64_t u
 
 GCContext* GCContext_CreateGC(RedisModuleString* keyName, float initialHZ, uint64_t uniqueId) {
   GCContext* ret = rm_calloc(1, sizeof(GCContext));
+  ret->keyName = RedisModule_CreateStringFromString(NULL, keyName);
+  ret->specUniqueId = uniqueId;
   switch (RSGlobalConfig.gcPolicy) {
     case GCPolicy_Fork:
       ret->gcCtx = FGC_New(keyName, uniqueId, &ret->callbacks);
       break;
+    case GCPolicy_Incremental:
+      ret->gcCtx = IGC_New(keyName, uniqueId, &ret->callbacks);
+      break;
     case GCPolicy_Sync:
     default:
       ret->gcCtx = NewGarbageCollector(keyName, initialHZ, uniqueId, &ret->callbacks);
@@ -76,6 +85,23 @@ static RedisModuleTimerID scheduleNext(GCTask *task) {
   return RedisModule_CreateTimer(RSDummyContext, period, timerCallback, task);
 }
 
+/* Work on the index as a whole, done on every run of the GC with the GIL held */
+static void maintainIndex(RedisModuleCtx *ctx, GCContext *gc) {
+  RedisSearchCtx *sctx = NewSearchCtx(ctx, gc->keyName, false);
+  if (!sctx) {
+    return;
+  }
+  IndexSpec *sp = sctx->spec;
+  if (sp->uniqueId == gc->specUniqueId) {
+    DocIdCompaction_RunIfDue(ctx, sp);
+    if (Trie_FreezeIfIdle(sp->terms, RSGlobalConfig.trieFreezeThreshold)) {
+      RedisModule_Log(ctx, "verbose", "Froze the %zu terms of index %s", sp->terms->size,
+                      sp->name);
+    }
+  }
+  SearchCtx_Free(sctx);
+}
+
 static void threadCallback(void* data) {
   GCTask* task= data;
   GCContext* gc = task->gc;
@@ -84,9 +110,9 @@ static void threadCallback(void* data) {
 
   if (gc->stopped) {
     if (bc && bc != DEADBEEF) {
-      RedisModule_ThreadSafeContextLock(ctx);
+      ConcurrentSearch_ThreadSafeContextLock(ctx);
       RedisModule_UnblockClient(bc, NULL);
-      RedisModule_ThreadSafeContextUnlock(ctx); 
+      ConcurrentSearch_ThreadSafeContextUnlock(ctx); 
     }
     rm_free(task);
     return;
@@ -94,7 +120,10 @@ static void threadCallback(void* data) {
 
   int ret = gc->callbacks.periodicCallback(ctx, gc->gcCtx);
 
-  RedisModule_ThreadSafeContextLock(ctx);
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
+  if (ret && !gc->stopped && gc->keyName) {
+    maintainIndex(ctx, gc);
+  }
   if (bc) { 
     if (bc != DEADBEEF) {
       RedisModule_UnblockClient(bc, NULL);
@@ -112,7 +141,7 @@ static void threadCallback(void* data) {
   gc->timerID = scheduleNext(task);
 
 end:
-  RedisModule_ThreadSafeContextUnlock(ctx);
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
 }
 
 static void destroyCallback(void* data) {
@@ -120,10 +149,13 @@ static void destroyCallback(void* data) {
   RedisModuleCtx* ctx = RSDummyContext;
   assert(gc->stopped == 1);
 
-  RedisModule_ThreadSafeContextLock(ctx);  
+  ConcurrentSearch_ThreadSafeContextLock(ctx);  
   gc->callbacks.onTerm(gc->gcCtx);
+  if (gc->keyName) {
+    RedisModule_FreeString(NULL, gc->keyName);
+  }
   rm_free(gc);
-  RedisModule_ThreadSafeContextUnlock(ctx);
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
 }
 
 static void timerCallback(RedisModuleCtx* ctx, void* data) {
@@ -171,9 +203,15 @@ void GCContext_RenderStats(GCContext* gc, RedisModuleCtx* ctx) {
   gc->callbacks.renderStats(ctx, gc->gcCtx);
 }
 
-void GCContext_OnDelete(GCContext* gc) {
+void GCContext_OnDelete(GCContext* gc, t_docId docId) {
   if (gc->callbacks.onDelete) {
-    gc->callbacks.onDelete(gc->gcCtx);
+    gc->callbacks.onDelete(gc->gcCtx, docId);
+  }
+}
+
+void GCContext_OnCompact(GCContext* gc) {
+  if (gc->callbacks.onCompact) {
+    gc->callbacks.onCompact(gc->gcCtx);
   }
 }
 
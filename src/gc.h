@@ -3,6 +3,7 @@
 #define SRC_GC_H_
 
 #include "redismodule.h"
+#include "redisearch.h"
 #include "util/dllist.h"
 #include <time.h>
 
@@ -15,7 +16,9 @@ struct IndexSpec;
 typedef struct GCCallbacks {
   int (*periodicCallback)(RedisModuleCtx* ctx, void* gcCtx);
   void (*renderStats)(RedisModuleCtx* ctx, void* gc);
-  void (*onDelete)(void* ctx);
+  void (*onDelete)(void* ctx, t_docId docId);
+  // the document ids of the index were renumbered, so the deleted ids the GC holds are stale
+  void (*onCompact)(void* ctx);
   void (*onTerm)(void* ctx);
 
   // Send a "kill signal" to the GC, requesting it to terminate asynchronously
@@ -28,6 +31,10 @@ typedef struct GCContext {
   RedisModuleTimerID timerID;
   GCCallbacks callbacks;
   int stopped;
+  // the index, for compacting its document ids after collecting it. NULL if it is not in the
+  // keyspace
+  RedisModuleString* keyName;
+  uint64_t specUniqueId;
 } GCContext;
 
 typedef struct GCTask {
@@ -41,7 +48,8 @@ GCContext* GCContext_CreateGC(RedisModuleString* keyName, float initialHZ, uint6
 void GCContext_Start(GCContext* gc);
 void GCContext_Stop(GCContext* gc);
 void GCContext_RenderStats(GCContext* gc, RedisModuleCtx* ctx);
-void GCContext_OnDelete(GCContext* gc);
+void GCContext_OnDelete(GCContext* gc, t_docId docId);
+void GCContext_OnCompact(GCContext* gc);
 void GCContext_ForceInvoke(GCContext* gc, RedisModuleBlockedClient* bc);
 void GCContext_ForceBGInvoke(GCContext* gc);
 
@@ -3,14 +3,55 @@
 #include "rmutil/util.h"
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
+#include "util/minmax.h"
+#include <math.h>
 
 static double extractUnitFactor(GeoDistance unit);
 
+/* Parse the corners of a box, following the BOX keyword */
+static int parseBox(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  static const char *names[] = {"<min lon>", "<min lat>", "<max lon>", "<max lat>"};
+  for (size_t ii = 0; ii < 4; ++ii) {
+    int rv;
+    if ((rv = AC_GetDouble(ac, &gf->box[ii], 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(status, names[ii], rv);
+      return REDISMODULE_ERR;
+    }
+  }
+  gf->shape = GEO_SHAPE_BOX;
+  return GeoFilter_Validate(gf, status) ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+/* Parse the number of vertices of a polygon and their lon/lat, following the POLYGON keyword */
+static int parsePolygon(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  size_t npoints;
+  int rv;
+  if ((rv = AC_GetSize(ac, &npoints, AC_F_GE1)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<num vertices>", rv);
+    return REDISMODULE_ERR;
+  }
+  if (AC_NumRemaining(ac) < npoints * 2) {
+    QERR_MKBADARGS_FMT(status, "POLYGON requires %zu coordinates", npoints * 2);
+    return REDISMODULE_ERR;
+  }
+  gf->shape = GEO_SHAPE_POLYGON;
+  gf->points = rm_malloc(npoints * 2 * sizeof(*gf->points));
+  gf->npoints = npoints;
+  for (size_t ii = 0; ii < npoints * 2; ++ii) {
+    if ((rv = AC_GetDouble(ac, &gf->points[ii], 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(status, ii % 2 ? "<lat>" : "<lon>", rv);
+      return REDISMODULE_ERR;
+    }
+  }
+  return GeoFilter_Validate(gf, status) ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0], and FILTER
  * is not passed to us.
  * The GEO filter syntax is (FILTER) <property> LONG LAT DIST m|km|ft|mi
  * Returns REDISMODUEL_OK or ERR  */
 int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_RADIUS;
   gf->lat = 0;
   gf->lon = 0;
   gf->radius = 0;
@@ -28,6 +69,13 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
   } else {
     gf->property = rm_strdup(gf->property);
   }
+
+  if (AC_AdvanceIfMatch(ac, "BOX")) {
+    return parseBox(gf, ac, status);
+  } else if (AC_AdvanceIfMatch(ac, "POLYGON")) {
+    return parsePolygon(gf, ac, status);
+  }
+
   if ((rv = AC_GetDouble(ac, &gf->lon, 0) != AC_OK)) {
     QERR_MKBADARGS_AC(status, "<lon>", rv);
     return REDISMODULE_ERR;
@@ -54,13 +102,9 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
 
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->property) rm_free((char *)gf->property);
-  if (gf->numericFilters) {
-    for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
-      if (gf->numericFilters[i])
-        NumericFilter_Free(gf->numericFilters[i]);
-    }
-    rm_free(gf->numericFilters);
-  }
+  if (gf->points) rm_free(gf->points);
+  if (gf->cover) rm_free(gf->cover);
+  if (gf->numericFilter) NumericFilter_Free(gf->numericFilter);
   rm_free(gf);
 }
 
@@ -104,39 +148,29 @@ done:
 }
 
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
-  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
-  double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
-
-  IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
-  size_t itersCount = 0;
-  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
-    if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1);
-      filt->fieldName = rm_strdup(gf->property);
-      filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
-    }
+  GeoFilter *f = (GeoFilter *)gf;
+  // the cover only depends on the filter, so it is computed once if the query is reevaluated
+  if (!f->cover) {
+    f->cover = rm_malloc(GEO_COVER_MAX_CELLS * sizeof(*f->cover));
+    f->ncover = geoCover(gf, f->cover);
   }
-
-  if (itersCount == 0) {
-    rm_free(iters);
+  if (f->ncover == 0) {
     return NULL;
-  } else if (itersCount == 1) {
-    IndexIterator *it = iters[0];
-    rm_free(iters);
-    return it;
   }
-  IndexIterator *it = NewUnionIterator(iters, itersCount, NULL, 1, 1, QN_GEO, NULL);
-  if (!it) {
-    return NULL;
+
+  double intervals[GEO_COVER_MAX_CELLS * 2];
+  for (size_t ii = 0; ii < f->ncover; ++ii) {
+    intervals[ii * 2] = f->cover[ii].min;
+    intervals[ii * 2 + 1] = f->cover[ii].max;
   }
-  return it;
+  // the readers check each location against the cover, so a single filter spans all of it
+  if (!f->numericFilter) {
+    f->numericFilter = NewNumericFilter(f->cover[0].min, f->cover[f->ncover - 1].max, 1, 0);
+    f->numericFilter->fieldName = rm_strdup(gf->property);
+    f->numericFilter->geoFilter = gf;
+  }
+  NumericFilter *filt = f->numericFilter;
+  return NewNumericIntervalsIterator(ctx, filt, intervals, f->ncover, INDEXFLD_T_GEO);
 }
 
 GeoDistance GeoDistance_Parse(const char *s) {
@@ -178,6 +212,34 @@ GeoFilter *NewGeoFilter(double lon, double lat, double radius, const char *unit)
 /* Make sure that the parameters of the filter make sense - i.e. coordinates are in range, radius is
  * sane, unit is valid. Return 1 if valid, 0 if not, and set the error string into err */
 int GeoFilter_Validate(GeoFilter *gf, QueryError *status) {
+  if (gf->shape == GEO_SHAPE_BOX) {
+    if (gf->box[1] > 90 || gf->box[1] < -90 || gf->box[0] > 180 || gf->box[0] < -180 ||
+        gf->box[3] > 90 || gf->box[3] < -90 || gf->box[2] > 180 || gf->box[2] < -180) {
+      QERR_MKSYNTAXERR(status, "Invalid GeoFilter lat/lon");
+      return 0;
+    }
+    if (gf->box[0] > gf->box[2] || gf->box[1] > gf->box[3]) {
+      QERR_MKSYNTAXERR(status, "Invalid GeoFilter box");
+      return 0;
+    }
+    return 1;
+  }
+
+  if (gf->shape == GEO_SHAPE_POLYGON) {
+    if (gf->npoints < 3) {
+      QERR_MKSYNTAXERR(status, "Invalid GeoFilter polygon");
+      return 0;
+    }
+    for (size_t ii = 0; ii < gf->npoints; ++ii) {
+      double lon = gf->points[ii * 2], lat = gf->points[ii * 2 + 1];
+      if (lat > 90 || lat < -90 || lon > 180 || lon < -180) {
+        QERR_MKSYNTAXERR(status, "Invalid GeoFilter lat/lon");
+        return 0;
+      }
+    }
+    return 1;
+  }
+
   if (gf->unitType == GEO_DISTANCE_INVALID) {
     QERR_MKSYNTAXERR(status, "Invalid GeoFilter unit");
     return 0;
@@ -262,6 +324,353 @@ int isWithinRadius(const GeoFilter *gf, double d, double *distance) {
   return rv;
 }
 
+/* Check if a point is inside a polygon, by counting the edges crossed on the way from it to
+ * the east */
+static int isWithinPolygon(const double *points, size_t npoints, double lon, double lat) {
+  int inside = 0;
+  for (size_t ii = 0, jj = npoints - 1; ii < npoints; jj = ii++) {
+    double lon1 = points[ii * 2], lat1 = points[ii * 2 + 1];
+    double lon2 = points[jj * 2], lat2 = points[jj * 2 + 1];
+    if ((lat1 > lat) != (lat2 > lat) &&
+        lon < (lon2 - lon1) * (lat - lat1) / (lat2 - lat1) + lon1) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+int GeoFilter_Match(const GeoFilter *gf, double d) {
+  if (gf->ncover) {
+    // find the last range starting at or before the location
+    size_t lo = 0, hi = gf->ncover;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (gf->cover[mid].min <= d) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == 0 || d >= gf->cover[lo - 1].max) {
+      return 0;
+    }
+    if (gf->cover[lo - 1].inside) {
+      return 1;
+    }
+  }
+
+  if (gf->shape == GEO_SHAPE_RADIUS) {
+    return isWithinRadius(gf, d, NULL);
+  }
+
+  double xy[2];
+  decodeGeo(d, xy);
+  if (gf->shape == GEO_SHAPE_BOX) {
+    return xy[0] >= gf->box[0] && xy[0] <= gf->box[2] && xy[1] >= gf->box[1] &&
+           xy[1] <= gf->box[3];
+  }
+  return isWithinPolygon(gf->points, gf->npoints, xy[0], xy[1]);
+}
+
+/*****************************************************************************
+ * Covering a shape with geohash cells
+ *
+ * A geohash cell is the area of all the locations whose geohash starts with the same bits, so the
+ * locations in a cell are a single range of the numeric index. A shape is covered by starting
+ * from the few largest cells around it, and splitting the cells crossed by its border as long as
+ * the number of cells stays within GEO_COVER_MAX_CELLS. Cells which are out of the shape are
+ * dropped, and the locations in cells which are inside it are not checked one by one.
+ *****************************************************************************/
+
+#define GEO_DEG_RAD(d) ((d)*M_PI / 180.0)
+#define GEO_RAD_DEG(r) ((r)*180.0 / M_PI)
+
+// Margin for rounding errors in distances, in meters
+#define GEO_DISTANCE_SLACK 0.001
+
+typedef enum {
+  GEO_CELL_OUTSIDE,
+  GEO_CELL_PARTIAL,
+  GEO_CELL_INSIDE,
+} GeoCellRelation;
+
+typedef struct {
+  // position of the cell in the grid of its step
+  uint32_t lonIdx;
+  uint32_t latIdx;
+  uint8_t step;
+  GeoCellRelation rel;
+} GeoCell;
+
+static void geoCellBounds(const GeoCell *c, double *lon, double *lat) {
+  double n = (double)(1ULL << c->step);
+  lon[0] = GEO_LONG_MIN + (GEO_LONG_MAX - GEO_LONG_MIN) * (c->lonIdx / n);
+  lon[1] = GEO_LONG_MIN + (GEO_LONG_MAX - GEO_LONG_MIN) * ((c->lonIdx + 1) / n);
+  lat[0] = GEO_LAT_MIN + (GEO_LAT_MAX - GEO_LAT_MIN) * (c->latIdx / n);
+  lat[1] = GEO_LAT_MIN + (GEO_LAT_MAX - GEO_LAT_MIN) * ((c->latIdx + 1) / n);
+}
+
+/* The geohash bits of a cell - the longitude and latitude bits interleaved, longitude first */
+static uint64_t geoCellBits(const GeoCell *c) {
+  uint64_t bits = 0;
+  for (int ii = c->step - 1; ii >= 0; --ii) {
+    bits = (bits << 2) | (((c->lonIdx >> ii) & 1) << 1) | ((c->latIdx >> ii) & 1);
+  }
+  return bits;
+}
+
+/* The shortest distance in meters from a location to the cell with the given bounds */
+static double geoCellMinDistance(double lon, double lat, const double *clon, const double *clat) {
+  if (lon >= clon[0] && lon <= clon[1]) {
+    // meridians are great circles, so the closest location is right north or south of it
+    double plat = lat < clat[0] ? clat[0] : lat > clat[1] ? clat[1] : lat;
+    return geohashGetDistance(lon, lat, lon, plat);
+  }
+
+  // otherwise the distance is shortest along one of the cell's meridian edges - either at one of
+  // its ends, or where it is crossed by the great circle perpendicular to it
+  double mindist = INFINITY;
+  for (int ii = 0; ii < 2; ++ii) {
+    double dlon = GEO_DEG_RAD(clon[ii] - lon);
+    double plat = GEO_RAD_DEG(atan2(sin(GEO_DEG_RAD(lat)), cos(GEO_DEG_RAD(lat)) * cos(dlon)));
+    double candidates[3] = {clat[0], clat[1], plat};
+    for (int jj = 0; jj < 3; ++jj) {
+      if (jj == 2 && (plat < clat[0] || plat > clat[1])) {
+        break;
+      }
+      double dist = geohashGetDistance(lon, lat, clon[ii], candidates[jj]);
+      if (dist < mindist) {
+        mindist = dist;
+      }
+    }
+  }
+  return mindist;
+}
+
+static GeoCellRelation geoCellRelateRadius(const GeoFilter *gf, const double *clon,
+                                           const double *clat) {
+  double radius = gf->radius * extractUnitFactor(gf->unitType);
+  if (geoCellMinDistance(gf->lon, gf->lat, clon, clat) > radius + GEO_DISTANCE_SLACK) {
+    return GEO_CELL_OUTSIDE;
+  }
+  // the farthest location in the cell is the closest one to the antipode of the center
+  double alon = gf->lon > 0 ? gf->lon - 180 : gf->lon + 180;
+  double maxdist = geohashGetDistance(gf->lon, gf->lat, alon, -gf->lat) -
+                   geoCellMinDistance(alon, -gf->lat, clon, clat);
+  return maxdist < radius - GEO_DISTANCE_SLACK ? GEO_CELL_INSIDE : GEO_CELL_PARTIAL;
+}
+
+static GeoCellRelation geoCellRelateBox(const double *box, const double *clon,
+                                        const double *clat) {
+  if (clon[1] < box[0] || clon[0] > box[2] || clat[1] < box[1] || clat[0] > box[3]) {
+    return GEO_CELL_OUTSIDE;
+  }
+  if (clon[0] >= box[0] && clon[1] <= box[2] && clat[0] >= box[1] && clat[1] <= box[3]) {
+    return GEO_CELL_INSIDE;
+  }
+  return GEO_CELL_PARTIAL;
+}
+
+/* Check if the segment between two points crosses or touches a box (Liang-Barsky clipping) */
+static int segmentCrossesBox(double x0, double y0, double x1, double y1, const double *bx,
+                             const double *by) {
+  double t0 = 0, t1 = 1;
+  double p[4] = {x0 - x1, x1 - x0, y0 - y1, y1 - y0};
+  double q[4] = {x0 - bx[0], bx[1] - x0, y0 - by[0], by[1] - y0};
+  for (int ii = 0; ii < 4; ++ii) {
+    if (p[ii] == 0) {
+      if (q[ii] < 0) {
+        return 0;
+      }
+      continue;
+    }
+    double t = q[ii] / p[ii];
+    if (p[ii] < 0) {
+      if (t > t1) return 0;
+      if (t > t0) t0 = t;
+    } else {
+      if (t < t0) return 0;
+      if (t < t1) t1 = t;
+    }
+  }
+  return 1;
+}
+
+static GeoCellRelation geoCellRelatePolygon(const GeoFilter *gf, const double *clon,
+                                            const double *clat) {
+  const double *pts = gf->points;
+  for (size_t ii = 0, jj = gf->npoints - 1; ii < gf->npoints; jj = ii++) {
+    if (segmentCrossesBox(pts[jj * 2], pts[jj * 2 + 1], pts[ii * 2], pts[ii * 2 + 1], clon,
+                          clat)) {
+      return GEO_CELL_PARTIAL;
+    }
+  }
+  // no edge crosses the cell, so it is either all inside or all outside
+  return isWithinPolygon(pts, gf->npoints, (clon[0] + clon[1]) / 2, (clat[0] + clat[1]) / 2)
+             ? GEO_CELL_INSIDE
+             : GEO_CELL_OUTSIDE;
+}
+
+static GeoCellRelation geoCellRelate(const GeoFilter *gf, const GeoCell *c) {
+  double clon[2], clat[2];
+  geoCellBounds(c, clon, clat);
+  switch (gf->shape) {
+    case GEO_SHAPE_RADIUS:
+      return geoCellRelateRadius(gf, clon, clat);
+    case GEO_SHAPE_BOX:
+      return geoCellRelateBox(gf->box, clon, clat);
+    case GEO_SHAPE_POLYGON:
+      return geoCellRelatePolygon(gf, clon, clat);
+  }
+  return GEO_CELL_PARTIAL;
+}
+
+/* Get the bounding box of the filter's shape, as min lon, min lat, max lon, max lat */
+static void geoShapeBounds(const GeoFilter *gf, double *bounds) {
+  switch (gf->shape) {
+    case GEO_SHAPE_RADIUS: {
+      // the angle of the circle's radius at the center of the earth
+      double angle = gf->radius * extractUnitFactor(gf->unitType) /
+                     (geohashGetDistance(0, 0, 180, 0) / M_PI);
+      double lat = GEO_DEG_RAD(gf->lat);
+      bounds[1] = GEO_RAD_DEG(lat - angle);
+      bounds[3] = GEO_RAD_DEG(lat + angle);
+      if (bounds[1] <= -90 || bounds[3] >= 90 || sin(angle) >= cos(lat)) {
+        // the circle contains a pole
+        bounds[0] = GEO_LONG_MIN;
+        bounds[2] = GEO_LONG_MAX;
+      } else {
+        double dlon = GEO_RAD_DEG(asin(sin(angle) / cos(lat)));
+        bounds[0] = gf->lon - dlon;
+        bounds[2] = gf->lon + dlon;
+        if (bounds[0] < GEO_LONG_MIN || bounds[2] > GEO_LONG_MAX) {
+          // the circle crosses the antimeridian
+          bounds[0] = GEO_LONG_MIN;
+          bounds[2] = GEO_LONG_MAX;
+        }
+      }
+      break;
+    }
+    case GEO_SHAPE_BOX:
+      memcpy(bounds, gf->box, sizeof(gf->box));
+      break;
+    case GEO_SHAPE_POLYGON:
+      bounds[0] = bounds[2] = gf->points[0];
+      bounds[1] = bounds[3] = gf->points[1];
+      for (size_t ii = 1; ii < gf->npoints; ++ii) {
+        bounds[0] = Min(bounds[0], gf->points[ii * 2]);
+        bounds[2] = Max(bounds[2], gf->points[ii * 2]);
+        bounds[1] = Min(bounds[1], gf->points[ii * 2 + 1]);
+        bounds[3] = Max(bounds[3], gf->points[ii * 2 + 1]);
+      }
+      break;
+  }
+}
+
+/* The position of a coordinate in the grid of the given step */
+static uint32_t geoGridIndex(double v, double min, double max, uint8_t step) {
+  double n = (double)(1ULL << step);
+  double idx = floor((v - min) / (max - min) * n);
+  return idx < 0 ? 0 : idx >= n ? (uint32_t)(n - 1) : (uint32_t)idx;
+}
+
+static int cmpCoverRanges(const void *a, const void *b) {
+  double d = ((const GeoCoverRange *)a)->min - ((const GeoCoverRange *)b)->min;
+  return d < 0 ? -1 : d > 0 ? 1 : 0;
+}
+
+size_t geoCover(const GeoFilter *gf, GeoCoverRange *ranges) {
+  double bounds[4];
+  geoShapeBounds(gf, bounds);
+  if (bounds[3] < GEO_LAT_MIN || bounds[1] > GEO_LAT_MAX) {
+    return 0;
+  }
+
+  // start from the smallest cells of which at most 4 cover the shape
+  uint32_t lonIdx[2], latIdx[2];
+  uint8_t step = 1;
+  for (uint8_t s = 1; s <= GEO_STEP_MAX; ++s) {
+    uint32_t lo[2] = {geoGridIndex(bounds[0], GEO_LONG_MIN, GEO_LONG_MAX, s),
+                      geoGridIndex(bounds[2], GEO_LONG_MIN, GEO_LONG_MAX, s)};
+    uint32_t la[2] = {geoGridIndex(bounds[1], GEO_LAT_MIN, GEO_LAT_MAX, s),
+                      geoGridIndex(bounds[3], GEO_LAT_MIN, GEO_LAT_MAX, s)};
+    if ((lo[1] - lo[0] + 1) * (la[1] - la[0] + 1) > 4) {
+      break;
+    }
+    step = s;
+    memcpy(lonIdx, lo, sizeof(lo));
+    memcpy(latIdx, la, sizeof(la));
+  }
+
+  GeoCell cells[GEO_COVER_MAX_CELLS];
+  size_t ncells = 0;
+  for (uint32_t x = lonIdx[0]; x <= lonIdx[1]; ++x) {
+    for (uint32_t y = latIdx[0]; y <= latIdx[1]; ++y) {
+      GeoCell c = {.lonIdx = x, .latIdx = y, .step = step};
+      if ((c.rel = geoCellRelate(gf, &c)) != GEO_CELL_OUTSIDE) {
+        cells[ncells++] = c;
+      }
+    }
+  }
+
+  // split the cells crossed by the border, a level at a time
+  for (; step < GEO_STEP_MAX; ++step) {
+    int split = 0;
+    for (size_t ii = 0; ii < ncells; ++ii) {
+      GeoCell *c = &cells[ii];
+      if (c->step != step || c->rel != GEO_CELL_PARTIAL) {
+        continue;
+      }
+      GeoCell children[4];
+      size_t nchildren = 0;
+      for (uint32_t jj = 0; jj < 4; ++jj) {
+        GeoCell child = {.lonIdx = c->lonIdx * 2 + (jj >> 1),
+                         .latIdx = c->latIdx * 2 + (jj & 1),
+                         .step = step + 1};
+        if ((child.rel = geoCellRelate(gf, &child)) != GEO_CELL_OUTSIDE) {
+          children[nchildren++] = child;
+        }
+      }
+      if (ncells - 1 + nchildren > GEO_COVER_MAX_CELLS) {
+        continue;
+      }
+      split = 1;
+      // the children replace the cell, and are not split again at this level
+      if (nchildren == 0) {
+        cells[ii--] = cells[--ncells];
+        continue;
+      }
+      cells[ii] = children[0];
+      for (size_t jj = 1; jj < nchildren; ++jj) {
+        cells[ncells++] = children[jj];
+      }
+    }
+    if (!split) {
+      break;
+    }
+  }
+
+  // each cell is a range of geohashes, and adjacent ones of the same kind are read as one
+  for (size_t ii = 0; ii < ncells; ++ii) {
+    uint64_t bits = geoCellBits(&cells[ii]);
+    uint8_t shift = (GEO_STEP_MAX - cells[ii].step) * 2;
+    ranges[ii] = (GeoCoverRange){.min = (double)(bits << shift),
+                                 .max = (double)((bits + 1) << shift),
+                                 .inside = cells[ii].rel == GEO_CELL_INSIDE};
+  }
+  qsort(ranges, ncells, sizeof(*ranges), cmpCoverRanges);
+  size_t nranges = 0;
+  for (size_t ii = 0; ii < ncells; ++ii) {
+    if (nranges && ranges[nranges - 1].max == ranges[ii].min &&
+        ranges[nranges - 1].inside == ranges[ii].inside) {
+      ranges[nranges - 1].max = ranges[ii].max;
+    } else {
+      ranges[nranges++] = ranges[ii];
+    }
+  }
+  return nranges;
+}
+
 static int checkResult(const GeoFilter *gf, const RSIndexResult *cur) {
   double distance;
   if (cur->type == RSResultType_Numeric) {
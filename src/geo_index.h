@@ -10,6 +10,10 @@
 #include "dep/geo/rs_geo.h"
 #include "numeric_index.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct geoIndex {
   RedisSearchCtx *ctx;
   const FieldSpec *sp;
@@ -30,13 +34,44 @@ typedef enum {  // Placeholder for bad/invalid unit
 #undef X
 } GeoDistance;
 
+// Maximal number of geohash cells covering the shape of a filter
+#define GEO_COVER_MAX_CELLS 32
+
+/* A range of geohashes covering a part of a filter's shape, as [min, max) */
+typedef struct {
+  double min;
+  double max;
+  // whether all the locations in the range are within the shape
+  int inside;
+} GeoCoverRange;
+
+typedef enum {
+  GEO_SHAPE_RADIUS,
+  GEO_SHAPE_BOX,
+  GEO_SHAPE_POLYGON,
+} GeoShape;
+
 typedef struct GeoFilter {
   const char *property;
+  GeoShape shape;
+
+  // GEO_SHAPE_RADIUS - the center and radius of the circle
   double lat;
   double lon;
   double radius;
   GeoDistance unitType;
-  NumericFilter **numericFilters;
+
+  // GEO_SHAPE_BOX - min lon, min lat, max lon, max lat
+  double box[4];
+
+  // GEO_SHAPE_POLYGON - lon/lat pairs of the vertices, which are connected as a plane polygon
+  double *points;
+  size_t npoints;
+
+  // the geohash ranges covering the shape and the filter of their readers, created by the iterator
+  GeoCoverRange *cover;
+  size_t ncover;
+  NumericFilter *numericFilter;
 } GeoFilter;
 
 /* Create a geo filter from parsed strings and numbers */
@@ -49,15 +84,29 @@ const char *GeoDistance_ToString(GeoDistance dist);
  * sane, unit is valid. Return 1 if valid, 0 if not, and set the error string into err */
 int GeoFilter_Validate(GeoFilter *f, QueryError *status);
 
-/* Parse a geo filter from redis arguments. We assume the filter args start at argv[0] */
+/* Parse a geo filter from redis arguments. We assume the filter args start at argv[0]. Besides a
+ * radius, the filter may be a box or a polygon:
+ *   <property> BOX <min lon> <min lat> <max lon> <max lat>
+ *   <property> POLYGON <num vertices> <lon> <lat> ... */
 int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
 void GeoFilter_Free(GeoFilter *gf);
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf);
 
 /*****************************************************************************/
 
+/* Cover the shape of the filter with geohash ranges, ordered and not overlapping. `ranges` must
+ * have room for GEO_COVER_MAX_CELLS ranges. Returns the number of ranges */
+size_t geoCover(const GeoFilter *gf, GeoCoverRange *ranges);
+
 #define INVALID_GEOHASH -1.0
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
 
+/* Check if the location with the geohash `d` is within the filter's shape. If the filter has
+ * a cover, locations out of it are rejected and those in inside ranges accepted without checks */
+int GeoFilter_Match(const GeoFilter *gf, double d);
+
+#ifdef __cplusplus
+}
+#endif
 #endif
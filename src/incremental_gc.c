@@ -0,0 +1,455 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/param.h>
+#include "incremental_gc.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "redis_index.h"
+#include "spec.h"
+#include "config.h"
+#include "time_sample.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+// the interval between slices while there is garbage to collect, and while there is none
+#define IGC_BUSY_INTERVAL_MS 10
+#define IGC_IDLE_INTERVAL_MS 1000
+
+// the slice's clock is checked after repairing a block, or after scanning this many clean ones
+#define IGC_CLEAN_BLOCKS_PER_CHECK 1024
+
+#define IGC_VERSION_UNSET UINT64_MAX
+
+/* An inverted index to sweep. Numeric ranges also point at their tree and node, to keep the entry
+ * count of the tree and the cardinality of the range */
+typedef struct {
+  InvertedIndex *idx;
+  NumericRangeTree *rt;
+  NumericRangeNode *node;
+} IGCUnit;
+
+static int cmpDocIds(const void *p1, const void *p2) {
+  t_docId id1 = *(const t_docId *)p1, id2 = *(const t_docId *)p2;
+  return id1 < id2 ? -1 : (id1 > id2 ? 1 : 0);
+}
+
+/* A block needs repairing if one of the ids deleted before the pass started is within its range */
+static bool IGC_isBlockDirty(const IncrementalGC *gc, const IndexBlock *blk) {
+  if (!blk->numDocs || blk->lastId - blk->firstId > UINT32_MAX) {
+    return false;
+  }
+  size_t lo = 0, hi = array_len(gc->sweepIds);
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (gc->sweepIds[mid] < blk->firstId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < array_len(gc->sweepIds) && gc->sweepIds[lo] <= blk->lastId;
+}
+
+static bool IGC_sliceExpired(TimeSample *ts) {
+  TimeSampler_End(ts);
+  return TimeSampler_DurationNS(ts) >= (long long)RSGlobalConfig.gcSliceTimeUS * 1000;
+}
+
+/* Get the inverted indexes held by a term or numeric keys dictionary entry. The version changes
+ * whenever the list may have changed, in which case the visit of the entry is restarted. Tag
+ * indexes may hold too many values to be listed at once, and are visited by IGC_sweepTags */
+static IGCUnit *IGC_collectUnits(const KeysDictValue *kdv, uint64_t *version) {
+  IGCUnit *units = array_new(IGCUnit, 1);
+  *version = 0;
+  if (kdv->dtor == InvertedIndex_Free) {
+    units = array_append(units, ((IGCUnit){.idx = kdv->p}));
+
+  } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+    NumericRangeTree *rt = kdv->p;
+    *version = rt->revisionId;
+    NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+    NumericRangeNode *node;
+    while ((node = NumericRangeTreeIterator_Next(iter))) {
+      if (node->range) {
+        units = array_append(units,
+                             ((IGCUnit){.idx = node->range->entries, .rt = rt, .node = node}));
+      }
+    }
+    NumericRangeTreeIterator_Free(iter);
+  }
+  return units;
+}
+
+/* Remove the value of a collected record from the cardinality values of its numeric range */
+static void IGC_uncountNumeric(const RSIndexResult *r, const IndexBlock *blk, void *arg) {
+  NumericRange *range = arg;
+  for (size_t i = 0; i < array_len(range->values); ++i) {
+    if (range->values[i].value != r->num.value) {
+      continue;
+    }
+    if (--range->values[i].appearances == 0) {
+      range->unique_sum -= range->values[i].value;
+      array_del_fast(range->values, i);
+      range->card = array_len(range->values);
+    }
+    return;
+  }
+}
+
+/* Recompute the bounds of a leaf range after values were removed from it. The bounds of inner
+ * nodes also cover their children, so they are kept */
+static void IGC_updateNumericBounds(NumericRangeNode *node) {
+  if (!NumericRangeNode_IsLeaf(node) || !array_len(node->range->values)) {
+    return;
+  }
+  NumericRange *range = node->range;
+  range->minVal = range->maxVal = range->values[0].value;
+  for (size_t i = 1; i < array_len(range->values); ++i) {
+    range->minVal = MIN(range->minVal, range->values[i].value);
+    range->maxVal = MAX(range->maxVal, range->values[i].value);
+  }
+}
+
+/* Remove the values of a tag index found empty during its visit, unless they were reused since */
+static void IGC_removeEmptyTags(IncrementalGC *gc, TagIndex *tagIdx) {
+  for (size_t i = 0; i < array_len(gc->emptyTags); ++i) {
+    char *tag = gc->emptyTags[i];
+    InvertedIndex *idx = TrieMap_Find(tagIdx->values, tag, strlen(tag));
+    if (idx != TRIEMAP_NOTFOUND && idx->numDocs == 0 &&
+        TrieMap_Delete(tagIdx->values, tag, strlen(tag), InvertedIndex_Free)) {
+      ++tagIdx->revisionId;
+    }
+    rm_free(tag);
+  }
+  array_clear(gc->emptyTags);
+}
+
+/* Remove the keys dictionary entry of a term left without documents, and the term itself */
+static void IGC_removeEmptyTerm(RedisSearchCtx *sctx, RedisModuleString *key) {
+  RedisModuleString *pf = fmtRedisTermKey(sctx, "", 0);
+  size_t pflen, len;
+  RedisModule_StringPtrLen(pf, &pflen);
+  const char *term = RedisModule_StringPtrLen(key, &len);
+  Trie_Delete(sctx->spec->terms, term + pflen, len - pflen);
+  RedisModule_FreeString(NULL, pf);
+  dictDelete(sctx->spec->keysDict, key);
+}
+
+/* Repair the dirty blocks of an inverted index, starting at gc->curBlock. Returns false if the
+ * slice ran out of time before the index was completed */
+static bool IGC_sweepUnit(IncrementalGC *gc, RedisSearchCtx *sctx, IGCUnit *unit, TimeSample *ts,
+                          size_t *cleanBlocks) {
+  for (; gc->curBlock < unit->idx->size; ++gc->curBlock) {
+    if (!IGC_isBlockDirty(gc, unit->idx->blocks + gc->curBlock)) {
+      if (++*cleanBlocks % IGC_CLEAN_BLOCKS_PER_CHECK == 0 && IGC_sliceExpired(ts)) {
+        return false;
+      }
+      continue;
+    }
+
+    IndexRepairParams params = {.limit = 1};
+    if (unit->node) {
+      params.RepairCallback = IGC_uncountNumeric;
+      params.arg = unit->node->range;
+    }
+    InvertedIndex_Repair(unit->idx, &sctx->spec->docs, gc->curBlock, &params);
+    sctx->spec->stats.numRecords -= params.docsCollected;
+    sctx->spec->stats.invertedSize -= params.bytesCollected;
+    if (unit->node) {
+      unit->node->range->invertedIndexSize -= params.bytesCollected;
+      unit->rt->numEntries -= params.docsCollected;
+      if (params.docsCollected) {
+        IGC_updateNumericBounds(unit->node);
+        NumericRangeTree_ClearBitmaps(unit->rt);
+      }
+    }
+    gc->stats.totalCollected += params.bytesCollected;
+    gc->stats.blocksRepaired++;
+
+    if (IGC_sliceExpired(ts)) {
+      ++gc->curBlock;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void IGC_releaseTagIter(IncrementalGC *gc) {
+  if (gc->tagIter) {
+    TrieMapIterator_Free(gc->tagIter);
+    gc->tagIter = NULL;
+  }
+  gc->curTag = NULL;
+}
+
+/* Sweep the values of a tag index one at a time, keeping the position in the trie between slices.
+ * If the nodes of the trie may have moved meanwhile, the visit restarts from the first value.
+ * Blocks repaired already are not dirty anymore, so they are skipped quickly */
+static bool IGC_sweepTags(IncrementalGC *gc, RedisSearchCtx *sctx, TagIndex *tagIdx,
+                          TimeSample *ts) {
+  uint64_t version = ((uint64_t)tagIdx->uniqueId << 32) | tagIdx->revisionId;
+  if (version != gc->curVersion) {
+    IGC_releaseTagIter(gc);
+    gc->curVersion = version;
+  }
+  if (!gc->tagIter) {
+    gc->tagIter = TrieMap_Iterate(tagIdx->values, "", 0);
+  }
+
+  size_t cleanBlocks = 0;
+  while (1) {
+    if (!gc->curTag) {
+      void *value;
+      if (!TrieMapIterator_Next(gc->tagIter, &gc->curTagStr, &gc->curTagLen, &value)) {
+        break;
+      }
+      gc->curTag = value;
+      gc->curBlock = 0;
+      // each value counts as a clean block for the slice's clock
+      if (++cleanBlocks % IGC_CLEAN_BLOCKS_PER_CHECK == 0 && IGC_sliceExpired(ts)) {
+        return false;
+      }
+    }
+
+    IGCUnit unit = {.idx = gc->curTag};
+    if (!IGC_sweepUnit(gc, sctx, &unit, ts, &cleanBlocks)) {
+      return false;
+    }
+    if (gc->curTag->numDocs == 0) {
+      gc->emptyTags = array_append(gc->emptyTags, rm_strndup(gc->curTagStr, gc->curTagLen));
+    }
+    gc->curTag = NULL;
+  }
+
+  IGC_releaseTagIter(gc);
+  IGC_removeEmptyTags(gc, tagIdx);
+  return true;
+}
+
+/* Repair the dirty blocks of the key being visited, starting where the previous slice stopped.
+ * Returns false if the slice ran out of time before the key was completed */
+static bool IGC_sweepKey(IncrementalGC *gc, RedisSearchCtx *sctx, TimeSample *ts) {
+  KeysDictValue *kdv = dictFetchValue(sctx->spec->keysDict, gc->curKey);
+  if (!kdv) {
+    // the key was removed since it was scanned
+    return true;
+  }
+  if (kdv->dtor == TagIndex_Free) {
+    return IGC_sweepTags(gc, sctx, kdv->p, ts);
+  }
+
+  uint64_t version;
+  IGCUnit *units = IGC_collectUnits(kdv, &version);
+  if (version != gc->curVersion) {
+    gc->curVersion = version;
+    gc->curUnit = gc->curBlock = 0;
+  }
+
+  bool done = true;
+  size_t cleanBlocks = 0;
+  for (; gc->curUnit < array_len(units); ++gc->curUnit, gc->curBlock = 0) {
+    if (!IGC_sweepUnit(gc, sctx, units + gc->curUnit, ts, &cleanBlocks)) {
+      done = false;
+      break;
+    }
+  }
+  array_free(units);
+
+  if (done && kdv->dtor == InvertedIndex_Free && ((InvertedIndex *)kdv->p)->numDocs == 0) {
+    IGC_removeEmptyTerm(sctx, gc->curKey);
+  }
+  return done;
+}
+
+static void IGC_scanCb(void *privdata, const dictEntry *de) {
+  IncrementalGC *gc = privdata;
+  RedisModuleString *key = dictGetKey(de);
+  RedisModule_RetainString(NULL, key);
+  gc->queue = array_append(gc->queue, key);
+}
+
+static void IGC_releaseKey(IncrementalGC *gc) {
+  IGC_releaseTagIter(gc);
+  for (size_t i = 0; i < array_len(gc->emptyTags); ++i) {
+    rm_free(gc->emptyTags[i]);
+  }
+  array_clear(gc->emptyTags);
+  if (gc->curKey) {
+    RedisModule_FreeString(NULL, gc->curKey);
+    gc->curKey = NULL;
+  }
+}
+
+static void IGC_endPass(IncrementalGC *gc) {
+  IGC_releaseKey(gc);
+  for (size_t i = 0; i < array_len(gc->queue); ++i) {
+    RedisModule_FreeString(NULL, gc->queue[i]);
+  }
+  array_clear(gc->queue);
+  array_free(gc->sweepIds);
+  gc->sweepIds = NULL;
+}
+
+static void IGC_startPass(IncrementalGC *gc) {
+  gc->sweepIds = gc->pendingIds;
+  gc->pendingIds = array_new(t_docId, 16);
+  qsort(gc->sweepIds, array_len(gc->sweepIds), sizeof(*gc->sweepIds), cmpDocIds);
+  gc->cursor = 0;
+  gc->scanDone = 0;
+}
+
+/* Run a single slice of the current pass, starting a new pass if there are deleted documents */
+static void IGC_runSlice(IncrementalGC *gc, RedisSearchCtx *sctx, TimeSample *ts) {
+  if (!gc->sweepIds) {
+    if (!array_len(gc->pendingIds)) {
+      return;
+    }
+    IGC_startPass(gc);
+  }
+
+  dict *keysDict = sctx->spec->keysDict;
+  while (keysDict) {
+    if (!gc->curKey) {
+      if (array_len(gc->queue)) {
+        gc->curKey = array_pop(gc->queue);
+        gc->curVersion = IGC_VERSION_UNSET;
+        gc->curUnit = gc->curBlock = 0;
+      } else if (gc->scanDone) {
+        break;
+      } else {
+        gc->cursor = dictScan(keysDict, gc->cursor, IGC_scanCb, NULL, gc);
+        gc->scanDone = gc->cursor == 0;
+        continue;
+      }
+    }
+
+    if (!IGC_sweepKey(gc, sctx, ts)) {
+      return;
+    }
+    IGC_releaseKey(gc);
+    if (IGC_sliceExpired(ts)) {
+      return;
+    }
+  }
+
+  IGC_endPass(gc);
+  gc->stats.numPasses++;
+}
+
+static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
+  IncrementalGC *gc = privdata;
+  int ret = 1;
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
+
+  // Check if RDB is loading - not needed after the first time we find out that rdb is not reloading
+  if (gc->rdbPossiblyLoading) {
+    if (isRdbLoading(ctx)) {
+      RedisModule_Log(ctx, "notice", "RDB Loading in progress, not performing GC");
+      goto end;
+    }
+    gc->rdbPossiblyLoading = 0;
+  }
+
+  RedisSearchCtx *sctx = NewSearchCtx(ctx, gc->keyName, false);
+  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    RedisModule_Log(ctx, "warning", "No index spec for GC %s",
+                    RedisModule_StringPtrLen(gc->keyName, NULL));
+    if (sctx) {
+      SearchCtx_Free(sctx);
+    }
+    ret = 0;
+    goto end;
+  }
+
+  if (gc->sweepIds || array_len(gc->pendingIds)) {
+    TimeSample ts;
+    TimeSampler_Start(&ts);
+    IGC_runSlice(gc, sctx, &ts);
+    TimeSampler_End(&ts);
+
+    long long us = TimeSampler_DurationNS(&ts) / 1000;
+    gc->stats.numSlices++;
+    gc->stats.totalSliceUS += us;
+    gc->stats.lastSliceUS = us;
+    gc->stats.maxSliceUS = MAX(gc->stats.maxSliceUS, us);
+  }
+  SearchCtx_Free(sctx);
+
+end:
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
+  return ret;
+}
+
+static void onTerminateCb(void *privdata) {
+  IncrementalGC *gc = privdata;
+  IGC_endPass(gc);
+  array_free(gc->emptyTags);
+  array_free(gc->queue);
+  array_free(gc->pendingIds);
+  RedisModule_FreeString(NULL, gc->keyName);
+  rm_free(gc);
+}
+
+static void statsCb(RedisModuleCtx *ctx, void *gcCtx) {
+#define REPLY_KVNUM(n, k, v)                   \
+  RedisModule_ReplyWithSimpleString(ctx, k);   \
+  RedisModule_ReplyWithDouble(ctx, (double)v); \
+  n += 2
+  IncrementalGC *gc = gcCtx;
+
+  int n = 0;
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  if (gc) {
+    REPLY_KVNUM(n, "bytes_collected", gc->stats.totalCollected);
+    REPLY_KVNUM(n, "blocks_repaired", gc->stats.blocksRepaired);
+    REPLY_KVNUM(n, "total_passes", gc->stats.numPasses);
+    REPLY_KVNUM(n, "total_slices", gc->stats.numSlices);
+    REPLY_KVNUM(n, "average_slice_time_us",
+                (double)gc->stats.totalSliceUS / (gc->stats.numSlices ? gc->stats.numSlices : 1));
+    REPLY_KVNUM(n, "last_slice_time_us", gc->stats.lastSliceUS);
+    REPLY_KVNUM(n, "max_slice_time_us", gc->stats.maxSliceUS);
+    REPLY_KVNUM(n, "pending_deleted_docs",
+                array_len(gc->pendingIds) + (gc->sweepIds ? array_len(gc->sweepIds) : 0));
+  }
+  RedisModule_ReplySetArrayLength(ctx, n);
+}
+
+static void deleteCb(void *ctx, t_docId docId) {
+  IncrementalGC *gc = ctx;
+  gc->pendingIds = array_append(gc->pendingIds, docId);
+}
+
+static void compactCb(void *ctx) {
+  IncrementalGC *gc = ctx;
+  // compaction dropped the records of every deleted document, and their ids now belong to others
+  IGC_endPass(gc);
+  array_clear(gc->pendingIds);
+}
+
+static struct timespec getIntervalCb(void *ctx) {
+  IncrementalGC *gc = ctx;
+  long ms = gc->sweepIds || array_len(gc->pendingIds) ? IGC_BUSY_INTERVAL_MS : IGC_IDLE_INTERVAL_MS;
+  struct timespec ret = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000};
+  return ret;
+}
+
+IncrementalGC *IGC_New(const RedisModuleString *k, uint64_t specUniqueId, GCCallbacks *callbacks) {
+  IncrementalGC *gc = rm_calloc(1, sizeof(*gc));
+  gc->keyName = RedisModule_CreateStringFromString(NULL, k);
+  gc->specUniqueId = specUniqueId;
+  gc->rdbPossiblyLoading = 1;
+  gc->pendingIds = array_new(t_docId, 16);
+  gc->queue = array_new(RedisModuleString *, 4);
+  gc->emptyTags = array_new(char *, 4);
+
+  callbacks->onTerm = onTerminateCb;
+  callbacks->periodicCallback = periodicCb;
+  callbacks->renderStats = statsCb;
+  callbacks->getInterval = getIntervalCb;
+  callbacks->onDelete = deleteCb;
+  callbacks->onCompact = compactCb;
+  return gc;
+}
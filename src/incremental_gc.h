@@ -0,0 +1,70 @@
+#ifndef RS_INCREMENTAL_GC_H_
+#define RS_INCREMENTAL_GC_H_
+
+#include "redismodule.h"
+#include "redisearch.h"
+#include "gc.h"
+#include "dep/triemap/triemap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // total bytes collected by the GC
+  size_t totalCollected;
+  // number of index blocks which were repaired
+  size_t blocksRepaired;
+  // number of full passes over the index
+  size_t numPasses;
+  // number of time slices the GC ran in, and their durations
+  size_t numSlices;
+  long long totalSliceUS;
+  long long lastSliceUS;
+  long long maxSliceUS;
+} IncrementalGCStats;
+
+/**
+ * The incremental GC repairs the index in the main process, in short time slices, instead of
+ * forking. Deleted document ids are collected as they are deleted, and on every pass only the
+ * index blocks whose id range contains a deleted document are decoded and repaired.
+ */
+typedef struct {
+  // inverted index key name for reopening the index
+  RedisModuleString *keyName;
+  uint64_t specUniqueId;
+
+  // ids deleted since the current pass started
+  t_docId *pendingIds;
+  // sorted ids the current pass is collecting, NULL if no pass is running
+  t_docId *sweepIds;
+
+  // position of the current pass: the keys dictionary scan cursor, the keys returned by the scan
+  // and not visited yet, and the position inside the key being visited
+  unsigned long cursor;
+  int scanDone;
+  RedisModuleString **queue;
+  RedisModuleString *curKey;
+  uint64_t curVersion;
+  uint32_t curUnit;
+  uint32_t curBlock;
+  // visiting a tag index: the iterator over its values, the value being swept and its string
+  // (owned by the iterator), and the values left empty, removed once the key is completed
+  TrieMapIterator *tagIter;
+  struct InvertedIndex *curTag;
+  char *curTagStr;
+  tm_len_t curTagLen;
+  char **emptyTags;
+
+  // flag for rdb loading. Set to 1 initially, but once it's set to 0 we don't need to check anymore
+  int rdbPossiblyLoading;
+
+  IncrementalGCStats stats;
+} IncrementalGC;
+
+IncrementalGC *IGC_New(const RedisModuleString *k, uint64_t specUniqueId, GCCallbacks *callbacks);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -11,12 +11,15 @@
 #include "rmutil/rm_assert.h"
 #include "util/heap.h"
 #include "profile.h"
+#include "inverted_index.h"
+#include "extension.h"
 
 static int UI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static int UI_SkipToHigh(void *ctx, t_docId docId, RSIndexResult **hit);
 static inline int UI_ReadUnsorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSortedHigh(void *ctx, RSIndexResult **hit);
+static int UI_ReadSortedPruned(void *ctx, RSIndexResult **hit);
 static size_t UI_NumEstimated(void *ctx);
 static IndexCriteriaTester *UI_GetCriteriaTester(void *ctx);
 static size_t UI_Len(void *ctx);
@@ -68,6 +71,12 @@ typedef struct {
   QueryNodeType origType;
   // original string for fuzzy or prefix unions
   const char *qstr;
+
+  // block-max pruning, see UnionIterator_EnableBlockMaxPruning
+  const double *pruneMinScore;
+  double pruneScale;
+  ExtScoreBoundFunction pruneBound;
+  RSIndexStats pruneStats;
 } UnionIterator;
 
 static void resetMinIdHeap(UnionIterator *ui) {
@@ -349,6 +358,122 @@ static inline int UI_ReadSorted(void *ctx, RSIndexResult **hit) {
   return INDEXREAD_EOF;
 }
 
+// Slack on the score bound, so that rounding errors never prune a qualifying document
+#define UI_PRUNE_EPSILON 1e-6
+
+static inline double UI_ChildScoreBound(const UnionIterator *ui, const IndexIterator *it) {
+  const IndexReader *ir = it->ctx;
+  const RSQueryTerm *term = ir->record->term.term;
+  uint16_t maxFreq = IndexReader_CurrentBlock(ir)->maxFreq;
+  if (!maxFreq) {
+    maxFreq = INDEX_BLOCK_MAXFREQ_UNKNOWN;
+  }
+  return ui->pruneBound(&ui->pruneStats, term ? term->idf : 0, ir->weight, maxFreq);
+}
+
+/**
+ * Skip the documents which cannot score high enough to be accepted by the consumer.
+ * All the documents up to the smallest last id of the children's current blocks are covered by
+ * those blocks, so if the sum of the blocks' bounds is below the threshold, none of these documents
+ * can qualify and all the children are skipped past them. Returns 1 if anything was skipped.
+ */
+static int UI_PruneBlocks(UnionIterator *ui) {
+  const double threshold = *ui->pruneMinScore;
+  if (threshold <= 0) {
+    return 0;
+  }
+
+  // position all the children after the last returned document
+  for (unsigned i = 0; i < ui->num; i++) {
+    IndexIterator *it = ui->its[i];
+    RSIndexResult *res = NULL;
+    int rc = INDEXREAD_OK;
+    while (it->minId <= ui->minDocId && rc != INDEXREAD_EOF) {
+      rc = it->Read(it->ctx, &res);
+      if (rc != INDEXREAD_EOF && res) {
+        it->minId = res->docId;
+      }
+    }
+    if (rc == INDEXREAD_EOF) {
+      i = UI_RemoveExhausted(ui, i);
+    }
+  }
+  if (ui->num == 0) {
+    return 0;
+  }
+
+  t_docId windowEnd = UINT64_MAX;
+  for (unsigned i = 0; i < ui->num; i++) {
+    const IndexBlock *blk = IndexReader_CurrentBlock(ui->its[i]->ctx);
+    if (blk->lastId < ui->its[i]->minId) {
+      // the reader is not positioned inside its block, nothing can be assumed
+      return 0;
+    }
+    windowEnd = MIN(windowEnd, blk->lastId);
+  }
+
+  double bound = 0;
+  for (unsigned i = 0; i < ui->num; i++) {
+    if (ui->its[i]->minId <= windowEnd) {
+      bound += UI_ChildScoreBound(ui, ui->its[i]);
+    }
+  }
+  if (bound * ui->pruneScale * (1 + UI_PRUNE_EPSILON) >= threshold) {
+    return 0;
+  }
+
+  for (unsigned i = 0; i < ui->num; i++) {
+    IndexIterator *it = ui->its[i];
+    if (it->minId > windowEnd) {
+      continue;
+    }
+    RSIndexResult *res = NULL;
+    if (it->SkipTo(it->ctx, windowEnd + 1, &res) == INDEXREAD_EOF) {
+      i = UI_RemoveExhausted(ui, i);
+    } else if (res) {
+      it->minId = res->docId;
+    }
+  }
+  ui->minDocId = windowEnd;
+  return 1;
+}
+
+static int UI_ReadSortedPruned(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (IITER_HAS_NEXT(&ui->base)) {
+    while (ui->num && UI_PruneBlocks(ui)) {
+    }
+  }
+  return UI_ReadSorted(ctx, hit);
+}
+
+int UnionIterator_EnableBlockMaxPruning(IndexIterator *it, const double *minScore,
+                                        double maxDocScore, ExtScoreBoundFunction bf,
+                                        const RSIndexStats *stats) {
+  if (it->type != UNION_ITERATOR || !bf) {
+    return 0;
+  }
+  UnionIterator *ui = it->ctx;
+  // unsorted and heap based unions are not supported
+  if (it->Read != UI_ReadSorted) {
+    return 0;
+  }
+  for (size_t i = 0; i < ui->norig; ++i) {
+    const IndexIterator *child = ui->origits[i];
+    if (child->type != READ_ITERATOR ||
+        ((IndexReader *)child->ctx)->record->type != RSResultType_Term) {
+      return 0;
+    }
+  }
+
+  ui->pruneMinScore = minScore;
+  ui->pruneScale = ui->weight * maxDocScore;
+  ui->pruneBound = bf;
+  ui->pruneStats = *stats;
+  it->Read = UI_ReadSortedPruned;
+  return 1;
+}
+
 // UI_Read for iterator with high count of children
 static inline int UI_ReadSortedHigh(void *ctx, RSIndexResult **hit) {
   UnionIterator *ui = ctx;
@@ -731,6 +856,22 @@ static void II_SortChildren(IntersectIterator *ctx) {
   array_free(unsortedIts);
 }
 
+void IntersectIterator_AddTester(IndexIterator *it, IndexCriteriaTester *tester) {
+  IntersectIterator *ic = it->ctx;
+  ic->testers = array_ensure_append(ic->testers, &tester, 1, IndexCriteriaTester *);
+}
+
+/* Check a document found on all the children against the testers. The unsorted children of a sorted
+ * intersection and the filters the query planner chose to test are not iterated */
+static int II_TestersMatch(IntersectIterator *ic, t_docId docId) {
+  for (size_t i = 0; i < array_len(ic->testers); ++i) {
+    if (!ic->testers[i]->Test(ic->testers[i], docId)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *dt,
                                    t_fieldMask fieldMask, int maxSlop, int inOrder, double weight) {
   // printf("Creating new intersection iterator with fieldMask=%llx\n", fieldMask);
@@ -821,8 +962,9 @@ static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
     // Update the last found id
     // if maxSlop == -1 there is no need to verify maxSlop and inorder, otherwise lets verify
-    if (ic->maxSlop == -1 ||
-        IndexResult_IsWithinRange(ic->base.current, ic->maxSlop, ic->inOrder)) {
+    if ((ic->maxSlop == -1 ||
+         IndexResult_IsWithinRange(ic->base.current, ic->maxSlop, ic->inOrder)) &&
+        II_TestersMatch(ic, ic->base.current->docId)) {
       ic->lastFoundId = ic->base.current->docId;
       if (hit) *hit = ic->base.current;
       return INDEXREAD_OK;
@@ -847,14 +989,7 @@ static int II_ReadUnsorted(void *ctx, RSIndexResult **hit) {
     if (rc == INDEXREAD_EOF) {
       return INDEXREAD_EOF;
     }
-    int isMatch = 1;
-    for (size_t i = 0; i < array_len(ic->testers); ++i) {
-      if (!ic->testers[i]->Test(ic->testers[i], res->docId)) {
-        isMatch = 0;
-        break;
-      }
-    }
-    if (!isMatch) {
+    if (!II_TestersMatch(ic, res->docId)) {
       continue;
     }
     *hit = res;
@@ -888,19 +1023,21 @@ static void II_TesterFree(struct IndexCriteriaTester *ct) {
 
 static IndexCriteriaTester *II_GetCriteriaTester(void *ctx) {
   IntersectIterator *ic = ctx;
+  // the children's testers are added to the intersection's own
+  size_t ntesters = array_len(ic->testers);
   for (size_t i = 0; i < ic->num; ++i) {
     IndexCriteriaTester *tester = NULL;
     if (ic->its[i]) {
       tester = IITER_GET_CRITERIA_TESTER(ic->its[i]);
     }
     if (!tester) {
-      for (int j = 0; j < i; j++) {
-        ic->testers[j]->Free(ic->testers[j]);
+      while (array_len(ic->testers) > ntesters) {
+        IndexCriteriaTester *added = array_pop(ic->testers);
+        added->Free(added);
       }
-      array_free(ic->testers);
       return NULL;
     }
-    ic->testers = array_ensure_append(ic->testers, tester, 1, IndexCriteriaTester *);
+    ic->testers = array_ensure_append(ic->testers, &tester, 1, IndexCriteriaTester *);
   }
   IICriteriaTester *ict = rm_malloc(sizeof(*ict));
   ict->children = ic->testers;
@@ -987,11 +1124,9 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
         }
       }
 
-      //      for(size_t i = 0 ; i < array_len(ic->testers) ; ++i){
-      //        if(!ic->testers[i]->TextCriteria(ic->testers[i]->ctx, ic->lastFoundId)){
-      //          continue;
-      //        }
-      //      }
+      if (!II_TestersMatch(ic, ic->lastFoundId)) {
+        continue;
+      }
 
       ic->len++;
       // printf("Returning OK\n");
@@ -1020,10 +1155,21 @@ typedef struct {
   IndexCriteriaTester *childCT;
   t_docId lastDocId;
   t_docId maxDocId;
+  const DocIdBitmap *live;
+  size_t liveHint;
   size_t len;
   double weight;
 } NotIterator, NotContext;
 
+/* The candidate id following docId, or maxDocId + 1 if there is none */
+static t_docId NI_NextCandidate(NotContext *nc, t_docId docId) {
+  if (!nc->live) {
+    return docId + 1;
+  }
+  t_docId next = DocIdBitmap_Next(nc->live, docId + 1, &nc->liveHint);
+  return next ? next : nc->maxDocId + 1;
+}
+
 static void NI_Abort(void *ctx) {
   NotContext *nc = ctx;
   if (nc->child) {
@@ -1034,6 +1180,7 @@ static void NI_Abort(void *ctx) {
 static void NI_Rewind(void *ctx) {
   NotContext *nc = ctx;
   nc->lastDocId = 0;
+  nc->liveHint = 0;
   nc->base.current->docId = 0;
   if (nc->child) {
     nc->child->Rewind(nc->child->ctx);
@@ -1061,6 +1208,13 @@ static int NI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   if (docId > nc->maxDocId) {
     return INDEXREAD_EOF;
   }
+  // A deleted document is not a match, whatever the child has
+  if (nc->live && !DocIdBitmap_Contains(nc->live, docId)) {
+    nc->base.current->docId = docId;
+    nc->lastDocId = docId;
+    *hit = nc->base.current;
+    return INDEXREAD_NOTFOUND;
+  }
   // If we don't have a child it means the sub iterator is of a meaningless expression.
   // So negating it means we will always return OK!
   if (!nc->child) {
@@ -1133,7 +1287,7 @@ static IndexCriteriaTester *NI_GetCriteriaTester(void *ctx) {
 
 static size_t NI_NumEstimated(void *ctx) {
   NotContext *nc = ctx;
-  return nc->maxDocId;
+  return nc->live ? DocIdBitmap_Cardinality(nc->live) : nc->maxDocId;
 }
 
 static int NI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
@@ -1151,7 +1305,8 @@ static int NI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
 }
 
 /* Read from a NOT iterator. This is applicable only if the only or leftmost node of a query is a
- * NOT node. We simply read until max docId, skipping docIds that exist in the child*/
+ * NOT node. We simply read the candidate ids until max docId, skipping docIds that exist in the
+ * child*/
 static int NI_ReadSorted(void *ctx, RSIndexResult **hit) {
   NotContext *nc = ctx;
   if (nc->lastDocId > nc->maxDocId) return INDEXREAD_EOF;
@@ -1162,38 +1317,36 @@ static int NI_ReadSorted(void *ctx, RSIndexResult **hit) {
     cr = IITER_CURRENT_RECORD(nc->child);
 
     if (cr == NULL || cr->docId == 0) {
-      nc->child->Read(nc->child->ctx, &cr);
+      if (nc->child->Read(nc->child->ctx, &cr) == INDEXREAD_EOF) {
+        cr = NULL;
+      }
     }
   }
 
-  // advance our reader by one, and let's test if it's a valid value or not
-  nc->base.current->docId++;
+  // advance our reader to the next candidate, and let's test if it's a valid value or not
+  t_docId docId = NI_NextCandidate(nc, nc->base.current->docId);
 
-  // If we don't have a child result, or the child result is ahead of the current counter,
-  // we just increment our virtual result's id until we hit the child result's
-  // in which case we'll read from the child and bypass it by one.
-  if (cr == NULL || cr->docId > nc->base.current->docId) {
-    goto ok;
-  }
-
-  while (cr->docId == nc->base.current->docId) {
-    // advance our docId to the next possible id
-    nc->base.current->docId++;
-
-    // read the next entry from the child
-    if (nc->child->Read(nc->child->ctx, &cr) == INDEXREAD_EOF) {
-      break;
+  // The child result may be behind the candidate, as candidates may skip ids. Bring it up to the
+  // candidate, and move on to the next candidate as long as the child has it.
+  while (cr && cr->docId <= docId && docId <= nc->maxDocId) {
+    if (cr->docId < docId) {
+      if (nc->child->SkipTo(nc->child->ctx, docId, &cr) != INDEXREAD_OK) {
+        // the child does not have the candidate
+        break;
+      }
     }
+    docId = NI_NextCandidate(nc, docId);
   }
 
   // make sure we did not overflow
-  if (nc->base.current->docId > nc->maxDocId) {
+  if (docId > nc->maxDocId) {
+    nc->lastDocId = docId;
     return INDEXREAD_EOF;
   }
 
-ok:
   // Set the next entry and return ok
-  nc->lastDocId = nc->base.current->docId;
+  nc->base.current->docId = docId;
+  nc->lastDocId = docId;
   if (hit) *hit = nc->base.current;
   ++nc->len;
 
@@ -1220,7 +1373,8 @@ static t_docId NI_LastDocId(void *ctx) {
   return nc->lastDocId;
 }
 
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight) {
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, const DocIdBitmap *live,
+                              double weight) {
 
   NotContext *nc = rm_malloc(sizeof(*nc));
   nc->base.current = NewVirtualResult(weight);
@@ -1230,6 +1384,8 @@ IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight
   nc->childCT = NULL;
   nc->lastDocId = 0;
   nc->maxDocId = maxDocId;
+  nc->live = live;
+  nc->liveHint = 0;
   nc->len = 0;
   nc->weight = weight;
 
@@ -1270,9 +1426,20 @@ typedef struct {
   t_docId lastDocId;
   t_docId maxDocId;
   t_docId nextRealId;
+  const DocIdBitmap *live;
+  size_t liveHint;
   double weight;
 } OptionalMatchContext, OptionalIterator;
 
+/* The id following docId to return, or maxDocId + 1 if there is none */
+static t_docId OI_NextCandidate(OptionalMatchContext *nc, t_docId docId) {
+  if (!nc->live) {
+    return docId + 1;
+  }
+  t_docId next = DocIdBitmap_Next(nc->live, docId + 1, &nc->liveHint);
+  return next ? next : nc->maxDocId + 1;
+}
+
 static void OI_Free(IndexIterator *it) {
   OptionalMatchContext *nc = it->ctx;
   if (nc->child) {
@@ -1353,13 +1520,14 @@ static IndexCriteriaTester *OI_GetCriteriaTester(void *ctx) {
 
 static size_t OI_NumEstimated(void *ctx) {
   OptionalMatchContext *nc = ctx;
-  return nc->maxDocId;
+  return nc->live ? DocIdBitmap_Cardinality(nc->live) : nc->maxDocId;
 }
 
 static int OI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
   OptionalMatchContext *nc = ctx;
   if (nc->lastDocId >= nc->maxDocId) return INDEXREAD_EOF;
-  nc->lastDocId++;
+  nc->lastDocId = OI_NextCandidate(nc, nc->lastDocId);
+  if (nc->lastDocId > nc->maxDocId) return INDEXREAD_EOF;
   nc->base.current = nc->virt;
   nc->base.current->docId = nc->lastDocId;
   *hit = nc->base.current;
@@ -1379,11 +1547,15 @@ static int OI_ReadSorted(void *ctx, RSIndexResult **hit) {
     return INDEXREAD_EOF;
   }
 
-  // Increase the size by one
-  nc->lastDocId++;
+  // Move on to the next candidate
+  nc->lastDocId = OI_NextCandidate(nc, nc->lastDocId);
+  if (nc->lastDocId > nc->maxDocId) {
+    return INDEXREAD_EOF;
+  }
 
   if (nc->lastDocId > nc->nextRealId) {
-    int rc = nc->child->Read(nc->child->ctx, &nc->base.current);
+    // candidates may skip ids, so the child is skipped to the candidate rather than read
+    int rc = nc->child->SkipTo(nc->child->ctx, nc->lastDocId, &nc->base.current);
     if (rc == INDEXREAD_EOF) {
       nc->nextRealId = nc->maxDocId + 1;
     } else {
@@ -1395,6 +1567,8 @@ static int OI_ReadSorted(void *ctx, RSIndexResult **hit) {
     nc->base.current = nc->virt;
     nc->base.current->weight = 0;
   } else {
+    // the child's hit may have been read by a previous call
+    nc->base.current = nc->child->current;
     nc->base.current->weight = nc->weight;
   }
 
@@ -1432,13 +1606,15 @@ static t_docId OI_LastDocId(void *ctx) {
 static void OI_Rewind(void *ctx) {
   OptionalMatchContext *nc = ctx;
   nc->lastDocId = 0;
+  nc->liveHint = 0;
   nc->virt->docId = 0;
   if (nc->child) {
     nc->child->Rewind(nc->child->ctx);
   }
 }
 
-IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double weight) {
+IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, const DocIdBitmap *live,
+                                   double weight) {
   OptionalMatchContext *nc = rm_malloc(sizeof(*nc));
   nc->virt = NewVirtualResult(weight);
   nc->virt->fieldMask = RS_FIELDMASK_ALL;
@@ -1450,6 +1626,8 @@ IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double w
   nc->maxDocId = maxDocId;
   nc->weight = weight;
   nc->nextRealId = 0;
+  nc->live = live;
+  nc->liveHint = 0;
 
   IndexIterator *ret = &nc->base;
   ret->ctx = nc;
@@ -1488,8 +1666,22 @@ typedef struct {
   IndexIterator base;
   t_docId topId;
   t_docId current;
+  const DocIdBitmap *live;
+  size_t liveHint;
 } WildcardIterator, WildcardIteratorCtx;
 
+/* Move to the first live id >= docId. Returns 0 if there is none up to the top id */
+static int WI_Seek(WildcardIteratorCtx *nc, t_docId docId) {
+  if (nc->live) {
+    docId = DocIdBitmap_Next(nc->live, docId, &nc->liveHint);
+    if (!docId) {
+      docId = nc->topId + 1;
+    }
+  }
+  nc->current = docId;
+  return docId <= nc->topId;
+}
+
 /* Free a wildcard iterator */
 static void WI_Free(IndexIterator *it) {
 
@@ -1501,7 +1693,7 @@ static void WI_Free(IndexIterator *it) {
 /* Read reads the next consecutive id, unless we're at the end */
 static int WI_Read(void *ctx, RSIndexResult **hit) {
   WildcardIteratorCtx *nc = ctx;
-  if (nc->current > nc->topId) {
+  if (nc->current > nc->topId || !WI_Seek(nc, nc->current)) {
     return INDEXREAD_EOF;
   }
   CURRENT_RECORD(nc)->docId = nc->current++;
@@ -1511,9 +1703,8 @@ static int WI_Read(void *ctx, RSIndexResult **hit) {
   return INDEXREAD_OK;
 }
 
-/* Skipto for wildcard iterator - always succeeds, but this should normally not happen as it has
- * no
- * meaning */
+/* Skipto for wildcard iterator - succeeds for every live document. Without the live documents
+ * it always succeeds */
 static int WI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   // printf("WI_Skipto %d\n", docId);
   WildcardIteratorCtx *nc = ctx;
@@ -1522,12 +1713,14 @@ static int WI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
   if (docId == 0) return WI_Read(ctx, hit);
 
-  nc->current = docId;
-  CURRENT_RECORD(nc)->docId = docId;
+  if (!WI_Seek(nc, docId)) {
+    return INDEXREAD_EOF;
+  }
+  CURRENT_RECORD(nc)->docId = nc->current;
   if (hit) {
     *hit = CURRENT_RECORD(nc);
   }
-  return INDEXREAD_OK;
+  return nc->current == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
 }
 
 static void WI_Abort(void *ctx) {
@@ -1545,7 +1738,7 @@ static int WI_HasNext(void *ctx) {
 /* Our len is the len of the index... */
 static size_t WI_Len(void *ctx) {
   WildcardIteratorCtx *nc = ctx;
-  return nc->topId;
+  return nc->live ? DocIdBitmap_Cardinality(nc->live) : nc->topId;
 }
 
 /* Last docId */
@@ -1558,6 +1751,7 @@ static t_docId WI_LastDocId(void *ctx) {
 static void WI_Rewind(void *p) {
   WildcardIteratorCtx *ctx = p;
   ctx->current = 1;
+  ctx->liveHint = 0;
 }
 
 static size_t WI_NumEstimated(void *p) {
@@ -1565,10 +1759,11 @@ static size_t WI_NumEstimated(void *p) {
 }
 
 /* Create a new wildcard iterator */
-IndexIterator *NewWildcardIterator(t_docId maxId) {
+IndexIterator *NewWildcardIterator(t_docId maxId, const DocIdBitmap *live) {
   WildcardIteratorCtx *c = rm_calloc(1, sizeof(*c));
   c->current = 1;
   c->topId = maxId;
+  c->live = live;
 
   CURRENT_RECORD(c) = NewVirtualResult(1);
   CURRENT_RECORD(c)->freq = 1;
@@ -1776,7 +1971,8 @@ PRINT_PROFILE_FUNC(printUnionIt) {
 
 PRINT_PROFILE_FUNC(printIntersectIt) {
   IntersectIterator *ii = (IntersectIterator *)root;
-  RedisModule_ReplyWithArray(ctx, ii->num + 2 + PROFILE_VERBOSE);
+  size_t ntesters = array_len(ii->testers);
+  RedisModule_ReplyWithArray(ctx, ii->num + ntesters + 2 + PROFILE_VERBOSE);
   RedisModule_ReplyWithSimpleString(ctx, "Intersect iterator");
   RedisModule_ReplyWithLongLong(ctx, counter);
   if (PROFILE_VERBOSE) RedisModule_ReplyWithDouble(ctx, cpuTime);
@@ -1787,6 +1983,10 @@ PRINT_PROFILE_FUNC(printIntersectIt) {
       RedisModule_ReplyWithNull(ctx);
     }
   }
+  // the children which are tested rather than iterated
+  for (size_t i = 0; i < ntesters; i++) {
+    RedisModule_ReplyWithSimpleString(ctx, "Criteria tester");
+  }
 }
 
 #define PRINT_PROFILE_SINGLE(name, iterType, text, hasChild)                        \
@@ -1811,6 +2011,7 @@ PRINT_PROFILE_SINGLE(printNotIt, NotIterator, "Not iterator", 1);
 PRINT_PROFILE_SINGLE(printOptionalIt, OptionalIterator, "Optional iterator", 1);
 PRINT_PROFILE_SINGLE(printWildcardIt, DummyIterator, "Wildcard iterator", 0);
 PRINT_PROFILE_SINGLE(printIdListIt, DummyIterator, "ID-List iterator", 0);
+PRINT_PROFILE_SINGLE(printBitmapIt, DummyIterator, "Bitmap iterator", 0);
 PRINT_PROFILE_SINGLE(printEmptyIt, DummyIterator, "Empty iterator", 0);
 
 PRINT_PROFILE_FUNC(printProfileIt) {
@@ -1840,6 +2041,7 @@ void printIteratorProfile(RedisModuleCtx *ctx, IndexIterator *root, size_t count
     case WILDCARD_ITERATOR:   { printWildcardIt(ctx, root, counter, cpuTime, depth, limited);   break; }
     case EMPTY_ITERATOR:      { printEmptyIt(ctx, root, counter, cpuTime, depth, limited);      break; }
     case ID_LIST_ITERATOR:    { printIdListIt(ctx, root, counter, cpuTime, depth, limited);     break; }
+    case BITMAP_ITERATOR:     { printBitmapIt(ctx, root, counter, cpuTime, depth, limited);     break; }
     case PROFILE_ITERATOR:    { printProfileIt(ctx, root, 0, 0, depth, limited);                break; }
     default:          { RS_LOG_ASSERT(0, "nope");   break; }
   }
@@ -1879,6 +2081,7 @@ void Profile_AddIters(IndexIterator **root) {
     case READ_ITERATOR:
     case EMPTY_ITERATOR:
     case ID_LIST_ITERATOR:
+    case BITMAP_ITERATOR:
       break;
     case PROFILE_ITERATOR:
     case MAX_ITERATOR:
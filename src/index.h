@@ -9,6 +9,7 @@
 #include "util/logging.h"
 #include "varint.h"
 #include "query_node.h"
+#include "extension.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,6 +41,13 @@ It will return each document of the underlying iterators, exactly once */
 IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int quickExit,
                                 double weight, QueryNodeType type, const char *qstr);
 
+/* Let a union of term iterators skip whole index blocks in which no document can score at least
+ * *minScore, according to the scorer's bound function. minScore is read on every call to Read and
+ * may increase while iterating. Returns 0 if the iterator does not support pruning */
+int UnionIterator_EnableBlockMaxPruning(IndexIterator *it, const double *minScore,
+                                        double maxDocScore, ExtScoreBoundFunction bf,
+                                        const RSIndexStats *stats);
+
 /* Create a new intersect iterator over the given list of child iterators. If maxSlop is not a
  * negative number, we will allow at most maxSlop intervening positions between the terms. If
  * maxSlop is set and inOrder is 1, we assert that the terms are in
@@ -47,18 +55,27 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int q
 IndexIterator *NewIntersecIterator(IndexIterator **its, size_t num, DocTable *t,
                                    t_fieldMask fieldMask, int maxSlop, int inOrder, double weight);
 
-/* Create a NOT iterator by wrapping another index iterator */
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight);
+/* Add a tester to an intersection, checked on every document found on all its children. The
+ * intersection takes ownership of the tester */
+void IntersectIterator_AddTester(IndexIterator *it, IndexCriteriaTester *tester);
+
+/* Create a NOT iterator by wrapping another index iterator. If `live` is set, only the ids in it
+ * are returned, otherwise all the ids up to maxDocId are */
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, const DocIdBitmap *live,
+                              double weight);
 
 /* Create an Optional clause iterator by wrapping another index iterator. An optional iterator
- * always returns OK on skips, but a virtual hit with frequency of 0 if there is no hit */
-IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double weight);
+ * always returns OK on skips, but a virtual hit with frequency of 0 if there is no hit. Like the NOT
+ * iterator, it reads the ids in `live` if it is set */
+IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, const DocIdBitmap *live,
+                                   double weight);
 
 /* Create a wildcard iterator, matching ALL documents in the index. This is used for one thing only
  * - purely negative queries. If the root of the query is a negative expression, we cannot process
  * it without a positive expression. So we create a wildcard iterator that basically just iterates
- * all the incremental document ids, and matches every skip within its range. */
-IndexIterator *NewWildcardIterator(t_docId maxId);
+ * all the incremental document ids, and matches every skip within its range. If `live` is set, it
+ * iterates the ids of the live documents in it instead */
+IndexIterator *NewWildcardIterator(t_docId maxId, const DocIdBitmap *live);
 
 /* Create a new IdListIterator from a pre populated list of document ids of size num. The doc ids
  * are sorted in this function, so there is no need to sort them. They are automatically freed in
@@ -21,6 +21,7 @@ enum iteratorType {
   WILDCARD_ITERATOR,
   EMPTY_ITERATOR,
   ID_LIST_ITERATOR,
+  BITMAP_ITERATOR,
   PROFILE_ITERATOR,
   MAX_ITERATOR,
 };
@@ -249,7 +249,7 @@ static int makeDocumentId(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, int repl
       --spec->stats.numDocuments;
       aCtx->oldMd = dmd;
       if (sctx->spec->gc) {
-        GCContext_OnDelete(sctx->spec->gc);
+        GCContext_OnDelete(sctx->spec->gc, dmd->id);
       }
     }
   }
@@ -444,6 +444,29 @@ cleanup:
   }
 }
 
+void Indexer_ProcessBatch(RSAddDocumentCtx *head, RedisSearchCtx *sctx) {
+  RSAddDocumentCtx *parentMap[MAX_BULK_DOCS];
+  BlkAlloc alloc;
+  KHTable mergeHt;
+
+  // the indexer's own table may be in use by its thread, so merge into a private one
+  BlkAlloc_Init(&alloc);
+  static const KHTableProcs procs = {
+      .Alloc = mergedAlloc, .Compare = mergedCompare, .Hash = mergedHash};
+  KHTable_Init(&mergeHt, &procs, &alloc, 4096);
+
+  RSAddDocumentCtx *firstZeroId = doMerge(head, &mergeHt, parentMap);
+  if (firstZeroId) {
+    doAssignIds(firstZeroId, sctx);
+  }
+  writeMergedEntries(head->indexer, head, sctx, &mergeHt, parentMap);
+  indexBulkFields(head, sctx);
+
+  KHTable_Clear(&mergeHt);
+  KHTable_Free(&mergeHt);
+  BlkAlloc_FreeAll(&alloc, NULL, 0, 0);
+}
+
 #define SHOULD_STOP(idxer) ((idxer)->options & INDEXER_STOPPED)
 
 static void *Indexer_Run(void *p) {
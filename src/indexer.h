@@ -51,6 +51,14 @@ DocumentIndexer *NewIndexer(IndexSpec *spec);
  */
 int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx);
 
+/**
+ * Write a chain of preprocessed documents (linked by their `next` field) to the index, merging
+ * the entries of all the documents by term so that every inverted index is opened once.
+ * The documents are assigned IDs in bulk. Must be called with the GIL held. The contexts are not
+ * finished; this is left to the caller.
+ */
+void Indexer_ProcessBatch(RSAddDocumentCtx *head, RedisSearchCtx *sctx);
+
 /**
  * Function to preprocess field data. This should do as much stateless processing
  * as possible on the field - this means things like input validation and normalization.
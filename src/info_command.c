@@ -2,6 +2,7 @@
 #include "spec.h"
 #include "inverted_index.h"
 #include "cursor.h"
+#include "async_index.h"
 
 #define REPLY_KVNUM(n, k, v)                       \
   do {                                             \
@@ -176,9 +177,9 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   //  REPLY_KVNUM(n, "score_index_size_mb", sp->stats.scoreIndexesSize / (float)0x100000);
 
   REPLY_KVNUM(n, "doc_table_size_mb", sp->docs.memsize / (float)0x100000);
-  REPLY_KVNUM(n, "sortable_values_size_mb", sp->docs.sortablesSize / (float)0x100000);
+  REPLY_KVNUM(n, "sortable_values_size_mb", DocTable_SortablesSize(&sp->docs) / (float)0x100000);
 
-  REPLY_KVNUM(n, "key_table_size_mb", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  REPLY_KVNUM(n, "key_table_size_mb", DocIdMap_MemUsage(&sp->docs.dim) / (float)0x100000);
   REPLY_KVNUM(n, "records_per_doc_avg",
               (float)sp->stats.numRecords / (float)sp->stats.numDocuments);
   REPLY_KVNUM(n, "bytes_per_record_avg",
@@ -206,6 +207,12 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   REPLY_KVNUM(n, "percent_indexed", percent_indexed);
 
+  if (sp->asyncQueue) {
+    RedisModule_ReplyWithSimpleString(ctx, "async_indexing");
+    AsyncIndexQueue_RenderStats(sp->asyncQueue, ctx);
+    n += 2;
+  }
+
   if (sp->gc) {
     RedisModule_ReplyWithSimpleString(ctx, "gc_stats");
     GCContext_RenderStats(sp->gc, ctx);
@@ -53,6 +53,34 @@ IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId) {
   return &INDEX_LAST_BLOCK(idx);
 }
 
+/* Append a skip pointer to the record at the given offset of a block starting at firstId, which
+ * follows the record with id prevId. Pointers whose relative id does not fit are not added */
+static void appendSkip(IndexBlockSkip *skips, uint8_t *numSkips, t_docId firstId, t_docId prevId,
+                       size_t offset) {
+  if (*numSkips < INDEX_BLOCK_MAX_SKIPS && prevId - firstId <= UINT32_MAX) {
+    skips[(*numSkips)++] = (IndexBlockSkip){.prevId = prevId - firstId, .offset = offset};
+  }
+}
+
+/* Add a skip pointer to the block being written, growing its skip pointers by one */
+static void IndexBlock_AddSkip(IndexBlock *blk, t_docId prevId, size_t offset) {
+  if (blk->numSkips < INDEX_BLOCK_MAX_SKIPS && prevId - blk->firstId <= UINT32_MAX) {
+    blk->skips = rm_realloc(blk->skips, (blk->numSkips + 1) * sizeof(*blk->skips));
+    appendSkip(blk->skips, &blk->numSkips, blk->firstId, prevId, offset);
+  }
+}
+
+/* Replace the skip pointers of a block with the given ones */
+static void IndexBlock_SetSkips(IndexBlock *blk, const IndexBlockSkip *skips, uint8_t numSkips) {
+  rm_free(blk->skips);
+  blk->skips = NULL;
+  if (numSkips) {
+    blk->skips = rm_malloc(numSkips * sizeof(*skips));
+    memcpy(blk->skips, skips, numSkips * sizeof(*skips));
+  }
+  blk->numSkips = numSkips;
+}
+
 InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
   InvertedIndex *idx = rm_malloc(sizeof(InvertedIndex));
   idx->blocks = NULL;
@@ -69,6 +97,9 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
 
 void indexBlock_Free(IndexBlock *blk) {
   Buffer_Free(&blk->buf);
+  rm_free(blk->skips);
+  blk->skips = NULL;
+  blk->numSkips = 0;
 }
 
 void InvertedIndex_Free(void *ctx) {
@@ -110,9 +141,20 @@ void IndexReader_OnReopen(void *privdata) {
     }
   }
 
+  IndexReader_Resync(ir);
+}
+
+void IndexReader_Resync(IndexReader *ir) {
+  if (ir->sp && ir->idsVersion != ir->sp->docs.idsVersion) {
+    // the documents were renumbered while we were asleep, there is no position to resume from
+    IR_Abort(ir);
+    return;
+  }
+
   // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
   if (ir->gcMarker == ir->idx->gcMarker) {
-    // no GC - we just go to the same offset we were at
+    // no GC - we just go to the same offset we were at. Buffered records keep their positions in
+    // the block rather than pointers, so they are still valid
     size_t offset = ir->br.pos;
     ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
     ir->br.pos = offset;
@@ -125,6 +167,9 @@ void IndexReader_OnReopen(void *privdata) {
     ir->currentBlock = 0;
     ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
     ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+    if (ir->buffer) {
+      ir->buffer->len = ir->buffer->pos = 0;
+    }
 
     // seek to the previous last id
     RSIndexResult *dummy = NULL;
@@ -445,6 +490,10 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
     delta = 0;
   }
 
+  if (blk->numDocs && blk->numDocs % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+    IndexBlock_AddSkip(blk, blk->lastId, blk->buf.offset);
+  }
+
   BufferWriter bw = NewBufferWriter(&blk->buf);
 
   // printf("Writing docId %llu, delta %llu, flags %x\n", docId, delta, (int)idx->flags);
@@ -452,6 +501,9 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
 
   idx->lastId = docId;
   blk->lastId = docId;
+  if (entry->freq > blk->maxFreq) {
+    blk->maxFreq = MIN(entry->freq, INDEX_BLOCK_MAXFREQ_UNKNOWN);
+  }
   ++blk->numDocs;
   ++idx->numDocs;
 
@@ -646,13 +698,12 @@ DECODER(readNumeric) {
 
   NumericFilter *f = ctx->ptr;
   if (f) {
-    if (f->geoFilter == NULL) {
-      int rv = NumericFilter_Match(f, res->num.value);
-      // printf("Checking against filter: %d\n", rv);
-      return rv;
-    } else {
-      return isWithinRadius(f->geoFilter, res->num.value, NULL);
+    int rv = NumericFilter_Match(f, res->num.value);
+    // printf("Checking against filter: %d\n", rv);
+    if (rv && f->geoFilter) {
+      rv = GeoFilter_Match(f->geoFilter, res->num.value);
     }
+    return rv;
   }
   // printf("Field matches.. hurray!\n");
   return 1;
@@ -773,6 +824,30 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
   }
 }
 
+/* The layout of records which are a single qint record, optionally followed by the offsets. Wide
+ * field masks are varint encoded and doc ids only records are a plain varint, so these are read one
+ * at a time by their decoder */
+static IndexRecordLayout InvertedIndex_GetRecordLayout(uint32_t flags) {
+  switch (flags & INDEX_STORAGE_MASK) {
+    case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets:
+      return (IndexRecordLayout){.width = 4, .freq = 1, .fieldMask = 2, .offsets = 3};
+    case Index_StoreFreqs | Index_StoreFieldFlags:
+      return (IndexRecordLayout){.width = 3, .freq = 1, .fieldMask = 2, .offsets = -1};
+    case Index_StoreFreqs | Index_StoreTermOffsets:
+      return (IndexRecordLayout){.width = 3, .freq = 1, .fieldMask = -1, .offsets = 2};
+    case Index_StoreFieldFlags | Index_StoreTermOffsets:
+      return (IndexRecordLayout){.width = 3, .freq = -1, .fieldMask = 1, .offsets = 2};
+    case Index_StoreFreqs:
+      return (IndexRecordLayout){.width = 2, .freq = 1, .fieldMask = -1, .offsets = -1};
+    case Index_StoreFieldFlags:
+      return (IndexRecordLayout){.width = 2, .freq = -1, .fieldMask = 1, .offsets = -1};
+    case Index_StoreTermOffsets:
+      return (IndexRecordLayout){.width = 2, .freq = -1, .fieldMask = -1, .offsets = 1};
+    default:
+      return (IndexRecordLayout){0};
+  }
+}
+
 IndexReader *NewNumericReader(const IndexSpec *sp, InvertedIndex *idx, const NumericFilter *flt,
                               double rangeMin, double rangeMax) {
   RSIndexResult *res = NewNumericResult();
@@ -891,12 +966,85 @@ size_t IR_NumEstimated(void *ctx) {
   return ir->idx->numDocs;
 }
 
+/* Decode up to `limit` of the next records of the current block into the reader's buffer, moving
+ * to the next block if it is exhausted. Returns 0 if there are no more records */
+static int IR_FillBuffer(IndexReader *ir, size_t limit) {
+  IndexReaderBuffer *b = ir->buffer;
+  const IndexRecordLayout *l = &ir->layout;
+  const t_fieldMask mask = ir->decoderCtx.num;
+  const t_docId lastId = ir->lastId;
+  b->len = b->pos = 0;
+
+  while (!b->len) {
+    // skip to the next block, skipping empty blocks that may appear here due to GC
+    while (BufferReader_AtEnd(&ir->br)) {
+      if (ir->currentBlock + 1 == ir->idx->size) {
+        ir->lastId = lastId;
+        return 0;
+      }
+      IndexReader_AdvanceBlock(ir);
+    }
+
+    int isFirst = ir->br.pos == 0;
+    size_t n = qint_decode_records(&ir->br, l->width, l->offsets, b->vals, b->offsetsPos, limit);
+    t_docId id = b->lastDecoded;
+    if (isFirst) {
+      // in old version rdbs the first entry of a block is the docid itself and not the delta
+      id = b->vals[0][0] ? 0 : IR_CURRENT_BLOCK(ir).firstId;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      id += b->vals[i][0];
+      if (l->fieldMask >= 0 && !(b->vals[i][l->fieldMask] & mask)) {
+        continue;
+      }
+      if (b->len != i) {
+        memcpy(b->vals[b->len], b->vals[i], sizeof(b->vals[i]));
+        b->offsetsPos[b->len] = b->offsetsPos[i];
+      }
+      b->docIds[b->len++] = id;
+    }
+    b->lastDecoded = id;
+  }
+  ir->lastId = lastId;
+  return 1;
+}
+
+/* Populate the reader's record from the i'th buffered record */
+static inline RSIndexResult *IR_ReadBuffered(IndexReader *ir, uint16_t i) {
+  const IndexReaderBuffer *b = ir->buffer;
+  const IndexRecordLayout *l = &ir->layout;
+  RSIndexResult *record = ir->record;
+  record->docId = ir->lastId = b->docIds[i];
+  if (l->freq >= 0) {
+    record->freq = b->vals[i][l->freq];
+  }
+  if (l->fieldMask >= 0) {
+    record->fieldMask = b->vals[i][l->fieldMask];
+  }
+  if (l->offsets >= 0) {
+    record->offsetsSz = b->vals[i][l->offsets];
+    record->term.offsets = (RSOffsetVector){
+        .data = IR_CURRENT_BLOCK(ir).buf.data + b->offsetsPos[i], .len = record->offsetsSz};
+  }
+  ++ir->len;
+  return record;
+}
+
 int IR_Read(void *ctx, RSIndexResult **e) {
 
   IndexReader *ir = ctx;
   if (IR_IS_AT_END(ir)) {
     goto eof;
   }
+
+  if (ir->buffer) {
+    IndexReaderBuffer *b = ir->buffer;
+    if (b->pos == b->len && !IR_FillBuffer(ir, IR_BUFFER_SIZE)) {
+      goto eof;
+    }
+    *e = IR_ReadBuffered(ir, b->pos++);
+    return INDEXREAD_OK;
+  }
   do {
 
     // if needed - skip to the next block (skipping empty blocks that may appear here due to GC)
@@ -970,6 +1118,59 @@ new_block:
   return rc;
 }
 
+/* Move the reader to the last skip pointer of its current block which precedes docId, if it is
+ * ahead of the reader. Returns 1 and puts the id of the record preceding the new position in
+ * prevId if the reader was moved */
+static int IndexReader_SkipInBlock(IndexReader *ir, t_docId docId, t_docId *prevId) {
+  const IndexBlock *blk = &IR_CURRENT_BLOCK(ir);
+  int i = blk->numSkips - 1;
+  while (i >= 0 && blk->firstId + blk->skips[i].prevId >= docId) {
+    --i;
+  }
+  if (i < 0 || blk->skips[i].offset <= ir->br.pos) {
+    return 0;
+  }
+  ir->br.pos = blk->skips[i].offset;
+  *prevId = blk->firstId + blk->skips[i].prevId;
+  return 1;
+}
+
+/* SkipTo for readers reading from their buffer. The buffered ids are sorted, so the record is
+ * looked up with a binary search instead of decoding the records one by one */
+static int IR_SkipToBuffered(IndexReader *ir, t_docId docId, RSIndexResult **hit) {
+  IndexReaderBuffer *b = ir->buffer;
+  if (!BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId)) {
+    IndexReader_SkipToBlock(ir, docId);
+    b->len = b->pos = 0;
+  }
+
+  while (b->pos == b->len || b->docIds[b->len - 1] < docId) {
+    // all the buffered records precede docId. If we can jump ahead, the record we look for is
+    // before the next skip pointer, so only the records up to it are decoded
+    size_t limit = IR_BUFFER_SIZE;
+    if (IndexReader_SkipInBlock(ir, docId, &b->lastDecoded)) {
+      limit = INDEX_BLOCK_SKIP_INTERVAL;
+    }
+    if (!IR_FillBuffer(ir, limit)) {
+      IR_SetAtEnd(ir, 1);
+      return INDEXREAD_EOF;
+    }
+  }
+
+  uint16_t lo = b->pos, hi = b->len - 1;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (b->docIds[mid] < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  b->pos = lo + 1;
+  *hit = IR_ReadBuffered(ir, lo);
+  return (*hit)->docId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
 int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   IndexReader *ir = ctx;
   if (!docId) {
@@ -984,6 +1185,10 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     goto eof;
   }
 
+  if (ir->buffer) {
+    return IR_SkipToBuffered(ir, docId, hit);
+  }
+
   if (!BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId)) {
     IndexReader_SkipToBlock(ir, docId);
   } else if (BufferReader_AtEnd(&ir->br)) {
@@ -995,6 +1200,9 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     }
   }
 
+  // jump over the records of the block that precede the last skip pointer before docId
+  IndexReader_SkipInBlock(ir, docId, &ir->lastId);
+
   /**
    * We need to replicate the effects of IR_Read() without actually calling it
    * continuously.
@@ -1077,6 +1285,9 @@ static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedInde
   ret->decoderCtx = decoderCtx;
   ret->isValidP = NULL;
   ret->sp = sp;
+  ret->idsVersion = sp ? sp->docs.idsVersion : 0;
+  ret->layout = (IndexRecordLayout){0};
+  ret->buffer = NULL;
   IR_SetAtEnd(ret, 0);
 }
 
@@ -1107,10 +1318,17 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
 
   IndexDecoderCtx dctx = {.num = fieldMask};
 
-  return NewIndexReaderGeneric(sp, idx, decoder, dctx, record, weight);
+  IndexReader *ir = NewIndexReaderGeneric(sp, idx, decoder, dctx, record, weight);
+  ir->layout = InvertedIndex_GetRecordLayout((uint32_t)idx->flags);
+  if (ir->layout.width) {
+    ir->buffer = rm_malloc(sizeof(*ir->buffer));
+    ir->buffer->len = ir->buffer->pos = 0;
+  }
+  return ir;
 }
 
 void IR_Free(IndexReader *ir) {
+  rm_free(ir->buffer);
 
   IndexResult_Free(ir->record);
   rm_free(ir);
@@ -1142,6 +1360,9 @@ void IR_Rewind(void *ctx) {
   ir->gcMarker = ir->idx->gcMarker;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  if (ir->buffer) {
+    ir->buffer->len = ir->buffer->pos = 0;
+  }
 }
 
 typedef struct {
@@ -1187,7 +1408,12 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
 
   RSIndexResult *res = flags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
   size_t frags = 0;
+  size_t nvalid = 0;
   int isLastValid = 0;
+  uint32_t maxFreq = 0;
+  // the skip pointers of the repaired block, replacing the block's ones if records were removed
+  IndexBlockSkip skips[INDEX_BLOCK_MAX_SKIPS];
+  uint8_t numSkips = 0;
 
   uint32_t readFlags = flags & INDEX_STORAGE_MASK;
   IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
@@ -1232,6 +1458,14 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
       params->bytesCollected += sz;
       isLastValid = 0;
     } else {
+      // the skip pointers are rebuilt along with the block, from the position of the record in
+      // the repaired buffer or in the original one if nothing was removed yet
+      if (nvalid && nvalid % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+        appendSkip(skips, &numSkips, blk->firstId, blk->lastId,
+                   frags ? repair.offset : bufBegin - blk->buf.data);
+      }
+      ++nvalid;
+
       // Valid document, but we're rewriting the block:
       if (frags) {
 
@@ -1253,6 +1487,7 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
         blk->firstId = res->docId;
       }
       blk->lastId = res->docId;
+      maxFreq = MAX(maxFreq, res->freq);
       isLastValid = 1;
     }
   }
@@ -1263,6 +1498,8 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     Buffer_Free(&blk->buf);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    blk->maxFreq = MIN(maxFreq, INDEX_BLOCK_MAXFREQ_UNKNOWN);
+    IndexBlock_SetSkips(blk, skips, numSkips);
   }
   if (blk->numDocs == 0) {
     // if we left with no elements we do need to keep the
@@ -1280,6 +1517,37 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
   return frags;
 }
 
+void IndexBlock_Rescan(IndexBlock *blk, IndexFlags flags) {
+  uint32_t readFlags = flags & INDEX_STORAGE_MASK;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
+  if (!decoders.decoder) {
+    return;
+  }
+
+  static const IndexDecoderCtx empty = {0};
+  RSIndexResult *res =
+      readFlags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
+  BufferReader br = NewBufferReader(&blk->buf);
+  uint32_t maxFreq = 0;
+  t_docId lastId = blk->firstId;
+  IndexBlockSkip skips[INDEX_BLOCK_MAX_SKIPS];
+  uint8_t numSkips = 0;
+  for (size_t n = 0; !BufferReader_AtEnd(&br); ++n) {
+    size_t pos = br.pos;
+    if (n && n % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+      appendSkip(skips, &numSkips, blk->firstId, lastId, pos);
+    }
+    decoders.decoder(&br, &empty, res);
+    lastId = calculateId(lastId, *(uint32_t *)&res->docId, pos == 0);
+    maxFreq = MAX(maxFreq, res->freq);
+  }
+  IndexBlock_SetSkips(blk, skips, numSkips);
+  if (readFlags != Index_StoreNumeric) {
+    blk->maxFreq = MIN(maxFreq, INDEX_BLOCK_MAXFREQ_UNKNOWN);
+  }
+  IndexResult_Free(res);
+}
+
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params) {
   size_t limit = params->limit ? params->limit : SIZE_MAX;
@@ -1307,3 +1575,56 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
 
   return startBlock < idx->size ? startBlock : 0;
 }
+
+void InvertedIndex_Renumber(InvertedIndex *idx, const DocIdRemap *remap,
+                            IndexRepairParams *params) {
+  uint32_t readFlags = idx->flags & INDEX_STORAGE_MASK;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
+  IndexEncoder encoder = InvertedIndex_GetEncoder(readFlags);
+  if (!encoder || !decoders.decoder) {
+    fprintf(stderr, "Could not get decoder/encoder for index\n");
+    return;
+  }
+
+  // The new ids keep the order of the old ones, so the records are written to a new index in the
+  // order they are read
+  static const IndexDecoderCtx empty = {0};
+  RSIndexResult *res = readFlags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
+  InvertedIndex *renumbered = NewInvertedIndex(idx->flags, 1);
+  for (uint32_t i = 0; i < idx->size; ++i) {
+    IndexBlock *blk = idx->blocks + i;
+    BufferReader br = NewBufferReader(&blk->buf);
+    t_docId lastId = blk->firstId;
+    while (!BufferReader_AtEnd(&br)) {
+      int isFirst = br.pos == 0;
+      decoders.decoder(&br, &empty, res);
+      lastId = calculateId(lastId, *(uint32_t *)&res->docId, isFirst);
+      t_docId docId = DocIdRemap_Get(remap, lastId);
+      if (!docId) {
+        ++params->docsCollected;
+        continue;
+      }
+      res->docId = docId;
+      InvertedIndex_WriteEntryGeneric(renumbered, encoder, docId, res);
+    }
+    params->bytesBeforFix += blk->buf.offset;
+    indexBlock_Free(blk);
+  }
+  IndexResult_Free(res);
+
+  for (uint32_t i = 0; i < renumbered->size; ++i) {
+    // the last block is left room for the records to come
+    if (i < renumbered->size - 1) {
+      Buffer_ShrinkToSize(&renumbered->blocks[i].buf);
+    }
+    params->bytesAfterFix += renumbered->blocks[i].buf.offset;
+  }
+  TotalIIBlocks -= idx->size;
+  rm_free(idx->blocks);
+  idx->blocks = renumbered->blocks;
+  idx->size = renumbered->size;
+  idx->lastId = renumbered->lastId;
+  idx->numDocs = renumbered->numDocs;
+  ++idx->gcMarker;
+  rm_free(renumbered);
+}
@@ -18,14 +18,38 @@ extern "C" {
 
 extern uint64_t TotalIIBlocks;
 
+// Number of records between two consecutive skip pointers of a block
+#define INDEX_BLOCK_SKIP_INTERVAL 16
+// Maximal number of skip pointers in a block, enough for a full block
+#define INDEX_BLOCK_MAX_SKIPS 6
+
+/* A position in a block from which its records can be decoded, so that readers seeking forward
+ * do not need to decode the records preceding it */
+typedef struct {
+  // id of the record preceding the position, relative to the block's first id. The record at the
+  // position is delta encoded from it
+  uint32_t prevId;
+  // offset of the record in the block's buffer
+  uint32_t offset;
+} IndexBlockSkip;
+
 /* A single block of data in the index. The index is basically a list of blocks we iterate */
 typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
+  // a skip pointer for every INDEX_BLOCK_SKIP_INTERVAL records, in order. Only allocated once the
+  // block reaches INDEX_BLOCK_SKIP_INTERVAL records, NULL before
+  IndexBlockSkip *skips;
   uint16_t numDocs;
+  // the maximal term frequency of the records in this block, used to bound the score of any
+  // document in it. INDEX_BLOCK_MAXFREQ_UNKNOWN if it is too high or was not recorded
+  uint16_t maxFreq;
+  uint8_t numSkips;
 } IndexBlock;
 
+#define INDEX_BLOCK_MAXFREQ_UNKNOWN UINT16_MAX
+
 typedef struct InvertedIndex {
   IndexBlock *blocks;
   uint32_t size;
@@ -79,9 +103,18 @@ void InvertedIndex_Free(void *idx);
 #define IndexBlock_DataBuf(b) (b)->buf.data
 #define IndexBlock_DataLen(b) (b)->buf.offset
 
+/* Recompute the data kept alongside the records of a block - its maximal frequency and skip
+ * pointers - by decoding all of them. Used when the block was loaded without it */
+void IndexBlock_Rescan(IndexBlock *blk, IndexFlags flags);
+
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params);
 
+/* Rewrite the index with the ids given to the documents by DocTable_Compact(), dropping the records
+ * of documents which are not in the table anymore. The number of records dropped and the size of
+ * the index before and after are added to `params` */
+void InvertedIndex_Renumber(InvertedIndex *idx, const DocIdRemap *remap, IndexRepairParams *params);
+
 /**
  * Decode a single record from the buffer reader. This function is responsible for:
  * (1) Decoding the record at the given position of br
@@ -114,6 +147,33 @@ typedef struct {
  * endoder/decoder when reading and writing */
 IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags);
 
+/* The position of the values in records which are encoded as a single qint record */
+typedef struct {
+  // number of integers in the record, or 0 if the records cannot be decoded in batches
+  uint8_t width;
+  // index of each value in the record, or -1 if it is not stored. The delta is always first
+  int8_t freq;
+  int8_t fieldMask;
+  // the length of the offset vector which follows the record
+  int8_t offsets;
+} IndexRecordLayout;
+
+// Number of records an IndexReader decodes at once
+#define IR_BUFFER_SIZE 128
+
+/* Records decoded ahead of the reader's position. They always belong to the reader's current block,
+ * and records filtered out by the field mask are not kept */
+typedef struct {
+  t_docId docIds[IR_BUFFER_SIZE];
+  uint32_t vals[IR_BUFFER_SIZE][4];
+  // position of the offset vectors in the block
+  uint32_t offsetsPos[IR_BUFFER_SIZE];
+  // id of the last record decoded, used for delta decoding of the next batch
+  t_docId lastDecoded;
+  uint16_t len;
+  uint16_t pos;
+} IndexReaderBuffer;
+
 /* An IndexReader wraps an inverted index record for reading and iteration */
 typedef struct IndexReader {
   const IndexSpec *sp;
@@ -132,6 +192,11 @@ typedef struct IndexReader {
   /* The decoding function for reading the index */
   IndexDecoderProcs decoders;
 
+  /* If the records' layout allows it, they are decoded a block at a time into the buffer, and read
+   * from it instead of using the decoder */
+  IndexRecordLayout layout;
+  IndexReaderBuffer *buffer;
+
   /* The number of records read */
   size_t len;
 
@@ -149,12 +214,25 @@ typedef struct IndexReader {
    */
   uint32_t gcMarker;
 
+  /* The version of the document ids of the spec when the reader was opened. The ids read so far
+   * are meaningless once the documents are renumbered */
+  uint32_t idsVersion;
+
   /* boosting weight */
   double weight;
 } IndexReader;
 
 void IndexReader_OnReopen(void *privdata);
 
+/* Restore the reader's position in its index after the GIL was released. If the GC visited the
+ * index in the meantime, the reader seeks back to the last id it returned */
+void IndexReader_Resync(IndexReader *ir);
+
+/* The block holding the record the reader is currently positioned at */
+static inline const IndexBlock *IndexReader_CurrentBlock(const IndexReader *ir) {
+  return &ir->idx->blocks[ir->currentBlock];
+}
+
 /* An index encoder is a callback that writes records to the index. It accepts a pre-calculated
  * delta for encoding */
 typedef size_t (*IndexEncoder)(BufferWriter *bw, uint32_t delta, RSIndexResult *record);
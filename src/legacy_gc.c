@@ -352,6 +352,9 @@ size_t gc_NumericIndex(RedisModuleCtx *ctx, GarbageCollectorCtx *gc, int *status
     blockNum = InvertedIndex_Repair(nextNode->range->entries, &sctx->spec->docs, blockNum, &params);
     /// update the statistics with the the number of records deleted
     numericGcCtx->rt->numEntries -= params.docsCollected;
+    if (params.docsCollected) {
+      NumericRangeTree_ClearBitmaps(numericGcCtx->rt);
+    }
     totalRemoved += params.docsCollected;
     gc_updateStats(sctx, gc, params.docsCollected, params.bytesCollected);
     // blockNum 0 means error or we've finished
@@ -388,7 +391,7 @@ int GC_PeriodicCallback(RedisModuleCtx *ctx, void *privdata) {
 
   int status = SPEC_STATUS_OK;
   RedisModule_AutoMemory(ctx);
-  RedisModule_ThreadSafeContextLock(ctx);
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
 
   // Check if RDB is loading - not needed after the first time we find out that rdb is not reloading
   if (gc->rdbPossiblyLoading) {
@@ -423,7 +426,7 @@ int GC_PeriodicCallback(RedisModuleCtx *ctx, void *privdata) {
 
 end:
 
-  RedisModule_ThreadSafeContextUnlock(ctx);
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
 
   return status == SPEC_STATUS_OK;
 }
@@ -441,7 +444,7 @@ void GC_OnTerm(void *privdata) {
 }
 
 // called externally when the user deletes a document to hint at increasing the HZ
-void GC_OnDelete(void *ctx) {
+void GC_OnDelete(void *ctx, t_docId docId) {
   GarbageCollectorCtx *gc = ctx;
   if (!gc) return;
   gc->hz = MIN(gc->hz * 1.5, GC_MAX_HZ);
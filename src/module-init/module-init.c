@@ -144,7 +144,7 @@ int RediSearch_Init(RedisModuleCtx *ctx, int mode) {
 
   Indexes_Init(ctx);
 
-  if (RSGlobalConfig.concurrentMode) {
+  if (RSGlobalConfig.concurrentMode || RSGlobalConfig.concurrentReadMode) {
     ConcurrentSearch_ThreadPoolStart();
   }
 
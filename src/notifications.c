@@ -1,6 +1,7 @@
 #include "config.h"
 #include "notifications.h"
 #include "spec.h"
+#include "concurrent_ctx.h"
 
 RedisModuleString *global_RenameFromKey = NULL;
 extern RedisModuleCtx *RSDummyContext;
@@ -35,8 +36,8 @@ static void freeHashFields() {
   }
 }
 
-int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
-                             RedisModuleString *key) {
+static int handleHashNotification(RedisModuleCtx *ctx, int type, const char *event,
+                                  RedisModuleString *key) {
 
 #define CHECK_CACHED_EVENT(E) \
   if (event == E##_event) {   \
@@ -108,7 +109,10 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
       // on loaded event the key is stack allocated so to use it to load the
       // document we must copy it
       key = RedisModule_CreateStringFromString(ctx, key);
-      // notice, not break is ok here, we want to continue.
+      Indexes_LoadedMatchingWithSchemaRules(ctx, key);
+      RedisModule_FreeString(ctx, key);
+      break;
+
     case hset_cmd:
     case hmset_cmd:
     case hsetnx_cmd:
@@ -117,9 +121,6 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
     case hdel_cmd:
     case restore_cmd:
       Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields);
-      if(redisCommand == loaded_cmd){
-        RedisModule_FreeString(ctx, key);
-      }
       break;
 
     case del_cmd:
@@ -158,6 +159,18 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
   return REDISMODULE_OK;
 }
 
+int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
+                             RedisModuleString *key) {
+  // keys are indexed right away, so queries running without the GIL must not read meanwhile
+  if (!ConcurrentSearch_HasReadModeQueries()) {
+    return handleHashNotification(ctx, type, event, key);
+  }
+  ConcurrentSearch_IndexWriteLock();
+  int rc = handleHashNotification(ctx, type, event, key);
+  ConcurrentSearch_IndexWriteUnlock();
+  return rc;
+}
+
 /*****************************************************************************/
 
 void CommandFilterCallback(RedisModuleCommandFilterCtx *filter) {
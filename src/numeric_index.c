@@ -12,16 +12,39 @@
 #define NR_EXPONENT 4
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
+// Number of ranges a filter must cover entirely for them to be read from a bitmap
+#define NR_BITMAP_MIN_RANGES 8
+// Number of bitmaps cached in a tree
+#define NR_BITMAP_CACHE_SIZE 4
 
 typedef struct {
   IndexIterator *it;
   uint32_t lastRevId;
+  NumericRangeTree *t;
+  // the readers of the ranges the iterator goes over
+  IndexReader **readers;
 } NumericUnionCtx;
 
 /* A callback called after a concurrent context regains execution context. When this happen we need
  * to make sure the key hasn't been deleted or its structure changed, which will render the
  * underlying iterators invalid */
 void NumericRangeIterator_OnReopen(void *privdata) {
+  NumericUnionCtx *nu = privdata;
+  if (nu->t->revisionId != nu->lastRevId) {
+    // the ranges were split, and the ones we iterate may have been freed
+    nu->it->Abort(nu->it->ctx);
+    return;
+  }
+  // records may have been added to the ranges meanwhile, and their blocks reallocated
+  for (size_t i = 0; i < array_len(nu->readers); ++i) {
+    IndexReader_Resync(nu->readers[i]);
+  }
+}
+
+static void NumericUnionCtx_Free(void *privdata) {
+  NumericUnionCtx *nu = privdata;
+  array_free(nu->readers);
+  rm_free(nu);
 }
 
 /* Returns 1 if the entire numeric range is contained between min and max */
@@ -292,9 +315,37 @@ NumericRangeTree *NewNumericRangeTree() {
   ret->revisionId = 0;
   ret->lastDocId = 0;
   ret->uniqueId = numericTreesUniqueId++;
+  ret->bitmaps = NULL;
   return ret;
 }
 
+static int NumericRangeBitmap_Match(const NumericRangeBitmap *b, double value) {
+  int minOK = b->inclusiveMin ? value >= b->min : value > b->min;
+  int maxOK = b->inclusiveMax ? value <= b->max : value < b->max;
+  return minOK && maxOK;
+}
+
+static void NumericRangeBitmap_Release(NumericRangeBitmap *b) {
+  // iterators may be freed by queries running without the GIL while the tree releases the bitmap
+  if (__atomic_sub_fetch(&b->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  array_free(b->ranges);
+  DocIdBitmap_Free(&b->docs);
+  rm_free(b);
+}
+
+void NumericRangeTree_ClearBitmaps(NumericRangeTree *t) {
+  if (!t->bitmaps) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(t->bitmaps); ++i) {
+    NumericRangeBitmap_Release(t->bitmaps[i]);
+  }
+  array_free(t->bitmaps);
+  t->bitmaps = NULL;
+}
+
 NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
 
   // Do not allow duplicate entries. This might happen due to indexer bugs and we need to protect
@@ -310,6 +361,16 @@ NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value)
   // will abort the next time they get execution context
   if (rv.changed) {
     t->revisionId++;
+    NumericRangeTree_ClearBitmaps(t);
+  } else if (t->bitmaps) {
+    // the ranges of the bitmaps stay the same, so the record belongs to those it matches. If it
+    // widened one of their ranges beyond the filter, the range is no longer covered by it, and the
+    // bitmap is not used again
+    for (size_t i = 0; i < array_len(t->bitmaps); ++i) {
+      if (NumericRangeBitmap_Match(t->bitmaps[i], value)) {
+        DocIdBitmap_Add(&t->bitmaps[i]->docs, docId);
+      }
+    }
   }
   t->numRanges += rv.numRanges;
   t->numEntries++;
@@ -321,6 +382,25 @@ Vector *NumericRangeTree_Find(NumericRangeTree *t, double min, double max) {
   return NumericRangeNode_FindRange(t->root, min, max);
 }
 
+NumericRange *NumericRangeTree_NextLeaf(NumericRangeTree *t, double bound, int ascending,
+                                        double *lo, double *hi) {
+  *lo = NF_NEGATIVE_INFINITY;
+  *hi = NF_INFINITY;
+  NumericRangeNode *n = t->root;
+  // the left child of a node holds the values below its split value, and the right one the rest
+  while (!NumericRangeNode_IsLeaf(n)) {
+    int right = ascending ? bound >= n->value : bound > n->value;
+    if (right) {
+      *lo = n->value;
+      n = n->right;
+    } else {
+      *hi = n->value;
+      n = n->left;
+    }
+  }
+  return n->range;
+}
+
 void NumericRangeNode_Traverse(NumericRangeNode *n,
                                void (*callback)(NumericRangeNode *n, void *ctx), void *ctx) {
 
@@ -335,28 +415,219 @@ void NumericRangeNode_Traverse(NumericRangeNode *n,
 }
 
 void NumericRangeTree_Free(NumericRangeTree *t) {
+  NumericRangeTree_ClearBitmaps(t);
   NumericRangeNode_Free(t->root);
   rm_free(t);
 }
 
-IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
-                                       const NumericFilter *f) {
+static IndexIterator *newNumericRangeIteratorEx(const IndexSpec *sp, NumericRange *nr,
+                                                const NumericFilter *f, IndexReader ***readers) {
 
   // if this range is at either end of the filter, we need to check each record
-  if (NumericFilter_Match(f, nr->minVal) && NumericFilter_Match(f, nr->maxVal) &&
+  if (f && NumericFilter_Match(f, nr->minVal) && NumericFilter_Match(f, nr->maxVal) &&
       f->geoFilter == NULL) {
     // make the filter NULL so the reader will ignore it
     f = NULL;
   }
   IndexReader *ir = NewNumericReader(sp, nr->entries, f, nr->minVal, nr->maxVal);
+  if (readers) {
+    *readers = array_append(*readers, ir);
+  }
 
   return NewReadIterator(ir);
 }
 
+IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
+                                       const NumericFilter *f) {
+  return newNumericRangeIteratorEx(sp, nr, f, NULL);
+}
+
+/* An iterator over the documents of a range bitmap. It holds a reference to the bitmap, so that it
+ * remains valid if the tree drops it while the iterator is suspended */
+typedef struct {
+  IndexIterator base;
+  NumericRangeBitmap *bitmap;
+  t_docId lastId;
+  // container of the last id, see DocIdBitmap_Next
+  size_t hint;
+} NumericBitmapIterator;
+
+static int NBI_Read(void *ctx, RSIndexResult **hit) {
+  NumericBitmapIterator *it = ctx;
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  t_docId docId = DocIdBitmap_Next(&it->bitmap->docs, it->lastId + 1, &it->hint);
+  if (!docId) {
+    it->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+  it->lastId = it->base.current->docId = docId;
+  if (hit) {
+    *hit = it->base.current;
+  }
+  return INDEXREAD_OK;
+}
+
+static int NBI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  NumericBitmapIterator *it = ctx;
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  if (docId <= it->lastId) {
+    return NBI_Read(ctx, hit);
+  }
+  t_docId next = DocIdBitmap_Next(&it->bitmap->docs, docId, &it->hint);
+  if (!next) {
+    it->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+  it->lastId = it->base.current->docId = next;
+  if (hit) {
+    *hit = it->base.current;
+  }
+  return next == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+static size_t NBI_Len(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  return DocIdBitmap_Cardinality(&it->bitmap->docs);
+}
+
+static t_docId NBI_LastDocId(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  return it->lastId;
+}
+
+static int NBI_HasNext(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static void NBI_Abort(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  it->base.isValid = 0;
+}
+
+static void NBI_Rewind(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  it->base.isValid = 1;
+  it->lastId = 0;
+  it->hint = 0;
+}
+
+typedef struct {
+  IndexCriteriaTester base;
+  NumericRangeBitmap *bitmap;
+} NumericBitmapCriteriaTester;
+
+static int NBI_Test(IndexCriteriaTester *ct, t_docId id) {
+  NumericBitmapCriteriaTester *nct = (NumericBitmapCriteriaTester *)ct;
+  return DocIdBitmap_Contains(&nct->bitmap->docs, id);
+}
+
+static void NBI_TesterFree(IndexCriteriaTester *ct) {
+  NumericBitmapCriteriaTester *nct = (NumericBitmapCriteriaTester *)ct;
+  NumericRangeBitmap_Release(nct->bitmap);
+  rm_free(nct);
+}
+
+static IndexCriteriaTester *NBI_GetCriteriaTester(void *ctx) {
+  NumericBitmapIterator *it = ctx;
+  NumericBitmapCriteriaTester *nct = rm_malloc(sizeof(*nct));
+  nct->base.Test = NBI_Test;
+  nct->base.Free = NBI_TesterFree;
+  nct->bitmap = it->bitmap;
+  __atomic_add_fetch(&nct->bitmap->refcount, 1, __ATOMIC_RELAXED);
+  return &nct->base;
+}
+
+static void NBI_Free(IndexIterator *self) {
+  NumericBitmapIterator *it = (NumericBitmapIterator *)self;
+  NumericRangeBitmap_Release(it->bitmap);
+  IndexResult_Free(it->base.current);
+  rm_free(it);
+}
+
+static IndexIterator *newNumericBitmapIterator(NumericRangeBitmap *b) {
+  NumericBitmapIterator *it = rm_calloc(1, sizeof(*it));
+  it->bitmap = b;
+  __atomic_add_fetch(&b->refcount, 1, __ATOMIC_RELAXED);
+
+  IndexIterator *ret = &it->base;
+  ret->ctx = it;
+  ret->type = BITMAP_ITERATOR;
+  ret->isValid = 1;
+  ret->current = NewVirtualResult(1);
+  ret->current->freq = 1;
+  ret->current->fieldMask = RS_FIELDMASK_ALL;
+  ret->Read = NBI_Read;
+  ret->SkipTo = NBI_SkipTo;
+  ret->Len = NBI_Len;
+  ret->NumEstimated = NBI_Len;
+  ret->LastDocId = NBI_LastDocId;
+  ret->HasNext = NBI_HasNext;
+  ret->Abort = NBI_Abort;
+  ret->Rewind = NBI_Rewind;
+  ret->GetCriteriaTester = NBI_GetCriteriaTester;
+  ret->Free = NBI_Free;
+  return ret;
+}
+
+/* Get the bitmap of the `covered` ranges, which are all the ranges of the tree within the filter.
+ * It is taken from the tree's cache if a bitmap of the same filter was built for the same ranges,
+ * or built and cached otherwise. Takes ownership of `covered` */
+static NumericRangeBitmap *getNumericRangeBitmap(const IndexSpec *sp, NumericRangeTree *t,
+                                                 const NumericFilter *f, NumericRange **covered) {
+  size_t n = array_len(covered);
+  for (size_t i = 0; t->bitmaps && i < array_len(t->bitmaps); ++i) {
+    NumericRangeBitmap *b = t->bitmaps[i];
+    if (b->min != f->min || b->max != f->max || b->inclusiveMin != f->inclusiveMin ||
+        b->inclusiveMax != f->inclusiveMax) {
+      continue;
+    }
+    // ranges may have been widened by new records, so that a different set is covered now
+    if (array_len(b->ranges) == n && !memcmp(b->ranges, covered, n * sizeof(*covered))) {
+      array_free(covered);
+      return b;
+    }
+    NumericRangeBitmap_Release(b);
+    array_del(t->bitmaps, i);
+    break;
+  }
+
+  NumericRangeBitmap *b = rm_malloc(sizeof(*b));
+  b->min = f->min;
+  b->max = f->max;
+  b->inclusiveMin = f->inclusiveMin;
+  b->inclusiveMax = f->inclusiveMax;
+  b->ranges = covered;
+  b->refcount = 1;
+  DocIdBitmap_Init(&b->docs);
+  for (size_t i = 0; i < n; ++i) {
+    IndexReader *ir = NewNumericReader(sp, covered[i]->entries, NULL, 0, 0);
+    RSIndexResult *res;
+    while (IR_Read(ir, &res) != INDEXREAD_EOF) {
+      DocIdBitmap_Add(&b->docs, res->docId);
+    }
+    IR_Free(ir);
+  }
+
+  // the least recently built bitmap is evicted
+  if (!t->bitmaps) {
+    t->bitmaps = array_new(NumericRangeBitmap *, NR_BITMAP_CACHE_SIZE);
+  } else if (array_len(t->bitmaps) == NR_BITMAP_CACHE_SIZE) {
+    NumericRangeBitmap_Release(t->bitmaps[0]);
+    array_del(t->bitmaps, 0);
+  }
+  t->bitmaps = array_append(t->bitmaps, b);
+  return b;
+}
+
 /* Create a union iterator from the numeric filter, over all the sub-ranges in the tree that fit
- * the filter */
-IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
-                                     const NumericFilter *f) {
+ * the filter. If `readers` is given, the readers of the ranges are appended to it */
+static IndexIterator *createNumericIteratorEx(const IndexSpec *sp, NumericRangeTree *t,
+                                              const NumericFilter *f, IndexReader ***readers) {
 
   Vector *v = NumericRangeTree_Find(t, f->min, f->max);
   if (!v || Vector_Size(v) == 0) {
@@ -371,14 +642,36 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
   if (n == 1) {
     NumericRange *rng;
     Vector_Get(v, 0, &rng);
-    IndexIterator *it = NewNumericRangeIterator(sp, rng, f);
+    IndexIterator *it = newNumericRangeIteratorEx(sp, rng, f, readers);
     Vector_Free(v);
     return it;
   }
 
+  // a wide filter's ranges, except for those at its edges, are read from a bitmap
+  NumericRange **covered = NULL;
+  if (!f->geoFilter && n >= NR_BITMAP_MIN_RANGES) {
+    covered = array_new(NumericRange *, n);
+    for (size_t i = 0; i < n; i++) {
+      NumericRange *rng;
+      Vector_Get(v, i, &rng);
+      if (rng && NumericFilter_Match(f, rng->minVal) && NumericFilter_Match(f, rng->maxVal)) {
+        covered = array_append(covered, rng);
+      }
+    }
+    if (array_len(covered) < NR_BITMAP_MIN_RANGES) {
+      array_free(covered);
+      covered = NULL;
+    }
+  }
+
   // We create a  union iterator, advancing a union on all the selected range,
   // treating them as one consecutive range
   IndexIterator **its = rm_calloc(n, sizeof(IndexIterator *));
+  size_t nits = 0;
+  if (covered) {
+    NumericRangeBitmap *b = getNumericRangeBitmap(sp, t, f, covered);
+    its[nits++] = newNumericBitmapIterator(b);
+  }
 
   for (size_t i = 0; i < n; i++) {
     NumericRange *rng;
@@ -386,17 +679,30 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
     if (!rng) {
       continue;
     }
+    if (covered && NumericFilter_Match(f, rng->minVal) && NumericFilter_Match(f, rng->maxVal)) {
+      continue;
+    }
 
-    its[i] = NewNumericRangeIterator(sp, rng, f);
+    its[nits++] = newNumericRangeIteratorEx(sp, rng, f, readers);
   }
   Vector_Free(v);
+  if (nits == 1) {
+    IndexIterator *it = its[0];
+    rm_free(its);
+    return it;
+  }
 
   QueryNodeType type = (!f || !f->geoFilter) ? QN_NUMERIC : QN_GEO;
-  IndexIterator *it = NewUnionIterator(its, n, NULL, 1, 1, type, NULL);
+  IndexIterator *it = NewUnionIterator(its, nits, NULL, 1, 1, type, NULL);
 
   return it;
 }
 
+IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
+                                     const NumericFilter *f) {
+  return createNumericIteratorEx(sp, t, f, NULL);
+}
+
 RedisModuleType *NumericIndexType = NULL;
 #define NUMERICINDEX_KEY_FMT "nm:%s/%s"
 
@@ -421,31 +727,44 @@ static NumericRangeTree *openNumericKeysDict(RedisSearchCtx *ctx, RedisModuleStr
   return kdv->p;
 }
 
-struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
-                                               ConcurrentSearchCtx *csx, FieldType forType) {
-  RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, flt->fieldName, forType);
+NumericRangeTree *OpenNumericIndexForRead(RedisSearchCtx *ctx, const FieldSpec *fs) {
+  if (!ctx->spec->keysDict) {
+    return NULL;
+  }
+  RedisModuleString *s = IndexSpec_GetFormattedKey(ctx->spec, fs, INDEXFLD_T_NUMERIC);
   if (!s) {
     return NULL;
   }
-  RedisModuleKey *key = NULL;
-  NumericRangeTree *t = NULL;
-  if (!ctx->spec->keysDict) {
-    key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
-    if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
-      return NULL;
-    }
+  return openNumericKeysDict(ctx, s, 0);
+}
 
-    t = RedisModule_ModuleTypeGetValue(key);
-  } else {
-    t = openNumericKeysDict(ctx, s, 0);
+static NumericRangeTree *openNumericIndexByName(RedisSearchCtx *ctx, const char *fieldName,
+                                                FieldType forType) {
+  RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, fieldName, forType);
+  if (!s) {
+    return NULL;
+  }
+  if (ctx->spec->keysDict) {
+    return openNumericKeysDict(ctx, s, 0);
   }
+  RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
+  if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
+    return NULL;
+  }
+  return RedisModule_ModuleTypeGetValue(key);
+}
 
+struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               ConcurrentSearchCtx *csx, FieldType forType) {
+  NumericRangeTree *t = openNumericIndexByName(ctx, flt->fieldName, forType);
   if (!t) {
     return NULL;
   }
 
-  IndexIterator *it = createNumericIterator(ctx->spec, t, flt);
+  IndexReader **readers = csx ? array_new(IndexReader *, 8) : NULL;
+  IndexIterator *it = createNumericIteratorEx(ctx->spec, t, flt, csx ? &readers : NULL);
   if (!it) {
+    array_free(readers);
     return NULL;
   }
 
@@ -453,11 +772,115 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
     NumericUnionCtx *uc = rm_malloc(sizeof(*uc));
     uc->lastRevId = t->revisionId;
     uc->it = it;
-    ConcurrentSearch_AddKey(csx, NumericRangeIterator_OnReopen, uc, rm_free);
+    uc->t = t;
+    uc->readers = readers;
+    ConcurrentSearch_AddKey(csx, NumericRangeIterator_OnReopen, uc, NumericUnionCtx_Free);
+  }
+  return it;
+}
+
+struct indexIterator *NewNumericIntervalsIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                                  const double *intervals, size_t n,
+                                                  FieldType forType) {
+  NumericRangeTree *t = openNumericIndexByName(ctx, flt->fieldName, forType);
+  if (!t) {
+    return NULL;
   }
+
+  // an interval may share its ranges with the previous ones, but each range is read once
+  NumericRange **rngs = array_new(NumericRange *, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    Vector *v = NumericRangeTree_Find(t, intervals[ii * 2], intervals[ii * 2 + 1]);
+    if (!v) {
+      continue;
+    }
+    for (size_t jj = 0; jj < Vector_Size(v); ++jj) {
+      NumericRange *rng;
+      Vector_Get(v, jj, &rng);
+      size_t kk = 0;
+      while (kk < array_len(rngs) && rngs[kk] != rng) {
+        kk++;
+      }
+      if (rng && kk == array_len(rngs)) {
+        rngs = array_append(rngs, rng);
+      }
+    }
+    Vector_Free(v);
+  }
+
+  size_t nrngs = array_len(rngs);
+  IndexIterator *it = NULL;
+  if (nrngs == 1) {
+    it = NewNumericRangeIterator(ctx->spec, rngs[0], flt);
+  } else if (nrngs > 1) {
+    IndexIterator **its = rm_calloc(nrngs, sizeof(*its));
+    for (size_t ii = 0; ii < nrngs; ++ii) {
+      its[ii] = NewNumericRangeIterator(ctx->spec, rngs[ii], flt);
+    }
+    QueryNodeType type = !flt->geoFilter ? QN_NUMERIC : QN_GEO;
+    it = NewUnionIterator(its, nrngs, NULL, 1, 1, type, NULL);
+  }
+  array_free(rngs);
   return it;
 }
 
+size_t NumericIndex_EstimateFilter(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                   FieldType forType) {
+  NumericRangeTree *t = openNumericIndexByName(ctx, flt->fieldName, forType);
+  if (!t) {
+    return 0;
+  }
+  Vector *v = NumericRangeTree_Find(t, flt->min, flt->max);
+  if (!v) {
+    return 0;
+  }
+  size_t n = 0;
+  for (size_t ii = 0; ii < Vector_Size(v); ++ii) {
+    NumericRange *rng;
+    Vector_Get(v, ii, &rng);
+    if (rng) {
+      n += rng->entries->numDocs;
+    }
+  }
+  Vector_Free(v);
+  return n;
+}
+
+typedef struct {
+  IndexCriteriaTester base;
+  const IndexSpec *sp;
+  const NumericFilter *flt;
+  int sortIdx;
+} NumericSortableCriteriaTester;
+
+static int NST_Test(IndexCriteriaTester *ct, t_docId id) {
+  NumericSortableCriteriaTester *nct = (NumericSortableCriteriaTester *)ct;
+  const RSSortingColumns *cols = nct->sp->docs.sortables;
+  if (!cols) {
+    return 0;
+  }
+  RSValue *v = RSSortingColumns_Get(cols, id, nct->sortIdx);
+  return v && v->t == RSValue_Number && NumericFilter_Match(nct->flt, v->numval);
+}
+
+static void NST_Free(IndexCriteriaTester *ct) {
+  rm_free(ct);
+}
+
+IndexCriteriaTester *NewNumericSortableTester(const IndexSpec *sp, const NumericFilter *flt) {
+  const FieldSpec *fs = IndexSpec_GetField(sp, flt->fieldName, strlen(flt->fieldName));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsSortable(fs)) {
+    return NULL;
+  }
+  NumericSortableCriteriaTester *nct = rm_malloc(sizeof(*nct));
+  nct->base.Test = NST_Test;
+  nct->base.Free = NST_Free;
+  nct->sp = sp;
+  nct->flt = flt;
+  nct->sortIdx = fs->sortIdx;
+  return &nct->base;
+}
+
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey) {
 
@@ -510,7 +933,6 @@ unsigned long NumericIndexType_MemUsage(const void *value) {
   return ret;
 }
 
-#define NUMERIC_INDEX_ENCVER 1
 
 int NumericIndexType_Register(RedisModuleCtx *ctx) {
 
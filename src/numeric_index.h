@@ -11,6 +11,7 @@
 #include "concurrent_ctx.h"
 #include "inverted_index.h"
 #include "numeric_filter.h"
+#include "docid_bitmap.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,8 +64,23 @@ typedef struct {
   NumericRangeNode **nodesStack;
 } NumericRangeTreeIterator;
 
-/* The root tree and its metadata */
+/* The documents of the ranges which are entirely within a wide filter, so that they are read as a
+ * bitmap rather than merged from many ranges. It is cached in the tree for the next queries with the
+ * same filter, and kept up to date as records are added */
 typedef struct {
+  double min;
+  double max;
+  int inclusiveMin;
+  int inclusiveMax;
+  // the ranges whose documents are in the bitmap
+  NumericRange **ranges;
+  DocIdBitmap docs;
+  // held by the tree and by the iterators reading it, updated atomically
+  uint32_t refcount;
+} NumericRangeBitmap;
+
+/* The root tree and its metadata */
+typedef struct NumericRangeTree {
   NumericRangeNode *root;
   size_t numRanges;
   size_t numEntries;
@@ -75,6 +91,8 @@ typedef struct {
 
   uint32_t uniqueId;
 
+  // bitmaps of recently used wide filters, dropped when the ranges change
+  NumericRangeBitmap **bitmaps;
 } NumericRangeTree;
 
 #define NumericRangeNode_IsLeaf(n) (n->left == NULL && n->right == NULL)
@@ -85,6 +103,23 @@ struct indexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange
 struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
                                                ConcurrentSearchCtx *csx, FieldType forType);
 
+/* Create an iterator over the ranges of the field's tree holding values in any of the `n`
+ * [min, max) intervals, given as consecutive pairs. Ranges shared by several intervals are read
+ * once, and `flt` must reject the values of such ranges which are out of the intervals */
+struct indexIterator *NewNumericIntervalsIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                                  const double *intervals, size_t n,
+                                                  FieldType forType);
+
+/* Estimate the number of documents matching the filter from the sizes of the ranges it spans.
+ * Ranges at the edges of the filter are counted whole */
+size_t NumericIndex_EstimateFilter(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                   FieldType forType);
+
+/* Create a tester matching the documents whose value of a sortable numeric field is within the
+ * filter, read from the sortable values rather than from the index. Returns NULL if the field is
+ * not sortable */
+IndexCriteriaTester *NewNumericSortableTester(const IndexSpec *sp, const NumericFilter *flt);
+
 /* Add an entry to a numeric range node. Returns the cardinality of the range after the
  * inserstion.
  * No deduplication is done */
@@ -121,11 +156,29 @@ Vector *NumericRangeTree_Find(NumericRangeTree *t, double min, double max);
 /* Free the tree and all nodes */
 void NumericRangeTree_Free(NumericRangeTree *t);
 
+/* Drop the bitmaps cached in the tree. Called when records are removed from its ranges */
+void NumericRangeTree_ClearBitmaps(NumericRangeTree *t);
+
+/* Find the leaf which follows `bound` in value order, for walking the leaves from the lowest values
+ * up (ascending), or from the highest values down. Going up, it is the leaf holding `bound`. Going
+ * down, it is the leaf holding the highest values below `bound`. The values the leaf may hold are
+ * returned as [lo, hi). Walking starts from -inf going up and +inf going down, and continues from
+ * hi or lo respectively. It ends after the leaf whose hi is +inf or lo is -inf.
+ * Since the bounds are split values, the walk remains valid if nodes are split along the way */
+NumericRange *NumericRangeTree_NextLeaf(NumericRangeTree *t, double bound, int ascending,
+                                        double *lo, double *hi);
+
+#define NUMERIC_INDEX_ENCVER 1
+
 extern RedisModuleType *NumericIndexType;
 
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey);
 
+/* Get the numeric index of a field without creating it. Returns NULL if the field has no index yet,
+ * or if the spec keeps its indexes in the keyspace */
+NumericRangeTree *OpenNumericIndexForRead(RedisSearchCtx *ctx, const FieldSpec *fs);
+
 int NumericIndexType_Register(RedisModuleCtx *ctx);
 void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver);
 void NumericIndexType_RdbSave(RedisModuleIO *rdb, void *value);
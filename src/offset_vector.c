@@ -3,6 +3,7 @@
 #include "rmalloc.h"
 #include "util/mempool.h"
 #include <sys/param.h>
+#include <pthread.h>
 
 /* We have two types of offset vector iterators - for terms and for aggregates. For terms we simply
  * yield the encoded offsets one by one. For aggregates, we merge them on the fly in order.
@@ -33,13 +34,48 @@ uint32_t _ovi_Next(void *ctx, RSQueryTerm **t);
 /* Rewind the iterator */
 void _ovi_Rewind(void *ctx);
 
-/* memory pool for buffer iterators */
-static mempool_t *__offsetIters = NULL;
-static mempool_t *__aggregateIters = NULL;
+/* memory pools for buffer iterators. They are kept per thread, since queries may run on several
+ * threads at once */
+typedef struct {
+  mempool_t *offsetIters;
+  mempool_t *aggregateIters;
+} offsetIterPools;
+
+static pthread_key_t offsetIterPoolsKey_g;
+
+static void offsetIterPoolsDtor(void *p) {
+  offsetIterPools *pools = p;
+  if (pools->offsetIters) {
+    mempool_destroy(pools->offsetIters);
+  }
+  if (pools->aggregateIters) {
+    mempool_destroy(pools->aggregateIters);
+  }
+  rm_free(pools);
+}
+
+static void __attribute__((constructor)) initOffsetIterPoolsKey() {
+  pthread_key_create(&offsetIterPoolsKey_g, offsetIterPoolsDtor);
+}
+
+static inline offsetIterPools *getOffsetIterPools() {
+  offsetIterPools *pools = pthread_getspecific(offsetIterPoolsKey_g);
+  if (pools == NULL) {
+    pools = rm_calloc(1, sizeof(*pools));
+    pthread_setspecific(offsetIterPoolsKey_g, pools);
+  }
+  return pools;
+}
 
 /* Free it */
 void _ovi_free(void *ctx) {
-  mempool_release(__offsetIters, ctx);
+  offsetIterPools *pools = getOffsetIterPools();
+  if (pools->offsetIters) {
+    mempool_release(pools->offsetIters, ctx);
+  } else {
+    // created by another thread
+    rm_free(ctx);
+  }
 }
 
 void *newOffsetIterator() {
@@ -47,12 +83,13 @@ void *newOffsetIterator() {
 }
 /* Create an offset iterator interface  from a raw offset vector */
 RSOffsetIterator RSOffsetVector_Iterate(const RSOffsetVector *v, RSQueryTerm *t) {
-  if (!__offsetIters) {
+  offsetIterPools *pools = getOffsetIterPools();
+  if (!pools->offsetIters) {
     mempool_options options = {
-        .isGlobal = 1, .initialCap = 8, .alloc = newOffsetIterator, .free = rm_free};
-    __offsetIters = mempool_new(&options);
+        .isGlobal = 0, .initialCap = 8, .alloc = newOffsetIterator, .free = rm_free};
+    pools->offsetIters = mempool_new(&options);
   }
-  _RSOffsetVectorIterator *it = mempool_get(__offsetIters);
+  _RSOffsetVectorIterator *it = mempool_get(pools->offsetIters);
   it->buf = (Buffer){.data = v->data, .offset = v->len, .cap = v->len};
   it->br = NewBufferReader(&it->buf);
   it->lastValue = 0;
@@ -85,12 +122,13 @@ static void aggiterFree(void *p) {
 
 /* Create an iterator from the aggregate offset iterators of the aggregate result */
 static RSOffsetIterator _aggregateResult_iterate(const RSAggregateResult *agg) {
-  if (!__aggregateIters) {
+  offsetIterPools *pools = getOffsetIterPools();
+  if (!pools->aggregateIters) {
     mempool_options opts = {
-        .isGlobal = 1, .initialCap = 8, .alloc = aggiterNew, .free = aggiterFree};
-    __aggregateIters = mempool_new(&opts);
+        .isGlobal = 0, .initialCap = 8, .alloc = aggiterNew, .free = aggiterFree};
+    pools->aggregateIters = mempool_new(&opts);
   }
-  _RSAggregateOffsetIterator *it = mempool_get(__aggregateIters);
+  _RSAggregateOffsetIterator *it = mempool_get(pools->aggregateIters);
   it->res = agg;
 
   if (agg->numChildren > it->size) {
@@ -204,7 +242,12 @@ void _aoi_Free(void *ctx) {
     it->iters[i].Free(it->iters[i].ctx);
   }
 
-  mempool_release(__aggregateIters, ctx);
+  offsetIterPools *pools = getOffsetIterPools();
+  if (pools->aggregateIters) {
+    mempool_release(pools->aggregateIters, ctx);
+  } else {
+    aggiterFree(ctx);
+  }
 }
 
 void _aoi_Rewind(void *ctx) {
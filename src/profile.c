@@ -49,7 +49,6 @@ static double _recursiveProfilePrint(RedisModuleCtx *ctx, ResultProcessor *rp, s
       case RP_SORTER:
       case RP_PAGER_LIMITER:
       case RP_HIGHLIGHTER:
-      case RP_GROUP:
       case RP_NETWORK:
         RedisModule_ReplyWithSimpleString(ctx, RPTypeToString(rp->type));
         break;
@@ -59,6 +58,10 @@ static double _recursiveProfilePrint(RedisModuleCtx *ctx, ResultProcessor *rp, s
         RPEvaluator_Reply(ctx, rp);
         break;
 
+      case RP_GROUP:
+        Grouper_Reply(ctx, rp);
+        break;
+
       case RP_PROFILE:
       case RP_MAX:
         RS_LOG_ASSERT(0, "RPType error");
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "buffer.h"
 #include "rmalloc.h"
 #include "qint.h"
@@ -196,6 +197,154 @@ QINT_API size_t qint_decode4(BufferReader *br, uint32_t *i, uint32_t *i2, uint32
   return total + 1;
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#define QINT_HAVE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+/* Tables for decoding a whole record at once, indexed by its leading byte. They are generated by
+ * the preprocessor: QINT_LEN is the length of the k'th integer of a record and QINT_END the offset
+ * just past it, not counting the leading byte */
+#define QINT_LEN(h, k) ((((h) >> (2 * (k))) & 0x03) + 1)
+#define QINT_END0(h) QINT_LEN(h, 0)
+#define QINT_END1(h) (QINT_END0(h) + QINT_LEN(h, 1))
+#define QINT_END2(h) (QINT_END1(h) + QINT_LEN(h, 2))
+#define QINT_END3(h) (QINT_END2(h) + QINT_LEN(h, 3))
+#define QINT_START0(h) 0
+#define QINT_START1(h) QINT_END0(h)
+#define QINT_START2(h) QINT_END1(h)
+#define QINT_START3(h) QINT_END2(h)
+
+#define QINT_GEN4(gen, h) gen(h) gen((h) + 1) gen((h) + 2) gen((h) + 3)
+#define QINT_GEN16(gen, h) \
+  QINT_GEN4(gen, h) QINT_GEN4(gen, (h) + 4) QINT_GEN4(gen, (h) + 8) QINT_GEN4(gen, (h) + 12)
+#define QINT_GEN64(gen, h) \
+  QINT_GEN16(gen, h) QINT_GEN16(gen, (h) + 16) QINT_GEN16(gen, (h) + 32) QINT_GEN16(gen, (h) + 48)
+#define QINT_GEN256(gen) \
+  QINT_GEN64(gen, 0) QINT_GEN64(gen, 64) QINT_GEN64(gen, 128) QINT_GEN64(gen, 192)
+
+#define QINT_ENDS(h) {QINT_END0(h), QINT_END1(h), QINT_END2(h), QINT_END3(h)},
+static const uint8_t qint_ends[256][4] = {QINT_GEN256(QINT_ENDS)};
+
+#ifdef QINT_HAVE_SSSE3
+// a pshufb mask moving the bytes of each integer to its own little endian 32 bit lane
+#define QINT_SHUF_BYTE(h, k, j) ((j) < QINT_LEN(h, k) ? QINT_START##k(h) + (j) : 0x80)
+#define QINT_SHUF_LANE(h, k) \
+  QINT_SHUF_BYTE(h, k, 0), QINT_SHUF_BYTE(h, k, 1), QINT_SHUF_BYTE(h, k, 2), QINT_SHUF_BYTE(h, k, 3)
+#define QINT_SHUFFLE(h) \
+  {QINT_SHUF_LANE(h, 0), QINT_SHUF_LANE(h, 1), QINT_SHUF_LANE(h, 2), QINT_SHUF_LANE(h, 3)},
+static const uint8_t qint_shuffle[256][16] __attribute__((aligned(16))) = {
+    QINT_GEN256(QINT_SHUFFLE)};
+#endif
+
+static inline void qint_decode_row(const uint8_t *p, int width, uint32_t *row) {
+  const uint8_t header = *p++;
+  for (int k = 0; k < width; k++) {
+    size_t nused;
+    QINT_DECODE_VALUE(row[k], (header >> (k * 2)) & 0x03, p, nused);
+    p += nused;
+  }
+}
+
+static size_t qint_decode_records_scalar(BufferReader *br, int width, int blob,
+                                         uint32_t (*out)[4], uint32_t *blobPos, size_t n) {
+  const uint8_t *data = (const uint8_t *)br->buf->data;
+  size_t pos = br->pos, end = br->buf->offset;
+  size_t i = 0;
+  for (; i < n && pos < end; i++) {
+    qint_decode_row(data + pos, width, out[i]);
+    pos += 1 + qint_ends[data[pos]][width - 1];
+    if (blob >= 0) {
+      blobPos[i] = pos;
+      pos += out[i][blob];
+    }
+  }
+  br->pos = pos;
+  return i;
+}
+
+#ifdef QINT_HAVE_SSSE3
+/* Like the scalar version, but every record is decoded with a single shuffle. The shuffle loads 16
+ * bytes, so records too close to the end of the buffer's allocation are decoded one by one.
+ * Consecutive records mostly share their leading byte, so the record length is only looked up when
+ * it changes: the branch is predicted, while the lookup would stall the next record's decoding */
+__attribute__((target("ssse3"), always_inline)) static inline size_t qint_decode_records_ssse3_w(
+    BufferReader *br, const int width, const int blob, uint32_t (*out)[4], uint32_t *blobPos,
+    size_t n) {
+  const uint8_t *data = (const uint8_t *)br->buf->data;
+  size_t pos = br->pos, end = br->buf->offset, cap = br->buf->cap;
+  int lastHeader = -1;
+  size_t len = 0, blobStart = 0;
+  uint32_t blobMask = 0;
+  size_t i = 0;
+  for (; i < n && pos < end; i++) {
+    const uint8_t header = data[pos];
+    if (__builtin_expect(header != lastHeader, 0)) {
+      lastHeader = header;
+      len = 1 + qint_ends[header][width - 1];
+      if (blob > 0) {
+        blobStart = 1 + qint_ends[header][blob - 1];
+        blobMask = 0xFFFFFFFF >> (8 * (4 - QINT_LEN(header, blob)));
+      }
+    }
+    if (pos + 17 <= cap) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(data + pos + 1));
+      v = _mm_shuffle_epi8(v, _mm_load_si128((const __m128i *)qint_shuffle[header]));
+      _mm_storeu_si128((__m128i *)out[i], v);
+      if (blob > 0) {
+        // read the blob's length from the buffer rather than from the stored row, so that the
+        // next record does not wait for the store
+        uint32_t blobLen;
+        memcpy(&blobLen, data + pos + blobStart, sizeof(blobLen));
+        blobPos[i] = pos + len;
+        pos += len + (blobLen & blobMask);
+        continue;
+      }
+    } else {
+      qint_decode_row(data + pos, width, out[i]);
+    }
+    pos += len;
+    if (blob >= 0) {
+      blobPos[i] = pos;
+      pos += out[i][blob];
+    }
+  }
+  br->pos = pos;
+  return i;
+}
+
+__attribute__((target("ssse3"))) static size_t qint_decode_records_ssse3(
+    BufferReader *br, int width, int blob, uint32_t (*out)[4], uint32_t *blobPos, size_t n) {
+  switch (width) {
+    case 2:
+      return blob < 0 ? qint_decode_records_ssse3_w(br, 2, -1, out, blobPos, n)
+                      : qint_decode_records_ssse3_w(br, 2, 1, out, blobPos, n);
+    case 3:
+      return blob < 0 ? qint_decode_records_ssse3_w(br, 3, -1, out, blobPos, n)
+                      : qint_decode_records_ssse3_w(br, 3, 2, out, blobPos, n);
+    case 4:
+      return blob < 0 ? qint_decode_records_ssse3_w(br, 4, -1, out, blobPos, n)
+                      : qint_decode_records_ssse3_w(br, 4, 3, out, blobPos, n);
+    default:
+      return qint_decode_records_ssse3_w(br, width, blob, out, blobPos, n);
+  }
+}
+#endif
+
+QINT_API size_t qint_decode_records(BufferReader *br, int width, int blob, uint32_t (*out)[4],
+                                    uint32_t *blobPos, size_t n) {
+#ifdef QINT_HAVE_SSSE3
+  static int hasSSSE3 = -1;
+  if (hasSSSE3 < 0) {
+    hasSSSE3 = __builtin_cpu_supports("ssse3");
+  }
+  if (hasSSSE3) {
+    return qint_decode_records_ssse3(br, width, blob, out, blobPos, n);
+  }
+#endif
+  return qint_decode_records_scalar(br, width, blob, out, blobPos, n);
+}
+
 // void printConfig(unsigned char c) {
 
 //   int off = 1;
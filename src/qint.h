@@ -49,4 +49,13 @@ QINT_API size_t qint_decode3(BufferReader *br, uint32_t *i, uint32_t *i2, uint32
 QINT_API size_t qint_decode4(BufferReader *br, uint32_t *i, uint32_t *i2, uint32_t *i3,
                              uint32_t *i4);
 
+/* Decode up to n consecutive records of `width` integers each, as written by qint_encode<width>,
+ * into the rows of `out`. Only the first `width` values of each row are meaningful. If `blob` is
+ * not negative, each record is followed by as many bytes as its integer at that index; they are
+ * skipped and their position in the buffer is written to `blobPos`. Returns the number of records
+ * decoded, which is less than n only if the end of the buffer was reached. Uses SSSE3 shuffles
+ * when the CPU supports them */
+QINT_API size_t qint_decode_records(BufferReader *br, int width, int blob, uint32_t (*out)[4],
+                                    uint32_t *blobPos, size_t n);
+
 #endif
\ No newline at end of file
@@ -413,8 +413,8 @@ static IndexIterator *Query_EvalLexRangeNode(QueryEvalCtx *q, QueryNode *lx) {
     end = strToFoldedRunes(lx->lxrng.end, &nend);
   }
 
-  TrieNode_IterateRange(t->root, begin, begin ? nbegin : -1, lx->lxrng.includeBegin, end,
-                        end ? nend : -1, lx->lxrng.includeEnd, rangeIterCb, &ctx);
+  Trie_IterateRange(t, begin, begin ? nbegin : -1, lx->lxrng.includeBegin, end, end ? nend : -1,
+                    lx->lxrng.includeEnd, rangeIterCb, &ctx);
   rm_free(begin);
   rm_free(end);
   if (!ctx.its || ctx.nits == 0) {
@@ -448,17 +448,27 @@ static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
     return Query_EvalNode(q, qn->children[0]);
   }
 
-  // recursively eval the children
+  // recursively eval the children. The filters marked by the planner are tested instead
   IndexIterator **iters = rm_calloc(QueryNode_NumChildren(qn), sizeof(IndexIterator *));
+  IndexCriteriaTester **testers = NULL;
+  size_t niters = 0;
   for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
-    qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
-    iters[ii] = Query_EvalNode(q, qn->children[ii]);
+    QueryNode *child = qn->children[ii];
+    child->opts.fieldMask &= qn->opts.fieldMask;
+    if (child->opts.flags & QueryNode_Tested) {
+      IndexCriteriaTester *tester = NewNumericSortableTester(q->sctx->spec, child->nn.nf);
+      if (tester) {
+        testers = array_ensure_append(testers, &tester, 1, IndexCriteriaTester *);
+        continue;
+      }
+    }
+    iters[niters++] = Query_EvalNode(q, child);
   }
   IndexIterator *ret;
 
   if (node->exact) {
-    ret = NewIntersecIterator(iters, QueryNode_NumChildren(qn), q->docTable,
-                              EFFECTIVE_FIELDMASK(q, qn), 0, 1, qn->opts.weight);
+    ret = NewIntersecIterator(iters, niters, q->docTable, EFFECTIVE_FIELDMASK(q, qn), 0, 1,
+                              qn->opts.weight);
   } else {
     // Let the query node override the slop/order parameters
     int slop = qn->opts.maxSlop;
@@ -474,9 +484,13 @@ static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
       slop = __INT_MAX__;
     }
 
-    ret = NewIntersecIterator(iters, QueryNode_NumChildren(qn), q->docTable,
-                              EFFECTIVE_FIELDMASK(q, qn), slop, inOrder, qn->opts.weight);
+    ret = NewIntersecIterator(iters, niters, q->docTable, EFFECTIVE_FIELDMASK(q, qn), slop,
+                              inOrder, qn->opts.weight);
   }
+  for (size_t ii = 0; ii < array_len(testers); ++ii) {
+    IntersectIterator_AddTester(ret, testers[ii]);
+  }
+  array_free(testers);
   return ret;
 }
 
@@ -485,7 +499,7 @@ static IndexIterator *Query_EvalWildcardNode(QueryEvalCtx *q, QueryNode *qn) {
     return NULL;
   }
 
-  return NewWildcardIterator(q->docTable->maxDocId);
+  return NewWildcardIterator(q->docTable->maxDocId, &q->docTable->live);
 }
 
 static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -495,7 +509,7 @@ static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
   QueryNotNode *node = &qn->inverted;
 
   return NewNotIterator(QueryNode_NumChildren(qn) ? Query_EvalNode(q, qn->children[0]) : NULL,
-                        q->docTable->maxDocId, qn->opts.weight);
+                        q->docTable->maxDocId, &q->docTable->live, qn->opts.weight);
 }
 
 static IndexIterator *Query_EvalOptionalNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -505,7 +519,7 @@ static IndexIterator *Query_EvalOptionalNode(QueryEvalCtx *q, QueryNode *qn) {
   QueryOptionalNode *node = &qn->opt;
 
   return NewOptionalIterator(QueryNode_NumChildren(qn) ? Query_EvalNode(q, qn->children[0]) : NULL,
-                             q->docTable->maxDocId, qn->opts.weight);
+                             q->docTable->maxDocId, &q->docTable->live, qn->opts.weight);
 }
 
 static IndexIterator *Query_EvalNumericNode(QueryEvalCtx *q, QueryNumericNode *node) {
@@ -586,6 +600,8 @@ static IndexIterator *Query_EvalTagLexRangeNode(QueryEvalCtx *q, TagIndex *idx,
   const char *begin = qn->lxrng.begin, *end = qn->lxrng.end;
   int nbegin = begin ? strlen(begin) : -1, nend = end ? strlen(end) : -1;
 
+  // iterating a range sorts the children of the trie nodes, moving them under the GC's iterator
+  ++idx->revisionId;
   TrieMap_IterateRange(t, begin, nbegin, qn->lxrng.includeBegin, end, nend, qn->lxrng.includeEnd,
                        rangeIterCbStrs, &ctx);
   if (ctx.nits == 0) {
@@ -872,6 +888,152 @@ int QAST_Expand(QueryAST *q, const char *expander, RSSearchOptions *opts, RedisS
   ;
 }
 
+/* A numeric filter on a sortable field is tested on the documents matched by its siblings, rather
+ * than iterated, if it matches this many times more documents than the most selective of them */
+#define PLAN_TEST_RATIO 8
+
+static size_t QueryNode_Plan(RedisSearchCtx *sctx, const RSSearchOptions *opts, QueryNode *qn,
+                             size_t total);
+
+static size_t estimateTermNode(RedisSearchCtx *sctx, QueryNode *qn) {
+  RedisModuleKey *k = NULL;
+  InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, qn->tn.str, qn->tn.len, 0, &k);
+  size_t n = idx ? idx->numDocs : 0;
+  if (k) {
+    RedisModule_CloseKey(k);
+  }
+  return n;
+}
+
+/* A tag node matches the union of its values, each of which has its own inverted index. Prefixes
+ * and ranges of values are not estimated */
+static size_t estimateTagNode(RedisSearchCtx *sctx, QueryNode *qn, size_t total) {
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, qn->tag.fieldName, qn->tag.len);
+  if (!fs) {
+    return 0;
+  }
+  RedisModuleString *kstr = IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_TAG);
+  RedisModuleKey *k = NULL;
+  TagIndex *idx = TagIndex_Open(sctx, kstr, 0, &k);
+  size_t n = 0;
+  for (size_t ii = 0; idx && ii < QueryNode_NumChildren(qn); ++ii) {
+    QueryNode *child = qn->children[ii];
+    if (child->type != QN_TOKEN) {
+      n = total;
+      break;
+    }
+    InvertedIndex *iv = TrieMap_Find(idx->values, child->tn.str, child->tn.len);
+    if (iv != TRIEMAP_NOTFOUND && iv) {
+      n += iv->numDocs;
+    }
+  }
+  if (k) {
+    RedisModule_CloseKey(k);
+  }
+  return n;
+}
+
+/* Whether the children of an intersection may be iterated in any order - that is, the positions
+ * of the terms are not checked */
+static int isUnordered(const RSSearchOptions *opts, const QueryNode *qn) {
+  return !qn->pn.exact && qn->opts.maxSlop == -1 && !qn->opts.inOrder && opts->slop == -1 &&
+         !(opts->flags & Search_InOrder);
+}
+
+/* Order the children of an intersection by their estimates, the most selective first, and mark
+ * the numeric filters which are cheaper to test than to iterate. Returns the estimate of the
+ * intersection */
+static size_t planIntersection(RedisSearchCtx *sctx, const RSSearchOptions *opts, QueryNode *qn,
+                               size_t total) {
+  size_t n = QueryNode_NumChildren(qn);
+  size_t est[n];
+  for (size_t ii = 0; ii < n; ++ii) {
+    qn->children[ii]->opts.flags &= ~QueryNode_Tested;
+    est[ii] = QueryNode_Plan(sctx, opts, qn->children[ii], total);
+  }
+  if (n < 2 || !isUnordered(opts, qn)) {
+    size_t min = total;
+    for (size_t ii = 0; ii < n; ++ii) {
+      min = MIN(min, est[ii]);
+    }
+    return min;
+  }
+
+  // a stable insertion sort, so that children with equal estimates keep the query's order
+  for (size_t ii = 1; ii < n; ++ii) {
+    QueryNode *child = qn->children[ii];
+    size_t cur = est[ii];
+    size_t jj = ii;
+    for (; jj > 0 && est[jj - 1] > cur; --jj) {
+      qn->children[jj] = qn->children[jj - 1];
+      est[jj] = est[jj - 1];
+    }
+    qn->children[jj] = child;
+    est[jj] = cur;
+  }
+
+  // the first child is always iterated, and the numeric filters far less selective than it are
+  // checked against the documents of the intersection instead
+  for (size_t ii = 1; ii < n; ++ii) {
+    QueryNode *child = qn->children[ii];
+    if (child->type != QN_NUMERIC || est[ii] <= est[0] * PLAN_TEST_RATIO) {
+      continue;
+    }
+    const NumericFilter *nf = child->nn.nf;
+    const FieldSpec *fs = IndexSpec_GetField(sctx->spec, nf->fieldName, strlen(nf->fieldName));
+    if (fs && FIELD_IS(fs, INDEXFLD_T_NUMERIC) && FieldSpec_IsSortable(fs) &&
+        FieldSpec_IsIndexable(fs)) {
+      child->opts.flags |= QueryNode_Tested;
+    }
+  }
+  return est[0];
+}
+
+static size_t QueryNode_Plan(RedisSearchCtx *sctx, const RSSearchOptions *opts, QueryNode *qn,
+                             size_t total) {
+  size_t n = total;
+  switch (qn->type) {
+    case QN_TOKEN:
+      n = estimateTermNode(sctx, qn);
+      break;
+    case QN_TAG:
+      n = estimateTagNode(sctx, qn, total);
+      break;
+    case QN_NUMERIC:
+      n = NumericIndex_EstimateFilter(sctx, qn->nn.nf, INDEXFLD_T_NUMERIC);
+      break;
+    case QN_IDS:
+      n = qn->fn.len;
+      break;
+    case QN_NULL:
+      n = 0;
+      break;
+    case QN_PHRASE:
+      n = planIntersection(sctx, opts, qn, total);
+      break;
+    case QN_UNION:
+      n = 0;
+      for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+        n += QueryNode_Plan(sctx, opts, qn->children[ii], total);
+      }
+      break;
+    default:
+      // the children are planned for their own intersections, but the node itself is not estimated
+      for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+        QueryNode_Plan(sctx, opts, qn->children[ii], total);
+      }
+      break;
+  }
+  return MIN(n, total);
+}
+
+void QAST_Plan(QueryAST *q, RedisSearchCtx *sctx, const RSSearchOptions *opts) {
+  if (!q->root) {
+    return;
+  }
+  QueryNode_Plan(sctx, opts, q->root, sctx->spec->stats.numDocuments);
+}
+
 /* Set the field mask recursively on a query node. This is called by the parser to handle
  * situations like @foo:(bar baz|gaz), where a complex tree is being applied a field mask */
 void QueryNode_SetFieldMask(QueryNode *n, t_fieldMask mask) {
@@ -1011,12 +1173,22 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       s = QueryNode_DumpChildren(s, spec, qs, depth + 1);
       s = doPad(s, depth);
       break;
-    case QN_GEO:
-
-      s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
-                       qs->gn.gf->lat, qs->gn.gf->radius,
-                       GeoDistance_ToString(qs->gn.gf->unitType));
+    case QN_GEO: {
+      const GeoFilter *gf = qs->gn.gf;
+      if (gf->shape == GEO_SHAPE_BOX) {
+        s = sdscatprintf(s, "GEO %s:{%f,%f --> %f,%f", gf->property, gf->box[0], gf->box[1],
+                         gf->box[2], gf->box[3]);
+      } else if (gf->shape == GEO_SHAPE_POLYGON) {
+        s = sdscatprintf(s, "GEO %s:{", gf->property);
+        for (size_t ii = 0; ii < gf->npoints; ++ii) {
+          s = sdscatprintf(s, "%s%f,%f", ii ? " " : "", gf->points[ii * 2], gf->points[ii * 2 + 1]);
+        }
+      } else {
+        s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", gf->property, gf->lon, gf->lat, gf->radius,
+                         GeoDistance_ToString(gf->unitType));
+      }
       break;
+    }
     case QN_IDS:
 
       s = sdscat(s, "IDS { ");
@@ -1037,6 +1209,9 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
   }
 
   s = sdscat(s, "}");
+  if (qs->opts.flags & QueryNode_Tested) {
+    s = sdscat(s, "(tested)");
+  }
   // print attributes if not the default
   if (qs->opts.weight != 1 || qs->opts.maxSlop != -1 || qs->opts.inOrder) {
     s = sdscat(s, " => {");
@@ -98,6 +98,14 @@ IndexIterator *QAST_Iterate(const QueryAST *ast, const RSSearchOptions *options,
 int QAST_Expand(QueryAST *q, const char *expander, RSSearchOptions *opts, RedisSearchCtx *sctx,
                 QueryError *status);
 
+/**
+ * Plan the evaluation of the query from the statistics of the index. The children of intersections
+ * are ordered by the number of documents they are estimated to match, the most selective first, and
+ * numeric filters matching far more documents than their siblings are marked to be tested on the
+ * intersection's documents rather than iterated. Called after the query is expanded
+ */
+void QAST_Plan(QueryAST *q, RedisSearchCtx *sctx, const RSSearchOptions *opts);
+
 /* Return a string representation of the QueryParseCtx parse tree. The string should be freed by the
  * caller */
 char *QAST_DumpExplain(const QueryAST *q, const IndexSpec *spec);
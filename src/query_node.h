@@ -106,6 +106,9 @@ typedef struct {
 
 typedef enum {
   QueryNode_Verbatim = 0x01,
+  // set by the planner on filters which are tested on the documents of their intersection rather
+  // than iterated
+  QueryNode_Tested = 0x02,
 } QueryNodeFlags;
 
 /* Query attribute is a dynamic attribute that can be applied to any query node.
@@ -50,6 +50,8 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       RedisModule_Free(blk->buf.data);
       blk->buf.data = buf;
     }
+    // the max frequency and skip pointers are not persisted, recompute them from the records
+    IndexBlock_Rescan(blk, idx->flags);
   }
   idx->size = actualSize;
   if (idx->size == 0) {
@@ -99,6 +101,7 @@ unsigned long InvertedIndex_MemUsage(const void *value) {
   for (size_t i = 0; i < idx->size; i++) {
     ret += sizeof(IndexBlock);
     ret += IndexBlock_DataLen(&idx->blocks[i]);
+    ret += idx->blocks[i].numSkips * sizeof(IndexBlockSkip);
   }
   return ret;
 }
@@ -183,9 +186,9 @@ RedisSearchCtx *SearchCtx_Refresh(RedisSearchCtx *sctx, RedisModuleString *keyNa
   RedisModuleCtx *redisCtx = sctx->redisCtx;
   SearchCtx_Free(sctx);
   // now release the global lock
-  RedisModule_ThreadSafeContextUnlock(redisCtx);
+  ConcurrentSearch_ThreadSafeContextUnlock(redisCtx);
   // try to acquire it again...
-  RedisModule_ThreadSafeContextLock(redisCtx);
+  ConcurrentSearch_ThreadSafeContextLock(redisCtx);
   // reopen the context - it might have gone away!
   return NewSearchCtx(redisCtx, keyName, true);
 }
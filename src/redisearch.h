@@ -25,7 +25,7 @@ typedef uint64_t t_fieldMask;
 #define RS_FIELDMASK_ALL 0xFFFFFFFFFFFFFFFF
 #endif
 
-struct RSSortingVector;
+struct RSSortingColumns;
 
 #define REDISEARCH_ERR 1
 #define REDISEARCH_OK 0
@@ -89,10 +89,10 @@ typedef struct RSDocumentMetadata_s {
   /* Optional user payload */
   RSPayload *payload;
 
-  struct RSSortingVector *sortVector;
+  /* The sortable columns of the index holding the document's sortable values, if it has any */
+  struct RSSortingColumns *sortCols;
   /* Offsets of all terms in the document (in bytes). Used by highlighter */
   struct RSByteOffsets *byteOffsets;
-  DLLIST2_node llnode;
   uint32_t ref_count;
 } RSDocumentMetadata;
 
@@ -152,7 +152,7 @@ int RediSearch_DeleteDocument(IndexSpec* sp, const void* docKey, size_t len) {
       // Delete returns true/false, not RM_{OK,ERR}
       sp->stats.numDocuments--;
       if (sp->gc) {
-        GCContext_OnDelete(sp->gc);
+        GCContext_OnDelete(sp->gc, id);
       }
     } else {
       rc = REDISMODULE_ERR;
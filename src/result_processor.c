@@ -4,6 +4,7 @@
 #include <util/minmax_heap.h>
 #include "ext/default.h"
 #include "rmutil/rm_assert.h"
+#include "numeric_index.h"
 
 /*******************************************************************************************************************
  *  General Result Processor Helper functions
@@ -45,6 +46,23 @@ void SearchResult_Destroy(SearchResult *r) {
   RLookupRow_Cleanup(&r->rowdata);
 }
 
+int RP_NextBatch(ResultProcessor *rp, SearchResult *results, size_t n, size_t *nread) {
+  if (rp->NextBatch) {
+    return rp->NextBatch(rp, results, n, nread);
+  }
+  int rc = RS_RESULT_OK;
+  size_t ii = 0;
+  while (ii < n && (rc = rp->Next(rp, &results[ii])) == RS_RESULT_OK) {
+    ii++;
+  }
+  if (ii < n) {
+    // the result may hold data even if it was not returned
+    SearchResult_Clear(&results[ii]);
+  }
+  *nread = ii;
+  return rc;
+}
+
 static int RPGeneric_NextEOF(ResultProcessor *rp, SearchResult *res) {
   return RS_RESULT_EOF;
 }
@@ -63,10 +81,68 @@ typedef struct {
   size_t timeoutLimiter;   // counter to limit number of calls to TimedOut()
 } RPIndexIterator;
 
+/* In concurrent read mode the index may be dropped while the query yields the index lock */
+static int rpIndexDropped(ResultProcessor *rp) {
+  QueryError_SetError(rp->parent->err, QUERY_ENOINDEX, "The index was dropped during the query");
+  return RS_RESULT_ERROR;
+}
+
+/* Check the index after the query yielded the index lock. Compaction does not run while queries
+ * use the index, but if the documents were renumbered the iterators cannot resume, and the query
+ * fails rather than return partial results */
+static int rpCheckIndex(ResultProcessor *rp) {
+  ConcurrentSearchCtx *conc = rp->parent->conc;
+  if (conc->spec->isDropped) {
+    return rpIndexDropped(rp);
+  }
+  if (conc->idsVersion != conc->spec->docs.idsVersion) {
+    QueryError_SetError(rp->parent->err, QUERY_EGENERIC,
+                        "The index was compacted during the query");
+    return RS_RESULT_ERROR;
+  }
+  return RS_RESULT_OK;
+}
+
+/* Get the metadata of a document read from the index, or NULL if it should not be returned */
+static RSDocumentMetadata *rpidxGetDocument(ResultProcessor *base, t_docId docId) {
+  RSDocumentMetadata *dmd = DocTable_Get(&RP_SPEC(base)->docs, docId);
+  if (!dmd || (dmd->flags & Document_Deleted)) {
+    return NULL;
+  }
+  if (isTrimming && RedisModule_ShardingGetKeySlot) {
+    RedisModuleString *key = RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr));
+    int slot = RedisModule_ShardingGetKeySlot(key);
+    RedisModule_FreeString(NULL, key);
+    int firstSlot, lastSlot;
+    RedisModule_ShardingGetSlotRange(&firstSlot, &lastSlot);
+    if (firstSlot > slot || lastSlot < slot) {
+      return NULL;
+    }
+  }
+  return dmd;
+}
+
+static void rpidxSetResult(SearchResult *res, RSIndexResult *r, RSDocumentMetadata *dmd) {
+  res->docId = r->docId;
+  res->indexResult = r;
+  res->score = 0;
+  res->dmd = dmd;
+  res->rowdata.sv = dmd->sortCols;
+  res->rowdata.svDocId = dmd->id;
+  DMD_Incref(dmd);
+}
+
 /* Next implementation */
 static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   RPIndexIterator *self = (RPIndexIterator *)base;
   IndexIterator *it = self->iiter;
+  ConcurrentSearchCtx *conc = base->parent->conc;
+
+  // Let writers in from time to time when running without the GIL
+  if (ConcurrentSearchCtx_IsReadMode(conc) && CONCURRENT_CTX_TICK(conc) &&
+      rpCheckIndex(base) != RS_RESULT_OK) {
+    return RS_RESULT_ERROR;
+  }
 
   if (++self->timeoutLimiter == 100) {
     self->timeoutLimiter = 0;
@@ -94,20 +170,10 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
       continue;
     }
 
-    dmd = DocTable_Get(&RP_SPEC(base)->docs, r->docId);
-    if (!dmd || (dmd->flags & Document_Deleted)) {
+    dmd = rpidxGetDocument(base, r->docId);
+    if (!dmd) {
       continue;
     }
-    if (isTrimming && RedisModule_ShardingGetKeySlot) {
-      RedisModuleString *key = RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr));
-      int slot = RedisModule_ShardingGetKeySlot(key);
-      RedisModule_FreeString(NULL, key);
-      int firstSlot, lastSlot;
-      RedisModule_ShardingGetSlotRange(&firstSlot, &lastSlot);
-      if (firstSlot > slot || lastSlot < slot) {
-        continue;
-      }
-    }
 
     // Increment the total results barring deleted results
     base->parent->totalResults++;
@@ -115,15 +181,21 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   }
 
   // set the result data
-  res->docId = r->docId;
-  res->indexResult = r;
-  res->score = 0;
-  res->dmd = dmd;
-  res->rowdata.sv = dmd->sortVector;
-  DMD_Incref(dmd);
+  rpidxSetResult(res, r, dmd);
   return RS_RESULT_OK;
 }
 
+/* NextBatch implementation, reading the results without a call through the chain for each */
+static int rpidxNextBatch(ResultProcessor *base, SearchResult *results, size_t n, size_t *nread) {
+  int rc = RS_RESULT_OK;
+  size_t ii = 0;
+  while (ii < n && (rc = rpidxNext(base, &results[ii])) == RS_RESULT_OK) {
+    ii++;
+  }
+  *nread = ii;
+  return rc;
+}
+
 static void rpidxFree(ResultProcessor *iter) {
   rm_free(iter);
 }
@@ -133,11 +205,270 @@ ResultProcessor *RPIndexIterator_New(IndexIterator *root, struct timespec timeou
   ret->iiter = root;
   ret->timeout = timeout;
   ret->base.Next = rpidxNext;
+  ret->base.NextBatch = rpidxNextBatch;
   ret->base.Free = rpidxFree;
   ret->base.type = RP_INDEX;
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Numeric Sorted Base Processor - replaces the base processor when the query is sorted by a SORTABLE
+ * numeric field.
+ *
+ * Rather than reading all the results of the root iterator and leaving their ordering to the sorter,
+ * it walks the leaf ranges of the field's numeric index in the sort order, and returns the results of
+ * the root iterator in each range. The ranges hold disjoint values, so once a whole range was read
+ * and at least `limit` results were returned, no later result can make it into the sorter's top
+ * results. The rest of the results of the root iterator are then only counted.
+ *
+ * Documents without a value sort before all the others in ascending order, and after them in
+ * descending order. They are looked for by scanning the root iterator, which is skipped in ascending
+ * order if every document has a value.
+ ********************************************************************************************************************/
+
+typedef enum {
+  RPNS_MISSING_FIRST,
+  RPNS_RANGES,
+  RPNS_MISSING_LAST,
+  RPNS_COUNT,
+  RPNS_EOF,
+} RPNumericSortedState;
+
+typedef struct {
+  ResultProcessor base;
+  IndexIterator *iiter;
+  struct timespec timeout;
+  size_t timeoutLimiter;
+
+  NumericRangeTree *tree;
+  int sortIdx;
+  int ascending;
+  size_t limit;
+  // whether there may be documents without a value
+  int hasMissing;
+
+  RPNumericSortedState state;
+  // number of results returned so far
+  size_t nfound;
+
+  // reader of the current range, and the bound the next range is looked up by
+  IndexIterator *rangeIt;
+  double bound;
+  int lastRange;
+  // last position of the root iterator within the current range, and its record
+  t_docId rootId;
+  RSIndexResult *rootHit;
+} RPNumericSorted;
+
+/* Read the next result of the root iterator within the current range. The range is usually far
+ * smaller than the root iterator's results, so it leads and the root iterator skips to its ids */
+static int rpnsReadRange(RPNumericSorted *self, RSIndexResult **hit) {
+  IndexIterator *root = self->iiter;
+  if (!self->rangeIt) {
+    double lo, hi;
+    NumericRange *rng =
+        NumericRangeTree_NextLeaf(self->tree, self->bound, self->ascending, &lo, &hi);
+    self->bound = self->ascending ? hi : lo;
+    self->lastRange = self->ascending ? hi == NF_INFINITY : lo == NF_NEGATIVE_INFINITY;
+    if (!rng) {
+      return INDEXREAD_EOF;
+    }
+    self->rangeIt = NewNumericRangeIterator(RP_SPEC(&self->base), rng, NULL);
+    root->Rewind(root->ctx);
+    self->rootId = 0;
+  }
+
+  IndexIterator *rit = self->rangeIt;
+  RSIndexResult *rr = NULL;
+  if (rit->Read(rit->ctx, &rr) != INDEXREAD_OK) {
+    return INDEXREAD_EOF;
+  }
+  while (1) {
+    if (self->rootId < rr->docId) {
+      if (root->SkipTo(root->ctx, rr->docId, &self->rootHit) == INDEXREAD_EOF) {
+        return INDEXREAD_EOF;
+      }
+      // whether it was found or not, the root iterator is now at its next result
+      self->rootId = self->rootHit->docId;
+    }
+    if (self->rootId == rr->docId) {
+      *hit = self->rootHit;
+      return INDEXREAD_OK;
+    }
+    if (rit->SkipTo(rit->ctx, self->rootId, &rr) == INDEXREAD_EOF) {
+      return INDEXREAD_EOF;
+    }
+  }
+}
+
+/* Move on once a range or a scan for documents without a value is done */
+static void rpnsEndGroup(RPNumericSorted *self) {
+  if (self->rangeIt) {
+    self->rangeIt->Free(self->rangeIt);
+    self->rangeIt = NULL;
+  }
+
+  switch (self->state) {
+    case RPNS_MISSING_FIRST:
+      self->state = RPNS_RANGES;
+      break;
+    case RPNS_RANGES:
+      if (!self->lastRange) {
+        break;
+      }
+      self->state = !self->ascending && self->hasMissing ? RPNS_MISSING_LAST : RPNS_EOF;
+      break;
+    default:
+      self->state = RPNS_EOF;
+      break;
+  }
+
+  if (self->state != RPNS_EOF && self->nfound >= self->limit) {
+    // the remaining results are all ordered after the ones returned
+    self->state = RPNS_COUNT;
+    self->base.parent->totalResults = 0;
+  }
+  if (self->state == RPNS_MISSING_LAST || self->state == RPNS_COUNT) {
+    self->iiter->Rewind(self->iiter->ctx);
+  }
+}
+
+/* Count the results of the root iterator, as the results returned were only the first ones */
+static int rpnsCount(RPNumericSorted *self) {
+  ResultProcessor *base = &self->base;
+  IndexIterator *root = self->iiter;
+  ConcurrentSearchCtx *conc = base->parent->conc;
+  DocTable *docs = &RP_SPEC(base)->docs;
+
+  // the wildcard iterator reads the live documents
+  if (root->type == WILDCARD_ITERATOR && !isTrimming) {
+    base->parent->totalResults = DocIdBitmap_Cardinality(&docs->live);
+    self->state = RPNS_EOF;
+    return RS_RESULT_EOF;
+  }
+
+  RSIndexResult *r = NULL;
+  while (1) {
+    if (ConcurrentSearchCtx_IsReadMode(conc) && CONCURRENT_CTX_TICK(conc) &&
+        rpCheckIndex(base) != RS_RESULT_OK) {
+      return RS_RESULT_ERROR;
+    }
+    if (++self->timeoutLimiter == 100) {
+      self->timeoutLimiter = 0;
+      if (TimedOut(self->timeout) == RS_RESULT_TIMEDOUT) {
+        return RS_RESULT_TIMEDOUT;
+      }
+    }
+
+    int rc = root->Read(root->ctx, &r);
+    if (rc == INDEXREAD_EOF) {
+      break;
+    } else if (!r || rc == INDEXREAD_NOTFOUND) {
+      continue;
+    }
+    if (isTrimming ? rpidxGetDocument(base, r->docId) != NULL
+                   : DocIdBitmap_Contains(&docs->live, r->docId)) {
+      base->parent->totalResults++;
+    }
+  }
+  self->state = RPNS_EOF;
+  return RS_RESULT_EOF;
+}
+
+static int rpnsNext(ResultProcessor *base, SearchResult *res) {
+  RPNumericSorted *self = (RPNumericSorted *)base;
+  ConcurrentSearchCtx *conc = base->parent->conc;
+
+  // No root filter - the query has 0 results
+  if (self->iiter == NULL) {
+    return RS_RESULT_EOF;
+  }
+
+  while (1) {
+    // Let writers in from time to time when running without the GIL. A range is read without
+    // yielding, as the tree may change meanwhile
+    if (!self->rangeIt && ConcurrentSearchCtx_IsReadMode(conc) && CONCURRENT_CTX_TICK(conc) &&
+        rpCheckIndex(base) != RS_RESULT_OK) {
+      return RS_RESULT_ERROR;
+    }
+
+    if (++self->timeoutLimiter == 100) {
+      self->timeoutLimiter = 0;
+      if (TimedOut(self->timeout) == RS_RESULT_TIMEDOUT) {
+        return RS_RESULT_TIMEDOUT;
+      }
+    }
+
+    RSIndexResult *r = NULL;
+    int rc;
+    switch (self->state) {
+      case RPNS_EOF:
+        return RS_RESULT_EOF;
+      case RPNS_COUNT:
+        return rpnsCount(self);
+      case RPNS_RANGES:
+        rc = rpnsReadRange(self, &r);
+        break;
+      default:
+        rc = self->iiter->Read(self->iiter->ctx, &r);
+        break;
+    }
+
+    if (rc == INDEXREAD_EOF) {
+      rpnsEndGroup(self);
+      continue;
+    } else if (!r || rc == INDEXREAD_NOTFOUND) {
+      continue;
+    }
+
+    RSDocumentMetadata *dmd = rpidxGetDocument(base, r->docId);
+    if (!dmd) {
+      continue;
+    }
+    if (self->state != RPNS_RANGES && dmd->sortCols &&
+        RSSortingColumns_Get(dmd->sortCols, dmd->id, self->sortIdx)) {
+      // only documents without a value are scanned for
+      continue;
+    }
+
+    base->parent->totalResults++;
+    self->nfound++;
+    rpidxSetResult(res, r, dmd);
+    return RS_RESULT_OK;
+  }
+}
+
+static void rpnsFree(ResultProcessor *base) {
+  RPNumericSorted *self = (RPNumericSorted *)base;
+  if (self->rangeIt) {
+    self->rangeIt->Free(self->rangeIt);
+  }
+  rm_free(self);
+}
+
+ResultProcessor *RPNumericSortedIterator_New(IndexIterator *root, struct timespec timeout,
+                                             RedisSearchCtx *sctx, NumericRangeTree *t,
+                                             const FieldSpec *fs, int ascending, size_t limit) {
+  RPNumericSorted *ret = rm_calloc(1, sizeof(*ret));
+  ret->iiter = root;
+  ret->timeout = timeout;
+  ret->tree = t;
+  ret->sortIdx = fs->sortIdx;
+  ret->ascending = ascending;
+  ret->limit = limit;
+  ret->bound = ascending ? NF_NEGATIVE_INFINITY : NF_INFINITY;
+
+  const DocTable *docs = &sctx->spec->docs;
+  ret->hasMissing = !docs->sortables || DocIdBitmap_Cardinality(&docs->live) >
+                                            RSSortingColumns_NumValues(docs->sortables, fs->sortIdx);
+  ret->state = ascending && ret->hasMissing ? RPNS_MISSING_FIRST : RPNS_RANGES;
+
+  ret->base.Next = rpnsNext;
+  ret->base.Free = rpnsFree;
+  ret->base.type = RP_INDEX;
+  return &ret->base;
+}
+
 void updateRPIndexTimeout(ResultProcessor *base, struct timespec timeout){
   RPIndexIterator *self = (RPIndexIterator *)base;
   self->timeout = timeout;
@@ -285,6 +616,9 @@ typedef struct {
   // pooled result - we recycle it to avoid allocations
   SearchResult *pooledResult;
 
+  // results read from upstream, before they are added to the heap
+  SearchResult *batch;
+
   struct {
     const RLookupKey **keys;
     size_t nkeys;
@@ -315,36 +649,23 @@ static void rpsortFree(ResultProcessor *rp) {
     SearchResult_Destroy(self->pooledResult);
     rm_free(self->pooledResult);
   }
+  if (self->batch) {
+    for (size_t ii = 0; ii < RP_BATCH_SIZE; ++ii) {
+      SearchResult_Destroy(&self->batch[ii]);
+    }
+    rm_free(self->batch);
+  }
 
   // calling mmh_free will free all the remaining results in the heap, if any
   mmh_free(self->pq);
   rm_free(rp);
 }
 
-#define RESULT_QUEUED RS_RESULT_MAX + 1
-
-static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
+/* Add a result read from upstream to the heap. The result is moved to the heap if it is one of the
+ * top results, and cleared otherwise */
+static int rpsortAddResult(ResultProcessor *rp, SearchResult *h) {
   RPSorter *self = (RPSorter *)rp;
 
-  if (self->pooledResult == NULL) {
-    self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
-  } else {
-    RLookupRow_Wipe(&self->pooledResult->rowdata);
-  }
-
-  SearchResult *h = self->pooledResult;
-  int rc = rp->upstream->Next(rp->upstream, h);
-
-  // if our upstream has finished - just change the state to not accumulating, and yield
-  if (rc == RS_RESULT_EOF) {
-    // Transition state:
-    rp->Next = rpsortNext_Yield;
-    return rpsortNext_Yield(rp, r);
-  } else if (rc != RS_RESULT_OK) {
-    // whoops!
-    return rc;
-  }
-
   // If the data is not in the sorted vector, lets load it.
   size_t nkeys = self->fieldcmp.nkeys;
   if (nkeys && h->dmd) {
@@ -375,56 +696,96 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
                                      .nkeys = nloadKeys,
                                      .keys = loadKeys,
                                      .status = &status};
+      if (ConcurrentSearchCtx_LockGIL(rp->parent->conc) != REDISMODULE_OK) {
+        if (freeKeys) rm_free(loadKeys);
+        return rpIndexDropped(rp);
+      }
       RLookup_LoadDocument(NULL, &h->rowdata, &loadopts);
+      ConcurrentSearchCtx_UnlockGIL(rp->parent->conc);
+      if (freeKeys) rm_free(loadKeys);
       if (QueryError_HasError(&status)) {
         return RS_RESULT_ERROR;
       }
-      if (freeKeys) rm_free(loadKeys);
     }
   }
 
   // If the queue is not full - we just push the result into it
   // If the pool size is 0 we always do that, letting the heap grow dynamically
-  if (!self->size || self->pq->count + 1 < self->pq->size) {
-
-    // copy the index result to make it thread safe - but only if it is pushed to the heap
-    h->indexResult = NULL;
-    mmh_insert(self->pq, h);
-    self->pooledResult = NULL;
-    if (h->score < rp->parent->minScore) {
-      rp->parent->minScore = h->score;
-    }
-
-  } else {
+  int push = !self->size || self->pq->count + 1 < self->pq->size;
+  SearchResult *minh = NULL;
+  if (!push) {
     // find the min result
-    SearchResult *minh = mmh_peek_min(self->pq);
+    minh = mmh_peek_min(self->pq);
+    push = self->cmp(h, minh, self->cmpCtx) > 0;
+  }
+  if (!push) {
+    // The current should not enter the pool, so just leave it as is
+    SearchResult_Clear(h);
+    return RS_RESULT_OK;
+  }
 
-    // update the min score. Irrelevant to SORTBY mode but hardly costs anything...
+  // The heap keeps its own copy, and the batch slot gets the pooled result's row to reuse
+  SearchResult *sr = self->pooledResult ? self->pooledResult : rm_calloc(1, sizeof(*sr));
+  SearchResult tmp = *sr;
+  *sr = *h;
+  *h = tmp;
+  // copy the index result to make it thread safe - but only if it is pushed to the heap
+  sr->indexResult = NULL;
+  self->pooledResult = NULL;
+
+  if (minh) {
+    // pop the min result and insert the new one
+    self->pooledResult = mmh_pop_min(self->pq);
+    SearchResult_Clear(self->pooledResult);
+  } else if (sr->score < rp->parent->minScore) {
+    rp->parent->minScore = sr->score;
+  }
+  mmh_insert(self->pq, sr);
+
+  // once the heap is full the scorer may skip results below its top, so the min score follows it.
+  // Irrelevant to SORTBY mode but hardly costs anything...
+  if (self->size && self->pq->count + 1 >= self->pq->size) {
+    minh = mmh_peek_min(self->pq);
     if (minh->score > rp->parent->minScore) {
       rp->parent->minScore = minh->score;
     }
-
-    // if needed - pop it and insert a new result
-    if (self->cmp(h, minh, self->cmpCtx) > 0) {
-      h->indexResult = NULL;
-      self->pooledResult = mmh_pop_min(self->pq);
-      mmh_insert(self->pq, h);
-      SearchResult_Clear(self->pooledResult);
-    } else {
-      // The current should not enter the pool, so just leave it as is
-      self->pooledResult = h;
-      SearchResult_Clear(self->pooledResult);
-    }
   }
-  return RESULT_QUEUED;
+  return RS_RESULT_OK;
 }
 
 static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
-  int rc;
-  while ((rc = rpsortNext_innerLoop(rp, r)) == RESULT_QUEUED) {
-    // Do nothing.
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->batch) {
+    self->batch = rm_calloc(RP_BATCH_SIZE, sizeof(*self->batch));
+  }
+
+  // The scorer gets the min score of the heap when scoring each result, which would be stale for
+  // all but the first of a batch. It reads its upstream one result at a time anyway, so nothing is
+  // saved by batching it
+  size_t batchSize = rp->upstream->type == RP_SCORER ? 1 : RP_BATCH_SIZE;
+  while (1) {
+    size_t n;
+    int rc = RP_NextBatch(rp->upstream, self->batch, batchSize, &n);
+    for (size_t ii = 0; ii < n; ++ii) {
+      int addrc = rpsortAddResult(rp, &self->batch[ii]);
+      if (addrc != RS_RESULT_OK) {
+        for (; ii < n; ++ii) {
+          SearchResult_Clear(&self->batch[ii]);
+        }
+        return addrc;
+      }
+    }
+
+    // if our upstream has finished - just change the state to not accumulating, and yield
+    if (rc == RS_RESULT_EOF) {
+      // Transition state:
+      rp->Next = rpsortNext_Yield;
+      return rpsortNext_Yield(rp, r);
+    } else if (rc != RS_RESULT_OK) {
+      // whoops!
+      return rc;
+    }
   }
-  return rc;
 }
 
 /* Compare results for the heap by score */
@@ -467,7 +828,8 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
       return ascending ? -rc : rc;
     }
 
-    int rc = RSValue_Cmp(v1, v2, qerr);
+    // sortable strings are interned, so equal sortable values are often the same value
+    int rc = v1 == v2 ? 0 : RSValue_Cmp(v1, v2, qerr);
     // printf("asc? %d Compare: \n", ascending);
     // RSValue_Print(v1);
     // printf(" <=> ");
@@ -587,55 +949,135 @@ ResultProcessor *RPPager_New(size_t offset, size_t limit) {
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+// Maximal number of results the loader reads ahead and loads at once
+#define RPLOADER_MAX_BATCH 64
+
 typedef struct {
   ResultProcessor base;
   RLookup *lk;
   const RLookupKey **fields;
   size_t nfields;
+
+  /* Results are loaded in batches, so that the GIL is only taken once per batch. Batches grow from a
+   * single result up to RPLOADER_MAX_BATCH, so that results which are read ahead of a LIMIT are not
+   * loaded needlessly */
+  SearchResult *batch;
+  size_t batchSize;
+  size_t batchLen;
+  size_t batchPos;
+  // the code returned by upstream after the last result of the batch
+  int batchRc;
 } RPLoader;
 
-static int rploaderNext(ResultProcessor *base, SearchResult *r) {
-  RPLoader *lc = (RPLoader *)base;
-  do {
-    int rc = base->upstream->Next(base->upstream, r);
-    if (rc != RS_RESULT_OK) {
-      return rc;
-    }
+/* Load the document of a result. The keyspace is only accessed under the GIL */
+static int rploaderLoadResult(RPLoader *lc, SearchResult *r) {
+  // Current behavior skips entire result if document does not exist.
+  // I'm unusre if that's intentional or an oversight.
+  if (r->dmd == NULL || (r->dmd->flags & Document_Deleted)) {
+    return REDISMODULE_OK;
+  }
 
-    int isExplicitReturn = !!lc->nfields;
+  QueryError status = {0};
+  RLookupLoadOptions loadopts = {.sctx = lc->base.parent->sctx,  // lb
+                                 .dmd = r->dmd,
+                                 .noSortables = 1,
+                                 .forceString = 1,
+                                 .status = &status,
+                                 .keys = lc->fields,
+                                 .nkeys = lc->nfields};
+  if (lc->nfields) {
+    loadopts.mode |= RLOOKUP_LOAD_KEYLIST;
+  } else {
+    loadopts.mode |= RLOOKUP_LOAD_ALLKEYS;
+  }
+  return RLookup_LoadDocument(lc->lk, &r->rowdata, &loadopts);
+}
 
-    // Current behavior skips entire result if document does not exist.
-    // I'm unusre if that's intentional or an oversight.
-    if (r->dmd == NULL || (r->dmd->flags & Document_Deleted)) {
-      return RS_RESULT_OK;
-    }
-    RedisSearchCtx *sctx = lc->base.parent->sctx;
+/* Load the documents of `n` results, taking the GIL once. Results whose documents could not be
+ * loaded are dropped, and `n` is set to the number of results left */
+static int rploaderLoadResults(RPLoader *lc, SearchResult *results, size_t *n) {
+  if (!*n) {
+    return RS_RESULT_OK;
+  }
 
-    QueryError status = {0};
-    RLookupLoadOptions loadopts = {.sctx = lc->base.parent->sctx,  // lb
-                                   .dmd = r->dmd,
-                                   .noSortables = 1,
-                                   .forceString = 1,
-                                   .status = &status,
-                                   .keys = lc->fields,
-                                   .nkeys = lc->nfields};
-    if (isExplicitReturn) {
-      loadopts.mode |= RLOOKUP_LOAD_KEYLIST;
-    } else {
-      loadopts.mode |= RLOOKUP_LOAD_ALLKEYS;
+  if (ConcurrentSearchCtx_LockGIL(lc->base.parent->conc) != REDISMODULE_OK) {
+    for (size_t ii = 0; ii < *n; ++ii) {
+      SearchResult_Clear(&results[ii]);
     }
-    if (RLookup_LoadDocument(lc->lk, &r->rowdata, &loadopts) != REDISMODULE_OK) {
-      base->parent->totalResults--;
+    *n = 0;
+    return rpIndexDropped(&lc->base);
+  }
+  size_t nloaded = 0;
+  for (size_t ii = 0; ii < *n; ++ii) {
+    SearchResult *r = &results[ii];
+    if (rploaderLoadResult(lc, r) != REDISMODULE_OK) {
+      lc->base.parent->totalResults--;
       SearchResult_Clear(r);
       continue;
     }
-    break;
-  } while (1);
+    if (ii != nloaded) {
+      // keep the loaded results first, swapping so that no row is leaked
+      SearchResult tmp = results[nloaded];
+      results[nloaded] = *r;
+      *r = tmp;
+    }
+    nloaded++;
+  }
+  ConcurrentSearchCtx_UnlockGIL(lc->base.parent->conc);
+  *n = nloaded;
   return RS_RESULT_OK;
 }
 
+/* Read the next batch of results from upstream and load their documents */
+static int rploaderFillBatch(RPLoader *lc) {
+  lc->batchPos = 0;
+  lc->batchRc = RP_NextBatch(lc->base.upstream, lc->batch, lc->batchSize, &lc->batchLen);
+  if (lc->batchSize < RPLOADER_MAX_BATCH) {
+    lc->batchSize *= 2;
+  }
+  return rploaderLoadResults(lc, lc->batch, &lc->batchLen);
+}
+
+static int rploaderNext(ResultProcessor *base, SearchResult *r) {
+  RPLoader *lc = (RPLoader *)base;
+  while (lc->batchPos == lc->batchLen) {
+    if (lc->batchRc != RS_RESULT_OK) {
+      // the batch ended where upstream stopped; report it once, and read on if called again
+      int rc = lc->batchRc;
+      lc->batchRc = RS_RESULT_OK;
+      return rc;
+    }
+    int rc = rploaderFillBatch(lc);
+    if (rc != RS_RESULT_OK) {
+      return rc;
+    }
+  }
+
+  // Hand over the result, and keep the caller's row for reuse by the next batch
+  SearchResult *h = &lc->batch[lc->batchPos++];
+  SearchResult tmp = *r;
+  *r = *h;
+  *h = tmp;
+  SearchResult_Clear(h);
+  return RS_RESULT_OK;
+}
+
+/* NextBatch implementation. The results are read and loaded straight into the caller's batch, so
+ * the loader is read either by Next() or by NextBatch(), and not by both */
+static int rploaderNextBatch(ResultProcessor *base, SearchResult *results, size_t n,
+                             size_t *nread) {
+  RPLoader *lc = (RPLoader *)base;
+  int rc = RP_NextBatch(base->upstream, results, n, nread);
+  int loadrc = rploaderLoadResults(lc, results, nread);
+  return loadrc != RS_RESULT_OK ? loadrc : rc;
+}
+
 static void rploaderFree(ResultProcessor *base) {
   RPLoader *lc = (RPLoader *)base;
+  for (size_t ii = 0; ii < RPLOADER_MAX_BATCH; ++ii) {
+    SearchResult_Destroy(&lc->batch[ii]);
+  }
+  rm_free(lc->batch);
   rm_free(lc->fields);
   rm_free(lc);
 }
@@ -645,9 +1087,12 @@ ResultProcessor *RPLoader_New(RLookup *lk, const RLookupKey **keys, size_t nkeys
   sc->nfields = nkeys;
   sc->fields = rm_calloc(nkeys, sizeof(*sc->fields));
   memcpy(sc->fields, keys, sizeof(*keys) * nkeys);
+  sc->batch = rm_calloc(RPLOADER_MAX_BATCH, sizeof(*sc->batch));
+  sc->batchSize = 1;
 
   sc->lk = lk;
   sc->base.Next = rploaderNext;
+  sc->base.NextBatch = rploaderNextBatch;
   sc->base.Free = rploaderFree;
   sc->base.type = RP_LOADER;
   return &sc->base;
@@ -693,6 +1138,18 @@ static int rpprofileNext(ResultProcessor *base, SearchResult *r) {
   return rc;
 }
 
+static int rpprofileNextBatch(ResultProcessor *base, SearchResult *results, size_t n,
+                              size_t *nread) {
+  RPProfile *self = (RPProfile *)base;
+
+  clock_t rpStartTime = clock();
+  int rc = RP_NextBatch(base->upstream, results, n, nread);
+  self->profileTime += clock() - rpStartTime;
+  // count the results as calls to Next() would, including the one which ended the stream
+  self->profileCount += *nread + (rc != RS_RESULT_OK);
+  return rc;
+}
+
 static void rpProfileFree(ResultProcessor *base) {
   RPProfile *rp = (RPProfile *)base;
   rm_free(rp);
@@ -705,6 +1162,7 @@ ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter) {
   rpp->base.upstream = rp;
   rpp->base.parent = qiter;
   rpp->base.Next = rpprofileNext;
+  rpp->base.NextBatch = rpprofileNextBatch;
   rpp->base.Free = rpProfileFree;
   rpp->base.type = RP_PROFILE;
 
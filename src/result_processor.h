@@ -167,6 +167,18 @@ typedef struct ResultProcessor {
    */
   int (*Next)(struct ResultProcessor *self, SearchResult *res);
 
+  /**
+   * Optional. Populates up to `n` results of the `results` array at once, as `n` calls to Next()
+   * would, and sets `nread` to the number of results populated. Processors which consume whole
+   * streams (e.g. sorters and groupers) pull their upstream in batches, saving a chain of calls
+   * per row. Use RP_NextBatch() to read a batch from any processor.
+   *
+   * Returns RS_RESULT_OK if the stream may go on - possibly after fewer than `n` results - or the
+   * code Next() would have returned after the results populated. The results past `nread` are
+   * left empty.
+   */
+  int (*NextBatch)(struct ResultProcessor *self, SearchResult *results, size_t n, size_t *nread);
+
   /** Frees the processor and any internal data related to it. */
   void (*Free)(struct ResultProcessor *self);
 } ResultProcessor;
@@ -174,6 +186,15 @@ typedef struct ResultProcessor {
 // Get the index spec from the result processor
 #define RP_SPEC(rpctx) ((rpctx)->parent->sctx->spec)
 
+// Number of results read at once by processors which consume their whole upstream
+#define RP_BATCH_SIZE 64
+
+/**
+ * Read a batch of results from `rp`, see ResultProcessor::NextBatch. Processors which don't
+ * implement it are called once per result.
+ */
+int RP_NextBatch(ResultProcessor *rp, SearchResult *results, size_t n, size_t *nread);
+
 /**
  * This function resets the search result, so that it may be reused again.
  * Internal caches are reset but not freed
@@ -188,6 +209,17 @@ void SearchResult_Destroy(SearchResult *r);
 
 ResultProcessor *RPIndexIterator_New(IndexIterator *itr, struct timespec timeoutTime);
 
+/**
+ * Like RPIndexIterator_New, for queries sorted by the SORTABLE numeric field `fs` whose numeric
+ * index is `t`. The results are returned a range of the numeric index at a time, in the sort order,
+ * until the range in which `limit` results were reached. The results are still fed to a sorter, which
+ * needs to keep `limit` results.
+ */
+struct NumericRangeTree;
+ResultProcessor *RPNumericSortedIterator_New(IndexIterator *itr, struct timespec timeoutTime,
+                                             RedisSearchCtx *sctx, struct NumericRangeTree *t,
+                                             const FieldSpec *fs, int ascending, size_t limit);
+
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs);
 
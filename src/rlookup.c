@@ -172,6 +172,7 @@ void RLookupRow_Wipe(RLookupRow *r) {
     }
   }
   r->sv = NULL;
+  r->svDocId = 0;
   if (r->rmkey) {
     RedisModule_CloseKey(r->rmkey);
     r->rmkey = NULL;
@@ -295,7 +296,7 @@ static int getKeyCommon(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOption
   if (!*keyobj) {
     RedisModuleCtx *ctx = options->sctx->redisCtx;
     RedisModuleString *keyName =
-        RedisModule_CreateString(ctx, options->dmd->keyPtr, strlen(options->dmd->keyPtr));
+        RedisModule_CreateString(ctx, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
     *keyobj = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ);
     RedisModule_FreeString(ctx, keyName);
     if (!*keyobj) {
@@ -367,55 +368,62 @@ done:
   return rc;
 }
 
-int RLookup_GetHash(RLookup *it, RLookupRow *dst, RedisModuleCtx *ctx, RedisModuleString *key) {
-  int rc = REDISMODULE_ERR;
-  RedisModuleCallReply *rep = RedisModule_Call(ctx, "HGETALL", "s", key);
+typedef struct {
+  RLookup *it;
+  RLookupRow *dst;
+  // Load sortable fields as well, rather than reading them from the sorting vector on demand
+  int noSortables;
+  int forceString;
+} RLookupHashLoader;
+
+/* Get the key a field of the hash is written to, or NULL if the field should not be loaded */
+static RLookupKey *hashFieldKey(RLookupHashLoader *hl, const char *kstr, size_t klen) {
+  RLookupKey *rlk = RLookup_GetKeyEx(hl->it, kstr, klen, RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC);
+  if (!hl->noSortables && (rlk->flags & RLOOKUP_F_SVSRC)) {
+    return NULL;  // Can load it from the sort vector on demand.
+  }
+  return rlk;
+}
 
-  if (rep == NULL || RedisModule_CallReplyType(rep) != REDISMODULE_REPLY_ARRAY) {
-    goto done;
-  }
+static void hashScanCallback(RedisModuleKey *key, RedisModuleString *field,
+                             RedisModuleString *value, void *privdata) {
+  RLookupHashLoader *hl = privdata;
+  size_t klen = 0;
+  const char *kstr = RedisModule_StringPtrLen(field, &klen);
+  RLookupKey *rlk = hashFieldKey(hl, kstr, klen);
+  if (!rlk) {
+    return;
+  }
+  RLookupCoerceType ctype = hl->forceString ? RLOOKUP_C_STR : rlk->fieldtype;
+  // String values retain the field's value rather than copying it
+  RLookup_WriteOwnKey(rlk, hl->dst, hvalToValue(value, ctype));
+}
 
-  size_t len = RedisModule_CallReplyLength(rep);
-  // Zero means the document does not exist in redis
-  if (len == 0) {
-    goto done;
+/* Read the hash directly from the keyspace. The hash is scanned in place, without building a
+ * reply for it */
+static int loadHashDirect(RLookupHashLoader *hl, RedisModuleCtx *ctx, RedisModuleString *krstr) {
+  RedisModuleKey *key = RedisModule_OpenKey(ctx, krstr, REDISMODULE_READ);
+  if (!key) {
+    return REDISMODULE_ERR;
   }
-
-  for (size_t i = 0; i < len; i += 2) {
-    size_t klen = 0;
-    RedisModuleCallReply *repk = RedisModule_CallReplyArrayElement(rep, i);
-    RedisModuleCallReply *repv = RedisModule_CallReplyArrayElement(rep, i + 1);
-
-    const char *kstr = RedisModule_CallReplyStringPtr(repk, &klen);
-    RLookupKey *rlk = RLookup_GetKeyEx(it, kstr, klen, RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC);
-    if (rlk->flags & RLOOKUP_F_SVSRC) {
-      continue;  // Can load it from the sort vector on demand.
-    }
-    RLookupCoerceType ctype = rlk->fieldtype;
-    if (1 /*options->forceString*/) {
-      ctype = RLOOKUP_C_STR;
-    }
-    RSValue *vptr = replyElemToValue(repv, ctype);
-    RLookup_WriteOwnKey(rlk, dst, vptr);
+  // A missing key is reported as empty by the module API
+  if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_HASH) {
+    RedisModule_CloseKey(key);
+    return REDISMODULE_ERR;
   }
 
-  rc = REDISMODULE_OK;
-
-done:
-  if (rep) {
-    RedisModule_FreeCallReply(rep);
+  RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
+  while (RedisModule_ScanKey(key, cursor, hashScanCallback, hl)) {
   }
-  return rc;
+  RedisModule_ScanCursorDestroy(cursor);
+  RedisModule_CloseKey(key);
+  return REDISMODULE_OK;
 }
 
-static int RLookup_HGETALL(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
+/* Read the hash with HGETALL, for servers which do not support scanning a key */
+static int loadHashCall(RLookupHashLoader *hl, RedisModuleCtx *ctx, RedisModuleString *krstr) {
   int rc = REDISMODULE_ERR;
-  RedisModuleCallReply *rep = NULL;
-  RedisModuleCtx *ctx = options->sctx->redisCtx;
-  RedisModuleString *krstr =
-      RedisModule_CreateString(ctx, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
-
-  rep = RedisModule_Call(ctx, "HGETALL", "s", krstr);
+  RedisModuleCallReply *rep = RedisModule_Call(ctx, "HGETALL", "s", krstr);
 
   if (rep == NULL || RedisModule_CallReplyType(rep) != REDISMODULE_REPLY_ARRAY) {
     goto done;
@@ -433,33 +441,53 @@ static int RLookup_HGETALL(RLookup *it, RLookupRow *dst, RLookupLoadOptions *opt
     RedisModuleCallReply *repv = RedisModule_CallReplyArrayElement(rep, i + 1);
 
     const char *kstr = RedisModule_CallReplyStringPtr(repk, &klen);
-    RLookupKey *rlk = RLookup_GetKeyEx(it, kstr, klen, RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC);
-    if (!options->noSortables && (rlk->flags & RLOOKUP_F_SVSRC)) {
-      continue;  // Can load it from the sort vector on demand.
-    }
-    RLookupCoerceType ctype = rlk->fieldtype;
-    if (options->forceString) {
-      ctype = RLOOKUP_C_STR;
+    RLookupKey *rlk = hashFieldKey(hl, kstr, klen);
+    if (!rlk) {
+      continue;
     }
+    RLookupCoerceType ctype = hl->forceString ? RLOOKUP_C_STR : rlk->fieldtype;
     RSValue *vptr = replyElemToValue(repv, ctype);
-    RLookup_WriteOwnKey(rlk, dst, vptr);
+    RLookup_WriteOwnKey(rlk, hl->dst, vptr);
   }
 
   rc = REDISMODULE_OK;
 
 done:
-  if (krstr) {
-    RedisModule_FreeString(ctx, krstr);
-  }
   if (rep) {
     RedisModule_FreeCallReply(rep);
   }
   return rc;
 }
 
+static int loadHash(RLookupHashLoader *hl, RedisModuleCtx *ctx, RedisModuleString *krstr) {
+  if (RedisModule_ScanKey) {
+    return loadHashDirect(hl, ctx, krstr);
+  }
+  return loadHashCall(hl, ctx, krstr);
+}
+
+int RLookup_GetHash(RLookup *it, RLookupRow *dst, RedisModuleCtx *ctx, RedisModuleString *key) {
+  RLookupHashLoader hl = {.it = it, .dst = dst, .noSortables = 0, .forceString = 1};
+  return loadHash(&hl, ctx, key);
+}
+
+static int RLookup_HGETALL(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
+  RedisModuleCtx *ctx = options->sctx->redisCtx;
+  RedisModuleString *krstr =
+      RedisModule_CreateString(ctx, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
+  RLookupHashLoader hl = {.it = it,
+                          .dst = dst,
+                          .noSortables = options->noSortables,
+                          .forceString = options->forceString};
+  int rc = loadHash(&hl, ctx, krstr);
+  RedisModule_FreeString(ctx, krstr);
+  return rc;
+}
+
 int RLookup_LoadDocument(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
   if (options->dmd) {
-    dst->sv = options->dmd->sortVector;
+    dst->sv = options->dmd->sortCols;
+    dst->svDocId = options->dmd->id;
   }
   if (options->mode & RLOOKUP_LOAD_ALLKEYS) {
     return RLookup_HGETALL(it, dst, options);
@@ -108,8 +108,9 @@ typedef struct RLookup {
  * data comes from.
  */
 typedef struct {
-  /** Sorting vector attached to document */
-  const RSSortingVector *sv;
+  /** Sortable columns of the document's index, read at `svDocId` */
+  const RSSortingColumns *sv;
+  t_docId svDocId;
 
   /** Module key for data that derives directly from a Redis data type */
   RedisModuleKey *rmkey;
@@ -256,11 +257,8 @@ static inline RSValue *RLookup_GetItem(const RLookupKey *key, const RLookupRow *
   }
   if (!ret) {
     if (key->flags & RLOOKUP_F_SVSRC) {
-      if (row->sv && row->sv->len > key->svidx) {
-        ret = row->sv->values[key->svidx];
-        if (ret != NULL && ret->t == RSValue_Null) {
-          ret = NULL;
-        }
+      if (row->sv) {
+        ret = RSSortingColumns_Get(row->sv, row->svDocId, key->svidx);
       }
     }
   }
@@ -1,6 +1,7 @@
 #include "rwlock.h"
 #include "rmalloc.h"
 #include "util/arr_rm_alloc.h"
+#include "config.h"
 #include <assert.h>
 
 pthread_mutex_t rwLockMutex;
@@ -12,13 +13,35 @@ typedef enum lockType { lockType_None, lockType_Read, lockType_Write } lockType;
 typedef struct rwlockThreadLocal {
   size_t locked;
   lockType type;
+  // the read lock depth given up for writing, restored once the write lock is released
+  size_t readDepth;
 } rwlockThreadLocal;
 
 rwlockThreadLocal** rwlocks;
 
+static uint64_t writeCount = 0;
+
+typedef struct {
+  void (*freeFn)(void *);
+  void *p;
+} deferredFree;
+
+// Freed the next time the lock is taken for writing. Guarded by rwLockMutex
+static deferredFree *deferredFrees = NULL;
+
 int RediSearch_LockInit(RedisModuleCtx* ctx) {
   rwlocks = array_new(rwlockThreadLocal*, 10);
+  deferredFrees = array_new(deferredFree, 8);
   pthread_mutex_init(&rwLockMutex, NULL);
+#ifdef __GLIBC__
+  // Queries in concurrent read mode hold the lock for reading most of the time, so writers must
+  // not wait for all of them to finish at once
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init(&attr);
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&RWLock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+#endif
   int err = pthread_key_create(&_lockKey, NULL);
   if (err) {
     if (ctx) {
@@ -35,6 +58,7 @@ static rwlockThreadLocal* RediSearch_GetLockThreadData() {
     rwData = rm_malloc(sizeof(*rwData));
     rwData->locked = 0;
     rwData->type = lockType_None;
+    rwData->readDepth = 0;
     pthread_setspecific(_lockKey, rwData);
     pthread_mutex_lock(&rwLockMutex);
     rwlocks = array_append(rwlocks, rwData);
@@ -45,21 +69,43 @@ static rwlockThreadLocal* RediSearch_GetLockThreadData() {
 
 void RediSearch_LockRead() {
   rwlockThreadLocal* rwData = RediSearch_GetLockThreadData();
-  assert(rwData->type != lockType_Write);
+  // a writer may read as well, it keeps the lock for writing
   if (rwData->locked == 0) {
     pthread_rwlock_rdlock(&RWLock);
     rwData->type = lockType_Read;
   }
-  assert(rwData->type == lockType_Read);
   ++rwData->locked;
 }
 
+static void RediSearch_RunDeferredFrees() {
+  pthread_mutex_lock(&rwLockMutex);
+  deferredFree *frees = deferredFrees;
+  deferredFrees = array_new(deferredFree, 8);
+  pthread_mutex_unlock(&rwLockMutex);
+
+  for (size_t i = 0; i < array_len(frees); ++i) {
+    frees[i].freeFn(frees[i].p);
+  }
+  array_free(frees);
+}
+
 void RediSearch_LockWrite() {
   rwlockThreadLocal* rwData = RediSearch_GetLockThreadData();
-  assert(rwData->type != lockType_Read);
+  if (rwData->type == lockType_Read) {
+    // A reader modifying the indexes, e.g. a query whose document lookup expired a key. The read
+    // lock cannot be upgraded in place, so it is released until the write lock is
+    pthread_rwlock_unlock(&RWLock);
+    rwData->readDepth = rwData->locked;
+    rwData->locked = 0;
+    rwData->type = lockType_None;
+  }
   if (rwData->locked == 0) {
     pthread_rwlock_wrlock(&RWLock);
     rwData->type = lockType_Write;
+    ++writeCount;
+    if (array_len(deferredFrees)) {
+      RediSearch_RunDeferredFrees();
+    }
   }
   assert(rwData->type == lockType_Write);
   ++rwData->locked;
@@ -71,6 +117,12 @@ void RediSearch_LockRelease() {
   if ((--rwData->locked) == 0) {
     pthread_rwlock_unlock(&RWLock);
     rwData->type = lockType_None;
+    if (rwData->readDepth) {
+      pthread_rwlock_rdlock(&RWLock);
+      rwData->type = lockType_Read;
+      rwData->locked = rwData->readDepth;
+      rwData->readDepth = 0;
+    }
   }
 }
 
@@ -80,5 +132,26 @@ void RediSearch_LockDestory() {
     rm_free(rwlocks[i]);
   }
   array_free(rwlocks);
+  for (size_t i = 0; i < array_len(deferredFrees); ++i) {
+    deferredFrees[i].freeFn(deferredFrees[i].p);
+  }
+  array_free(deferredFrees);
   pthread_mutex_unlock(&rwLockMutex);
 }
+
+uint64_t RediSearch_LockWriteCount() {
+  return writeCount;
+}
+
+void RediSearch_LockDeferFree(void (*freeFn)(void *), void *p) {
+  if (RSGlobalConfig.concurrentReadMode) {
+    rwlockThreadLocal* rwData = RediSearch_GetLockThreadData();
+    if (rwData->type == lockType_Read) {
+      pthread_mutex_lock(&rwLockMutex);
+      deferredFrees = array_append(deferredFrees, ((deferredFree){.freeFn = freeFn, .p = p}));
+      pthread_mutex_unlock(&rwLockMutex);
+      return;
+    }
+  }
+  freeFn(p);
+}
@@ -2,6 +2,7 @@
 #define SRC_RWLOCK_H_
 
 #include <pthread.h>
+#include <stdint.h>
 #include "redismodule.h"
 
 extern pthread_rwlock_t RWLock;
@@ -15,6 +16,15 @@ void RediSearch_LockRelease();
 
 void RediSearch_LockDestory();
 
+/* The number of times the lock was taken for writing. It does not change while the lock is held
+ * for reading, so a reader can tell if the indexes were modified since it last held the lock */
+uint64_t RediSearch_LockWriteCount();
+
+/* Free `p` with `freeFn`. If the calling thread holds the lock for reading in concurrent read
+ * mode, other readers may still use `p`, and it is freed the next time the lock is taken for
+ * writing instead */
+void RediSearch_LockDeferFree(void (*freeFn)(void *), void *p);
+
 #define RWLOCK_ACQUIRE_READ() RediSearch_LockRead()
 #define RWLOCK_ACQUIRE_WRITE() RediSearch_LockWrite()
 #define RWLOCK_RELEASE() RediSearch_LockRelease()
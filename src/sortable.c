@@ -7,6 +7,7 @@
 #include "rmalloc.h"
 #include "sortable.h"
 #include "buffer.h"
+#include "util/arr.h"
 
 /* Create a sorting vector of a given length for a document */
 RSSortingVector *NewSortingVector(int len) {
@@ -62,6 +63,21 @@ char *normalizeStr(const char *str) {
   return lower_buffer;
 }
 
+/* Create the value stored for a sortable of the given type, or NULL for nil */
+static RSValue *newSortableValue(const void *p, int type) {
+  switch (type) {
+    case RS_SORTABLE_NUM:
+      return RS_NumVal(*(double *)p);
+    case RS_SORTABLE_STR: {
+      char *ns = normalizeStr((const char *)p);
+      return RS_StringValT(ns, strlen(ns), RSString_RMAlloc);
+    }
+    case RS_SORTABLE_NIL:
+    default:
+      return NULL;
+  }
+}
+
 /* Put a value in the sorting vector */
 void RSSortingVector_Put(RSSortingVector *tbl, int idx, const void *p, int type) {
   if (idx > RS_SORTABLES_MAX) {
@@ -71,21 +87,8 @@ void RSSortingVector_Put(RSSortingVector *tbl, int idx, const void *p, int type)
     RSValue_Decref(tbl->values[idx]);
     tbl->values[idx] = NULL;
   }
-  switch (type) {
-    case RS_SORTABLE_NUM:
-      tbl->values[idx] = RS_NumVal(*(double *)p);
-
-      break;
-    case RS_SORTABLE_STR: {
-      char *ns = normalizeStr((const char *)p);
-      tbl->values[idx] = RS_StringValT(ns, strlen(ns), RSString_RMAlloc);
-      break;
-    }
-    case RS_SORTABLE_NIL:
-    default:
-      tbl->values[idx] = RS_NullVal();
-      break;
-  }
+  RSValue *v = newSortableValue(p, type);
+  tbl->values[idx] = v ? v : RS_NullVal();
 }
 
 /* Free a sorting vector */
@@ -96,88 +99,382 @@ void SortingVector_Free(RSSortingVector *v) {
   rm_free(v);
 }
 
-/* Save a sorting vector to rdb. This is called from the doc table */
-void SortingVector_RdbSave(RedisModuleIO *rdb, RSSortingVector *v) {
-  if (!v) {
-    RedisModule_SaveUnsigned(rdb, 0);
+static uint64_t sortingStringsHash(const void *key) {
+  return dictGenHashFunction(key, strlen((const char *)key));
+}
+
+static int sortingStringsCompare(void *privdata, const void *key1, const void *key2) {
+  return strcmp((const char *)key1, (const char *)key2) == 0;
+}
+
+// The keys of a column's string dictionary point at the interned values, so they are not copied
+static dictType dictTypeSortingStrings = {
+    .hashFunction = sortingStringsHash,
+    .keyCompare = sortingStringsCompare,
+};
+
+#define CHUNK_OFFSET(docId) ((docId) & (RS_SORTING_CHUNK_SIZE - 1))
+
+RSSortingColumns *NewSortingColumns(void) {
+  RSSortingColumns *cols = rm_calloc(1, sizeof(*cols));
+  cols->refcount = 1;
+  return cols;
+}
+
+static size_t chunkSize(const RSSortingColumn *col) {
+  size_t cell = col->type == RSValue_Number ? sizeof(RSValue) : sizeof(uint32_t);
+  return sizeof(RSSortingChunk) + RS_SORTING_CHUNK_SIZE * cell;
+}
+
+static RSSortingColumn *getColumn(RSSortingColumns *cols, size_t idx) {
+  if (idx >= cols->len) {
+    cols->fields = rm_realloc(cols->fields, (idx + 1) * sizeof(*cols->fields));
+    memset(cols->fields + cols->len, 0, (idx + 1 - cols->len) * sizeof(*cols->fields));
+    cols->memsize += (idx + 1 - cols->len) * sizeof(*cols->fields);
+    cols->len = idx + 1;
+  }
+  return cols->fields + idx;
+}
+
+static RSSortingChunk *getChunk(RSSortingColumns *cols, RSSortingColumn *col, t_docId docId) {
+  size_t ci = docId >> RS_SORTING_CHUNK_BITS;
+  if (ci >= col->nchunks) {
+    size_t n = MAX(ci + 1, col->nchunks * 2);
+    col->chunks = rm_realloc(col->chunks, n * sizeof(*col->chunks));
+    memset(col->chunks + col->nchunks, 0, (n - col->nchunks) * sizeof(*col->chunks));
+    cols->memsize += (n - col->nchunks) * sizeof(*col->chunks);
+    col->nchunks = n;
+  }
+  if (!col->chunks[ci]) {
+    col->chunks[ci] = rm_calloc(1, chunkSize(col));
+    cols->memsize += chunkSize(col);
+  }
+  return col->chunks[ci];
+}
+
+static uint32_t cellRefcount(const RSValue *cell) {
+  RSValue v;
+  v.flagsWord = __atomic_load_n(&cell->flagsWord, __ATOMIC_ACQUIRE);
+  return v.refcount;
+}
+
+static int isChunkReferenced(const RSSortingChunk *chunk) {
+  const RSValue *cells = (const RSValue *)chunk->cells;
+  for (size_t i = 0; i < RS_SORTING_CHUNK_SIZE; i++) {
+    if (cells[i].t == RSValue_Number && cellRefcount(cells + i) > 1) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Free the retired chunks of a numeric column whose values are not referenced anymore */
+static void reclaimRetired(RSSortingColumns *cols, RSSortingColumn *col) {
+  for (size_t i = 0; i < array_len(col->retired);) {
+    if (isChunkReferenced(col->retired[i])) {
+      i++;
+      continue;
+    }
+    rm_free(col->retired[i]);
+    cols->memsize -= chunkSize(col);
+    array_del_fast(col->retired, i);
+  }
+}
+
+/* Get the cell of a document in a numeric column for changing it. If the cell's value is referenced,
+ * the chunk is copied and the old one retired, so the references keep the value they took */
+static RSValue *writableCell(RSSortingColumns *cols, RSSortingColumn *col, t_docId docId) {
+  size_t ci = docId >> RS_SORTING_CHUNK_BITS;
+  RSValue *cell = (RSValue *)col->chunks[ci]->cells + CHUNK_OFFSET(docId);
+  if (cell->t != RSValue_Number || cellRefcount(cell) <= 1) {
+    return cell;
+  }
+
+  if (col->retired) {
+    reclaimRetired(cols, col);
+  } else {
+    col->retired = array_new(RSSortingChunk *, 1);
+  }
+  RSSortingChunk *copy = rm_malloc(chunkSize(col));
+  memcpy(copy, col->chunks[ci], chunkSize(col));
+  RSValue *cells = (RSValue *)copy->cells;
+  for (size_t i = 0; i < RS_SORTING_CHUNK_SIZE; i++) {
+    if (cells[i].t == RSValue_Number) {
+      cells[i].refcount = 1;
+    }
+  }
+  col->retired = array_append(col->retired, col->chunks[ci]);
+  col->chunks[ci] = copy;
+  cols->memsize += chunkSize(col);
+  return cells + CHUNK_OFFSET(docId);
+}
+
+static void releaseChunkValue(RSSortingColumns *cols, RSSortingColumn *col, size_t ci) {
+  if (!--col->chunks[ci]->used) {
+    rm_free(col->chunks[ci]);
+    col->chunks[ci] = NULL;
+    cols->memsize -= chunkSize(col);
+  }
+}
+
+/* Get the code of a string in the column's dictionary, adding the string if needed */
+static uint32_t internString(RSSortingColumns *cols, RSSortingColumn *col, const char *str,
+                             size_t len) {
+  if (!col->codes) {
+    col->codes = dictCreate(&dictTypeSortingStrings, NULL);
+    col->strs = array_new(RSValue *, 8);
+    col->strRefs = array_new(uint32_t, 8);
+    col->freeCodes = array_new(uint32_t, 8);
+    // code 0 stands for no value
+    col->strs = array_append(col->strs, NULL);
+    col->strRefs = array_append(col->strRefs, 0);
+  }
+
+  dictEntry *de = dictFind(col->codes, str);
+  if (de) {
+    uint32_t code = dictGetUnsignedIntegerVal(de);
+    ++col->strRefs[code];
+    return code;
+  }
+
+  RSValue *v = RS_StringValT(rm_strndup(str, len), len, RSString_RMAlloc);
+  uint32_t code;
+  if (array_len(col->freeCodes)) {
+    code = array_pop(col->freeCodes);
+    col->strs[code] = v;
+    col->strRefs[code] = 1;
+  } else {
+    code = array_len(col->strs);
+    col->strs = array_append(col->strs, v);
+    col->strRefs = array_append(col->strRefs, 1);
+  }
+  de = dictAddRaw(col->codes, v->strval.str, NULL);
+  dictSetUnsignedIntegerVal(de, code);
+  cols->memsize += sizeof(RSValue) + len + 1;
+  return code;
+}
+
+static void releaseString(RSSortingColumns *cols, RSSortingColumn *col, uint32_t code) {
+  if (--col->strRefs[code]) {
+    return;
+  }
+  RSValue *v = col->strs[code];
+  dictDelete(col->codes, v->strval.str);
+  cols->memsize -= sizeof(RSValue) + v->strval.len + 1;
+  // results being processed may still hold a reference to the value
+  RSValue_Decref(v);
+  col->strs[code] = NULL;
+  col->freeCodes = array_append(col->freeCodes, code);
+}
+
+static void releaseValue(RSSortingColumns *cols, RSSortingColumn *col, t_docId docId) {
+  size_t ci = docId >> RS_SORTING_CHUNK_BITS;
+  if (ci >= col->nchunks || !col->chunks[ci]) {
+    return;
+  }
+  if (col->type == RSValue_Number) {
+    RSValue *cell = (RSValue *)col->chunks[ci]->cells + CHUNK_OFFSET(docId);
+    if (cell->t != RSValue_Number) {
+      return;
+    }
+    writableCell(cols, col, docId)->t = RSValue_Undef;
+  } else {
+    uint32_t *cell = (uint32_t *)col->chunks[ci]->cells + CHUNK_OFFSET(docId);
+    if (!*cell) {
+      return;
+    }
+    releaseString(cols, col, *cell);
+    *cell = 0;
+  }
+  releaseChunkValue(cols, col, ci);
+}
+
+static void putNumber(RSSortingColumns *cols, RSSortingColumn *col, t_docId docId, double num) {
+  getChunk(cols, col, docId);
+  RSValue *cell = writableCell(cols, col, docId);
+  if (cell->t != RSValue_Number) {
+    *cell = (RSValue)RSVALUE_STATICALLOC_INIT(RSValue_Number);
+    // the cell is owned by the column, references to it never free it
+    cell->refcount = 1;
+    ++col->chunks[docId >> RS_SORTING_CHUNK_BITS]->used;
+    ++col->numValues;
+  }
+  cell->numval = num;
+}
+
+static void putString(RSSortingColumns *cols, RSSortingColumn *col, t_docId docId, const char *str,
+                      size_t len) {
+  RSSortingChunk *chunk = getChunk(cols, col, docId);
+  uint32_t *cell = (uint32_t *)chunk->cells + CHUNK_OFFSET(docId);
+  uint32_t code = internString(cols, col, str, len);
+  if (*cell) {
+    releaseString(cols, col, *cell);
+  } else {
+    ++chunk->used;
+    ++col->numValues;
+  }
+  *cell = code;
+}
+
+void RSSortingColumns_Put(RSSortingColumns *cols, t_docId docId, size_t idx, RSValue *v) {
+  if (idx >= RS_SORTABLES_MAX) {
+    return;
+  }
+  RSSortingColumn *col = getColumn(cols, idx);
+  v = v ? RSValue_Dereference(v) : NULL;
+  RSValueType type = RSValue_IsString(v) ? RSValue_String : v ? v->t : RSValue_Null;
+  if (col->type == RSValue_Undef && (type == RSValue_Number || type == RSValue_String)) {
+    col->type = type;
+  }
+  if (type != col->type) {
+    // nil, or a value which does not match the column: the document has no value
+    if (col->numValues && RSSortingColumns_Get(cols, docId, idx)) {
+      --col->numValues;
+    }
+    releaseValue(cols, col, docId);
+    return;
+  }
+
+  if (type == RSValue_Number) {
+    putNumber(cols, col, docId, v->numval);
+  } else {
+    size_t len;
+    const char *str = RSValue_StringPtrLen(v, &len);
+    putString(cols, col, docId, str, len);
+  }
+}
+
+void RSSortingColumns_PutRaw(RSSortingColumns *cols, t_docId docId, size_t idx, const void *p,
+                             int type) {
+  RSValue *v = newSortableValue(p, type);
+  RSSortingColumns_Put(cols, docId, idx, v);
+  if (v) {
+    RSValue_Decref(v);
+  }
+}
+
+void RSSortingColumns_PutVector(RSSortingColumns *cols, t_docId docId, const RSSortingVector *v) {
+  if (!v->len) {
+    return;
+  }
+  // make sure every field of the vector has a column, even if all its values are nil
+  getColumn(cols, v->len - 1);
+  for (size_t i = 0; i < v->len; i++) {
+    RSSortingColumns_Put(cols, docId, i, v->values[i]);
+  }
+}
+
+void RSSortingColumns_MarkDeleted(RSSortingColumns *cols, t_docId docId) {
+  for (size_t i = 0; i < cols->len; i++) {
+    RSSortingColumn *col = cols->fields + i;
+    if (col->numValues && RSSortingColumns_Get(cols, docId, i)) {
+      --col->numValues;
+    }
+  }
+}
+
+void RSSortingColumns_Clear(RSSortingColumns *cols, t_docId docId) {
+  for (size_t i = 0; i < cols->len; i++) {
+    RSSortingColumn *col = cols->fields + i;
+    releaseValue(cols, col, docId);
+    if (col->retired && array_len(col->retired)) {
+      reclaimRetired(cols, col);
+    }
+  }
+}
+
+void SortingColumns_Decref(RSSortingColumns *cols) {
+  if (--cols->refcount) {
     return;
   }
-  RedisModule_SaveUnsigned(rdb, v->len);
-  for (int i = 0; i < v->len; i++) {
-    RSValue *val = v->values[i];
+  for (size_t i = 0; i < cols->len; i++) {
+    RSSortingColumn *col = cols->fields + i;
+    for (size_t ci = 0; ci < col->nchunks; ci++) {
+      rm_free(col->chunks[ci]);
+    }
+    rm_free(col->chunks);
+    if (col->retired) {
+      for (size_t ri = 0; ri < array_len(col->retired); ri++) {
+        rm_free(col->retired[ri]);
+      }
+      array_free(col->retired);
+    }
+    if (col->codes) {
+      dictRelease(col->codes);
+      for (size_t code = 1; code < array_len(col->strs); code++) {
+        if (col->strs[code]) {
+          RSValue_Decref(col->strs[code]);
+        }
+      }
+      array_free(col->strs);
+      array_free(col->strRefs);
+      array_free(col->freeCodes);
+    }
+  }
+  rm_free(cols->fields);
+  rm_free(cols);
+}
+
+/* Save a document's values to rdb. This is called from the doc table */
+void SortingColumns_RdbSave(RedisModuleIO *rdb, const RSSortingColumns *cols, t_docId docId) {
+  RedisModule_SaveUnsigned(rdb, cols->len);
+  for (size_t i = 0; i < cols->len; i++) {
+    RSValue *val = RSSortingColumns_Get(cols, docId, i);
     if (!val) {
       RedisModule_SaveUnsigned(rdb, RSValue_Null);
       continue;
     }
     RedisModule_SaveUnsigned(rdb, val->t);
-    switch (val->t) {
-      case RSValue_String:
-        // save string - one extra byte for null terminator
-        RedisModule_SaveStringBuffer(rdb, val->strval.str, val->strval.len + 1);
-        break;
-
-      case RSValue_Number:
-        // save numeric value
-        RedisModule_SaveDouble(rdb, val->numval);
-        break;
-      // for nil we write nothing
-      default:
-        break;
+    if (val->t == RSValue_String) {
+      // save string - one extra byte for null terminator
+      RedisModule_SaveStringBuffer(rdb, val->strval.str, val->strval.len + 1);
+    } else {
+      RedisModule_SaveDouble(rdb, val->numval);
     }
   }
 }
 
-/* Load a sorting vector from RDB */
-RSSortingVector *SortingVector_RdbLoad(RedisModuleIO *rdb, int encver) {
-
+/* Load a document's values from rdb */
+int SortingColumns_RdbLoad(RedisModuleIO *rdb, RSSortingColumns *cols, t_docId docId, int encver) {
   int len = (int)RedisModule_LoadUnsigned(rdb);
   if (len > RS_SORTABLES_MAX || len <= 0) {
-    return NULL;
+    return 0;
   }
-  RSSortingVector *vec = NewSortingVector(len);
+  getColumn(cols, len - 1);
   for (int i = 0; i < len; i++) {
     RSValueType t = RedisModule_LoadUnsigned(rdb);
+    RSSortingColumn *col = cols->fields + i;
+    if (col->type == RSValue_Undef && (t == RSValue_Number || t == RSValue_String)) {
+      col->type = t;
+    }
 
     switch (t) {
       case RSValue_String: {
-        size_t len;
+        size_t slen;
         // strings include an extra character for null terminator. we set it to zero just in case
-        char *s = RedisModule_LoadStringBuffer(rdb, &len);
-        s[len - 1] = '\0';
-        vec->values[i] = RS_StringValT(rm_strdup(s), len - 1, RSString_RMAlloc);
+        char *s = RedisModule_LoadStringBuffer(rdb, &slen);
+        s[slen - 1] = '\0';
+        if (col->type == RSValue_String) {
+          putString(cols, col, docId, s, slen - 1);
+        }
         RedisModule_Free(s);
         break;
       }
-      case RS_SORTABLE_NUM:
+      case RS_SORTABLE_NUM: {
         // load numeric value
-        vec->values[i] = RS_NumVal(RedisModule_LoadDouble(rdb));
+        double num = RedisModule_LoadDouble(rdb);
+        if (col->type == RSValue_Number) {
+          putNumber(cols, col, docId, num);
+        }
         break;
+      }
       // for nil we read nothing
       case RS_SORTABLE_NIL:
       default:
-        vec->values[i] = RS_NullVal();
         break;
     }
   }
-  return vec;
-}
-
-size_t RSSortingVector_GetMemorySize(RSSortingVector *v) {
-  if (!v) return 0;
-
-  size_t sum = v->len * sizeof(RSValue *);
-  for (int i = 0; i < v->len; i++) {
-    if (!v->values[i]) continue;
-    sum += sizeof(RSValue);
-
-    RSValue *val = RSValue_Dereference(v->values[i]);
-    if (val && RSValue_IsString(val)) {
-      size_t sz;
-      RSValue_StringPtrLen(val, &sz);
-      sum += sz;
-    }
-  }
-  return sum;
+  return 1;
 }
 
 /* Create a new sorting table of a given length */
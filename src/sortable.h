@@ -2,6 +2,7 @@
 #define __RS_SORTABLE_H__
 #include "redismodule.h"
 #include "value.h"
+#include "util/dict.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,52 @@ typedef struct RSSortingVector {
 
 #pragma pack()
 
+/* Documents per chunk of a sorting column. Chunks are allocated when their first value is set and
+ * never move, so the values handed out by a column remain at the same address. A numeric chunk
+ * whose values are referenced is copied before one of them is changed or cleared, and the old
+ * chunk is kept aside until the references are released */
+#define RS_SORTING_CHUNK_BITS 10
+#define RS_SORTING_CHUNK_SIZE (1 << RS_SORTING_CHUNK_BITS)
+
+typedef struct {
+  // number of values set in the chunk. The chunk is freed once it drops to zero
+  size_t used;
+  // RS_SORTING_CHUNK_SIZE cells: static RSValues for numeric columns, string codes for string ones
+  char cells[];
+} RSSortingChunk;
+
+/* A single sortable field of all the documents in an index, indexed by document id */
+typedef struct {
+  // RSValue_Number or RSValue_String, decided by the first value set in the column
+  RSValueType type;
+  RSSortingChunk **chunks;
+  size_t nchunks;
+  // numeric chunks replaced while some of their values were referenced, freed once they are not
+  RSSortingChunk **retired;
+  // number of live documents with a value in the column. Deleted documents which are not cleared
+  // yet may make it fall short, but it never exceeds it
+  size_t numValues;
+
+  // dictionary of the distinct strings of a string column, with the number of documents using each
+  // of them. Code 0 means no value
+  RSValue **strs;
+  uint32_t *strRefs;
+  uint32_t *freeCodes;
+  dict *codes;
+} RSSortingColumn;
+
+/* RSSortingColumns stores the sortable values of all the documents in an index, one column per
+ * sortable field. Numbers are stored inline in a dense array and strings are dictionary encoded, so
+ * reading the sort key of a document does not chase a per-document vector. The returned values are
+ * owned by the columns and valid as long as the document is referenced. Every document with
+ * sortable values holds a reference to the columns */
+typedef struct RSSortingColumns {
+  RSSortingColumn *fields;
+  uint16_t len;
+  uint32_t refcount;
+  size_t memsize;
+} RSSortingColumns;
+
 /* RSSortingTable defines the length and names of the fields in a sorting vector. It is saved as
  * part of the spec */
 typedef struct {
@@ -81,19 +128,72 @@ static inline RSValue *RSSortingVector_Get(RSSortingVector *v, size_t index) {
   return v->values[index];
 }
 
-size_t RSSortingVector_GetMemorySize(RSSortingVector *v);
-
 /* Create a sorting vector of a given length for a document */
 RSSortingVector *NewSortingVector(int len);
 
 /* Free a sorting vector */
 void SortingVector_Free(RSSortingVector *v);
 
-/* Save a document's sorting vector into an rdb dump */
-void SortingVector_RdbSave(RedisModuleIO *rdb, RSSortingVector *v);
+/* Create empty sorting columns, referenced once */
+RSSortingColumns *NewSortingColumns(void);
+
+static inline RSSortingColumns *SortingColumns_Incref(RSSortingColumns *cols) {
+  ++cols->refcount;
+  return cols;
+}
+
+/* Release a reference to the columns, freeing them with the last one */
+void SortingColumns_Decref(RSSortingColumns *cols);
+
+/* Set a document's value in a column, replacing its previous value. A NULL or nil value clears it */
+void RSSortingColumns_Put(RSSortingColumns *cols, t_docId docId, size_t idx, RSValue *v);
+
+/* Like RSSortingVector_Put, but for a document's value in the columns */
+void RSSortingColumns_PutRaw(RSSortingColumns *cols, t_docId docId, size_t idx, const void *p,
+                             int type);
+
+/* Set all the values of a document from its sorting vector */
+void RSSortingColumns_PutVector(RSSortingColumns *cols, t_docId docId, const RSSortingVector *v);
+
+/* Stop counting the values of a deleted document. They remain readable until the document is
+ * cleared */
+void RSSortingColumns_MarkDeleted(RSSortingColumns *cols, t_docId docId);
+
+/* Clear all the values of a document */
+void RSSortingColumns_Clear(RSSortingColumns *cols, t_docId docId);
+
+/* Returns the value of a document in a column, or NULL if it has none. Does not increment the
+ * refcount */
+static inline RSValue *RSSortingColumns_Get(const RSSortingColumns *cols, t_docId docId,
+                                            size_t idx) {
+  if (idx >= cols->len) {
+    return NULL;
+  }
+  const RSSortingColumn *col = cols->fields + idx;
+  size_t ci = docId >> RS_SORTING_CHUNK_BITS;
+  if (ci >= col->nchunks || !col->chunks[ci]) {
+    return NULL;
+  }
+  size_t off = docId & (RS_SORTING_CHUNK_SIZE - 1);
+  if (col->type == RSValue_Number) {
+    RSValue *v = (RSValue *)col->chunks[ci]->cells + off;
+    return v->t == RSValue_Number ? v : NULL;
+  }
+  uint32_t code = ((uint32_t *)col->chunks[ci]->cells)[off];
+  return code ? col->strs[code] : NULL;
+}
+
+/* Returns the number of live documents with a value in a column. It is never more than the actual
+ * number of documents, but may be less */
+static inline size_t RSSortingColumns_NumValues(const RSSortingColumns *cols, size_t idx) {
+  return idx < cols->len ? cols->fields[idx].numValues : 0;
+}
+
+/* Save a document's values in the format of a sorting vector */
+void SortingColumns_RdbSave(RedisModuleIO *rdb, const RSSortingColumns *cols, t_docId docId);
 
-/* Load a sorting vector from RDB */
-RSSortingVector *SortingVector_RdbLoad(RedisModuleIO *rdb, int encver);
+/* Load a document's values saved as a sorting vector. Returns 0 if the document had no values */
+int SortingColumns_RdbLoad(RedisModuleIO *rdb, RSSortingColumns *cols, t_docId docId, int encver);
 
 #ifdef __cplusplus
 }
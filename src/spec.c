@@ -13,8 +13,11 @@
 #include "config.h"
 #include "cursor.h"
 #include "tag_index.h"
+#include "numeric_index.h"
 #include "redis_index.h"
 #include "indexer.h"
+#include "concurrent_ctx.h"
+#include "async_index.h"
 #include "alias.h"
 #include "module.h"
 #include "aggregate/expr/expression.h"
@@ -626,7 +629,8 @@ IndexSpecCache *IndexSpec_GetSpecCache(const IndexSpec *spec) {
     ((IndexSpec *)spec)->spcache = IndexSpec_BuildSpecCache(spec);
   }
 
-  spec->spcache->refcount++;
+  // queries may release the cache while running without the GIL
+  __sync_fetch_and_add(&spec->spcache->refcount, 1);
   return spec->spcache;
 }
 
@@ -643,7 +647,7 @@ IndexSpecCache *IndexSpec_BuildSpecCache(const IndexSpec *spec) {
 }
 
 void IndexSpecCache_Decref(IndexSpecCache *c) {
-  if (--c->refcount) {
+  if (__sync_sub_and_fetch(&c->refcount, 1)) {
     return;
   }
   for (size_t ii = 0; ii < c->nfields; ++ii) {
@@ -709,7 +713,8 @@ char *IndexSpec_GetRandomTerm(IndexSpec *sp, size_t sampleSize) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-void IndexSpec_FreeInternals(IndexSpec *spec) {
+/* Remove the spec from everywhere it can be found, so that no new command or query reaches it */
+static void IndexSpec_Unlink(IndexSpec *spec) {
   if (dictFetchValue(specDict_g, spec->name) == spec) {
     dictDelete(specDict_g, spec->name);
   }
@@ -720,6 +725,27 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
     spec->isTimerSet = false;
   }
 
+  if (spec->asyncQueue) {
+    AsyncIndexQueue_Cancel(spec->asyncQueue);
+    spec->asyncQueue = NULL;
+  }
+
+  if (spec->uniqueId) {
+    // If uniqueid is 0, it means the index was not initialized
+    // and is being freed now during an error.
+    Cursors_PurgeWithName(&RSCursors, spec->name);
+    CursorList_RemoveSpec(&RSCursors, spec->name);
+    IndexSpec_ClearAliases(spec);
+  }
+
+  if (spec->scanner) {
+    spec->scanner->cancelled = true;
+    spec->scanner->spec = NULL;
+  }
+  spec->isDropped = true;
+}
+
+static void IndexSpec_FreeUnlinked(IndexSpec *spec) {
   if (spec->indexer) {
     Indexer_Free(spec->indexer);
   }
@@ -732,13 +758,6 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
   }
   DocTable_Free(&spec->docs);
 
-  if (spec->uniqueId) {
-    // If uniqueid is 0, it means the index was not initialized
-    // and is being freed now during an error.
-    Cursors_PurgeWithName(&RSCursors, spec->name);
-    CursorList_RemoveSpec(&RSCursors, spec->name);
-  }
-
   if (spec->rule) {
     SchemaRule_Free(spec->rule);
     spec->rule = NULL;
@@ -779,21 +798,22 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
     }
     rm_free(spec->fields);
   }
-  if (spec->uniqueId) {
-    // If uniqueid is 0, it means the index was not initialized
-    // and is being freed now during an error.
-    IndexSpec_ClearAliases(spec);
-  }
 
   if (spec->keysDict) {
     dictRelease(spec->keysDict);
   }
+  rm_free(spec);
+}
 
-  if (spec->scanner) {
-    spec->scanner->cancelled = true;
-    spec->scanner->spec = NULL;
+void IndexSpec_FreeInternals(IndexSpec *spec) {
+  if (spec->isDropped) {
+    return;
+  }
+  IndexSpec_Unlink(spec);
+  // Queries running without the GIL may still use the index, the last of them frees it
+  if (__atomic_sub_fetch(&spec->activeQueries, 1, __ATOMIC_SEQ_CST) == -1) {
+    IndexSpec_FreeUnlinked(spec);
   }
-  rm_free(spec);
 }
 
 //---------------------------------------------------------------------------------------------
@@ -805,12 +825,12 @@ static void IndexSpec_FreeTask(IndexSpec *spec) {
 
   RedisModuleCtx *threadCtx = RedisModule_GetThreadSafeContext(NULL);
   RedisModule_AutoMemory(threadCtx);
-  RedisModule_ThreadSafeContextLock(threadCtx);
+  ConcurrentSearch_ThreadSafeContextLock(threadCtx);
 
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(threadCtx, spec);
   Redis_DropIndex(&sctx, spec->cascadeDelete);
 
-  RedisModule_ThreadSafeContextUnlock(threadCtx);
+  ConcurrentSearch_ThreadSafeContextUnlock(threadCtx);
   RedisModule_FreeThreadSafeContext(threadCtx);
 }
 
@@ -822,6 +842,29 @@ void IndexSpec_LegacyFree(void *spec) {
   // index pointer in the legacySpecDict so we will free it when needed
 }
 
+static void IndexSpec_FreeDroppedTask(IndexSpec *spec) {
+  RedisModuleCtx *threadCtx = RedisModule_GetThreadSafeContext(NULL);
+  ConcurrentSearch_ThreadSafeContextLock(threadCtx);
+  IndexSpec_FreeUnlinked(spec);
+  ConcurrentSearch_ThreadSafeContextUnlock(threadCtx);
+  RedisModule_FreeThreadSafeContext(threadCtx);
+}
+
+void IndexSpec_IncrActiveQueries(IndexSpec *spec) {
+  __atomic_add_fetch(&spec->activeQueries, 1, __ATOMIC_SEQ_CST);
+}
+
+void IndexSpec_DecrActiveQueries(IndexSpec *spec) {
+  if (__atomic_sub_fetch(&spec->activeQueries, 1, __ATOMIC_SEQ_CST) == -1) {
+    // The index was dropped while we were using it. The caller may still hold the index lock for
+    // reading, so it is freed in the background
+    if (!cleanPool) {
+      cleanPool = thpool_init(1);
+    }
+    thpool_add_work(cleanPool, (thpool_proc)IndexSpec_FreeDroppedTask, spec);
+  }
+}
+
 void IndexSpec_Free(IndexSpec *spec) {
   if (spec->flags & Index_Temporary) {
     if (!cleanPool) {
@@ -1195,6 +1238,199 @@ static void IndexStats_RdbSave(RedisModuleIO *rdb, IndexStats *stats) {
   RedisModule_SaveUnsigned(rdb, stats->termsSize);
 }
 
+typedef enum {
+  IndexContent_Term = 1,
+  IndexContent_Numeric = 2,
+  IndexContent_Tag = 3,
+} IndexContentType;
+
+static int keysDictEntryType(const KeysDictValue *kdv) {
+  if (kdv->dtor == InvertedIndex_Free) {
+    return IndexContent_Term;
+  } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+    return IndexContent_Numeric;
+  } else if (kdv->dtor == TagIndex_Free) {
+    return IndexContent_Tag;
+  }
+  return 0;
+}
+
+static RedisModuleType *IndexContentPartType;
+
+// The contents version written by IndexSpec_RdbSaveContent, changed by FT.DEBUG to test loading
+// contents of an unknown version
+static uint64_t indexContentEncver = INDEX_CONTENT_ENCVER;
+
+void IndexSpec_SetContentEncver(uint64_t encver) {
+  indexContentEncver = encver;
+}
+
+/* A part of the index contents: the header (stats, doc table and terms trie) when key is NULL,
+ * otherwise one entry of the spec's keys dictionary */
+typedef struct {
+  IndexSpec *sp;
+  RedisModuleString *key;
+  KeysDictValue *kdv;
+} IndexContentPart;
+
+// The spec the parts are loaded into. Only set while IndexSpec_RdbLoadContent runs
+static IndexSpec *contentLoadSpec = NULL;
+
+static void IndexContentPart_RdbSave(RedisModuleIO *rdb, void *value) {
+  IndexContentPart *part = value;
+  IndexSpec *sp = part->sp;
+  if (!part->key) {
+    IndexStats_RdbSave(rdb, &sp->stats);
+    DocTable_RdbSave(&sp->docs, rdb);
+    TrieType_GenericSave(rdb, sp->terms, 0);
+    return;
+  }
+
+  int type = keysDictEntryType(part->kdv);
+  RedisModule_SaveUnsigned(rdb, type);
+  RedisModule_SaveString(rdb, part->key);
+  switch (type) {
+    case IndexContent_Term:
+      InvertedIndex_RdbSave(rdb, part->kdv->p);
+      break;
+    case IndexContent_Numeric:
+      NumericIndexType_RdbSave(rdb, part->kdv->p);
+      break;
+    case IndexContent_Tag:
+      TagIndex_RdbSave(rdb, part->kdv->p);
+      break;
+  }
+}
+
+/* Load a part into contentLoadSpec. Returns the spec, or NULL if the part cannot be parsed */
+static void *IndexContentPart_RdbLoad(RedisModuleIO *rdb, int encver) {
+  IndexSpec *sp = contentLoadSpec;
+  if (!sp->rdbContentLoaded) {
+    // the first part is the header
+    IndexStats_RdbLoad(rdb, &sp->stats);
+    DocTable_RdbLoad(&sp->docs, rdb, INDEX_CURRENT_VERSION);
+    TrieType_Free(sp->terms);
+    sp->terms = TrieType_GenericLoad(rdb, 0);
+    sp->rdbContentLoaded = true;
+    return sp;
+  }
+
+  int type = RedisModule_LoadUnsigned(rdb);
+  RedisModuleString *key = RedisModule_LoadString(rdb);
+  KeysDictValue *kdv = rm_calloc(1, sizeof(*kdv));
+  switch (type) {
+    case IndexContent_Term:
+      kdv->p = InvertedIndex_RdbLoad(rdb, INVERTED_INDEX_ENCVER);
+      kdv->dtor = InvertedIndex_Free;
+      break;
+    case IndexContent_Numeric:
+      kdv->p = NumericIndexType_RdbLoad(rdb, NUMERIC_INDEX_ENCVER);
+      kdv->dtor = (void (*)(void *))NumericRangeTree_Free;
+      break;
+    case IndexContent_Tag:
+      kdv->p = TagIndex_RdbLoad(rdb, TAGIDX_CURRENT_VERSION);
+      kdv->dtor = TagIndex_Free;
+      break;
+  }
+  if (!kdv->p) {
+    RedisModule_LogIOError(rdb, "warning", "Index '%s': failed loading contents of %s",
+                           sp->name, RedisModule_StringPtrLen(key, NULL));
+    RedisModule_FreeString(NULL, key);
+    rm_free(kdv);
+    return NULL;
+  }
+  dictAdd(sp->keysDict, key, kdv);
+  RedisModule_FreeString(NULL, key);
+  return sp;
+}
+
+static void IndexContentPart_Free(void *value) {
+}
+
+static void IndexContentPart_SaveString(RedisModuleIO *rdb, IndexContentPart *part) {
+  RedisModuleString *s = RedisModule_SaveDataTypeToString(NULL, part, IndexContentPartType);
+  RedisModule_SaveString(rdb, s);
+  RedisModule_FreeString(NULL, s);
+}
+
+/* Save the doc table, the terms trie and every inverted index, numeric tree and tag index kept in
+ * the spec's keys dictionary. The contents are the contents version and the number of parts,
+ * followed by each part serialized to a string, so that a loader that does not know the version
+ * can skip them. A leading 0 marks a spec whose contents were not saved */
+static void IndexSpec_RdbSaveContent(RedisModuleIO *rdb, IndexSpec *sp) {
+  if (!RSGlobalConfig.persistIndexes || !sp->keysDict || sp->scan_in_progress) {
+    RedisModule_SaveUnsigned(rdb, 0);
+    return;
+  }
+  RedisModule_SaveUnsigned(rdb, indexContentEncver);
+
+  size_t nparts = 1;
+  dictIterator *iter = dictGetIterator(sp->keysDict);
+  dictEntry *entry = NULL;
+  while ((entry = dictNext(iter))) {
+    if (keysDictEntryType(dictGetVal(entry))) {
+      ++nparts;
+    }
+  }
+  dictReleaseIterator(iter);
+  RedisModule_SaveUnsigned(rdb, nparts);
+
+  IndexContentPart part = {.sp = sp};
+  IndexContentPart_SaveString(rdb, &part);
+
+  iter = dictGetIterator(sp->keysDict);
+  while ((entry = dictNext(iter))) {
+    part.kdv = dictGetVal(entry);
+    if (!keysDictEntryType(part.kdv)) {
+      continue;
+    }
+    part.key = dictGetKey(entry);
+    IndexContentPart_SaveString(rdb, &part);
+  }
+  dictReleaseIterator(iter);
+}
+
+/* Load the contents saved by IndexSpec_RdbSaveContent. Contents of an unknown version are skipped
+ * and the spec is left empty, to be rebuilt from the keyspace. Returns REDISMODULE_ERR if the
+ * contents cannot be parsed */
+static int IndexSpec_RdbLoadContent(RedisModuleIO *rdb, IndexSpec *sp, int encver) {
+  if (encver < INDEX_MIN_PERSIST_CONTENT_VERSION) {
+    return REDISMODULE_OK;
+  }
+  uint64_t contentver = RedisModule_LoadUnsigned(rdb);
+  if (contentver == 0) {
+    // nothing was saved, the index is rebuilt from the keyspace
+    return REDISMODULE_OK;
+  }
+
+  size_t nparts = RedisModule_LoadUnsigned(rdb);
+  if (contentver != INDEX_CONTENT_ENCVER) {
+    RedisModule_Log(NULL, "warning",
+                    "Index '%s': skipping contents of unsupported version %lu, the index will be "
+                    "rebuilt from the keyspace",
+                    sp->name, (unsigned long)contentver);
+    for (size_t i = 0; i < nparts; ++i) {
+      RedisModule_FreeString(NULL, RedisModule_LoadString(rdb));
+    }
+    return REDISMODULE_OK;
+  }
+
+  int rc = REDISMODULE_OK;
+  contentLoadSpec = sp;
+  for (size_t i = 0; i < nparts && rc == REDISMODULE_OK; ++i) {
+    RedisModuleString *s = RedisModule_LoadString(rdb);
+    if (!RedisModule_LoadDataTypeFromString(s, IndexContentPartType)) {
+      rc = REDISMODULE_ERR;
+    }
+    RedisModule_FreeString(NULL, s);
+  }
+  contentLoadSpec = NULL;
+  if (rc != REDISMODULE_OK) {
+    RedisModule_LogIOError(rdb, "warning", "Index '%s': failed loading contents", sp->name);
+  }
+  return rc;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 static threadpool reindexPool = NULL;
@@ -1288,7 +1524,7 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
 
   RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
   RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
-  RedisModule_ThreadSafeContextLock(ctx);
+  ConcurrentSearch_ThreadSafeContextLock(ctx);
 
   if (scanner->cancelled) {
     goto end;
@@ -1300,9 +1536,9 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
   }
 
   while (RedisModule_Scan(ctx, cursor, (RedisModuleScanCB)Indexes_ScanProc, scanner)) {
-    RedisModule_ThreadSafeContextUnlock(ctx);
+    ConcurrentSearch_ThreadSafeContextUnlock(ctx);
     sched_yield();
-    RedisModule_ThreadSafeContextLock(ctx);
+    ConcurrentSearch_ThreadSafeContextLock(ctx);
 
     if (scanner->cancelled) {
       goto end;
@@ -1319,7 +1555,7 @@ end:
 
   IndexesScanner_Free(scanner);
 
-  RedisModule_ThreadSafeContextUnlock(ctx);
+  ConcurrentSearch_ThreadSafeContextUnlock(ctx);
   RedisModule_ScanCursorDestroy(cursor);
 
   RedisModule_FreeThreadSafeContext(ctx);
@@ -1542,6 +1778,12 @@ IndexSpec *IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int
     RS_LOG_ASSERT(rc == REDISMODULE_OK, "adding alias to index failed");
   }
 
+  if (IndexSpec_RdbLoadContent(rdb, sp, encver) != REDISMODULE_OK) {
+    QueryError_SetErrorFmt(status, QUERY_EGENERIC, "Failed to load index contents");
+    IndexSpec_Free(sp);
+    return NULL;
+  }
+
   sp->indexer = NewIndexer(sp);
 
   sp->scanner = NULL;
@@ -1735,6 +1977,8 @@ void Indexes_RdbSave(RedisModuleIO *rdb, int when) {
     } else {
       RedisModule_SaveUnsigned(rdb, 0);
     }
+
+    IndexSpec_RdbSaveContent(rdb, sp);
   }
 
   dictReleaseIterator(iter);
@@ -1781,6 +2025,14 @@ static void Indexes_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint
     Indexes_Free();
     legacySpecDict = dictCreate(&dictTypeHeapStrings, NULL);
   } else if (subevent == REDISMODULE_SUBEVENT_LOADING_ENDED) {
+    dictIterator *specIter = dictGetIterator(specDict_g);
+    dictEntry *specEntry = NULL;
+    while ((specEntry = dictNext(specIter))) {
+      IndexSpec *sp = dictGetVal(specEntry);
+      sp->rdbContentLoaded = false;
+    }
+    dictReleaseIterator(specIter);
+
     int hasLegacyIndexes = dictSize(legacySpecDict);
     Indexes_UpgradeLegacyIndexes();
 
@@ -1831,6 +2083,20 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx) {
     return REDISMODULE_ERR;
   }
 
+  RedisModuleTypeMethods contentTm = {
+      .version = REDISMODULE_TYPE_METHOD_VERSION,
+      .rdb_load = IndexContentPart_RdbLoad,
+      .rdb_save = IndexContentPart_RdbSave,
+      .free = IndexContentPart_Free,
+  };
+
+  IndexContentPartType =
+      RedisModule_CreateDataType(ctx, "ft_idxcnt", INDEX_CONTENT_ENCVER, &contentTm);
+  if (IndexContentPartType == NULL) {
+    RedisModule_Log(ctx, "error", "Could not create index contents type");
+    return REDISMODULE_ERR;
+  }
+
   RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_Loading, Indexes_LoadingEvent);
 
   return REDISMODULE_OK;
@@ -1842,6 +2108,11 @@ int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleSt
     return REDISMODULE_ERR;
   }
 
+  if (spec->asyncQueue) {
+    // a queued or in-flight document of the key is older than the one indexed now
+    AsyncIndexQueue_Invalidate(spec->asyncQueue, key);
+  }
+
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
   Document doc = {0};
   Document_Init(&doc, key, 1.0, DEFAULT_LANGUAGE);
@@ -1864,6 +2135,10 @@ int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleSt
 int IndexSpec_DeleteHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
 
+  if (spec->asyncQueue) {
+    AsyncIndexQueue_Invalidate(spec->asyncQueue, key);
+  }
+
   // Get the doc ID
   t_docId id = DocTable_GetIdR(&spec->docs, key);
   if (id == 0) {
@@ -1877,7 +2152,7 @@ int IndexSpec_DeleteHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
 
     // Increment the index's garbage collector's scanning frequency after document deletions
     if (spec->gc) {
-      GCContext_OnDelete(spec->gc);
+      GCContext_OnDelete(spec->gc, id);
     }
   }
   return REDISMODULE_OK;
@@ -1899,8 +2174,10 @@ static void onFlush(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent
   if (subevent != REDISMODULE_SUBEVENT_FLUSHDB_START) {
     return;
   }
+  ConcurrentSearch_IndexWriteLock();
   IndexSpec_CleanAll();
   Dictionary_Clear();
+  ConcurrentSearch_IndexWriteUnlock();
 }
 
 void Indexes_Init(RedisModuleCtx *ctx) {
@@ -2022,15 +2299,32 @@ void Indexes_SpecOpsIndexingCtxFree(SpecOpIndexingCtx *specs) {
   rm_free(specs);
 }
 
-void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
-                                           RedisModuleString **hashFields) {
+/* Index the hash, or queue it for the index thread pool when ASYNC_INDEXING is on */
+static void IndexSpec_IndexHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
+  if (RSGlobalConfig.asyncIndexing) {
+    AsyncIndexQueue_Enqueue(spec, key);
+  } else {
+    IndexSpec_UpdateWithHash(spec, ctx, key);
+  }
+}
+
+static void Indexes_UpdateMatchingInternal(RedisModuleCtx *ctx, RedisModuleString *key,
+                                           RedisModuleString **hashFields, bool loaded) {
   SpecOpIndexingCtx *specs = Indexes_FindMatchingSchemaRules(ctx, key, true, NULL);
 
   for (size_t i = 0; i < array_len(specs->specsOps); ++i) {
     SpecOpCtx *specOp = specs->specsOps + i;
+    if (loaded && specOp->spec->rdbContentLoaded) {
+      // the key was indexed when it was saved along with the index contents
+      continue;
+    }
     if (!hashFields || hashFieldChanged(specOp->spec, hashFields)) {
       if (specOp->op == SpecOp_Add) {
-        IndexSpec_UpdateWithHash(specOp->spec, ctx, key);
+        if (loaded) {
+          IndexSpec_UpdateWithHash(specOp->spec, ctx, key);
+        } else {
+          IndexSpec_IndexHash(specOp->spec, ctx, key);
+        }
       } else {
         IndexSpec_DeleteHash(specOp->spec, ctx, key);
       }
@@ -2040,6 +2334,15 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
   Indexes_SpecOpsIndexingCtxFree(specs);
 }
 
+void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                           RedisModuleString **hashFields) {
+  Indexes_UpdateMatchingInternal(ctx, key, hashFields, false);
+}
+
+void Indexes_LoadedMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key) {
+  Indexes_UpdateMatchingInternal(ctx, key, NULL, true);
+}
+
 void IndexSpec_UpdateMatchingWithSchemaRules(IndexSpec *sp, RedisModuleCtx *ctx,
                                              RedisModuleString *key) {
   SpecOpIndexingCtx *specs = Indexes_FindMatchingSchemaRules(ctx, key, true, NULL);
@@ -2092,7 +2395,10 @@ void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStri
       continue;
     }
     dictEntry *entry = dictFind(to_specs->specs, spec->name);
-    if (entry) {
+    if (entry && spec->asyncQueue && AsyncIndexQueue_Invalidate(spec->asyncQueue, from_key)) {
+      // the indexed document is outdated, so it cannot be renamed. Index the new key instead
+      IndexSpec_DeleteHash(spec, ctx, from_key);
+    } else if (entry) {
       DocTable_Replace(&spec->docs, from_str, from_len, to_str, to_len);
       size_t index = entry->v.u64;
       dictDelete(to_specs->specs, spec->name);
@@ -2112,7 +2418,7 @@ void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStri
       // on the spec from section.
       continue;
     }
-    IndexSpec_UpdateWithHash(specOp->spec, ctx, to_key);
+    IndexSpec_IndexHash(specOp->spec, ctx, to_key);
   }
   Indexes_SpecOpsIndexingCtxFree(from_specs);
   Indexes_SpecOpsIndexingCtxFree(to_specs);
@@ -169,7 +169,7 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 17
+#define INDEX_CURRENT_VERSION 18
 #define INDEX_MIN_COMPAT_VERSION 17
 
 #define LEGACY_INDEX_MAX_VERSION 16
@@ -204,6 +204,14 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 
 #define INDEX_MIN_ALIAS_VERSION 15
 
+// Versions below this never contain the index contents (doc table, terms and field indexes)
+#define INDEX_MIN_PERSIST_CONTENT_VERSION 18
+
+// Version of the serialized index contents. The contents are always framed as the version, the
+// number of parts and the parts as length-prefixed strings. Contents saved with any other version
+// are skipped and the index is rebuilt from the keyspace instead
+#define INDEX_CONTENT_ENCVER 1
+
 #define IDXFLD_LEGACY_FULLTEXT 0
 #define IDXFLD_LEGACY_NUMERIC 1
 #define IDXFLD_LEGACY_GEO 2
@@ -257,6 +265,8 @@ typedef struct IndexSpec {
   void *getValueCtx;
   char **aliases;  // Aliases to self-remove when the index is deleted
   struct DocumentIndexer *indexer;
+  // keys waiting to be indexed when ASYNC_INDEXING is on, created on first use
+  struct AsyncIndexQueue *asyncQueue;
 
   SchemaRule *rule;
 
@@ -265,6 +275,15 @@ typedef struct IndexSpec {
   // in favor on a newer, pending scan
   bool scan_in_progress;
   bool cascadeDelete;  // remove keys when removing spec
+  // contents were restored from rdb, keys loaded along with them are already indexed
+  bool rdbContentLoaded;
+
+  // Queries using the index, including those paused in cursors or running without the GIL in
+  // concurrent read mode. Dropping the index subtracts one as well, and whoever brings it to -1
+  // frees the index
+  int activeQueries;
+  // removed from the keyspace, its memory is freed once no query uses it
+  bool isDropped;
 } IndexSpec;
 
 typedef enum SpecOp { SpecOp_Add, SpecOp_Del } SpecOp;
@@ -473,6 +492,11 @@ char *IndexSpec_GetRandomTerm(IndexSpec *sp, size_t sampleSize);
 void IndexSpec_Free(IndexSpec *spec);
 void IndexSpec_FreeInternals(IndexSpec *spec);
 
+/* Keep the spec from being freed while a query runs on it without the GIL. Should be called with
+ * the GIL held. If the index is dropped meanwhile, the last query to finish frees it */
+void IndexSpec_IncrActiveQueries(IndexSpec *spec);
+void IndexSpec_DecrActiveQueries(IndexSpec *spec);
+
 /**
  * Free the index synchronously. Any keys associated with the index (but not the
  * documents themselves) are freed before this function returns.
@@ -497,7 +521,13 @@ void IndexSpec_RdbSave(RedisModuleIO *rdb, int when);
 void IndexSpec_Digest(RedisModuleDigest *digest, void *value);
 int CompareVestions(Version v1, Version v2);
 int IndexSpec_RegisterType(RedisModuleCtx *ctx);
+
+/* Override the contents version written to RDB. Used by FT.DEBUG to test loading contents of an
+ * unknown version */
+void IndexSpec_SetContentEncver(uint64_t encver);
+
 int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
+int IndexSpec_DeleteHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
 void IndexSpec_ClearAliases(IndexSpec *sp);
 
 /*
@@ -522,6 +552,9 @@ typedef struct IndexesScanner {
 void Indexes_Init(RedisModuleCtx *ctx);
 void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
                                            RedisModuleString **hashFields);
+/* Same as Indexes_UpdateMatchingWithSchemaRules for keys loaded from rdb. Specs whose contents
+ * were restored from the same rdb skip the key */
+void Indexes_LoadedMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key);
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
                                            RedisModuleString **hashFields);
 void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *from_key,
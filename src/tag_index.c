@@ -17,6 +17,7 @@ TagIndex *NewTagIndex() {
   TagIndex *idx = rm_new(TagIndex);
   idx->values = NewTrieMap();
   idx->uniqueId = tagUniqueId++;
+  idx->revisionId = 0;
   return idx;
 }
 
@@ -87,6 +88,7 @@ struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_
     if (create) {
       iv = NewInvertedIndex(Index_DocIdsOnly, 1);
       TrieMap_Add(idx->values, (char *)value, len, iv, NULL);
+      ++idx->revisionId;
     }
   }
   return iv;
@@ -127,28 +129,7 @@ static void TagReader_OnReopen(void *privdata) {
 
   // If the key is valid, we just reset the reader's buffer reader to the current block pointer
   for (size_t ii = 0; ii < nits; ++ii) {
-    IndexReader *ir = its[ii]->ctx;
-
-    // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
-    if (ir->gcMarker == ir->idx->gcMarker) {
-      // no GC - we just go to the same offset we were at
-      size_t offset = ir->br.pos;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->br.pos = offset;
-    } else {
-      // if there has been a GC cycle on this key while we were asleep, the offset might not be
-      // valid anymore. This means that we need to seek to last docId we were at
-
-      // reset the state of the reader
-      t_docId lastId = ir->lastId;
-      ir->currentBlock = 0;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->lastId = 0;
-
-      // seek to the previous last id
-      RSIndexResult *dummy = NULL;
-      IR_SkipTo(ir, lastId, &dummy);
-    }
+    IndexReader_Resync(its[ii]->ctx);
   }
 }
 
@@ -94,6 +94,9 @@ extern "C" {
  */
 typedef struct {
   uint32_t uniqueId;
+  // incremented whenever the nodes of `values` may move: when a value is added or removed, or
+  // their children are sorted
+  uint32_t revisionId;
   TrieMap *values;
 } TagIndex;
 
@@ -136,6 +139,9 @@ void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx);
 
 #define TAGIDX_CURRENT_VERSION 1
 extern RedisModuleType *TagIndexType;
+void *TagIndex_RdbLoad(RedisModuleIO *rdb, int encver);
+void TagIndex_RdbSave(RedisModuleIO *rdb, void *value);
+
 /* Register the tag index type in redis */
 int TagIndex_RegisterType(RedisModuleCtx *ctx);
 
@@ -0,0 +1,665 @@
+#include "../dep/libnu/libnu.h"
+#include "../util/arr.h"
+#include "../varint.h"
+#include "frozen_trie.h"
+#include <sys/param.h>
+#include <math.h>
+#include "rmalloc.h"
+
+// the longest string of each length class, in runes. The classes are narrow for the short
+// strings, whose scores the length factor of prefix searches tells apart the most
+static const t_len lengthClasses[FROZEN_TRIE_LENGTH_CLASSES] = {2, 4, 6, 8, 12,
+                                                               TRIE_INITIAL_STRING_LEN};
+
+static int lengthClass(size_t nrunes) {
+  int c = 0;
+  while (c < FROZEN_TRIE_LENGTH_CLASSES - 1 && nrunes > lengthClasses[c]) {
+    ++c;
+  }
+  return c;
+}
+
+/* The number of runes of a UTF-8 string, which are the bytes not continuing a rune */
+static size_t utf8Len(const char *s, size_t len) {
+  size_t n = 0;
+  for (size_t ii = 0; ii < len; ++ii) {
+    n += ((unsigned char)s[ii] & 0xc0) != 0x80;
+  }
+  return n;
+}
+
+int FrozenTrie_CmpStrings(const char *a, size_t na, const char *b, size_t nb) {
+  int rc = memcmp(a, b, MIN(na, nb));
+  if (rc) {
+    return rc;
+  }
+  return na < nb ? -1 : na > nb;
+}
+
+static int runeCmp(const rune *a, size_t na, const rune *b, size_t nb) {
+  for (size_t ii = 0; ii < MIN(na, nb); ++ii) {
+    if (a[ii] != b[ii]) {
+      return a[ii] < b[ii] ? -1 : 1;
+    }
+  }
+  return na < nb ? -1 : na > nb;
+}
+
+size_t FrozenTrie_EncodeRunes(const rune *runes, size_t len, char *out) {
+  char *p = out;
+  for (size_t ii = 0; ii < len; ++ii) {
+    p = nu_utf8_write(runes[ii], p);
+  }
+  return p - out;
+}
+
+FrozenTrie *NewFrozenTrie() {
+  FrozenTrie *ft = rm_calloc(1, sizeof(*ft));
+  Buffer_Init(&ft->data, 1024);
+  ft->blocks = array_new(uint32_t, 16);
+  ft->levels = array_new(FrozenTrieRange *, 4);
+  ft->levels = array_append(ft->levels, array_new(FrozenTrieRange, 16));
+  ft->scores = array_new(float, 256);
+  return ft;
+}
+
+void FrozenTrie_Append(FrozenTrie *ft, const char *s, size_t len, float score, const char *payload,
+                       size_t plen) {
+  BufferWriter bw = NewBufferWriter(&ft->data);
+  size_t lcp = 0, n = MIN(len, ft->lastLen);
+  while (lcp < n && ft->last[lcp] == s[lcp]) {
+    ++lcp;
+  }
+  if (ft->size % FROZEN_TRIE_BLOCK_SIZE == 0) {
+    ft->blocks = array_append(ft->blocks, Buffer_Offset(&ft->data));
+    FrozenTrieRange r = {.lcp = len, .prevLcp = lcp};
+    for (int c = 0; c < FROZEN_TRIE_LENGTH_CLASSES; ++c) {
+      r.maxScores[c] = -INFINITY;
+    }
+    ft->levels[0] = array_append(ft->levels[0], r);
+    // the first string of a block is stored whole
+    lcp = 0;
+  } else {
+    FrozenTrieRange *r = &array_tail(ft->levels[0]);
+    r->lcp = MIN(r->lcp, lcp);
+  }
+  float *maxScore = &array_tail(ft->levels[0]).maxScores[lengthClass(utf8Len(s, len))];
+  *maxScore = MAX(*maxScore, score);
+
+  WriteVarint(lcp, &bw);
+  WriteVarint(len - lcp, &bw);
+  Buffer_Write(&bw, s + lcp, len - lcp);
+  memcpy(ft->last, s, len);
+  ft->lastLen = len;
+  ft->scores = array_append(ft->scores, score);
+
+  if (payload && plen && !ft->payloadOffsets) {
+    // none of the strings so far had a payload
+    ft->payloadOffsets = array_new(uint32_t, ft->size + 16);
+    for (size_t ii = 0; ii <= ft->size; ++ii) {
+      ft->payloadOffsets = array_append(ft->payloadOffsets, 0);
+    }
+  }
+  if (ft->payloadOffsets) {
+    if (payload && plen) {
+      BufferWriter pw = NewBufferWriter(&ft->payloads);
+      Buffer_Write(&pw, payload, plen);
+    }
+    ft->payloadOffsets = array_append(ft->payloadOffsets, Buffer_Offset(&ft->payloads));
+  }
+  ft->size++;
+}
+
+/* Group the ranges of a level by FROZEN_TRIE_FANOUT into the ranges of the level above */
+static FrozenTrieRange *groupRanges(FrozenTrieRange *ranges) {
+  size_t n = array_len(ranges);
+  FrozenTrieRange *groups =
+      array_new(FrozenTrieRange, (n + FROZEN_TRIE_FANOUT - 1) / FROZEN_TRIE_FANOUT);
+  for (size_t ii = 0; ii < n; ii += FROZEN_TRIE_FANOUT) {
+    FrozenTrieRange g = ranges[ii];
+    for (size_t jj = ii + 1; jj < MIN(n, ii + FROZEN_TRIE_FANOUT); ++jj) {
+      g.lcp = MIN(g.lcp, MIN(ranges[jj].lcp, ranges[jj].prevLcp));
+      for (int c = 0; c < FROZEN_TRIE_LENGTH_CLASSES; ++c) {
+        g.maxScores[c] = MAX(g.maxScores[c], ranges[jj].maxScores[c]);
+      }
+    }
+    groups = array_append(groups, g);
+  }
+  return groups;
+}
+
+void FrozenTrie_Seal(FrozenTrie *ft) {
+  Buffer_ShrinkToSize(&ft->data);
+  if (ft->size) {
+    ft->blocks = array_trimm_cap(ft->blocks, array_len(ft->blocks));
+    ft->scores = array_trimm_cap(ft->scores, array_len(ft->scores));
+    ft->levels[0] = array_trimm_cap(ft->levels[0], array_len(ft->levels[0]));
+    while (array_len(array_tail(ft->levels)) > 1) {
+      FrozenTrieRange *groups = groupRanges(array_tail(ft->levels));
+      ft->levels = array_append(ft->levels, groups);
+    }
+  }
+  if (ft->payloadOffsets) {
+    ft->payloadOffsets = array_trimm_cap(ft->payloadOffsets, array_len(ft->payloadOffsets));
+    Buffer_ShrinkToSize(&ft->payloads);
+  }
+  ft->deleted = rm_calloc(ft->size / 8 + 1, 1);
+  ft->lastLen = 0;
+}
+
+/* Read the string at the reader's position, which shares its first bytes with the string in `str` */
+static void cursorDecode(FrozenTrieCursor *c) {
+  c->lcp = ReadVarint(&c->br);
+  size_t n = ReadVarint(&c->br);
+  Buffer_Read(&c->br, c->str + c->lcp, n);
+  c->len = c->lcp + n;
+}
+
+int FrozenTrieCursor_Init(FrozenTrieCursor *c, const FrozenTrie *ft) {
+  c->ft = ft;
+  c->br = (BufferReader){.buf = (Buffer *)&ft->data, .pos = 0};
+  c->idx = 0;
+  c->len = 0;
+  if (!ft->size) {
+    return 0;
+  }
+  cursorDecode(c);
+  return 1;
+}
+
+int FrozenTrieCursor_Next(FrozenTrieCursor *c) {
+  if (c->idx + 1 >= c->ft->size) {
+    c->idx = c->ft->size;
+    return 0;
+  }
+  ++c->idx;
+  cursorDecode(c);
+  return 1;
+}
+
+int FrozenTrieCursor_SeekBlock(FrozenTrieCursor *c, size_t block) {
+  if (block >= array_len(c->ft->blocks)) {
+    c->idx = c->ft->size;
+    return 0;
+  }
+  c->br.pos = c->ft->blocks[block];
+  c->idx = block * FROZEN_TRIE_BLOCK_SIZE;
+  cursorDecode(c);
+  return 1;
+}
+
+/* Compare the first string of the block with `s` */
+static int blockCmp(const FrozenTrie *ft, size_t block, const char *s, size_t len) {
+  BufferReader br = {.buf = (Buffer *)&ft->data, .pos = ft->blocks[block]};
+  // the first string of a block shares nothing with the previous one
+  ReadVarint(&br);
+  size_t n = ReadVarint(&br);
+  return FrozenTrie_CmpStrings(BufferReader_Current(&br), n, s, len);
+}
+
+int FrozenTrieCursor_Seek(FrozenTrieCursor *c, const char *s, size_t len) {
+  if (c->idx >= c->ft->size) {
+    return 0;
+  }
+  if (FrozenTrie_CmpStrings(c->str, c->len, s, len) >= 0) {
+    return 1;
+  }
+  // find the last block starting no later than `s`, which is the current one or a following one.
+  // Filters mostly skip a few strings at a time, so the blocks ahead are galloped over before they
+  // are binary searched
+  size_t lo = c->idx / FROZEN_TRIE_BLOCK_SIZE, n = array_len(c->ft->blocks), step = 1;
+  while (lo + step < n && blockCmp(c->ft, lo + step, s, len) <= 0) {
+    lo += step;
+    step *= 2;
+  }
+  size_t hi = MIN(n, lo + step);
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (blockCmp(c->ft, mid, s, len) <= 0) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo != c->idx / FROZEN_TRIE_BLOCK_SIZE) {
+    FrozenTrieCursor_SeekBlock(c, lo);
+  }
+  while (FrozenTrie_CmpStrings(c->str, c->len, s, len) < 0) {
+    if (!FrozenTrieCursor_Next(c)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int FrozenTrie_Find(const FrozenTrie *ft, const char *s, size_t len, size_t *idx) {
+  FrozenTrieCursor c;
+  if (!FrozenTrieCursor_Init(&c, ft) || !FrozenTrieCursor_Seek(&c, s, len) ||
+      FrozenTrie_CmpStrings(c.str, c.len, s, len) || FrozenTrie_IsDeleted(ft, c.idx)) {
+    return 0;
+  }
+  *idx = c.idx;
+  return 1;
+}
+
+const char *FrozenTrie_GetPayload(const FrozenTrie *ft, size_t idx, size_t *plen) {
+  if (!ft->payloadOffsets || ft->payloadOffsets[idx] == ft->payloadOffsets[idx + 1]) {
+    *plen = 0;
+    return NULL;
+  }
+  *plen = ft->payloadOffsets[idx + 1] - ft->payloadOffsets[idx];
+  return ft->payloads.data + ft->payloadOffsets[idx];
+}
+
+void FrozenTrie_SetScore(FrozenTrie *ft, size_t idx, size_t nrunes, float score) {
+  ft->scores[idx] = score;
+  // the scores of the ranges only need to bound those of their strings, so they are not lowered
+  int c = lengthClass(nrunes);
+  size_t ii = idx / FROZEN_TRIE_BLOCK_SIZE;
+  for (size_t level = 0; level < array_len(ft->levels); ++level, ii /= FROZEN_TRIE_FANOUT) {
+    float *maxScore = &ft->levels[level][ii].maxScores[c];
+    *maxScore = MAX(*maxScore, score);
+  }
+}
+
+void FrozenTrie_Delete(FrozenTrie *ft, size_t idx) {
+  if (!FrozenTrie_IsDeleted(ft, idx)) {
+    ft->deleted[idx >> 3] |= 1 << (idx & 7);
+    ft->numDeleted++;
+  }
+}
+
+size_t FrozenTrie_GetString(const FrozenTrie *ft, size_t idx, char *buf) {
+  FrozenTrieCursor c = {.ft = ft, .br = {.buf = (Buffer *)&ft->data}};
+  FrozenTrieCursor_SeekBlock(&c, idx / FROZEN_TRIE_BLOCK_SIZE);
+  while (c.idx < idx) {
+    FrozenTrieCursor_Next(&c);
+  }
+  memcpy(buf, c.str, c.len);
+  return c.len;
+}
+
+void FrozenTrie_IterateRange(const FrozenTrie *ft, const rune *min, int nmin, bool includeMin,
+                             const rune *max, int nmax, bool includeMax,
+                             TrieRangeCallback callback, void *ctx) {
+  if (min && max) {
+    int cmp = runeCmp(min, nmin, max, nmax);
+    if (cmp > 0 || (cmp == 0 && !includeMin && !includeMax)) {
+      return;
+    } else if (cmp == 0) {
+      // as with the nodes, a single string is in the range if either bound includes it
+      includeMin = includeMax = true;
+    }
+  }
+
+  // the trie holds no string longer than TRIE_INITIAL_STRING_LEN runes, so longer bounds order
+  // the same as their first TRIE_INITIAL_STRING_LEN runes
+  char minStr[FROZEN_TRIE_MAX_STRING], maxStr[FROZEN_TRIE_MAX_STRING];
+  size_t minLen = 0, maxLen = 0;
+  if (min) {
+    minLen = FrozenTrie_EncodeRunes(min, MIN(nmin, TRIE_INITIAL_STRING_LEN), minStr);
+  }
+  if (max) {
+    maxLen = FrozenTrie_EncodeRunes(max, MIN(nmax, TRIE_INITIAL_STRING_LEN), maxStr);
+  }
+
+  FrozenTrieCursor c;
+  int ok = FrozenTrieCursor_Init(&c, ft);
+  if (min) {
+    ok = ok && FrozenTrieCursor_Seek(&c, minStr, minLen);
+  }
+  rune runes[TRIE_INITIAL_STRING_LEN + 1];
+  for (; ok; ok = FrozenTrieCursor_Next(&c)) {
+    if (max) {
+      int cmp = FrozenTrie_CmpStrings(c.str, c.len, maxStr, maxLen);
+      if (cmp > 0 || (cmp == 0 && !includeMax)) {
+        break;
+      }
+    }
+    if (FrozenTrie_IsDeleted(ft, c.idx) ||
+        (min && !includeMin && !FrozenTrie_CmpStrings(c.str, c.len, minStr, minLen))) {
+      continue;
+    }
+    size_t n = strToRunesN(c.str, c.len, runes);
+    callback(runes, n, ctx);
+  }
+}
+
+size_t FrozenTrie_MemUsage(const FrozenTrie *ft) {
+  size_t mem = sizeof(*ft) + ft->data.cap + ft->payloads.cap + ft->size / 8 + 1 +
+               array_len(ft->blocks) * sizeof(uint32_t) + array_len(ft->scores) * sizeof(float) +
+               array_len(ft->payloadOffsets) * sizeof(uint32_t);
+  for (size_t ii = 0; ii < array_len(ft->levels); ++ii) {
+    mem += array_len(ft->levels[ii]) * sizeof(FrozenTrieRange);
+  }
+  return mem;
+}
+
+void FrozenTrie_Free(FrozenTrie *ft) {
+  Buffer_Free(&ft->data);
+  Buffer_Free(&ft->payloads);
+  array_free(ft->blocks);
+  array_free_ex(ft->levels, array_free(*(FrozenTrieRange **)ptr));
+  array_free(ft->scores);
+  array_free(ft->payloadOffsets);
+  rm_free(ft->deleted);
+  rm_free(ft);
+}
+
+FrozenTrieIterator *FrozenTrie_Iterate(const FrozenTrie *ft, const DFAFilter *fc) {
+  FrozenTrieIterator *it = rm_malloc(sizeof(*it));
+  it->c.ft = ft;
+  it->fc = fc;
+  it->started = false;
+  it->len = 0;
+  it->nrunes = 0;
+  it->ends[0] = 0;
+  it->states[0] = fc->stack[0];
+  it->minDists[0] = fc->distStack[0];
+  return it;
+}
+
+int FrozenTrieIterator_Next(FrozenTrieIterator *it, rune **ptr, t_len *len, RSPayload *payload,
+                            float *score, int *dist) {
+  FrozenTrieCursor *c = &it->c;
+  const FrozenTrie *ft = c->ft;
+  int ok = it->started ? FrozenTrieCursor_Next(c) : FrozenTrieCursor_Init(c, ft);
+  it->started = true;
+
+  while (ok) {
+    if (FrozenTrie_IsDeleted(ft, c->idx)) {
+      ok = FrozenTrieCursor_Next(c);
+      continue;
+    }
+
+    // the states of the runes the string shares with the previous one are still good
+    size_t common = 0, n = MIN(c->len, it->len);
+    while (common < n && c->str[common] == it->str[common]) {
+      ++common;
+    }
+    t_len k = it->nrunes;
+    while (k > 0 && it->ends[k] > common) {
+      --k;
+    }
+    memcpy(it->str + it->ends[k], c->str + it->ends[k], c->len - it->ends[k]);
+    it->len = c->len;
+
+    dfaNode *state = it->states[k];
+    int minDist = it->minDists[k];
+    int matched = 0, d = 0;
+    bool stopped = false;
+    const char *p = it->str + it->ends[k], *end = it->str + it->len;
+    while (p < end) {
+      uint32_t cp;
+      p = nu_utf8_read(p, &cp);
+      it->runes[k] = cp;
+      d = minDist;
+      if (DFAFilter_Step(it->fc, &state, &minDist, cp, &matched, &d) == F_STOP) {
+        stopped = true;
+        break;
+      }
+      ++k;
+      it->states[k] = state;
+      it->minDists[k] = minDist;
+      it->ends[k] = p - it->str;
+    }
+    it->nrunes = k;
+
+    if (stopped) {
+      // no string starting with the runes up to this one can match: seek past all of them
+      char next[FROZEN_TRIE_MAX_STRING];
+      size_t nlen = p - it->str;
+      memcpy(next, it->str, nlen);
+      while (nlen && (unsigned char)next[nlen - 1] == 0xff) {
+        --nlen;
+      }
+      if (!nlen) {
+        return 0;
+      }
+      ++next[nlen - 1];
+      ok = FrozenTrieCursor_Seek(c, next, nlen);
+      continue;
+    }
+    if (!matched) {
+      ok = FrozenTrieCursor_Next(c);
+      continue;
+    }
+
+    *ptr = it->runes;
+    *len = k;
+    *score = ft->scores[c->idx];
+    if (payload) {
+      payload->data = (char *)FrozenTrie_GetPayload(ft, c->idx, &payload->len);
+    }
+    if (dist) {
+      *dist = d;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+void FrozenTrieIterator_Free(FrozenTrieIterator *it) {
+  rm_free(it);
+}
+
+/* A range of strings waiting to be visited by FrozenTrie_Search() */
+typedef struct {
+  // the greatest score a string of the range may get
+  float bound;
+  uint32_t idx;
+  uint8_t level;
+  // the state of the filter after the runes all the strings of the range share, which take up
+  // `depth` bytes
+  dfaNode *dfa;
+  int minDist;
+  uint16_t depth;
+  t_len nrunes;
+  // whether the filter matched after the last of these runes, and at which distance
+  int matched;
+  int dist;
+} frozenSearchNode;
+
+typedef struct {
+  const FrozenTrie *ft;
+  const DFAFilter *fc;
+  FrozenTrieScorer scorer;
+  FrozenTrieCollector collect;
+  void *ctx;
+  // the score a string needs to beat to be collected
+  float minScore;
+} frozenSearchCtx;
+
+/* Push a range to the frontier, a max-heap of ranges by their bound */
+static frozenSearchNode *frontierPush(frozenSearchNode *frontier, frozenSearchNode node) {
+  frontier = array_append(frontier, node);
+  size_t ii = array_len(frontier) - 1;
+  while (ii > 0 && frontier[(ii - 1) / 2].bound < node.bound) {
+    frontier[ii] = frontier[(ii - 1) / 2];
+    ii = (ii - 1) / 2;
+  }
+  frontier[ii] = node;
+  return frontier;
+}
+
+static frozenSearchNode frontierPop(frozenSearchNode *frontier) {
+  frozenSearchNode top = frontier[0];
+  frozenSearchNode last = array_pop(frontier);
+  size_t n = array_len(frontier);
+  if (!n) {
+    return top;
+  }
+  size_t ii = 0;
+  while (2 * ii + 1 < n) {
+    size_t child = 2 * ii + 1;
+    if (child + 1 < n && frontier[child + 1].bound > frontier[child].bound) {
+      ++child;
+    }
+    if (frontier[child].bound <= last.bound) {
+      break;
+    }
+    frontier[ii] = frontier[child];
+    ii = child;
+  }
+  frontier[ii] = last;
+  return top;
+}
+
+/* The greatest score a string of the range may get. The strings of the range are as long as the
+ * runes they share at least, and match at no less than the least distance the filter may reach */
+static float searchBound(const frozenSearchCtx *sc, const FrozenTrieRange *r,
+                         const frozenSearchNode *node) {
+  int dist = DFAFilter_MinDistance(node->dfa, node->minDist);
+  float bound = -INFINITY;
+  size_t minLen = 1;
+  for (int c = 0; c < FROZEN_TRIE_LENGTH_CLASSES; ++c) {
+    if (r->maxScores[c] > -INFINITY) {
+      float b = sc->scorer(r->maxScores[c], dist, MAX(minLen, node->nrunes),
+                           MAX(lengthClasses[c], node->nrunes), sc->ctx);
+      bound = MAX(bound, b);
+    }
+    minLen = lengthClasses[c] + 1;
+  }
+  return bound;
+}
+
+/* Make `node` the range at `idx` in `level`, within the range of `parent`: step the filter over the
+ * runes its strings share past those of the parent, and bound their scores. Returns 0 if none of
+ * its strings can match */
+static int searchEnter(const frozenSearchCtx *sc, const frozenSearchNode *parent, uint8_t level,
+                       size_t idx, frozenSearchNode *node) {
+  const FrozenTrie *ft = sc->ft;
+  const FrozenTrieRange *r = &ft->levels[level][idx];
+  *node = *parent;
+  node->level = level;
+  node->idx = idx;
+
+  // the first string of the range is the first of its first block, which is stored whole
+  size_t block = idx;
+  for (uint8_t ii = 0; ii < level; ++ii) {
+    block *= FROZEN_TRIE_FANOUT;
+  }
+  BufferReader br = {.buf = (Buffer *)&ft->data, .pos = ft->blocks[block]};
+  ReadVarint(&br);
+  ReadVarint(&br);
+  const char *s = BufferReader_Current(&br);
+  const char *p = s + node->depth, *end = s + r->lcp;
+  while (p < end) {
+    uint32_t cp;
+    const char *next = nu_utf8_read(p, &cp);
+    if (next > end) {
+      // the strings of the range differ within this rune
+      break;
+    }
+    node->dist = node->minDist;
+    if (DFAFilter_Step(sc->fc, &node->dfa, &node->minDist, cp, &node->matched, &node->dist) ==
+        F_STOP) {
+      return 0;
+    }
+    node->nrunes++;
+    p = next;
+  }
+  node->depth = p - s;
+  node->bound = searchBound(sc, r, node);
+  return 1;
+}
+
+/* Collect the matching strings of a block. The states of the filter over the runes a string shares
+ * with the previous one are kept, as FrozenTrieIterator does */
+static void searchBlock(frozenSearchCtx *sc, const frozenSearchNode *node) {
+  const FrozenTrie *ft = sc->ft;
+  FrozenTrieCursor c = {.ft = ft, .br = {.buf = (Buffer *)&ft->data}};
+  FrozenTrieCursor_SeekBlock(&c, node->idx);
+  size_t last = MIN(ft->size, (node->idx + 1) * FROZEN_TRIE_BLOCK_SIZE);
+
+  rune runes[TRIE_INITIAL_STRING_LEN + 1];
+  t_len ends[TRIE_INITIAL_STRING_LEN + 1];
+  dfaNode *states[TRIE_INITIAL_STRING_LEN + 1];
+  int minDists[TRIE_INITIAL_STRING_LEN + 1], matched[TRIE_INITIAL_STRING_LEN + 1],
+      dists[TRIE_INITIAL_STRING_LEN + 1];
+  t_len base = node->nrunes, known = base;
+  strToRunesN(c.str, node->depth, runes);
+  ends[base] = node->depth;
+  states[base] = node->dfa;
+  minDists[base] = node->minDist;
+  matched[base] = node->matched;
+  dists[base] = node->dist;
+
+  for (int ok = 1; ok && c.idx < last; ok = FrozenTrieCursor_Next(&c)) {
+    size_t common = MAX(c.lcp, node->depth);
+    t_len k = known;
+    while (k > base && ends[k] > common) {
+      --k;
+    }
+    known = k;
+    if (FrozenTrie_IsDeleted(ft, c.idx)) {
+      continue;
+    }
+
+    const char *p = c.str + ends[k], *end = c.str + c.len;
+    bool stopped = false;
+    while (p < end) {
+      uint32_t cp;
+      p = nu_utf8_read(p, &cp);
+      runes[k] = cp;
+      dfaNode *state = states[k];
+      int minDist = minDists[k], m = 0, d = minDist;
+      if (DFAFilter_Step(sc->fc, &state, &minDist, cp, &m, &d) == F_STOP) {
+        stopped = true;
+        break;
+      }
+      ++k;
+      ends[k] = p - c.str;
+      states[k] = state;
+      minDists[k] = minDist;
+      matched[k] = m;
+      dists[k] = d;
+    }
+    known = k;
+    if (stopped || !matched[k]) {
+      continue;
+    }
+
+    float score = sc->scorer(ft->scores[c.idx], dists[k], k, k, sc->ctx);
+    if (score > sc->minScore) {
+      RSPayload payload;
+      payload.data = (char *)FrozenTrie_GetPayload(ft, c.idx, &payload.len);
+      sc->minScore = sc->collect(runes, k, score, &payload, sc->ctx);
+    }
+  }
+}
+
+void FrozenTrie_Search(const FrozenTrie *ft, const DFAFilter *fc, FrozenTrieScorer scorer,
+                       FrozenTrieCollector collect, float minScore, void *ctx) {
+  if (!ft->size) {
+    return;
+  }
+  frozenSearchCtx sc = {
+      .ft = ft, .fc = fc, .scorer = scorer, .collect = collect, .ctx = ctx, .minScore = minScore};
+  frozenSearchNode start = {0}, top;
+  start.dfa = fc->stack[0];
+  start.minDist = fc->distStack[0];
+
+  frozenSearchNode *frontier = array_new(frozenSearchNode, 16);
+  if (searchEnter(&sc, &start, array_len(ft->levels) - 1, 0, &top) && top.bound > minScore) {
+    frontier = frontierPush(frontier, top);
+  }
+  while (array_len(frontier)) {
+    frozenSearchNode cur = frontierPop(frontier);
+    if (cur.bound <= sc.minScore) {
+      break;
+    }
+    if (!cur.level) {
+      searchBlock(&sc, &cur);
+      continue;
+    }
+    size_t end = MIN(array_len(ft->levels[cur.level - 1]), (cur.idx + 1) * FROZEN_TRIE_FANOUT);
+    for (size_t ii = cur.idx * FROZEN_TRIE_FANOUT; ii < end; ++ii) {
+      frozenSearchNode ch;
+      if (searchEnter(&sc, &cur, cur.level - 1, ii, &ch) && ch.bound > sc.minScore) {
+        frontier = frontierPush(frontier, ch);
+      }
+    }
+  }
+  array_free(frontier);
+}
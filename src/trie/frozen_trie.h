@@ -0,0 +1,185 @@
+#ifndef __FROZEN_TRIE_H__
+#define __FROZEN_TRIE_H__
+
+#include "trie.h"
+#include "levenshtein.h"
+#include "../buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A frozen trie holds the strings of a trie which rarely changes in a compact, read-mostly form:
+ * the strings are encoded as UTF-8 and sorted, and each is stored as the number of bytes it shares
+ * with the previous one and the rest of its bytes. The strings are grouped in blocks of
+ * FROZEN_TRIE_BLOCK_SIZE, the first of which is stored whole, so that a lookup binary searches the
+ * blocks and then scans a single one.
+ *
+ * Above the blocks, every FROZEN_TRIE_FANOUT ranges of strings are grouped in a wider range, up to
+ * a single range holding them all. Each range keeps the prefix its strings share and the greatest
+ * score of its strings of each length class, which FrozenTrie_Search() walks best first as
+ * Trie_Search() walks the nodes by their maxChildScore.
+ *
+ * Strings cannot be added to a frozen trie once it is built. Their scores can be changed in place,
+ * and they can be deleted, which only marks them as such. New strings go to the nodes of the Trie
+ * holding it, which is frozen again once it holds enough of them.
+ */
+
+#define FROZEN_TRIE_BLOCK_SIZE 32
+#define FROZEN_TRIE_FANOUT 16
+// the longest string a frozen trie holds, in bytes
+#define FROZEN_TRIE_MAX_STRING (TRIE_INITIAL_STRING_LEN * 3)
+// strings are told apart by their length in runes when bounding their scores, see frozen_trie.c
+#define FROZEN_TRIE_LENGTH_CLASSES 6
+
+/* A range of consecutive strings: a block, or a group of ranges of the level below */
+typedef struct {
+  // the number of bytes all the strings of the range share
+  uint16_t lcp;
+  // the number of bytes the first string of the range shares with the string before it
+  uint16_t prevLcp;
+  // the greatest score of the strings of each length class, -INFINITY if there are none
+  float maxScores[FROZEN_TRIE_LENGTH_CLASSES];
+} FrozenTrieRange;
+
+typedef struct FrozenTrie {
+  Buffer data;
+  // the offset of the first string of each block in the data
+  uint32_t *blocks;
+  // the ranges of each level, starting with the blocks and ending with a single range
+  FrozenTrieRange **levels;
+  float *scores;
+  // where the payload of each string starts in `payloads`, followed by where the last one ends.
+  // NULL if no string has a payload
+  uint32_t *payloadOffsets;
+  Buffer payloads;
+  // a bit per string, set when the string is deleted. Allocated when the trie is sealed
+  uint8_t *deleted;
+  size_t size;
+  size_t numDeleted;
+
+  // the last string appended, while the trie is built
+  char last[FROZEN_TRIE_MAX_STRING];
+  size_t lastLen;
+} FrozenTrie;
+
+FrozenTrie *NewFrozenTrie();
+
+/* Append a string to a trie being built. Strings are appended in ascending byte order, and are at
+ * most FROZEN_TRIE_MAX_STRING bytes long */
+void FrozenTrie_Append(FrozenTrie *ft, const char *s, size_t len, float score, const char *payload,
+                       size_t plen);
+
+/* Done appending strings: build the levels above the blocks and give back the room kept for more */
+void FrozenTrie_Seal(FrozenTrie *ft);
+
+/* Find a string. Returns 1 and puts its index in `idx` if it is there and not deleted */
+int FrozenTrie_Find(const FrozenTrie *ft, const char *s, size_t len, size_t *idx);
+
+/* The payload of the string at `idx`, or NULL if it has none */
+const char *FrozenTrie_GetPayload(const FrozenTrie *ft, size_t idx, size_t *plen);
+
+/* Change the score of the string at `idx`, which is `nrunes` runes long */
+void FrozenTrie_SetScore(FrozenTrie *ft, size_t idx, size_t nrunes, float score);
+
+#define FrozenTrie_GetScore(ft, idx) ((ft)->scores[idx])
+#define FrozenTrie_IsDeleted(ft, idx) ((ft)->deleted[(idx) >> 3] & (1 << ((idx)&7)))
+#define FrozenTrie_NumLive(ft) ((ft)->size - (ft)->numDeleted)
+
+void FrozenTrie_Delete(FrozenTrie *ft, size_t idx);
+
+/* Put the string at `idx` in `buf`, which holds FROZEN_TRIE_MAX_STRING bytes. Returns its length */
+size_t FrozenTrie_GetString(const FrozenTrie *ft, size_t idx, char *buf);
+
+/* Call the callback on every string which is not deleted within the range, in ascending order. The
+ * bounds follow TrieNode_IterateRange() */
+void FrozenTrie_IterateRange(const FrozenTrie *ft, const rune *min, int nmin, bool includeMin,
+                             const rune *max, int nmax, bool includeMax,
+                             TrieRangeCallback callback, void *ctx);
+
+size_t FrozenTrie_MemUsage(const FrozenTrie *ft);
+
+void FrozenTrie_Free(FrozenTrie *ft);
+
+/* A position over the strings of a frozen trie, decoding them one after the other */
+typedef struct {
+  const FrozenTrie *ft;
+  BufferReader br;
+  // the index of the current string, or `ft->size` once past the last one
+  size_t idx;
+  char str[FROZEN_TRIE_MAX_STRING];
+  size_t len;
+  // the number of bytes the string shares with the previous one, 0 for the first of a block
+  size_t lcp;
+} FrozenTrieCursor;
+
+/* Start a cursor at the first string. Returns 0 if the trie is empty */
+int FrozenTrieCursor_Init(FrozenTrieCursor *c, const FrozenTrie *ft);
+
+/* Move to the next string. Returns 0 past the last one */
+int FrozenTrieCursor_Next(FrozenTrieCursor *c);
+
+/* Move to the first string of the block */
+int FrozenTrieCursor_SeekBlock(FrozenTrieCursor *c, size_t block);
+
+/* Move forward to the first string not less than `s`. Returns 0 if there is none */
+int FrozenTrieCursor_Seek(FrozenTrieCursor *c, const char *s, size_t len);
+
+/* Iterates the strings of a frozen trie matching a DFA filter, as TrieIterator does for nodes. The
+ * filter is stepped over the runes a string does not share with the previous one, and when it
+ * stops at a rune the iterator seeks past every string starting with it */
+typedef struct FrozenTrieIterator {
+  FrozenTrieCursor c;
+  const DFAFilter *fc;
+  bool started;
+
+  // the last string the filter was stepped over, its runes, where each of them ends in the string,
+  // and the states of the filter before each of them
+  char str[FROZEN_TRIE_MAX_STRING];
+  size_t len;
+  rune runes[TRIE_INITIAL_STRING_LEN + 1];
+  t_len ends[TRIE_INITIAL_STRING_LEN + 1];
+  dfaNode *states[TRIE_INITIAL_STRING_LEN + 1];
+  int minDists[TRIE_INITIAL_STRING_LEN + 1];
+  // the number of runes whose states are known
+  t_len nrunes;
+} FrozenTrieIterator;
+
+/* Iterate the strings matching the filter, which must outlive the iterator. It only reads the
+ * filter, so it can share it with a TrieIterator */
+FrozenTrieIterator *FrozenTrie_Iterate(const FrozenTrie *ft, const DFAFilter *fc);
+
+/* Move to the next matching string, with the same outputs as TrieIterator_Next(). `dist`, if not
+ * NULL, is set to the distance of the match. Returns 0 when done */
+int FrozenTrieIterator_Next(FrozenTrieIterator *it, rune **ptr, t_len *len, RSPayload *payload,
+                            float *score, int *dist);
+
+void FrozenTrieIterator_Free(FrozenTrieIterator *it);
+
+/* The greatest score a string may get from its score, its distance from the query and its length
+ * in runes, given bounds for each: at most `score`, at least `dist`, and between `minLen` and
+ * `maxLen`. It never gets more when any of them gets worse */
+typedef float (*FrozenTrieScorer)(float score, int dist, size_t minLen, size_t maxLen, void *ctx);
+
+/* Called with a matching string and the score the scorer gave it. Returns the score the following
+ * strings need to beat, or -INFINITY to keep all of them */
+typedef float (*FrozenTrieCollector)(const rune *str, t_len len, float score,
+                                     const RSPayload *payload, void *ctx);
+
+/* Collect the strings matching the filter which score more than `minScore`. The ranges are visited
+ * by the greatest score their strings may get, and the search stops when none of them can beat the
+ * score the collector asks for */
+void FrozenTrie_Search(const FrozenTrie *ft, const DFAFilter *fc, FrozenTrieScorer scorer,
+                       FrozenTrieCollector collect, float minScore, void *ctx);
+
+/* Compare strings by their bytes, which orders UTF-8 strings by their runes */
+int FrozenTrie_CmpStrings(const char *a, size_t na, const char *b, size_t nb);
+
+/* Encode runes as UTF-8 into `out`, which has room for 3 bytes per rune. Returns the length */
+size_t FrozenTrie_EncodeRunes(const rune *runes, size_t len, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
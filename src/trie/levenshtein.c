@@ -2,8 +2,12 @@
 #include <stdio.h>
 #include <sys/param.h>
 #include <string.h>
+#include <pthread.h>
 #include "levenshtein.h"
 #include "rune_util.h"
+#include "../util/fnv.h"
+#include "../util/khash.h"
+#include "../util/arr.h"
 #include "rmalloc.h"
 
 // NewSparseAutomaton creates a new automaton for the string s, with a given max
@@ -105,21 +109,28 @@ int __sv_equals(sparseVector *sv1, sparseVector *sv2) {
   return 1;
 }
 
-dfaNode *__dfn_getCache(Vector *cache, sparseVector *v) {
-  size_t n = Vector_Size(cache);
-  for (int i = 0; i < n; i++) {
-    dfaNode *dfn;
-    Vector_Get(cache, i, &dfn);
+static khint_t __sv_hash(const sparseVector *v) {
+  return rs_fnv_32a_buf(v->entries, v->len * sizeof(*v->entries), 0);
+}
 
-    if (__sv_equals(v, dfn->v)) {
-      return dfn;
-    }
-  }
-  return NULL;
+// the states of a DFA being built by their sparse vector
+KHASH_INIT(dfaStates, sparseVector *, dfaNode *, 1, __sv_hash, __sv_equals);
+
+typedef struct {
+  Vector *states;
+  khash_t(dfaStates) * index;
+} dfaBuildCtx;
+
+static dfaNode *__dfn_getCache(dfaBuildCtx *b, sparseVector *v) {
+  khiter_t it = kh_get(dfaStates, b->index, v);
+  return it == kh_end(b->index) ? NULL : kh_val(b->index, it);
 }
 
-void __dfn_putCache(Vector *cache, dfaNode *dfn) {
-  Vector_Push(cache, dfn);
+static void __dfn_putCache(dfaBuildCtx *b, dfaNode *dfn) {
+  int absent;
+  khiter_t it = kh_put(dfaStates, b->index, dfn->v, &absent);
+  kh_val(b->index, it) = dfn;
+  Vector_Push(b->states, dfn);
 }
 
 inline dfaNode *__dfn_getEdge(dfaNode *n, rune r) {
@@ -136,7 +147,8 @@ void __dfn_addEdge(dfaNode *n, rune r, dfaNode *child) {
   n->edges[n->numEdges++] = (dfaEdge){.r = r, .n = child};
 }
 
-void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
+/* Recusively build the DFA node and all its descendants */
+static void dfa_build(dfaNode *parent, SparseAutomaton *a, dfaBuildCtx *cache) {
   parent->match = SparseAutomaton_IsMatch(a, parent->v);
 
   for (int i = 0; i < parent->v->len; i++) {
@@ -185,54 +197,131 @@ void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
   //}
 }
 
-DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
-  Vector *cache = NewVector(dfaNode *, 8);
+static dfaAutomaton *dfaAutomaton_Build(const rune *str, size_t len, int maxDist) {
+  dfaAutomaton *ret = rm_malloc(sizeof(*ret));
+  ret->str = rm_malloc((len + 1) * sizeof(rune));
+  memcpy(ret->str, str, len * sizeof(rune));
+  ret->len = len;
+  ret->maxDist = maxDist;
+  ret->states = NewVector(dfaNode *, 8);
+  ret->refcount = 1;
+
+  SparseAutomaton a = NewSparseAutomaton(ret->str, len, maxDist);
+  dfaBuildCtx cache = {.states = ret->states, .index = kh_init(dfaStates)};
+  dfaNode *dr = __newDfaNode(0, SparseAutomaton_Start(&a));
+  __dfn_putCache(&cache, dr);
+  dfa_build(dr, &a, &cache);
+  kh_destroy(dfaStates, cache.index);
+  return ret;
+}
+
+static void dfaAutomaton_Free(dfaAutomaton *a) {
+  for (int i = 0; i < Vector_Size(a->states); i++) {
+    dfaNode *dn;
+    Vector_Get(a->states, i, &dn);
+
+    if (dn) __dfaNode_free(dn);
+  }
+  Vector_Free(a->states);
+  rm_free(a->str);
+  rm_free(a);
+}
+
+/* Fuzzy automata, by their string and distance. Each one cached holds a reference to it, which is
+ * dropped when it is evicted */
+static struct {
+  dfaAutomaton *entries[DFA_CACHE_SIZE];
+  // when each entry was last used, to evict the least recently used one
+  uint64_t lastUsed[DFA_CACHE_SIZE];
+  uint64_t clock;
+  pthread_mutex_t lock;
+} dfaCache = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/* Drop a reference to an automaton, with the cache lock held. Returns 1 if it was the last one, in
+ * which case the caller frees the automaton once the lock is released */
+static int dfaAutomaton_Unref(dfaAutomaton *a) {
+  return a && --a->refcount == 0;
+}
+
+/* Get the automaton for the string and distance, from the cache or built anew */
+static dfaAutomaton *dfaCache_Get(const rune *str, size_t len, int maxDist) {
+  if (maxDist <= 0) {
+    // exact and prefix automata are built in no time, and would only push the fuzzy ones out
+    return dfaAutomaton_Build(str, len, maxDist);
+  }
+
+  pthread_mutex_lock(&dfaCache.lock);
+  for (int i = 0; i < DFA_CACHE_SIZE; i++) {
+    dfaAutomaton *a = dfaCache.entries[i];
+    if (a && a->maxDist == maxDist && a->len == len && !memcmp(a->str, str, len * sizeof(rune))) {
+      a->refcount++;
+      dfaCache.lastUsed[i] = ++dfaCache.clock;
+      pthread_mutex_unlock(&dfaCache.lock);
+      return a;
+    }
+  }
+  pthread_mutex_unlock(&dfaCache.lock);
+
+  // built without the lock, as long automata take a while. Another thread may build the same one
+  // meanwhile, in which case the cache keeps both until one is evicted
+  dfaAutomaton *ret = dfaAutomaton_Build(str, len, maxDist);
 
-  SparseAutomaton a = NewSparseAutomaton(str, len, maxDist);
+  pthread_mutex_lock(&dfaCache.lock);
+  int slot = 0;
+  for (int i = 1; i < DFA_CACHE_SIZE && dfaCache.entries[slot]; i++) {
+    if (!dfaCache.entries[i] || dfaCache.lastUsed[i] < dfaCache.lastUsed[slot]) {
+      slot = i;
+    }
+  }
+  dfaAutomaton *evicted = dfaCache.entries[slot];
+  int freeEvicted = dfaAutomaton_Unref(evicted);
+  ret->refcount++;
+  dfaCache.entries[slot] = ret;
+  dfaCache.lastUsed[slot] = ++dfaCache.clock;
+  pthread_mutex_unlock(&dfaCache.lock);
+
+  if (freeEvicted) {
+    dfaAutomaton_Free(evicted);
+  }
+  return ret;
+}
 
-  sparseVector *v = SparseAutomaton_Start(&a);
-  dfaNode *dr = __newDfaNode(0, v);
-  __dfn_putCache(cache, dr);
-  dfa_build(dr, &a, cache);
+DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
+  dfaAutomaton *automaton = dfaCache_Get(str, len, maxDist);
+  dfaNode *dr;
+  Vector_Get(automaton->states, 0, &dr);
 
   DFAFilter ret;
-  ret.cache = cache;
-  ret.stack = NewVector(dfaNode *, 8);
-  ret.distStack = NewVector(int, 8);
-  ret.a = a;
+  ret.automaton = automaton;
+  ret.stack = array_new(dfaNode *, 8);
+  ret.distStack = array_new(int, 8);
+  ret.a = NewSparseAutomaton(automaton->str, len, maxDist);
   ret.prefixMode = prefixMode;
-  Vector_Push(ret.stack, dr);
-  Vector_Push(ret.distStack, (maxDist + 1));
+  ret.stack = array_append(ret.stack, dr);
+  ret.distStack = array_append(ret.distStack, (maxDist + 1));
 
   return ret;
 }
 
 void DFAFilter_Free(DFAFilter *fc) {
-  for (int i = 0; i < Vector_Size(fc->cache); i++) {
-    dfaNode *dn;
-    Vector_Get(fc->cache, i, &dn);
-
-    if (dn) __dfaNode_free(dn);
+  pthread_mutex_lock(&dfaCache.lock);
+  int last = dfaAutomaton_Unref(fc->automaton);
+  pthread_mutex_unlock(&dfaCache.lock);
+  if (last) {
+    dfaAutomaton_Free(fc->automaton);
   }
 
-  Vector_Free(fc->cache);
-  Vector_Free(fc->stack);
-  Vector_Free(fc->distStack);
+  array_free(fc->stack);
+  array_free(fc->distStack);
 }
 
-FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
-  DFAFilter *fc = ctx;
-  dfaNode *dn;
-  int minDist;
-
-  Vector_Get(fc->stack, Vector_Size(fc->stack) - 1, &dn);
-  Vector_Get(fc->distStack, Vector_Size(fc->distStack) - 1, &minDist);
+FilterCode DFAFilter_Step(const DFAFilter *fc, dfaNode **state, int *minDist, rune b, int *matched,
+                          int *dist) {
+  dfaNode *dn = *state;
 
   // a null node means we're in prefix mode, and we're done matching our prefix
   if (dn == NULL) {
     *matched = 1;
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
     return F_CONTINUE;
   }
 
@@ -240,9 +329,8 @@ FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
 
   if (*matched) {
     // printf("MATCH %c, dist %d\n", b, dn->distance);
-    int *pdist = matchCtx;
-    if (pdist) {
-      *pdist = MIN(dn->distance, minDist);
+    if (dist) {
+      *dist = MIN(dn->distance, *minDist);
     }
   }
 
@@ -252,34 +340,52 @@ FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
   dfaNode *next = __dfn_getEdge(dn, foldedRune);
   if (!next) next = dn->fallback;
 
-  // we can continue - push the state on the stack
+  // we can continue - advance the state
   if (next) {
     if (next->match) {
       // printf("MATCH NEXT %c, dist %d\n", b, next->distance);
       *matched = 1;
-      int *pdist = matchCtx;
-      if (pdist) {
-        *pdist = MIN(next->distance, minDist);
+      if (dist) {
+        *dist = MIN(next->distance, *minDist);
       }
       //    if (fc->prefixMode) next = NULL;
     }
-    Vector_Push(fc->stack, next);
-    Vector_Push(fc->distStack, MIN(next->distance, minDist));
+    *state = next;
+    *minDist = MIN(next->distance, *minDist);
     return F_CONTINUE;
   } else if (fc->prefixMode && *matched) {
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
+    *state = NULL;
     return F_CONTINUE;
   }
 
   return F_STOP;
 }
 
-void StackPop(void *ctx, int numLevels) {
+int DFAFilter_MinDistance(const dfaNode *dn, int minDist) {
+  if (dn) {
+    for (size_t ii = 0; ii < dn->v->len; ++ii) {
+      minDist = MIN(minDist, dn->v->entries[ii].val);
+    }
+  }
+  return minDist;
+}
+
+FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
   DFAFilter *fc = ctx;
+  dfaNode *dn = array_tail(fc->stack);
+  int minDist = array_tail(fc->distStack);
 
-  for (int i = 0; i < numLevels; i++) {
-    Vector_Pop(fc->stack, NULL);
-    Vector_Pop(fc->distStack, NULL);
+  FilterCode rc = DFAFilter_Step(fc, &dn, &minDist, b, matched, matchCtx);
+  if (rc == F_CONTINUE) {
+    fc->stack = array_append(fc->stack, dn);
+    fc->distStack = array_append(fc->distStack, minDist);
   }
+  return rc;
+}
+
+void StackPop(void *ctx, int numLevels) {
+  DFAFilter *fc = ctx;
+
+  array_trimm_len(fc->stack, array_len(fc->stack) - numLevels);
+  array_trimm_len(fc->distStack, array_len(fc->distStack) - numLevels);
 }
@@ -6,6 +6,10 @@
 #include "../rmutil/vector.h"
 #include "trie.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
 * SparseAutomaton is a C implementation of a levenshtein automaton using
 * sparse vectors, as described and implemented here:
@@ -45,9 +49,6 @@ dfaNode *__dfn_getEdge(dfaNode *n, rune r);
 /* Create a new DFA node */
 dfaNode *__newDfaNode(int distance, sparseVector *state);
 
-/* Recusively build the DFA node and all its descendants */
-void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache);
-
 /* Create a new Sparse Levenshtein Automaton  for string s and length len, with a maximal edit
  * distance of maxEdits */
 SparseAutomaton NewSparseAutomaton(const rune *s, size_t len, int maxEdits);
@@ -64,14 +65,30 @@ int SparseAutomaton_IsMatch(SparseAutomaton *a, sparseVector *v);
 /* Can the current state lead to a possible match, or is this a dead end? */
 int SparseAutomaton_CanMatch(SparseAutomaton *a, sparseVector *v);
 
+/* The states of the DFA built for a string and a maximal distance. Once built they are only read,
+ * so the filters of the same string and distance share them, see NewDFAFilter() */
+typedef struct {
+    rune *str;
+    size_t len;
+    int maxDist;
+    // the states of the DFA, the first of which is the initial state
+    Vector *states;
+    // the filters using the automaton, plus one while it is cached
+    uint32_t refcount;
+} dfaAutomaton;
+
+// the number of fuzzy automata kept for reuse by later filters
+#define DFA_CACHE_SIZE 32
+
 /* DFAFilter is a constructed DFA used to filter the traversal on the trie */
 typedef struct {
-    // a cache of the DFA states, allowing us to re-use the same state whenever we need it
-    Vector *cache;
-    // A stack of the states leading up to the current state
-    Vector *stack;
+    // the states of the DFA, possibly shared with other filters
+    dfaAutomaton *automaton;
+    // A stack of the states leading up to the current state, an arr.h array as it changes with every
+    // rune the filter is fed
+    dfaNode **stack;
     // A stack of the minimal distance for each state, used for prefix matching
-    Vector *distStack;
+    int *distStack;
     // whether the filter works in prefix mode or not
     int prefixMode;
 
@@ -80,9 +97,21 @@ typedef struct {
 
 /* Create a new DFA filter  using a Levenshtein automaton, for the given string  and maximum
  * distance. If prefixMode is 1, we match prefixes within the given distance, and then continue
- * onwards to all suffixes. */
+ * onwards to all suffixes. The automata of fuzzy filters are cached by their string and distance,
+ * so that the filters of a term queried again, or looked up in several dictionaries, are not built
+ * again. The filter does not hold on to `str`. */
 DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode);
 
+/* Feed the next rune of a trie path to the filter, from the state `*state` which was reached with
+ * at least `*minDist` edits. On F_CONTINUE the state and distance are advanced. `matched` tells
+ * whether the path matches so far, in which case `dist` (if not NULL) is set to its distance */
+FilterCode DFAFilter_Step(const DFAFilter *fc, dfaNode **state, int *minDist, rune b, int *matched,
+                          int *dist);
+
+/* The fewest edits a match may have from the state `dn`, reached with at least `minDist` edits. The
+ * values of the automaton's states never decrease along a path */
+int DFAFilter_MinDistance(const dfaNode *dn, int minDist);
+
 /* A callback function for the DFA Filter, passed to the Trie iterator */
 FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx);
 
@@ -94,4 +123,7 @@ void StackPop(void *ctx, int numLevels);
  * is not freed by itself. */
 void DFAFilter_Free(DFAFilter *fc);
 
+#ifdef __cplusplus
+}
+#endif
 #endif
\ No newline at end of file
@@ -8,6 +8,10 @@
 #define MAX_RUNESTR_LEN 1024
 
 static uint32_t __fold(uint32_t runelike) {
+  // ASCII only folds from upper to lower case, which does not need the lookup
+  if (runelike < 0x80) {
+    return runelike >= 'A' && runelike <= 'Z' ? runelike + ('a' - 'A') : runelike;
+  }
   uint32_t lowered = 0;
   const char *map = 0;
   map = nu_tofold(runelike);
@@ -1,5 +1,6 @@
 #include <sys/param.h>
 #include "trie.h"
+#include "frozen_trie.h"
 #include "util/bsearch.h"
 #include "sparse_vector.h"
 #include "redisearch.h"
@@ -151,6 +152,7 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
     // node
     if (offset == len) {
       n->score = score;
+      n->maxChildScore = MAX(n->maxChildScore, score);
       n->flags |= TRIENODE_TERMINAL;
       TrieNode *newChild = __trieNode_children(n)[0];
       n = rm_realloc(n, __trieNode_Sizeof(n->numChildren, n->len));
@@ -189,6 +191,8 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
       default:
         n->score = score;
     }
+    // an incremented score may exceed the increment accounted for above
+    n->maxChildScore = MAX(n->maxChildScore, n->score);
     if (n->payload != NULL) {
       rm_free(n->payload);
       n->payload = NULL;
@@ -210,6 +214,7 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
     if (str[offset] == child->str[0]) {
       int rc = TrieNode_Add(&child, str + offset, len - offset, payload, score, op);
       __trieNode_children(n)[i] = child;
+      n->maxChildScore = MAX(n->maxChildScore, MAX(child->score, child->maxChildScore));
       return rc;
     }
   }
@@ -281,7 +286,7 @@ void __trieNode_optimizeChildren(TrieNode *n) {
       // just "fill" the hole with the next node up
       while (i < n->numChildren - 1) {
         nodes[i] = nodes[i + 1];
-        n->maxChildScore = MAX(n->maxChildScore, nodes[i]->maxChildScore);
+        n->maxChildScore = MAX(n->maxChildScore, MAX(nodes[i]->score, nodes[i]->maxChildScore));
         i++;
       }
       // reduce child count
@@ -293,7 +298,7 @@ void __trieNode_optimizeChildren(TrieNode *n) {
       if (nodes[i] && nodes[i]->numChildren == 1) {
         nodes[i] = __trieNode_MergeWithSingleChild(nodes[i]);
       }
-      n->maxChildScore = MAX(n->maxChildScore, nodes[i]->maxChildScore);
+      n->maxChildScore = MAX(n->maxChildScore, MAX(nodes[i]->score, nodes[i]->maxChildScore));
     }
     i++;
   }
@@ -515,6 +520,9 @@ TrieIterator *TrieNode_Iterate(TrieNode *n, StepFilter f, StackPopCallback pf, v
 }
 
 void TrieIterator_Free(TrieIterator *it) {
+  if (it->frozen) {
+    FrozenTrieIterator_Free(it->frozen);
+  }
   rm_free(it);
 }
 
@@ -544,6 +552,9 @@ int TrieIterator_Next(TrieIterator *it, rune **ptr, t_len *len, RSPayload *paylo
     }
   }
 
+  if (it->frozen) {
+    return FrozenTrieIterator_Next(it->frozen, ptr, len, payload, score, matchCtx);
+  }
   return 0;
 }
 
@@ -702,10 +713,11 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
   if (__trieNode_isTerminal(n)) {
     // current node is a termina.
     // if nmin or nmax is zero, it means that we find an exact match
-    // we should fire the callback only if exact match requested
-    if (r->includeMin && nmin == 0) {
-      r->callback(r->buf, array_len(r->buf), r->cbctx);
-    } else if (r->includeMax && nmax == 0) {
+    // we should fire the callback only if exact match requested. A positive nmin means the string
+    // is a prefix of min, thus less than it, while a positive nmax means it is less than max
+    bool minOk = nmin < 0 || (nmin == 0 && r->includeMin);
+    bool maxOk = nmax != 0 || r->includeMax;
+    if (minOk && maxOk) {
       r->callback(r->buf, array_len(r->buf), r->cbctx);
     }
   }
@@ -748,21 +760,19 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
     // we need to call recursively with the child contains this prefix
     TrieNode *child = arr[beginEqIdx];
 
+    // a child going past min is greater than it, and one going past max is greater than it
     const rune *nextMin = min + child->len;
     int nNextMin = nmin - child->len;
     if (nNextMin < 0) {
-      nNextMin = 0;
+      nNextMin = -1;
       nextMin = NULL;
     }
 
     const rune *nextMax = max + child->len;
     int nNextMax = nmax - child->len;
-    if (nNextMax < 0) {
-      nNextMax = 0;
-      nextMax = NULL;
+    if (nNextMax >= 0) {
+      rangeIterate(child, nextMin, nNextMin, nextMax, nNextMax, r);
     }
-
-    rangeIterate(child, nextMin, nNextMin, nextMax, nNextMax, r);
     goto clean_stack;
   }
 
@@ -775,7 +785,7 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
     const rune *nextMin = min + child->len;
     int nNextMin = nmin - child->len;
     if (nNextMin < 0) {
-      nNextMin = 0;
+      nNextMin = -1;
       nextMin = NULL;
     }
 
@@ -797,6 +807,14 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
     h.n = nmax;
     endIdx = rsb_lt(arr, arrlen, sizeof(*arr), &h, rsbCompareExact);
   }
+  // a child sharing its string with a prefix of a bound compares within the bounds, but its
+  // subtree may not be, and it is searched on its own
+  if (beginEqIdx != -1) {
+    beginIdx = MAX(beginIdx, beginEqIdx + 1);
+  }
+  if (endEqIdx != -1) {
+    endIdx = MIN(endIdx, endEqIdx - 1);
+  }
 
   // we need to iterate (without any checking) on all the subtree from beginIdx to endIdx
   for (int ii = beginIdx; ii <= endIdx; ++ii) {
@@ -811,12 +829,9 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
 
     const rune *nextMax = max + child->len;
     int nNextMax = nmax - child->len;
-    if (nNextMax < 0) {
-      nNextMax = 0;
-      nextMax = NULL;
+    if (nNextMax >= 0) {
+      rangeIterate(child, NULL, -1, nextMax, nNextMax, r);
     }
-
-    rangeIterate(child, NULL, -1, nextMax, nNextMax, r);
   }
 
 clean_stack:
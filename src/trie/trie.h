@@ -79,9 +79,9 @@ TrieNode *__newTrieNode(rune *str, t_len offset, t_len len, const char *payload,
 
 /* Get a pointer to the children array of a node. This is not an actual member
  * of the node for
- * memory saving reasons */
+ * memory saving reasons. The offset is added to a char pointer, so that it can be used from C++ */
 #define __trieNode_children(n) \
-  ((TrieNode **)((void *)n + sizeof(TrieNode) + (n->len + 1) * sizeof(rune)))
+  ((TrieNode **)((char *)(n) + sizeof(TrieNode) + ((n)->len + 1) * sizeof(rune)))
 
 #define __trieNode_isTerminal(n) (n->flags & TRIENODE_TERMINAL)
 
@@ -160,6 +160,8 @@ typedef struct TrieIterator {
   int nodesSkipped;
   StackPopCallback popCallback;
   void *ctx;
+  // the strings of the trie's frozen part, iterated once the nodes are done. May be NULL
+  struct FrozenTrieIterator *frozen;
 } TrieIterator;
 
 /* push a new trie iterator stack node  */
@@ -2,10 +2,12 @@
 #include "../rmutil/strings.h"
 #include "../rmutil/util.h"
 #include "../util/heap.h"
+#include "../util/arr.h"
 #include "../util/misc.h"
 #include "rune_util.h"
 
 #include "trie_type.h"
+#include "../config.h"
 #include <math.h>
 #include <sys/param.h>
 #include <time.h>
@@ -18,6 +20,8 @@ Trie *NewTrie() {
   rune *rs = strToRunes("", 0);
   tree->root = __newTrieNode(rs, 0, 0, NULL, 0, 0, 0, 0);
   tree->size = 0;
+  tree->frozen = NULL;
+  tree->revision = tree->idleRevision = 0;
   rm_free(rs);
   return tree;
 }
@@ -63,6 +67,35 @@ static inline void runeBufFree(runeBuf *buf) {
   }
 }
 
+/* Find a string in the frozen part of the trie, if there is one */
+static int trieFindFrozen(const Trie *t, const rune *runes, size_t len, size_t *idx) {
+  if (!t->frozen) {
+    return 0;
+  }
+  char str[FROZEN_TRIE_MAX_STRING];
+  size_t slen = FrozenTrie_EncodeRunes(runes, len, str);
+  return FrozenTrie_Find(t->frozen, str, slen, idx);
+}
+
+/* Insert a string which is in the frozen part. Its score is updated in place, but as the frozen
+ * part cannot change payloads, the string moves to the nodes when either it or the new one has a
+ * payload */
+static void trieUpdateFrozen(Trie *t, size_t idx, rune *runes, size_t len, float score, int incr,
+                             RSPayload *payload) {
+  FrozenTrie *ft = t->frozen;
+  if (incr) {
+    score += FrozenTrie_GetScore(ft, idx);
+  }
+  size_t plen;
+  if (!(payload && payload->data && payload->len) && !FrozenTrie_GetPayload(ft, idx, &plen)) {
+    FrozenTrie_SetScore(ft, idx, len, score);
+    return;
+  }
+  FrozenTrie_Delete(ft, idx);
+  TrieNode_Add(&t->root, runes, len, payload, score, ADD_REPLACE);
+  t->revision++;
+}
+
 int Trie_InsertStringBuffer(Trie *t, const char *s, size_t len, double score, int incr,
                             RSPayload *payload) {
   if (len > TRIE_INITIAL_STRING_LEN * sizeof(rune)) {
@@ -70,13 +103,17 @@ int Trie_InsertStringBuffer(Trie *t, const char *s, size_t len, double score, in
   }
   runeBuf buf;
   rune *runes = runeBufFill(s, len, &buf, &len);
-  int rc;
+  int rc = 0;
+  size_t idx;
 
   if (runes && len && len < TRIE_INITIAL_STRING_LEN) {
-    rc = TrieNode_Add(&t->root, runes, len, payload, (float)score, incr ? ADD_INCR : ADD_REPLACE);
-    t->size += rc;
-  } else {
-    rc = 0;
+    if (trieFindFrozen(t, runes, len, &idx)) {
+      trieUpdateFrozen(t, idx, runes, len, (float)score, incr, payload);
+    } else {
+      rc = TrieNode_Add(&t->root, runes, len, payload, (float)score, incr ? ADD_INCR : ADD_REPLACE);
+      t->size += rc;
+      t->revision += rc;
+    }
   }
 
   runeBufFree(&buf);
@@ -90,7 +127,13 @@ int Trie_Delete(Trie *t, const char *s, size_t len) {
     return 0;
   }
   int rc = TrieNode_Delete(t->root, runes, len);
+  size_t idx;
+  if (!rc && trieFindFrozen(t, runes, len, &idx)) {
+    FrozenTrie_Delete(t->frozen, idx);
+    rc = 1;
+  }
   t->size -= rc;
+  t->revision += rc;
   rm_free(runes);
   return rc;
 }
@@ -129,10 +172,190 @@ TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist,
   *fc = NewDFAFilter(runes, rlen, maxDist, prefixMode);
 
   TrieIterator *it = TrieNode_Iterate(t->root, FilterFunc, StackPop, fc);
+  if (t->frozen) {
+    it->frozen = FrozenTrie_Iterate(t->frozen, fc);
+  }
   rm_free(runes);
   return it;
 }
 
+void Trie_IterateRange(Trie *t, const rune *min, int nmin, bool includeMin, const rune *max,
+                       int nmax, bool includeMax, TrieRangeCallback callback, void *ctx) {
+  TrieNode_IterateRange(t->root, min, nmin, includeMin, max, nmax, includeMax, callback, ctx);
+  if (t->frozen) {
+    FrozenTrie_IterateRange(t->frozen, min, nmin, includeMin, max, nmax, includeMax, callback,
+                            ctx);
+  }
+}
+
+/* A subtree of the trie waiting to be visited by Trie_Search */
+typedef struct {
+  TrieNode *n;
+  // the greatest score an entry of the subtree may get
+  float bound;
+  // the state of the filter before the runes of the node
+  dfaNode *dfa;
+  int minDist;
+  // the visited node leading to this one, in the search path
+  int parent;
+  // the length of the string leading to the node
+  t_len depth;
+  // whether the string leading to the node is a prefix of the query
+  bool onExact;
+} trieSearchNode;
+
+/* A visited node with children, kept to spell out the strings of its descendants */
+typedef struct {
+  TrieNode *n;
+  int parent;
+} trieSearchStep;
+
+/* Push a subtree to the frontier, a max-heap of subtrees by their bound */
+static trieSearchNode *frontierPush(trieSearchNode *frontier, trieSearchNode node) {
+  frontier = array_append(frontier, node);
+  size_t ii = array_len(frontier) - 1;
+  while (ii > 0 && frontier[(ii - 1) / 2].bound < node.bound) {
+    frontier[ii] = frontier[(ii - 1) / 2];
+    ii = (ii - 1) / 2;
+  }
+  frontier[ii] = node;
+  return frontier;
+}
+
+static trieSearchNode frontierPop(trieSearchNode *frontier) {
+  trieSearchNode top = frontier[0];
+  trieSearchNode last = array_pop(frontier);
+  size_t n = array_len(frontier);
+  if (!n) {
+    return top;
+  }
+  size_t ii = 0;
+  while (2 * ii + 1 < n) {
+    size_t child = 2 * ii + 1;
+    if (child + 1 < n && frontier[child + 1].bound > frontier[child].bound) {
+      ++child;
+    }
+    if (frontier[child].bound <= last.bound) {
+      break;
+    }
+    frontier[ii] = frontier[child];
+    ii = child;
+  }
+  frontier[ii] = last;
+  return top;
+}
+
+/* The string of the node `n`, whose ancestors start at `parent` in the search path */
+static char *trieSearchString(const trieSearchStep *path, int parent, const TrieNode *n, t_len len,
+                              size_t *slen) {
+  rune buf[len + 1];
+  t_len offset = len - n->len;
+  memcpy(buf + offset, n->str, n->len * sizeof(rune));
+  for (int ii = parent; ii >= 0; ii = path[ii].parent) {
+    const TrieNode *p = path[ii].n;
+    offset -= p->len;
+    memcpy(buf + offset, p->str, p->len * sizeof(rune));
+  }
+  return runesToStr(buf, len, slen);
+}
+
+/* Factor the distance of a match, and in prefix mode its length, into its score */
+static float trieSearchScore(float score, int dist, size_t slen, size_t len, int maxDist,
+                             int prefixMode) {
+  if (maxDist > 0) {
+    score *= exp((double)-(2 * dist));
+  }
+  if (prefixMode) {
+    score /= sqrt(1 + (slen >= len ? slen - len : len - slen));
+  }
+  return score;
+}
+
+/* Get an entry to fill for a result with the given score, or NULL if it does not make it to the
+ * results. The entry is then put in the results with trieSearchOffer() */
+static TrieSearchResult *trieSearchSlot(heap_t *pq, float score, float minScore) {
+  if (heap_count(pq) < heap_size(pq)) {
+    return rm_malloc(sizeof(TrieSearchResult));
+  } else if (score > minScore) {
+    TrieSearchResult *ent = heap_poll(pq);
+    rm_free(ent->str);
+    return ent;
+  }
+  return NULL;
+}
+
+/* Put a filled entry in the results, returning the score a result now needs to make it there */
+static float trieSearchOffer(heap_t *pq, TrieSearchResult *ent, float minScore) {
+  heap_offerx(pq, ent);
+  if (heap_count(pq) == heap_size(pq)) {
+    minScore = ((TrieSearchResult *)heap_peek(pq))->score;
+  }
+  return minScore;
+}
+
+typedef struct {
+  heap_t *pq;
+  const rune *runes;
+  size_t rlen;
+  size_t len;
+  int maxDist;
+  int prefixMode;
+  float minScore;
+} trieSearchFrozenCtx;
+
+static float trieSearchFrozenScore(float score, int dist, size_t minLen, size_t maxLen, void *ctx) {
+  trieSearchFrozenCtx *sc = ctx;
+  // the length factor is the greatest for the length closest to the query's
+  size_t slen = MIN(MAX(sc->len, minLen), maxLen);
+  return trieSearchScore(score, dist, slen, sc->len, sc->maxDist, sc->prefixMode);
+}
+
+static float trieSearchFrozenCollect(const rune *str, t_len len, float score,
+                                     const RSPayload *payload, void *ctx) {
+  trieSearchFrozenCtx *sc = ctx;
+  // the query itself was already put first
+  if (len != sc->rlen || memcmp(str, sc->runes, len * sizeof(rune))) {
+    TrieSearchResult *ent = trieSearchSlot(sc->pq, score, sc->minScore);
+    if (ent) {
+      ent->score = score;
+      ent->str = runesToStr(str, len, &ent->len);
+      ent->payload = payload->data;
+      ent->plen = payload->len;
+      sc->minScore = trieSearchOffer(sc->pq, ent, sc->minScore);
+    }
+  }
+  return heap_count(sc->pq) == heap_size(sc->pq) ? sc->minScore : -INFINITY;
+}
+
+/* Search the frozen part of the trie for the results which beat those found in the nodes */
+static void trieSearchFrozen(const FrozenTrie *ft, const DFAFilter *fc, const rune *runes,
+                             size_t rlen, size_t len, int maxDist, int prefixMode, heap_t *pq,
+                             float minScore) {
+  // the query itself comes first whatever its score, so it is looked up rather than searched
+  char str[FROZEN_TRIE_MAX_STRING];
+  size_t idx;
+  if (FrozenTrie_Find(ft, str, FrozenTrie_EncodeRunes(runes, rlen, str), &idx)) {
+    float score = trieSearchScore(INT_MAX, 0, rlen, len, maxDist, prefixMode);
+    TrieSearchResult *ent = trieSearchSlot(pq, score, minScore);
+    if (ent) {
+      ent->score = score;
+      ent->str = runesToStr(runes, rlen, &ent->len);
+      ent->payload = (char *)FrozenTrie_GetPayload(ft, idx, &ent->plen);
+      minScore = trieSearchOffer(pq, ent, minScore);
+    }
+  }
+
+  trieSearchFrozenCtx ctx = {.pq = pq,
+                             .runes = runes,
+                             .rlen = rlen,
+                             .len = len,
+                             .maxDist = maxDist,
+                             .prefixMode = prefixMode,
+                             .minScore = minScore};
+  FrozenTrie_Search(ft, fc, trieSearchFrozenScore, trieSearchFrozenCollect,
+                    heap_count(pq) == heap_size(pq) ? minScore : -INFINITY, &ctx);
+}
+
 Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
                     int trim, int optimize) {
 
@@ -151,81 +374,91 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
   heap_init(pq, cmpEntries, NULL, num);
 
   DFAFilter fc = NewDFAFilter(runes, rlen, maxDist, prefixMode);
-
-  TrieIterator *it = TrieNode_Iterate(tree->root, FilterFunc, StackPop, &fc);
-  // TrieIterator *it = TrieNode_Iterate(tree->root,NULL, NULL, NULL);
-  rune *rstr;
-  t_len slen;
-  float score;
-  RSPayload payload = {.data = NULL, .len = 0};
-
-  TrieSearchResult *pooledEntry = NULL;
-  int dist = maxDist + 1;
-  while (TrieIterator_Next(it, &rstr, &slen, &payload, &score, &dist)) {
-    if (pooledEntry == NULL) {
-      pooledEntry = rm_malloc(sizeof(TrieSearchResult));
-      pooledEntry->str = NULL;
-      pooledEntry->payload = NULL;
-      pooledEntry->plen = 0;
+  trieSearchNode root = {.n = tree->root, .bound = INT_MAX, .parent = -1, .onExact = true};
+  root.dfa = fc.stack[0];
+  root.minDist = fc.distStack[0];
+
+  // Subtrees are visited best first, by the greatest score their entries may get, until none of
+  // them can beat the results found so far. The distance and length factors below only ever lower
+  // the score of an entry, except for the query itself, which always comes first
+  trieSearchNode *frontier = array_new(trieSearchNode, 16);
+  trieSearchStep *path = array_new(trieSearchStep, 16);
+  frontier = frontierPush(frontier, root);
+  float minScore = 0;
+
+  while (num && array_len(frontier)) {
+    trieSearchNode cur = frontierPop(frontier);
+    if (heap_count(pq) == heap_size(pq) && cur.bound <= minScore) {
+      break;
     }
-    TrieSearchResult *ent = pooledEntry;
-
-    ent->score = slen > 0 && slen == rlen && memcmp(runes, rstr, slen) == 0 ? INT_MAX : score;
 
-    if (maxDist > 0) {
-      // factor the distance into the score
-      ent->score *= exp((double)-(2 * dist));
+    TrieNode *n = cur.n;
+    bool onExact = cur.onExact;
+    int matched = 0;
+    int dist = maxDist + 1;
+    t_len ii = 0;
+    for (; ii < n->len; ++ii) {
+      dist = cur.minDist;
+      if (DFAFilter_Step(&fc, &cur.dfa, &cur.minDist, n->str[ii], &matched, &dist) == F_STOP) {
+        break;
+      }
+      onExact = onExact && cur.depth + ii < rlen && n->str[ii] == runes[cur.depth + ii];
     }
-    // in prefix mode we also factor in the total length of the suffix
-    if (prefixMode) {
-      ent->score /= sqrt(1 + (slen >= len ? slen - len : len - slen));
+    if (ii < n->len) {
+      continue;
     }
-
-    if (heap_count(pq) < heap_size(pq)) {
-      ent->str = runesToStr(rstr, slen, &ent->len);
-      ent->payload = payload.data;
-      ent->plen = payload.len;
-      heap_offerx(pq, ent);
-      pooledEntry = NULL;
-
-      if (heap_count(pq) == heap_size(pq)) {
-        TrieSearchResult *qe = heap_peek(pq);
-        it->minScore = qe->score;
+    t_len slen = cur.depth + n->len;
+
+    if (matched && n->len > 0 && __trieNode_isTerminal(n) && !__trieNode_isDeleted(n)) {
+      float score = trieSearchScore(onExact && slen == rlen ? INT_MAX : n->score, dist, slen, len,
+                                    maxDist, prefixMode);
+      TrieSearchResult *ent = trieSearchSlot(pq, score, minScore);
+      if (ent) {
+        ent->score = score;
+        ent->str = trieSearchString(path, cur.parent, n, slen, &ent->len);
+        ent->payload = n->payload ? n->payload->data : NULL;
+        ent->plen = n->payload ? n->payload->len : 0;
+        minScore = trieSearchOffer(pq, ent, minScore);
       }
+    }
 
-    } else {
-      if (ent->score > it->minScore) {
-        pooledEntry = heap_poll(pq);
-        rm_free(pooledEntry->str);
-        pooledEntry->str = NULL;
-        ent->str = runesToStr(rstr, slen, &ent->len);
-        ent->payload = payload.data;
-        ent->plen = payload.len;
-        heap_offerx(pq, ent);
-
-        // get the new minimal score
-        TrieSearchResult *qe = heap_peek(pq);
-        if (qe->score > it->minScore) {
-          it->minScore = qe->score;
+    if (!n->numChildren) {
+      continue;
+    }
+    path = array_append(path, ((trieSearchStep){.n = n, .parent = cur.parent}));
+    int self = array_len(path) - 1;
+    double distFactor = maxDist > 0 ? exp((double)-(2 * DFAFilter_MinDistance(cur.dfa, cur.minDist))) : 1;
+    for (t_len jj = 0; jj < n->numChildren; ++jj) {
+      TrieNode *ch = __trieNode_children(n)[jj];
+      bool childExact = onExact && slen < rlen && ch->len && ch->str[0] == runes[slen];
+      float bound = INT_MAX;
+      if (!childExact) {
+        bound = MAX(ch->maxChildScore, ch->score) * distFactor;
+        // the strings of the subtree are at least as long as the child's
+        size_t minLen = slen + ch->len;
+        if (prefixMode && minLen > len) {
+          bound /= sqrt(1 + minLen - len);
         }
-
-      } else {
-        pooledEntry = ent;
       }
+      if (heap_count(pq) == heap_size(pq) && bound <= minScore) {
+        continue;
+      }
+      frontier = frontierPush(frontier, (trieSearchNode){.n = ch,
+                                                         .bound = bound,
+                                                         .dfa = cur.dfa,
+                                                         .minDist = cur.minDist,
+                                                         .parent = self,
+                                                         .depth = slen,
+                                                         .onExact = childExact});
     }
-
-    // dist = maxDist + 3;
   }
+  array_free(frontier);
+  array_free(path);
 
-  if (pooledEntry) {
-    TrieSearchResult_Free(pooledEntry);
+  if (num && tree->frozen) {
+    trieSearchFrozen(tree->frozen, &fc, runes, rlen, len, maxDist, prefixMode, pq, minScore);
   }
 
-  // printf("Nodes consumed: %d/%d (%.02f%%)\n", it->nodesConsumed,
-  //        it->nodesConsumed + it->nodesSkipped,
-  //        100.0 * (float)(it->nodesConsumed) / (float)(it->nodesConsumed +
-  //        it->nodesSkipped));
-
   // put the results from the heap on a vector to return
   size_t n = MIN(heap_count(pq), num);
   Vector *ret = NewVector(TrieSearchResult *, n);
@@ -243,32 +476,50 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
       Vector_Get(ret, i, &h);
 
       if (maxScore && h->score < maxScore / SCORE_TRIM_FACTOR) {
-        // TODO: Fix trimming the vector
-        ret->top = i;
         break;
       }
       maxScore = MAX(maxScore, h->score);
     }
 
-    for (; i < n; ++i) {
+    // free the trimmed results before they are out of the vector's reach
+    for (int j = i; j < n; ++j) {
       TrieSearchResult *h;
-      Vector_Get(ret, i, &h);
+      Vector_Get(ret, j, &h);
       TrieSearchResult_Free(h);
     }
+    ret->top = i;
   }
 
   rm_free(runes);
-  TrieIterator_Free(it);
   DFAFilter_Free(&fc);
   heap_free(pq);
 
   return ret;
 }
 
+/* Get a random string of the frozen part, which has at least one that is not deleted */
+static void frozenRandomKey(const FrozenTrie *ft, char **str, t_len *len, double *score) {
+  size_t idx = rand() % ft->size;
+  while (FrozenTrie_IsDeleted(ft, idx)) {
+    idx = (idx + 1) % ft->size;
+  }
+  char buf[FROZEN_TRIE_MAX_STRING];
+  size_t slen = FrozenTrie_GetString(ft, idx, buf);
+  *str = rm_strndup(buf, slen);
+  *len = slen;
+  *score = FrozenTrie_GetScore(ft, idx);
+}
+
 int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score) {
   if (t->size == 0) {
     return 0;
   }
+  // pick a part in proportion to the number of strings it has
+  size_t numFrozen = t->frozen ? FrozenTrie_NumLive(t->frozen) : 0;
+  if (numFrozen && rand() % t->size < numFrozen) {
+    frozenRandomKey(t->frozen, str, len, score);
+    return 1;
+  }
 
   rune *rstr;
   t_len rlen;
@@ -288,6 +539,98 @@ int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score) {
   return 1;
 }
 
+/* A string of the nodes, collected to be frozen */
+typedef struct {
+  // the string's offset in the collected strings, which may move until they are all in
+  size_t offset;
+  const char *str;
+  size_t len;
+  float score;
+  const char *payload;
+  size_t plen;
+} trieFreezeEntry;
+
+static int cmpFreezeEntries(const void *p1, const void *p2) {
+  const trieFreezeEntry *e1 = p1, *e2 = p2;
+  return FrozenTrie_CmpStrings(e1->str, e1->len, e2->str, e2->len);
+}
+
+void Trie_Freeze(Trie *t) {
+  // collect the strings of the nodes, as UTF-8
+  trieFreezeEntry *entries = array_new(trieFreezeEntry, 16);
+  Buffer strs;
+  Buffer_Init(&strs, 1024);
+  BufferWriter bw = NewBufferWriter(&strs);
+  TrieIterator *it = TrieNode_Iterate(t->root, NULL, NULL, NULL);
+  rune *rstr;
+  t_len rlen;
+  float score;
+  RSPayload payload = {.data = NULL, .len = 0};
+  while (TrieIterator_Next(it, &rstr, &rlen, &payload, &score, NULL)) {
+    char str[FROZEN_TRIE_MAX_STRING];
+    trieFreezeEntry e = {.offset = Buffer_Offset(&strs),
+                         .len = FrozenTrie_EncodeRunes(rstr, rlen, str),
+                         .score = score,
+                         .payload = payload.data,
+                         .plen = payload.len};
+    Buffer_Write(&bw, str, e.len);
+    entries = array_append(entries, e);
+  }
+  TrieIterator_Free(it);
+  size_t n = array_len(entries);
+  for (size_t ii = 0; ii < n; ++ii) {
+    entries[ii].str = strs.data + entries[ii].offset;
+  }
+  qsort(entries, n, sizeof(*entries), cmpFreezeEntries);
+
+  // merge them with the strings frozen before
+  FrozenTrie *old = t->frozen;
+  FrozenTrie *ft = NewFrozenTrie();
+  FrozenTrieCursor c;
+  int ok = old && FrozenTrieCursor_Init(&c, old);
+  size_t ii = 0;
+  while (ok || ii < n) {
+    if (ok && FrozenTrie_IsDeleted(old, c.idx)) {
+      ok = FrozenTrieCursor_Next(&c);
+    } else if (ii < n &&
+               (!ok || FrozenTrie_CmpStrings(entries[ii].str, entries[ii].len, c.str, c.len) < 0)) {
+      const trieFreezeEntry *e = &entries[ii++];
+      FrozenTrie_Append(ft, e->str, e->len, e->score, e->payload, e->plen);
+    } else {
+      size_t plen;
+      const char *p = FrozenTrie_GetPayload(old, c.idx, &plen);
+      FrozenTrie_Append(ft, c.str, c.len, FrozenTrie_GetScore(old, c.idx), p, plen);
+      ok = FrozenTrieCursor_Next(&c);
+    }
+  }
+  FrozenTrie_Seal(ft);
+  array_free(entries);
+  Buffer_Free(&strs);
+
+  if (old) {
+    FrozenTrie_Free(old);
+  }
+  t->frozen = ft->size ? ft : NULL;
+  if (!ft->size) {
+    FrozenTrie_Free(ft);
+  }
+  TrieNode_Free(t->root);
+  rune *rs = strToRunes("", 0);
+  t->root = __newTrieNode(rs, 0, 0, NULL, 0, 0, 0, 0);
+  rm_free(rs);
+}
+
+int Trie_FreezeIfIdle(Trie *t, size_t minSize) {
+  int idle = t->revision == t->idleRevision;
+  t->idleRevision = t->revision;
+  size_t numFrozen = t->frozen ? FrozenTrie_NumLive(t->frozen) : 0;
+  if (!idle || !minSize || t->size - numFrozen < minSize) {
+    return 0;
+  }
+  Trie_Freeze(t);
+  return 1;
+}
+
 /***************************************************************
  *
  *                       Trie type methods
@@ -322,6 +665,9 @@ void *TrieType_GenericLoad(RedisModuleIO *rdb, int loadPayloads) {
     RedisModule_Free(str);
     if (payload.data != NULL) RedisModule_Free(payload.data);
   }
+  if (RSGlobalConfig.trieFreezeThreshold && tree->size >= RSGlobalConfig.trieFreezeThreshold) {
+    Trie_Freeze(tree);
+  }
   // TrieNode_Print(tree->root, 0, 0);
   return tree;
 }
@@ -330,6 +676,23 @@ void TrieType_RdbSave(RedisModuleIO *rdb, void *value) {
   TrieType_GenericSave(rdb, (Trie *)value, 1);
 }
 
+static void trieSaveEntry(RedisModuleIO *rdb, const char *s, size_t slen, float score,
+                          const char *payload, size_t plen, int savePayloads) {
+  RedisModule_SaveStringBuffer(rdb, s, slen + 1);
+  RedisModule_SaveDouble(rdb, (double)score);
+
+  if (savePayloads) {
+    // save an extra space for the null terminator to make the payload null terminated on load
+    if (payload != NULL && plen > 0) {
+      RedisModule_SaveStringBuffer(rdb, payload, plen + 1);
+    } else {
+      // If there's no payload - we save an empty string
+      RedisModule_SaveStringBuffer(rdb, "", 1);
+    }
+  }
+  // TODO: Save a marker for empty payload!
+}
+
 void TrieType_GenericSave(RedisModuleIO *rdb, Trie *tree, int savePayloads) {
   RedisModule_SaveUnsigned(rdb, tree->size);
   RedisModuleCtx *ctx = RedisModule_GetContextFromIO(rdb);
@@ -345,28 +708,32 @@ void TrieType_GenericSave(RedisModuleIO *rdb, Trie *tree, int savePayloads) {
     while (TrieIterator_Next(it, &rstr, &len, &payload, &score, NULL)) {
       size_t slen = 0;
       char *s = runesToStr(rstr, len, &slen);
-      RedisModule_SaveStringBuffer(rdb, s, slen + 1);
-      RedisModule_SaveDouble(rdb, (double)score);
-
-      if (savePayloads) {
-        // save an extra space for the null terminator to make the payload null terminated on load
-        if (payload.data != NULL && payload.len > 0) {
-          RedisModule_SaveStringBuffer(rdb, payload.data, payload.len + 1);
-        } else {
-          // If there's no payload - we save an empty string
-          RedisModule_SaveStringBuffer(rdb, "", 1);
-        }
-      }
-      // TODO: Save a marker for empty payload!
+      trieSaveEntry(rdb, s, slen, score, payload.data, payload.len, savePayloads);
       rm_free(s);
       count++;
     }
-    if (count != tree->size) {
-      RedisModule_Log(ctx, "warning", "Trie: saving %zd nodes actually iterated only %d nodes",
-                      tree->size, count);
-    }
     TrieIterator_Free(it);
   }
+  if (tree->frozen) {
+    const FrozenTrie *ft = tree->frozen;
+    FrozenTrieCursor c;
+    for (int ok = FrozenTrieCursor_Init(&c, ft); ok; ok = FrozenTrieCursor_Next(&c)) {
+      if (FrozenTrie_IsDeleted(ft, c.idx)) {
+        continue;
+      }
+      // the cursor keeps room past the longest string
+      c.str[c.len] = '\0';
+      size_t plen;
+      const char *payload = FrozenTrie_GetPayload(ft, c.idx, &plen);
+      trieSaveEntry(rdb, c.str, c.len, FrozenTrie_GetScore(ft, c.idx), payload, plen,
+                    savePayloads);
+      count++;
+    }
+  }
+  if (count != tree->size) {
+    RedisModule_Log(ctx, "warning", "Trie: saving %zd nodes actually iterated only %d nodes",
+                    tree->size, count);
+  }
 }
 
 void TrieType_Digest(RedisModuleDigest *digest, void *value) {
@@ -379,6 +746,9 @@ void TrieType_Free(void *value) {
 
     TrieNode_Free(tree->root);
   }
+  if (tree->frozen) {
+    FrozenTrie_Free(tree->frozen);
+  }
 
   rm_free(tree);
 }
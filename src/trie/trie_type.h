@@ -4,6 +4,7 @@
 #include "../redismodule.h"
 
 #include "trie.h"
+#include "frozen_trie.h"
 #include "levenshtein.h"
 
 #ifdef __cplusplus
@@ -17,7 +18,14 @@ extern RedisModuleType *TrieType;
 
 typedef struct {
   TrieNode *root;
+  // the number of strings, in the nodes and the frozen part
   size_t size;
+  // the strings moved out of the nodes by Trie_Freeze(), or NULL. A string is never in both
+  FrozenTrie *frozen;
+  // bumped whenever a string is added to the nodes or deleted
+  uint32_t revision;
+  // the revision seen by the last call to Trie_FreezeIfIdle()
+  uint32_t idleRevision;
 } Trie;
 
 typedef struct {
@@ -46,6 +54,20 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
  * Otherwise we return an iterator to all strings within maxDist Levenshtein distance */
 TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist, int prefixMode);
 
+/* Iterate the strings within a lexical range. Strings in the nodes come first, and those of the
+ * frozen part after them, so the callback is not called in lexical order. The bounds follow
+ * TrieNode_IterateRange() */
+void Trie_IterateRange(Trie *t, const rune *min, int nmin, bool includeMin, const rune *max,
+                       int nmax, bool includeMax, TrieRangeCallback callback, void *ctx);
+
+/* Move all the strings of the trie to its frozen part, which takes a fraction of the memory of the
+ * nodes, leaving the nodes empty for the strings added from now on */
+void Trie_Freeze(Trie *t);
+
+/* Freeze the trie if its nodes hold at least `minSize` strings, and no string was added or deleted
+ * since the previous call, so that a trie is only frozen once it settles. Returns 1 if it was */
+int Trie_FreezeIfIdle(Trie *t, size_t minSize);
+
 /* Get a random key from the trie, and put the node's score in the score pointer. Returns 0 if the
  * trie is empty and we cannot do that */
 int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score);
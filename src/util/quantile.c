@@ -249,6 +249,35 @@ void QS_Insert(QuantStream *stream, double val) {
   }
 }
 
+void QS_Merge(QuantStream *dst, const QuantStream *src) {
+  // Interleave the samples of both streams by value. A sample's rank is now also uncertain by the
+  // gap between the two samples of the other stream around it, which is added to its delta
+  Sample *pos = dst->firstSample;
+  for (const Sample *cur = src->firstSample; cur; cur = cur->next) {
+    while (pos && pos->v <= cur->v) {
+      pos->d += fmax(cur->g + cur->d - 1, 0);
+      pos = pos->next;
+    }
+    Sample *newSample = QS_NewSample(dst);
+    newSample->v = cur->v;
+    newSample->g = cur->g;
+    if (pos) {
+      newSample->d = cur->d + fmax(pos->g + pos->d - 1, 0);
+      QS_InsertSampleAt(dst, pos, newSample);
+    } else {
+      newSample->d = cur->d;
+      QS_AppendSample(dst, newSample);
+    }
+  }
+  dst->n += src->n;
+
+  // the values which were not flushed yet are inserted as they are
+  for (size_t ii = 0; ii < src->bufferLength; ++ii) {
+    QS_Insert(dst, src->buffer[ii]);
+  }
+  QS_Compress(dst);
+}
+
 double QS_Query(QuantStream *stream, double q) {
   if (stream->bufferLength) {
     QS_Flush(stream);
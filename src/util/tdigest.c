@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <math.h>
+#include "tdigest.h"
+#include "rmalloc.h"
+
+typedef struct {
+  double mean;
+  double weight;
+} Centroid;
+
+struct TDigest {
+  double compression;
+  double min;
+  double max;
+  // Total weight of the centroids and the buffered values
+  double weight;
+
+  // The first `ncentroids` entries are merged centroids, sorted by their means. They are followed
+  // by `nbuffered` values which were not merged yet
+  Centroid *centroids;
+  // Room the centroids are merged into, swapped with `centroids` on every merge
+  Centroid *scratch;
+  size_t ncentroids;
+  size_t nbuffered;
+  size_t cap;
+};
+
+/* Sort centroids by their means. This is called for every buffer of values, where qsort() spends
+ * most of its time calling the comparison function */
+static void centroidSort(Centroid *c, size_t n) {
+  while (n > 16) {
+    double pivot = c[n / 2].mean;
+    size_t lo = 0, hi = n - 1;
+    for (;;) {
+      while (c[lo].mean < pivot) ++lo;
+      while (c[hi].mean > pivot) --hi;
+      if (lo >= hi) break;
+      Centroid tmp = c[lo];
+      c[lo++] = c[hi];
+      c[hi--] = tmp;
+    }
+    // recurse into the smaller part, and loop over the larger one
+    if (hi + 1 < n - hi - 1) {
+      centroidSort(c, hi + 1);
+      c += hi + 1;
+      n -= hi + 1;
+    } else {
+      centroidSort(c + hi + 1, n - hi - 1);
+      n = hi + 1;
+    }
+  }
+  for (size_t ii = 1; ii < n; ++ii) {
+    Centroid cur = c[ii];
+    size_t jj = ii;
+    for (; jj > 0 && c[jj - 1].mean > cur.mean; --jj) {
+      c[jj] = c[jj - 1];
+    }
+    c[jj] = cur;
+  }
+}
+
+/* The greatest quantile a centroid starting at quantile `q` may span to. This is the k1 scale
+ * function of the paper, limiting every centroid to a unit of k = compression/2pi * asin(2q-1) */
+static double tdQuantileLimit(const TDigest *td, double q) {
+  double k = td->compression / (2 * M_PI) * asin(2 * q - 1) + 1;
+  if (k >= td->compression / 4) {
+    return 1;
+  }
+  return (sin(k * 2 * M_PI / td->compression) + 1) / 2;
+}
+
+/* Merge the buffered values into the centroids */
+static void tdCompress(TDigest *td) {
+  if (!td->nbuffered) {
+    return;
+  }
+  // Only the buffer needs sorting, and it is then merged with the sorted centroids
+  Centroid *c = td->centroids, *buf = c + td->ncentroids;
+  centroidSort(buf, td->nbuffered);
+  size_t n = 0;
+  for (size_t ii = 0, jj = 0; ii < td->ncentroids || jj < td->nbuffered;) {
+    if (jj == td->nbuffered || (ii < td->ncentroids && c[ii].mean <= buf[jj].mean)) {
+      td->scratch[n++] = c[ii++];
+    } else {
+      td->scratch[n++] = buf[jj++];
+    }
+  }
+
+  c = td->scratch;
+  size_t out = 0;
+  double before = 0;
+  double limit = tdQuantileLimit(td, 0);
+  for (size_t ii = 1; ii < n; ++ii) {
+    if ((before + c[out].weight + c[ii].weight) / td->weight <= limit) {
+      c[out].weight += c[ii].weight;
+      c[out].mean += (c[ii].mean - c[out].mean) * c[ii].weight / c[out].weight;
+    } else {
+      before += c[out].weight;
+      limit = tdQuantileLimit(td, before / td->weight);
+      c[++out] = c[ii];
+    }
+  }
+  td->scratch = td->centroids;
+  td->centroids = c;
+  td->ncentroids = out + 1;
+  td->nbuffered = 0;
+}
+
+static void tdAddWeighted(TDigest *td, double mean, double weight) {
+  if (td->ncentroids + td->nbuffered == td->cap) {
+    tdCompress(td);
+  }
+  if (!td->weight || mean < td->min) {
+    td->min = mean;
+  }
+  if (!td->weight || mean > td->max) {
+    td->max = mean;
+  }
+  td->centroids[td->ncentroids + td->nbuffered++] = (Centroid){.mean = mean, .weight = weight};
+  td->weight += weight;
+}
+
+TDigest *NewTDigest(size_t compression) {
+  TDigest *td = rm_calloc(1, sizeof(*td));
+  td->compression = compression;
+  // The k1 scale function keeps at most about `compression` centroids, the rest of the room is
+  // left to the buffer
+  td->cap = 6 * compression + 10;
+  td->centroids = rm_malloc(td->cap * sizeof(*td->centroids));
+  td->scratch = rm_malloc(td->cap * sizeof(*td->scratch));
+  return td;
+}
+
+void TD_Add(TDigest *td, double val) {
+  tdAddWeighted(td, val, 1);
+}
+
+void TD_Merge(TDigest *dst, const TDigest *src) {
+  for (size_t ii = 0; ii < src->ncentroids + src->nbuffered; ++ii) {
+    tdAddWeighted(dst, src->centroids[ii].mean, src->centroids[ii].weight);
+  }
+  if (src->weight) {
+    dst->min = src->min < dst->min ? src->min : dst->min;
+    dst->max = src->max > dst->max ? src->max : dst->max;
+  }
+}
+
+double TD_Quantile(TDigest *td, double q) {
+  tdCompress(td);
+  const Centroid *c = td->centroids;
+  size_t n = td->ncentroids;
+  if (!n) {
+    return 0;
+  } else if (n == 1 || q <= 0) {
+    return q <= 0 ? td->min : c[0].mean;
+  } else if (q >= 1) {
+    return td->max;
+  }
+
+  // Each centroid's mean is taken to be at the middle of its weight, and values between the
+  // middles are interpolated. The extremes are interpolated towards the minimum and maximum
+  double index = q * td->weight;
+  if (index < c[0].weight / 2) {
+    return td->min + (c[0].mean - td->min) * index / (c[0].weight / 2);
+  }
+  double after = td->weight - index;
+  if (after < c[n - 1].weight / 2) {
+    return td->max - (td->max - c[n - 1].mean) * after / (c[n - 1].weight / 2);
+  }
+
+  double before = c[0].weight / 2;
+  for (size_t ii = 0; ii < n - 1; ++ii) {
+    double span = (c[ii].weight + c[ii + 1].weight) / 2;
+    if (before + span > index) {
+      return c[ii].mean + (c[ii + 1].mean - c[ii].mean) * (index - before) / span;
+    }
+    before += span;
+  }
+  return c[n - 1].mean;
+}
+
+size_t TD_GetCount(const TDigest *td) {
+  return (size_t)td->weight;
+}
+
+void TD_Free(TDigest *td) {
+  rm_free(td->centroids);
+  rm_free(td->scratch);
+  rm_free(td);
+}
@@ -0,0 +1,25 @@
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <stdlib.h>
+
+/**
+ * A merging t-digest (Dunning & Ertl): the values are summarized by weighted centroids, which are
+ * small near the tails of the distribution and larger around its median. The digest takes a
+ * fixed amount of memory, determined by its compression, and values are buffered and merged into
+ * the centroids when the buffer fills up. Two digests can be merged into one.
+ */
+typedef struct TDigest TDigest;
+
+#define TDIGEST_DEFAULT_COMPRESSION 100
+
+TDigest *NewTDigest(size_t compression);
+void TD_Add(TDigest *td, double val);
+/* Estimate the value at the quantile `q`, between 0 and 1. An empty digest yields 0 */
+double TD_Quantile(TDigest *td, double q);
+/* Add the values summarized by `src` to `dst`. `src` is left unchanged */
+void TD_Merge(TDigest *dst, const TDigest *src);
+size_t TD_GetCount(const TDigest *td);
+void TD_Free(TDigest *td);
+
+#endif
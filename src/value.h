@@ -13,6 +13,7 @@
 #include "rmutil/args.h"
 #include "rmalloc.h"
 #include "query_error.h"
+#include "config.h"
 #include "rmutil/rm_assert.h"
 
 #ifdef __cplusplus
@@ -90,14 +91,23 @@ typedef struct RSValue {
     // reference to another value
     struct RSValue *ref;
   };
-  RSValueType t : 8;
-  uint32_t refcount : 23;
-  uint8_t allocated : 1;
+  union {
+    struct {
+      RSValueType t : 8;
+      uint32_t refcount : 23;
+      uint8_t allocated : 1;
+    };
+    // the above as a single word, so that the refcount can be changed atomically. Values are
+    // shared by queries running concurrently, e.g. the index's sortable values
+    uint32_t flagsWord;
+  };
 
 #ifdef __cplusplus
   RSValue() {
   }
-  RSValue(RSValueType t_) : ref(NULL), t(t_), refcount(0), allocated(0) {
+  RSValue(RSValueType t_) : ref(NULL) {
+    flagsWord = 0;
+    t = t_;
   }
 
 #endif
@@ -114,14 +124,38 @@ void RSValue_Clear(RSValue *v);
  * the actual value object */
 void RSValue_Free(RSValue *v);
 
+/* The value of a refcount of 1 in the flags word */
+static inline uint32_t RSValue_RefcountUnit(void) {
+  RSValue v;
+  v.flagsWord = 0;
+  v.refcount = 1;
+  return v.flagsWord;
+}
+
+/* Values are only shared between threads by queries running without the GIL, so the refcount is
+ * only updated atomically in concurrent read mode, which cannot change after the module loads */
 static inline RSValue *RSValue_IncrRef(RSValue *v) {
-  ++v->refcount;
+  if (RSGlobalConfig.concurrentReadMode) {
+    __atomic_add_fetch(&v->flagsWord, RSValue_RefcountUnit(), __ATOMIC_RELAXED);
+  } else {
+    ++v->refcount;
+  }
   return v;
 }
 
-#define RSValue_Decref(v) \
-  if (!--(v)->refcount) { \
-    RSValue_Free(v);      \
+/* Decrement the refcount of the value, returning the new refcount */
+static inline uint32_t RSValue_DecrRefcount(RSValue *v) {
+  if (!RSGlobalConfig.concurrentReadMode) {
+    return --v->refcount;
+  }
+  RSValue after;
+  after.flagsWord = __atomic_sub_fetch(&v->flagsWord, RSValue_RefcountUnit(), __ATOMIC_ACQ_REL);
+  return after.refcount;
+}
+
+#define RSValue_Decref(v)         \
+  if (!RSValue_DecrRefcount(v)) { \
+    RSValue_Free(v);              \
   }
 
 RSValue *RS_NewValue(RSValueType t);
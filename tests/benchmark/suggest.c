@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "time_sample.h"
+
+#include <hiredis/hiredis.h>
+
+/* Measures FT.SUGGET latency on a large suggestion dictionary, for short prefixes where the
+ * candidates under the prefix far outnumber the requested results */
+
+#define PORT 6379
+#define KEY "bm_suggest"
+#define N 2000000
+#define PIPELINE 1000
+#define RUNS 100
+
+/* Scores are skewed, with few popular suggestions and a long tail, as in real dictionaries */
+static double randScore() {
+  double r = (double)rand() / RAND_MAX;
+  return 1 + 1000000 * r * r * r * r;
+}
+
+static void fill(redisContext *c) {
+  const char alphabet[] = "abcdefghijklmnopqrstuvwxyz";
+  char buf[32];
+  for (int i = 0; i < N; i++) {
+    int n = (rand() % 16) + 3;
+    for (int j = 0; j < n; j++) {
+      // favor the first letters, so that short prefixes cover many suggestions
+      buf[j] = alphabet[(rand() % 26) * (rand() % 26) / 26];
+    }
+    redisAppendCommand(c, "FT.SUGADD " KEY " %b %f", buf, (size_t)n, randScore());
+    if ((i + 1) % PIPELINE == 0) {
+      for (int j = 0; j < PIPELINE; j++) {
+        redisReply *r;
+        redisGetReply(c, (void **)&r);
+        freeReplyObject(r);
+      }
+    }
+  }
+}
+
+static void search(redisContext *c, const char *prefix, int fuzzy) {
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  for (int i = 0; i < RUNS; i++) {
+    redisReply *r = redisCommand(c, fuzzy ? "FT.SUGGET " KEY " %s MAX 10 FUZZY"
+                                          : "FT.SUGGET " KEY " %s MAX 10",
+                                 prefix);
+    freeReplyObject(r);
+    TimeSampler_Tick(&ts);
+  }
+  TimeSampler_End(&ts);
+  printf("%-8s %-6s %.3f ms/query\n", prefix, fuzzy ? "fuzzy" : "",
+         TimeSampler_IterationSec(&ts) * 1000);
+}
+
+int main(int argc, char **argv) {
+  redisContext *c = redisConnect("127.0.0.1", PORT);
+  if (!c || c->err) {
+    fprintf(stderr, "could not connect to redis on port %d\n", PORT);
+    return 1;
+  }
+  redisReply *r = redisCommand(c, "DEL " KEY);
+  freeReplyObject(r);
+
+  srand(1337);
+  TIME_SAMPLE_RUN(fill(c));
+
+  const char *prefixes[] = {"a", "b", "ab", "abc", "bad", "zzz", NULL};
+  for (int i = 0; prefixes[i]; i++) {
+    search(c, prefixes[i], 0);
+    search(c, prefixes[i], 1);
+  }
+
+  r = redisCommand(c, "DEL " KEY);
+  freeReplyObject(r);
+  redisFree(c);
+  return 0;
+}
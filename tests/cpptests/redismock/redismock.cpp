@@ -382,6 +382,41 @@ RedisModuleString **RMCK_HashGetAll(RedisModuleKey *key) {
   return hv->kvarray(key->parent);
 }
 
+/** Scanning. Keys are small, so they are scanned in a single call */
+struct RedisModuleScanCursor {
+  bool done = false;
+};
+
+RedisModuleScanCursor *RMCK_ScanCursorCreate() {
+  return new RedisModuleScanCursor();
+}
+
+void RMCK_ScanCursorRestart(RedisModuleScanCursor *cursor) {
+  cursor->done = false;
+}
+
+void RMCK_ScanCursorDestroy(RedisModuleScanCursor *cursor) {
+  delete cursor;
+}
+
+int RMCK_ScanKey(RedisModuleKey *key, RedisModuleScanCursor *cursor, RedisModuleScanKeyCB fn,
+                 void *privdata) {
+  if (cursor->done || key->ref == NULL || key->ref->typecode() != REDISMODULE_KEYTYPE_HASH) {
+    return 0;
+  }
+  auto *hv = static_cast<HashValue *>(key->ref);
+  for (auto it : hv->items()) {
+    // Like redis, the strings passed to the callback are only valid during the call
+    RedisModuleString *field = new RedisModuleString(it.first);
+    RedisModuleString *value = new RedisModuleString(it.second);
+    fn(key, field, value, privdata);
+    field->decref();
+    value->decref();
+  }
+  cursor->done = true;
+  return 0;
+}
+
 typedef enum {
   LL_DEBUG = 0,  // nlb
   LL_VERBOSE,
@@ -782,6 +817,11 @@ static void registerApis() {
   REGISTER_API(HashGet);
   REGISTER_API(HashGetAll);
 
+  REGISTER_API(ScanCursorCreate);
+  REGISTER_API(ScanCursorRestart);
+  REGISTER_API(ScanCursorDestroy);
+  REGISTER_API(ScanKey);
+
   REGISTER_API(CreateString);
   REGISTER_API(CreateStringPrintf);
   REGISTER_API(CreateStringFromString);
@@ -5,9 +5,12 @@
 #include "redismock/internal.h"
 #include "spec.h"
 #include "common.h"
+#include "concurrent_ctx.h"
 #include <module.h>
 #include <version.h>
 #include <vector>
+#include <map>
+#include <string>
 #include <array>
 #include <iostream>
 #include <cstdarg>
@@ -244,6 +247,220 @@ TEST_F(AggTest, testGroupSplit) {
   RLookup_Cleanup(&lk_out);
 }
 
+class ScoreGenerator : public ResultProcessor {
+ public:
+  RLookupKey *kvalue = NULL;
+  RLookupKey *kscore = NULL;
+  std::vector<const char *> values = {"foo", "bar", "baz", "qux", "quux"};
+  size_t counter = 0;
+  size_t limit = 20000;
+
+  ScoreGenerator() {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+  }
+};
+
+typedef std::map<std::string, std::vector<double>> GroupResults;
+
+// Group the rows of the generator by value, reducing the score with each of the reducers. Each
+// reducer is given as its name followed by its arguments. Array results are reported by length
+static void runGrouper(const std::vector<std::vector<const char *>> &reducers, GroupResults &out) {
+  QueryIterator qitr = {0};
+  ScoreGenerator gen;
+  RLookup lk_in = {0};
+  RLookup lk_out = {0};
+  gen.kvalue = RLookup_GetKey(&lk_in, "value", RLOOKUP_F_OCREAT);
+  gen.kscore = RLookup_GetKey(&lk_in, "score", RLOOKUP_F_OCREAT);
+  gen.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+    ScoreGenerator *p = static_cast<ScoreGenerator *>(rp);
+    if (p->counter >= p->limit) return RS_RESULT_EOF;
+    res->docId = ++p->counter;
+    RLookup_WriteOwnKey(p->kvalue, &res->rowdata,
+                        RS_ConstStringValC((char *)p->values[p->counter % p->values.size()]));
+    RLookup_WriteOwnKey(p->kscore, &res->rowdata, RS_NumVal((p->counter * 7919) % 1000));
+    return RS_RESULT_OK;
+  };
+  QITR_PushRP(&qitr, &gen);
+
+  RLookupKey *val_out = RLookup_GetKey(&lk_out, "value", RLOOKUP_F_OCREAT);
+  Grouper *gr = Grouper_New((const RLookupKey **)&gen.kvalue, (const RLookupKey **)&val_out, 1);
+  std::vector<RLookupKey *> outkeys;
+  for (size_t ii = 0; ii < reducers.size(); ++ii) {
+    std::vector<const char *> args(reducers[ii].begin() + 1, reducers[ii].end());
+    ArgsCursor ac = {0};
+    ArgsCursor_InitCString(&ac, args.data(), args.size());
+    QueryError status = {QueryErrorCode(0)};
+    ReducerOptions opts = REDUCEROPTS_INIT(reducers[ii][0], &ac, &lk_in, &status);
+    Reducer *r = RDCR_GetFactory(reducers[ii][0])(&opts);
+    ASSERT_TRUE(r != NULL) << QueryError_GetError(&status);
+    std::string name = "out" + std::to_string(ii);
+    outkeys.push_back(RLookup_GetKey(&lk_out, name.c_str(), RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC));
+    Grouper_AddReducer(gr, r, outkeys.back());
+  }
+
+  ResultProcessor *gp = Grouper_GetRP(gr);
+  QITR_PushRP(&qitr, gp);
+  SearchResult res = {0};
+  while (gp->Next(gp, &res) == RS_RESULT_OK) {
+    RSValue *group = RLookup_GetItem(val_out, &res.rowdata);
+    ASSERT_TRUE(group != NULL);
+    std::vector<double> &vals = out[RSValue_StringPtrLen(group, NULL)];
+    for (auto kk : outkeys) {
+      RSValue *v = RSValue_Dereference(RLookup_GetItem(kk, &res.rowdata));
+      double d = 0;
+      if (v->t == RSValue_Array) {
+        d = RSValue_ArrayLen(v);
+      } else {
+        ASSERT_TRUE(RSValue_ToNumber(v, &d));
+      }
+      vals.push_back(d);
+    }
+    SearchResult_Clear(&res);
+  }
+  SearchResult_Destroy(&res);
+  gp->Free(gp);
+  RLookup_Cleanup(&lk_in);
+  RLookup_Cleanup(&lk_out);
+}
+
+TEST_F(AggTest, testGroupByParallel) {
+  std::vector<std::vector<const char *>> reducers = {
+      {"COUNT"},          {"SUM", "score"},           {"MIN", "score"},
+      {"MAX", "score"},   {"COUNT_DISTINCT", "score"}, {"COUNT_DISTINCTISH", "score"},
+      {"TOLIST", "score"}, {"AVG", "score"},            {"STDDEV", "score"},
+      {"QUANTILE", "score", "0.5"}, {"QUANTILE", "score", "0.9", "TDIGEST"}};
+  const size_t nexact = 7;
+  // partitions are only grouped in parallel on the search pool
+  ConcurrentSearch_ThreadPoolStart();
+
+  // FIRST_VALUE cannot merge partial states, so the first grouper reduces every row serially
+  GroupResults serial, parallel;
+  auto withFirst = reducers;
+  withFirst.push_back({"FIRST_VALUE", "score"});
+  runGrouper(withFirst, serial);
+  runGrouper(reducers, parallel);
+
+  ASSERT_EQ(5, serial.size());
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (auto &it : serial) {
+    auto &sv = it.second;
+    auto &pv = parallel[it.first];
+    ASSERT_EQ(reducers.size(), pv.size()) << it.first;
+    ASSERT_EQ(4000, sv[0]) << it.first;
+    for (size_t ii = 0; ii < nexact; ++ii) {
+      ASSERT_EQ(sv[ii], pv[ii]) << it.first << ": " << reducers[ii][0];
+    }
+    ASSERT_NEAR(sv[nexact], pv[nexact], 1e-6) << it.first;
+    ASSERT_NEAR(sv[nexact + 1], pv[nexact + 1], 1e-6) << it.first;
+    ASSERT_NEAR(sv[nexact + 2], pv[nexact + 2], 50) << it.first;
+    ASSERT_NEAR(900, pv[nexact + 3], 10) << it.first;
+    ASSERT_NEAR(sv[nexact + 3], pv[nexact + 3], 10) << it.first;
+  }
+}
+
+TEST_F(AggTest, testCountDistinctBudget) {
+  RLookup lk = {0};
+  RLookupKey *kvalue = RLookup_GetKey(&lk, "value", RLOOKUP_F_OCREAT);
+  size_t maxMemory = RSGlobalConfig.maxDistinctMemory;
+  RSGlobalConfig.maxDistinctMemory = 64 << 10;
+  ReducerOptionsCXX options("COUNT_DISTINCT", &lk, "value");
+  Reducer *r = RDCRCountDistinct_New(&options);
+  RSGlobalConfig.maxDistinctMemory = maxMemory;
+  ASSERT_TRUE(r != NULL) << QueryError_GetError(options.status);
+
+  auto addValues = [&](void *instance, size_t n) {
+    RLookupRow row = {0};
+    for (size_t ii = 0; ii < n; ++ii) {
+      RLookup_WriteOwnKey(kvalue, &row, RS_NumVal(ii));
+      r->Add(r, instance, &row);
+    }
+    RLookupRow_Cleanup(&row);
+  };
+  auto finalize = [&](void *instance) {
+    RSValue *v = r->Finalize(r, instance);
+    double d = 0;
+    RSValue_ToNumber(v, &d);
+    RSValue_Decref(v);
+    return d;
+  };
+
+  // the small group is counted exactly
+  void *small = r->NewInstance(r);
+  addValues(small, 1000);
+  ASSERT_EQ(1000, finalize(small));
+  ASSERT_FALSE(r->approximate);
+  ASSERT_GT(r->memory, 0);
+
+  // the big one no longer fits, and is estimated within the budget
+  void *big = r->NewInstance(r);
+  addValues(big, 100000);
+  ASSERT_TRUE(r->approximate);
+  ASSERT_LE(r->memory, 64 << 10);
+  ASSERT_NEAR(100000, finalize(big), 5000);
+  ASSERT_EQ(1000, finalize(small));
+
+  r->Merge(r, big, small);
+  ASSERT_NEAR(100000, finalize(big), 5000);
+
+  r->FreeInstance(r, small);
+  r->FreeInstance(r, big);
+  ASSERT_EQ(0, r->memory);
+  r->Free(r);
+  RLookup_Cleanup(&lk);
+}
+
+TEST_F(AggTest, testCountDistinctBudgetSmallGroups) {
+  RLookup lk = {0};
+  RLookupKey *kvalue = RLookup_GetKey(&lk, "value", RLOOKUP_F_OCREAT);
+  size_t maxMemory = RSGlobalConfig.maxDistinctMemory;
+  RSGlobalConfig.maxDistinctMemory = 16 << 10;
+  ReducerOptionsCXX options("COUNT_DISTINCT", &lk, "value");
+  Reducer *r = RDCRCountDistinct_New(&options);
+  RSGlobalConfig.maxDistinctMemory = maxMemory;
+  ASSERT_TRUE(r != NULL) << QueryError_GetError(options.status);
+
+  // none of the groups is big, but together they take well over the budget
+  const size_t ngroups = 1000, nvalues = 50;
+  std::vector<void *> groups;
+  RLookupRow row = {0};
+  for (size_t ii = 0; ii < ngroups; ++ii) {
+    void *instance = r->NewInstance(r);
+    groups.push_back(instance);
+    for (size_t jj = 0; jj < nvalues; ++jj) {
+      RLookup_WriteOwnKey(kvalue, &row, RS_NumVal(ii * nvalues + jj));
+      r->Add(r, instance, &row);
+    }
+  }
+  RLookupRow_Cleanup(&row);
+  ASSERT_TRUE(r->approximate);
+  // past the budget, the sets are replaced by counters no bigger than them once they reach 256
+  // bytes, rather than by 4KB ones
+  ASSERT_LE(r->memory, (16 << 10) + ngroups * 260);
+
+  for (auto instance : groups) {
+    RSValue *v = r->Finalize(r, instance);
+    double d = 0;
+    RSValue_ToNumber(v, &d);
+    RSValue_Decref(v);
+    ASSERT_NEAR(nvalues, d, nvalues / 5);
+  }
+
+  // merging counters of different precisions estimates both groups
+  r->Merge(r, groups[0], groups[ngroups - 1]);
+  RSValue *v = r->Finalize(r, groups[0]);
+  double d = 0;
+  RSValue_ToNumber(v, &d);
+  RSValue_Decref(v);
+  ASSERT_NEAR(2 * nvalues, d, nvalues / 2);
+
+  for (auto instance : groups) {
+    r->FreeInstance(r, instance);
+  }
+  ASSERT_EQ(0, r->memory);
+  r->Free(r);
+  RLookup_Cleanup(&lk);
+}
+
 #if 0
 int testAggregatePlan() {
   CmdString *argv = CmdParser_NewArgListV(
@@ -261,4 +261,96 @@ TEST_F(ExprTest, testPropertyFetch) {
   // RSValue_Print(&ctx.result());
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+TEST_F(ExprTest, testProgram) {
+  RLookup lk;
+  RLookup_Init(&lk, NULL);
+  RLookupRow rr = {0};
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "foo", RLOOKUP_F_OCREAT), &rr, RS_NumVal(1));
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "bar", RLOOKUP_F_OCREAT), &rr, RS_NumVal(2));
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "str", RLOOKUP_F_OCREAT), &rr,
+                      RS_ConstStringValC("hello"));
+  RLookup_WriteKey(RLookup_GetKey(&lk, "nul", RLOOKUP_F_OCREAT), &rr, RS_NullVal());
+  RLookup_GetKey(&lk, "missing", RLOOKUP_F_OCREAT);
+
+  // the compiled program gives the same results and errors as evaluating the tree
+  const char *exprs[] = {"@foo + @bar * 2",
+                         "(@foo + 1) * (@bar - 3) / 2 ^ 2",
+                         "2 * 3 + 1 - 7 % 4",
+                         "@foo < @bar && @bar < 3",
+                         "@foo > @bar || 1",
+                         "!(@foo == 1)",
+                         "@str == 'hello'",
+                         "@str < 'goo'",
+                         "@str + 1",
+                         "abs(0 - @foo) + sqrt(@bar * 8)",
+                         "upper(@str)",
+                         "format('%s-%s', @str, @foo)",
+                         "substr(@str, 1, 2)",
+                         "split('a,b')",
+                         "to_number('3') * 2 > 5",
+                         "exists(@missing)",
+                         "exists(@foo)",
+                         "exists(@nul)",
+                         "exists(NULL)",
+                         "@missing",
+                         "@missing + 1",
+                         "@missing == 1",
+                         "0 && @missing",
+                         "1 || @missing",
+                         "1 && @missing",
+                         "@foo",
+                         "'lit'",
+                         "NULL == NULL",
+                         "!NULL",
+                         "@str && @foo",
+                         "1 == 1 && 2 == 2 || 3",
+                         "@nul",
+                         "NULL",
+                         "@nul == NULL",
+                         "@nul != 1"};
+  for (auto e : exprs) {
+    QueryError status = {QueryErrorCode(0)};
+    RSExpr *root = ExprAST_Parse(e, strlen(e), &status);
+    ASSERT_TRUE(root) << e << ": " << QueryError_GetError(&status);
+    ASSERT_EQ(EXPR_EVAL_OK, ExprAST_GetLookupKeys(root, &lk, &status)) << e;
+
+    TEvalCtx tree(root);
+    tree.lookup = &lk;
+    tree.srcrow = &rr;
+    tree.res = NULL;
+    BlkAlloc_Init(&tree.stralloc);
+    int treerc = tree.eval();
+
+    ExprProgram *prog = ExprProgram_Compile(root);
+    QueryError progStatus = {QueryErrorCode(0)};
+    ExprEval eval = {0};
+    eval.err = &progStatus;
+    eval.lookup = &lk;
+    eval.srcrow = &rr;
+    eval.root = root;
+    BlkAlloc_Init(&eval.stralloc);
+    RSValue res = {RSValue_Undef};
+    // evaluated twice, as the program's slots are reused for every row
+    for (int ii = 0; ii < 2; ++ii) {
+      QueryError_ClearError(&progStatus);
+      ASSERT_EQ(treerc, ExprProgram_Eval(prog, &eval, &res)) << e;
+      ASSERT_EQ(tree.status_s.code, progStatus.code) << e;
+      if (treerc == EXPR_EVAL_OK) {
+        RSValue *l = RSValue_Dereference(&tree.result());
+        RSValue *r = RSValue_Dereference(&res);
+        ASSERT_EQ(l->t, r->t) << e;
+        ASSERT_TRUE(RSValue_Equal(l, r, NULL)) << e;
+      }
+    }
+    RSValue_Clear(&res);
+    QueryError_ClearError(&progStatus);
+    ExprProgram_Free(prog);
+    BlkAlloc_FreeAll(&eval.stralloc, NULL, NULL, 0);
+    BlkAlloc_FreeAll(&tree.stralloc, NULL, NULL, 0);
+  }
+
+  RLookupRow_Cleanup(&rr);
+  RLookup_Cleanup(&lk);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "geo_index.h"
+#include "rmalloc.h"
+#include <stdlib.h>
+#include <vector>
+
+class GeoTest : public ::testing::Test {};
+
+// Check the cover of the filter against random locations around (lon, lat): every location within
+// the shape is in a range, and every location in a range marked inside is within the shape. Matching
+// against the cover gives the same results as checking the shape alone
+static void checkCover(GeoFilter *gf, double lon, double lat, double spread) {
+  GeoCoverRange ranges[GEO_COVER_MAX_CELLS];
+  size_t n = geoCover(gf, ranges);
+  ASSERT_GT(n, 0);
+  ASSERT_LE(n, GEO_COVER_MAX_CELLS);
+  for (size_t ii = 1; ii < n; ++ii) {
+    ASSERT_LE(ranges[ii - 1].max, ranges[ii].min);
+  }
+
+  srand(1337);
+  size_t nmatched = 0, ninside = 0;
+  for (size_t ii = 0; ii < 20000; ++ii) {
+    double plon = lon + spread * (2.0 * rand() / RAND_MAX - 1);
+    double plat = lat + spread * (2.0 * rand() / RAND_MAX - 1);
+    double hash = calcGeoHash(plon, plat);
+    if (hash == INVALID_GEOHASH) {
+      continue;
+    }
+    const GeoCoverRange *rng = NULL;
+    for (size_t jj = 0; jj < n; ++jj) {
+      if (hash >= ranges[jj].min && hash < ranges[jj].max) {
+        rng = &ranges[jj];
+      }
+    }
+    int matched = GeoFilter_Match(gf, hash);
+    gf->cover = ranges;
+    gf->ncover = n;
+    ASSERT_EQ(matched, GeoFilter_Match(gf, hash)) << plon << "," << plat;
+    gf->cover = NULL;
+    gf->ncover = 0;
+    if (matched) {
+      nmatched++;
+      ASSERT_TRUE(rng != NULL) << plon << "," << plat;
+    }
+    if (rng && rng->inside) {
+      ninside++;
+      ASSERT_TRUE(matched) << plon << "," << plat;
+    }
+  }
+  ASSERT_GT(nmatched, 0);
+  ASSERT_GT(ninside, 0);
+}
+
+TEST_F(GeoTest, testCoverRadius) {
+  struct {
+    double lon, lat, radius;
+  } circles[] = {{2.35, 48.85, 10}, {-122.4, 37.7, 250}, {179.9, 10, 50}, {0, 80, 400}};
+  for (auto &c : circles) {
+    GeoFilter *gf = NewGeoFilter(c.lon, c.lat, c.radius, "km");
+    gf->property = rm_strdup("loc");
+    // a degree of latitude is about 111km
+    checkCover(gf, c.lon, c.lat, c.radius / 50.0);
+    GeoFilter_Free(gf);
+  }
+}
+
+TEST_F(GeoTest, testCoverBox) {
+  GeoFilter *gf = NewGeoFilter(0, 0, 0, NULL);
+  gf->property = rm_strdup("loc");
+  gf->shape = GEO_SHAPE_BOX;
+  double box[4] = {-0.2, 51.3, 0.1, 51.7};
+  memcpy(gf->box, box, sizeof(box));
+  checkCover(gf, -0.05, 51.5, 0.5);
+  GeoFilter_Free(gf);
+}
+
+TEST_F(GeoTest, testCoverPolygon) {
+  GeoFilter *gf = NewGeoFilter(0, 0, 0, NULL);
+  gf->property = rm_strdup("loc");
+  gf->shape = GEO_SHAPE_POLYGON;
+  // a concave polygon
+  double points[] = {10, 10, 12, 10, 12, 12, 11, 11, 10, 12};
+  gf->npoints = 5;
+  gf->points = (double *)rm_malloc(sizeof(points));
+  memcpy(gf->points, points, sizeof(points));
+  checkCover(gf, 11, 11, 1.5);
+
+  GeoCoverRange ranges[GEO_COVER_MAX_CELLS];
+  ASSERT_GT(geoCover(gf, ranges), 0);
+  double hash = calcGeoHash(11, 11.5);
+  ASSERT_FALSE(GeoFilter_Match(gf, hash));
+  hash = calcGeoHash(11, 10.5);
+  ASSERT_TRUE(GeoFilter_Match(gf, hash));
+  GeoFilter_Free(gf);
+}
@@ -15,6 +15,8 @@
 #include <float.h>
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <string>
 #include <cstdint>
 
 class IndexTest : public ::testing::Test {};
@@ -205,6 +207,147 @@ TEST_P(IndexFlagsTest, testRWFlags) {
   InvertedIndex_Free(idx);
 }
 
+TEST_P(IndexFlagsTest, testBufferedRead) {
+  IndexFlags indexFlags = (IndexFlags)GetParam();
+  InvertedIndex *idx = NewInvertedIndex(indexFlags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+
+  // gaps of all the qint widths, and more records than a single buffer holds
+  std::vector<t_docId> ids;
+  t_docId id = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    id += i % 5 == 0 ? 1 : i % 5 == 1 ? 300 : i % 5 == 2 ? 70000 : i % 5 == 3 ? 20000000 : 2;
+    ForwardIndexEntry h = {0};
+    h.docId = id;
+    h.fieldMask = i % 3 ? 1 : 2;
+    h.freq = 1 + i % 7;
+    h.vw = NewVarintVectorWriter(8);
+    for (int n = 0; n < i % 4; n++) {
+      VVW_Write(h.vw, n);
+    }
+    VVW_Truncate(h.vw);
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    VVW_Free(h.vw);
+    if (!(indexFlags & Index_StoreFieldFlags) || h.fieldMask == 2) {
+      ids.push_back(i);
+    }
+  }
+
+  // the expected values of the i'th record written
+  auto expectRecord = [&](size_t i, const RSIndexResult *h) {
+    ASSERT_EQ(indexFlags & Index_StoreFreqs ? 1 + i % 7 : 1, h->freq);
+    if (indexFlags & Index_StoreTermOffsets) {
+      ASSERT_EQ(i % 4, h->term.offsets.len);
+    }
+  };
+  std::vector<t_docId> docIds;
+  id = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    id += i % 5 == 0 ? 1 : i % 5 == 1 ? 300 : i % 5 == 2 ? 70000 : i % 5 == 3 ? 20000000 : 2;
+    docIds.push_back(id);
+  }
+
+  IndexReader *ir = NewTermIndexReader(idx, NULL, 2, NULL, 1);
+  RSIndexResult *h = NULL;
+  size_t n = 0;
+  while (IR_Read(ir, &h) != INDEXREAD_EOF) {
+    ASSERT_LT(n, ids.size());
+    ASSERT_EQ(docIds[ids[n]], h->docId);
+    expectRecord(ids[n], h);
+    n++;
+  }
+  ASSERT_EQ(ids.size(), n);
+
+  // skip to every third matching record, or to the id right after the matching record before it
+  IR_Free(ir);
+  ir = NewTermIndexReader(idx, NULL, 2, NULL, 1);
+  for (size_t j = 0; j < ids.size(); j += 3) {
+    t_docId target = j % 2 ? docIds[ids[j - 1]] + 1 : docIds[ids[j]];
+    int rc = IR_SkipTo(ir, target, &h);
+    ASSERT_EQ(docIds[ids[j]] == target ? INDEXREAD_OK : INDEXREAD_NOTFOUND, rc);
+    ASSERT_EQ(docIds[ids[j]], h->docId);
+    expectRecord(ids[j], h);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_SkipTo(ir, docIds.back() + 1, &h));
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_P(IndexFlagsTest, testBlockSkips) {
+  IndexFlags indexFlags = (IndexFlags)GetParam();
+  InvertedIndex *idx = NewInvertedIndex(indexFlags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+  DocTable dt = NewDocTable(10, 1000);
+  const size_t N = 1000;
+  for (size_t i = 1; i <= N; i++) {
+    std::string key = "doc" + std::to_string(i);
+    ASSERT_EQ(i, DocTable_Put(&dt, key.c_str(), key.size(), 1, Document_DefaultFlags, NULL, 0));
+    ForwardIndexEntry h = {0};
+    h.docId = i;
+    h.fieldMask = i % 3 ? 1 : 2;
+    h.freq = 1;
+    h.vw = NewVarintVectorWriter(8);
+    VVW_Write(h.vw, i);
+    VVW_Truncate(h.vw);
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    VVW_Free(h.vw);
+    if (i == INDEX_BLOCK_SKIP_INTERVAL) {
+      // the skip pointers are only allocated once a block needs one
+      ASSERT_TRUE(idx->blocks[0].skips == NULL);
+    }
+  }
+
+  // a skip pointer every 16 records, following the 16th record of the block
+  ASSERT_EQ(INDEX_BLOCK_MAX_SKIPS, idx->blocks[0].numSkips);
+  ASSERT_EQ(15, idx->blocks[0].skips[0].prevId);
+
+  // skip to every 7th id with the readers, with and without their buffer
+  auto checkSkips = [&](const std::vector<t_docId> &ids) {
+    for (int buffered = 0; buffered < 2; buffered++) {
+      IndexReader *ir = NewTermIndexReader(idx, NULL, 2, NULL, 1);
+      if (!buffered) {
+        rm_free(ir->buffer);
+        ir->buffer = NULL;
+      }
+      RSIndexResult *h = NULL;
+      for (t_docId target = 1; target <= N; target += 7) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), target);
+        int rc = IR_SkipTo(ir, target, &h);
+        if (it == ids.end()) {
+          ASSERT_EQ(INDEXREAD_EOF, rc);
+          break;
+        }
+        ASSERT_EQ(*it == target ? INDEXREAD_OK : INDEXREAD_NOTFOUND, rc);
+        ASSERT_EQ(*it, h->docId);
+      }
+      IR_Free(ir);
+    }
+  };
+  std::vector<t_docId> ids;
+  for (t_docId i = 1; i <= N; i++) {
+    if (!(indexFlags & Index_StoreFieldFlags) || i % 3 == 0) {
+      ids.push_back(i);
+    }
+  }
+  checkSkips(ids);
+
+  // the skip pointers are rebuilt when the GC removes records from the blocks
+  for (t_docId i = 1; i <= N; i += 2) {
+    std::string key = "doc" + std::to_string(i);
+    DocTable_Delete(&dt, key.c_str(), key.size());
+  }
+  IndexRepairParams params = {0};
+  InvertedIndex_Repair(idx, &dt, 0, &params);
+  // the first block now holds the even ids from 2, so its first pointer follows id 32
+  ASSERT_EQ(3, idx->blocks[0].numSkips);
+  ASSERT_EQ(32 - 2, idx->blocks[0].skips[0].prevId);
+  ids.erase(std::remove_if(ids.begin(), ids.end(), [](t_docId id) { return id % 2; }), ids.end());
+  checkSkips(ids);
+
+  InvertedIndex_Free(idx);
+  DocTable_Free(&dt);
+}
+
 INSTANTIATE_TEST_CASE_P(IndexFlagsP, IndexFlagsTest, ::testing::Range(1, 32));
 
 InvertedIndex *createIndex(int size, int idStep) {
@@ -311,6 +454,66 @@ TEST_F(IndexTest, testUnion) {
   InvertedIndex_Free(w2);
 }
 
+static double freqBound(const RSIndexStats *, double idf, double weight, uint32_t maxFreq) {
+  return idf * weight * maxFreq;
+}
+
+TEST_F(IndexTest, testUnionBlockMaxPruning) {
+  InvertedIndex *w = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+  InvertedIndex *w2 = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(w->flags);
+  // a single document with a high frequency, all the others have a frequency of 1
+  for (t_docId id = 1; id <= 1000; id++) {
+    ForwardIndexEntry h = {0};
+    h.docId = id;
+    h.fieldMask = 1;
+    h.freq = id == 950 ? 10 : 1;
+    h.vw = NewVarintVectorWriter(8);
+    VVW_Write(h.vw, 1);
+    InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+    if (id % 2 == 0) {
+      h.freq = 1;
+      InvertedIndex_WriteForwardIndexEntry(w2, enc, &h);
+    }
+    VVW_Free(h.vw);
+  }
+  ASSERT_EQ(10, w->size);
+  ASSERT_EQ(1, w->blocks[0].maxFreq);
+  ASSERT_EQ(10, w->blocks[9].maxFreq);
+
+  auto readAll = [&](bool prune) {
+    RSToken tok = {.str = (char *)"hello", .len = 5};
+    IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
+    irs[0] = NewReadIterator(NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NewQueryTerm(&tok, 1), 1));
+    irs[1] = NewReadIterator(NewTermIndexReader(w2, NULL, RS_FIELDMASK_ALL, NewQueryTerm(&tok, 2), 1));
+    IndexIterator *ui = NewUnionIterator(irs, 2, NULL, 0, 1, QN_UNION, NULL);
+    // only a document containing the high frequency term can score above the threshold
+    double minScore = 5;
+    RSIndexStats stats = {0};
+    if (prune) {
+      EXPECT_TRUE(UnionIterator_EnableBlockMaxPruning(ui, &minScore, 1, freqBound, &stats));
+    }
+    std::vector<t_docId> ids;
+    RSIndexResult *h = NULL;
+    while (ui->Read(ui->ctx, &h) != INDEXREAD_EOF) {
+      ids.push_back(h->docId);
+    }
+    ui->Free(ui);
+    return ids;
+  };
+
+  std::vector<t_docId> all = readAll(false);
+  ASSERT_EQ(1000, all.size());
+  std::vector<t_docId> pruned = readAll(true);
+  // everything but the last block is skipped
+  ASSERT_EQ(100, pruned.size());
+  ASSERT_EQ(901, pruned.front());
+  ASSERT_EQ(1000, pruned.back());
+
+  InvertedIndex_Free(w);
+  InvertedIndex_Free(w2);
+}
+
 TEST_F(IndexTest, testWeight) {
   InvertedIndex *w = createIndex(10, 1);
   InvertedIndex *w2 = createIndex(10, 2);
@@ -358,7 +561,7 @@ TEST_F(IndexTest, testNot) {
   // printf("Reading!\n");
   IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
   irs[0] = NewReadIterator(r1);
-  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, 1);
+  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, NULL, 1);
 
   IndexIterator *ui = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
   RSIndexResult *h = NULL;
@@ -382,7 +585,7 @@ TEST_F(IndexTest, testPureNot) {
   IndexReader *r1 = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);  //
   printf("last id: %llu\n", (unsigned long long)w->lastId);
 
-  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, 1);
+  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, NULL, 1);
 
   RSIndexResult *h = NULL;
   int expected[] = {1,  2,  4,  5,  7,  8,  10, 11, 13, 14, 16, 17, 19,
@@ -397,6 +600,84 @@ TEST_F(IndexTest, testPureNot) {
   InvertedIndex_Free(w);
 }
 
+TEST_F(IndexTest, testPureNotLiveDocs) {
+  InvertedIndex *w = createIndex(10, 3);
+  IndexReader *r1 = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);
+
+  // only the even ids are alive
+  DocIdBitmap live;
+  DocIdBitmap_Init(&live);
+  for (t_docId id = 2; id <= 40; id += 2) {
+    DocIdBitmap_Add(&live, id);
+  }
+
+  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, &live, 1);
+  RSIndexResult *h = NULL;
+  int expected[] = {2, 4, 8, 10, 14, 16, 20, 22, 26, 28, 32, 34};
+  size_t i = 0;
+  while (ir->Read(ir->ctx, &h) != INDEXREAD_EOF) {
+    ASSERT_EQ(expected[i++], h->docId);
+  }
+  ASSERT_EQ(sizeof(expected) / sizeof(*expected), i);
+  ir->Free(ir);
+
+  IndexIterator *wi = NewWildcardIterator(35, &live);
+  ASSERT_EQ(INDEXREAD_OK, wi->Read(wi->ctx, &h));
+  ASSERT_EQ(2, h->docId);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, wi->SkipTo(wi->ctx, 7, &h));
+  ASSERT_EQ(8, h->docId);
+  ASSERT_EQ(INDEXREAD_OK, wi->SkipTo(wi->ctx, 34, &h));
+  ASSERT_EQ(INDEXREAD_EOF, wi->SkipTo(wi->ctx, 35, &h));
+  wi->Free(wi);
+
+  DocIdBitmap_Free(&live);
+  InvertedIndex_Free(w);
+}
+
+TEST_F(IndexTest, testDocIdBitmap) {
+  DocIdBitmap b;
+  DocIdBitmap_Init(&b);
+  // a dense container, a sparse one and a far away one
+  for (t_docId id = 1; id < 20000; ++id) {
+    DocIdBitmap_Add(&b, id);
+  }
+  DocIdBitmap_Add(&b, 70000);
+  DocIdBitmap_Add(&b, 70005);
+  DocIdBitmap_Add(&b, 1ULL << 40);
+  DocIdBitmap_Add(&b, 70005);
+  ASSERT_EQ(20002, DocIdBitmap_Cardinality(&b));
+  ASSERT_EQ(3, b.len);
+  ASSERT_EQ(0, b.containers[0].cap);
+
+  size_t hint = 0;
+  ASSERT_EQ(1, DocIdBitmap_Next(&b, 0, &hint));
+  ASSERT_EQ(19999, DocIdBitmap_Next(&b, 19999, &hint));
+  ASSERT_EQ(70000, DocIdBitmap_Next(&b, 20000, &hint));
+  ASSERT_EQ(70005, DocIdBitmap_Next(&b, 70001, &hint));
+  ASSERT_EQ(1ULL << 40, DocIdBitmap_Next(&b, 70006, &hint));
+  ASSERT_EQ(0, DocIdBitmap_Next(&b, (1ULL << 40) + 1, &hint));
+
+  // removing most of the dense container turns it back to an array
+  for (t_docId id = 1; id < 20000; ++id) {
+    if (id % 10) {
+      DocIdBitmap_Remove(&b, id);
+    }
+  }
+  ASSERT_NE(0, b.containers[0].cap);
+  ASSERT_TRUE(DocIdBitmap_Contains(&b, 10));
+  ASSERT_FALSE(DocIdBitmap_Contains(&b, 11));
+  hint = 0;
+  ASSERT_EQ(20, DocIdBitmap_Next(&b, 11, &hint));
+
+  DocIdBitmap_Remove(&b, 70000);
+  DocIdBitmap_Remove(&b, 70005);
+  ASSERT_EQ(2, b.len);
+  ASSERT_FALSE(DocIdBitmap_Contains(&b, 70005));
+  ASSERT_EQ(1ULL << 40, DocIdBitmap_Next(&b, 19991, &hint));
+  ASSERT_EQ(1999 + 1, DocIdBitmap_Cardinality(&b));
+  DocIdBitmap_Free(&b);
+}
+
 // Note -- in test_index.c, this test was never actually run!
 TEST_F(IndexTest, DISABLED_testOptional) {
   InvertedIndex *w = createIndex(16, 1);
@@ -408,7 +689,7 @@ TEST_F(IndexTest, DISABLED_testOptional) {
   // printf("Reading!\n");
   IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
   irs[0] = NewReadIterator(r1);
-  irs[1] = NewOptionalIterator(NewReadIterator(r2), w2->lastId, 1);
+  irs[1] = NewOptionalIterator(NewReadIterator(r2), w2->lastId, NULL, 1);
 
   IndexIterator *ui = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
   RSIndexResult *h = NULL;
@@ -626,6 +907,47 @@ TEST_F(IndexTest, testIntersection) {
   InvertedIndex_Free(w2);
 }
 
+static int testDivisibleBy3(IndexCriteriaTester *ct, t_docId id) {
+  return id % 3 == 0;
+}
+
+static void freeTester(IndexCriteriaTester *ct) {
+  rm_free(ct);
+}
+
+TEST_F(IndexTest, testIntersectionTester) {
+  InvertedIndex *w = createIndex(1000, 4);
+  InvertedIndex *w2 = createIndex(1000, 2);
+  IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
+  irs[0] = NewReadIterator(NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1));
+  irs[1] = NewReadIterator(NewTermIndexReader(w2, NULL, RS_FIELDMASK_ALL, NULL, 1));
+  IndexIterator *ii = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+
+  IndexCriteriaTester *tester = (IndexCriteriaTester *)rm_malloc(sizeof(*tester));
+  tester->Test = testDivisibleBy3;
+  tester->Free = freeTester;
+  IntersectIterator_AddTester(ii, tester);
+
+  // only the ids found on both children which pass the tester are returned
+  RSIndexResult *h = NULL;
+  size_t count = 0;
+  while (ii->Read(ii->ctx, &h) != INDEXREAD_EOF) {
+    ASSERT_EQ((count + 1) * 12, h->docId);
+    ++count;
+  }
+  ASSERT_EQ(count, 2000 / 12);
+
+  ii->Rewind(ii->ctx);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, ii->SkipTo(ii->ctx, 16, &h));
+  ASSERT_EQ(24, h->docId);
+  ASSERT_EQ(INDEXREAD_OK, ii->SkipTo(ii->ctx, 36, &h));
+  ASSERT_EQ(36, h->docId);
+
+  ii->Free(ii);
+  InvertedIndex_Free(w);
+  InvertedIndex_Free(w2);
+}
+
 TEST_F(IndexTest, testBuffer) {
   // TEST_START();
   Buffer b = {0};
@@ -949,8 +1271,7 @@ TEST_F(IndexTest, testDocTable) {
   char buf[16];
   DocTable dt = NewDocTable(10, 10);
   t_docId did = 0;
-  // N is set to 100 and the max cap of the doc table is 10 so we surely will
-  // get overflow and check that everything works correctly
+  // N is set to 100 and the table is created with room for 10 ids, so it has to grow
   int N = 100;
   for (int i = 0; i < N; i++) {
     size_t nkey = sprintf(buf, "doc_%d", i);
@@ -962,7 +1283,7 @@ TEST_F(IndexTest, testDocTable) {
   ASSERT_EQ(N + 1, dt.size);
   ASSERT_EQ(N, dt.maxDocId);
 #ifdef __x86_64__
-  ASSERT_EQ(10980, (int)dt.memsize);
+  ASSERT_EQ(17580, (int)dt.memsize);
 #endif
   for (int i = 0; i < N; i++) {
     sprintf(buf, "doc_%d", i);
@@ -1013,6 +1334,50 @@ TEST_F(IndexTest, testDocTable) {
   DocTable_Free(&dt);
 }
 
+// Documents spread over many chunks, most of them deleted: the chunks whose documents are all
+// deleted are freed, and the keys of the remaining documents are still found
+TEST_F(IndexTest, testDocTableChunks) {
+  char buf[32];
+  DocTable dt = NewDocTable(10, 10);
+  const size_t N = DOCTABLE_CHUNK_SIZE * 8;
+  for (size_t ii = 1; ii <= N; ++ii) {
+    size_t nkey = sprintf(buf, "doc_%zu", ii);
+    ASSERT_EQ(ii, DocTable_Put(&dt, buf, nkey, 1, Document_DefaultFlags, NULL, 0));
+  }
+  ASSERT_EQ(N, dt.dim.size);
+  size_t memsize = dt.memsize;
+
+  // keep every 7th document, and all of the documents in the last chunk
+  for (size_t ii = 1; ii <= N; ++ii) {
+    if (ii % 7 && ii < N - DOCTABLE_CHUNK_SIZE) {
+      size_t nkey = sprintf(buf, "doc_%zu", ii);
+      ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+    }
+  }
+  for (size_t ii = 1; ii <= N; ++ii) {
+    size_t nkey = sprintf(buf, "doc_%zu", ii);
+    bool kept = !(ii % 7 && ii < N - DOCTABLE_CHUNK_SIZE);
+    ASSERT_EQ(kept ? ii : 0, DocIdMap_Get(&dt.dim, buf, nkey)) << buf;
+    ASSERT_EQ(kept, !!DocTable_Get(&dt, ii)) << buf;
+    ASSERT_EQ(kept, DocTable_Exists(&dt, ii)) << buf;
+  }
+
+  // deleting the rest frees all the chunks
+  size_t ndocs = 0;
+  DOCTABLE_FOREACH((&dt), ++ndocs);
+  ASSERT_EQ(dt.size - 1, ndocs);
+  for (size_t ii = 1; ii <= N; ++ii) {
+    size_t nkey = sprintf(buf, "doc_%zu", ii);
+    DocTable_Delete(&dt, buf, nkey);
+  }
+  ASSERT_EQ(0, dt.dim.size);
+  for (size_t ii = 0; ii < dt.nchunks; ++ii) {
+    ASSERT_TRUE(dt.chunks[ii] == NULL);
+  }
+  ASSERT_EQ(memsize - (N / DOCTABLE_CHUNK_SIZE + 1) * sizeof(DocTableChunk), dt.memsize);
+  DocTable_Free(&dt);
+}
+
 TEST_F(IndexTest, testSortable) {
   RSSortingTable *tbl = NewSortingTable();
   RSSortingTable_Add(&tbl, "foo", RSValue_String);
@@ -1085,6 +1450,91 @@ TEST_F(IndexTest, testSortable) {
   SortingVector_Free(v2);
 }
 
+TEST_F(IndexTest, testSortingColumns) {
+  RSSortingColumns *cols = NewSortingColumns();
+  double num = 3.141;
+  RSSortingVector *v = NewSortingVector(3);
+  RSSortingVector_Put(v, 0, "Hello", RS_SORTABLE_STR);
+  RSSortingVector_Put(v, 1, &num, RS_SORTABLE_NUM);
+  RSSortingColumns_PutVector(cols, 1, v);
+  SortingVector_Free(v);
+  ASSERT_EQ(3, cols->len);
+
+  // documents in different chunks share the dictionary of their strings
+  t_docId far = 5 * RS_SORTING_CHUNK_SIZE + 3;
+  RSSortingColumns_PutRaw(cols, far, 0, "hello", RS_SORTABLE_STR);
+  RSValue *s1 = RSSortingColumns_Get(cols, 1, 0);
+  RSValue *s2 = RSSortingColumns_Get(cols, far, 0);
+  ASSERT_TRUE(s1 != NULL);
+  ASSERT_EQ(s1, s2);
+  ASSERT_STREQ("hello", s1->strval.str);
+
+  RSValue *n = RSSortingColumns_Get(cols, 1, 1);
+  ASSERT_EQ(RSValue_Number, n->t);
+  ASSERT_EQ(num, n->numval);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 1, 2) == NULL);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, far, 1) == NULL);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 2, 0) == NULL);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 1, 10) == NULL);
+
+  // a value of the wrong type is not stored
+  RSSortingColumns_PutRaw(cols, 2, 1, "foo", RS_SORTABLE_STR);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 2, 1) == NULL);
+
+  // replacing a value keeps the string while it is used by another document
+  RSSortingColumns_PutRaw(cols, 1, 0, "world", RS_SORTABLE_STR);
+  ASSERT_STREQ("world", RSSortingColumns_Get(cols, 1, 0)->strval.str);
+  ASSERT_EQ(s2, RSSortingColumns_Get(cols, far, 0));
+
+  // a referenced string outlives its last document
+  RSValue_IncrRef(s2);
+  RSSortingColumns_Clear(cols, far);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, far, 0) == NULL);
+  ASSERT_STREQ("hello", s2->strval.str);
+  RSValue_Decref(s2);
+
+  size_t memsize = cols->memsize;
+  RSSortingColumns_Clear(cols, 1);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 1, 0) == NULL);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 1, 1) == NULL);
+  ASSERT_GT(memsize, cols->memsize);
+  SortingColumns_Decref(cols);
+}
+
+TEST_F(IndexTest, testSortingColumnsReferencedNumbers) {
+  RSSortingColumns *cols = NewSortingColumns();
+  size_t empty = cols->memsize;
+  double num = 1;
+  RSSortingColumns_PutRaw(cols, 1, 0, &num, RS_SORTABLE_NUM);
+  num = 2;
+  RSSortingColumns_PutRaw(cols, 2, 0, &num, RS_SORTABLE_NUM);
+
+  // changing a referenced number copies its chunk, the reference keeps the old value
+  RSValue *n1 = RSValue_IncrRef(RSSortingColumns_Get(cols, 1, 0));
+  num = 10;
+  RSSortingColumns_PutRaw(cols, 1, 0, &num, RS_SORTABLE_NUM);
+  ASSERT_EQ(10, RSSortingColumns_Get(cols, 1, 0)->numval);
+  ASSERT_NE(n1, RSSortingColumns_Get(cols, 1, 0));
+  ASSERT_EQ(1, n1->numval);
+  ASSERT_EQ(2, RSSortingColumns_Get(cols, 2, 0)->numval);
+
+  // clearing a referenced number releases its cell and chunk
+  RSValue *n2 = RSValue_IncrRef(RSSortingColumns_Get(cols, 2, 0));
+  RSSortingColumns_Clear(cols, 2);
+  ASSERT_TRUE(RSSortingColumns_Get(cols, 2, 0) == NULL);
+  ASSERT_EQ(2, n2->numval);
+  RSValue_Decref(n1);
+  RSValue_Decref(n2);
+
+  // the retired chunks are freed once their values are not referenced
+  RSSortingColumns_Clear(cols, 1);
+  ASSERT_TRUE(cols->fields[0].chunks[0] == NULL);
+  ASSERT_EQ(0, array_len(cols->fields[0].retired));
+  ASSERT_EQ(empty + sizeof(*cols->fields) + cols->fields[0].nchunks * sizeof(RSSortingChunk *),
+            cols->memsize);
+  SortingColumns_Decref(cols);
+}
+
 TEST_F(IndexTest, testVarintFieldMask) {
   t_fieldMask x = 127;
   size_t expected[] = {1, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 19};
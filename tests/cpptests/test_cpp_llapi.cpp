@@ -3,6 +3,8 @@
 #include <set>
 #include <string>
 #include "common.h"
+#include "docid_compaction.h"
+#include "concurrent_ctx.h"
 
 #define DOCID1 "doc1"
 #define DOCID2 "doc2"
@@ -747,4 +749,73 @@ TEST_F(LLApiTest, duplicateFieldAdd) {
 
   RediSearch_FreeDocument(d);
   RediSearch_DropIndex(index);
-}
\ No newline at end of file
+}
+
+TEST_F(LLApiTest, testCompactDocIds) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, NUMERIC_FIELD_NAME, RSFLDTYPE_NUMERIC, RSFLDOPT_SORTABLE);
+  RediSearch_CreateTagField(index, TAG_FIELD_NAME1);
+
+  char buf[32];
+  const size_t N = 3000;
+  for (size_t ii = 1; ii <= N; ++ii) {
+    sprintf(buf, "doc_%zu", ii);
+    RSDoc* d = RediSearch_CreateDocumentSimple(buf);
+    RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, ii % 2 ? "hello odd" : "hello even",
+                                       RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldNumber(d, NUMERIC_FIELD_NAME, ii, RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldCString(d, TAG_FIELD_NAME1, ii % 3 ? "a" : "b", RSFLDTYPE_DEFAULT);
+    ASSERT_EQ(REDISMODULE_OK, RediSearch_SpecAddDocument(index, d));
+  }
+  // keep every 5th document
+  for (size_t ii = 1; ii <= N; ++ii) {
+    if (ii % 5) {
+      sprintf(buf, "doc_%zu", ii);
+      ASSERT_EQ(REDISMODULE_OK, RediSearch_DropDocument(index, buf, strlen(buf)));
+    }
+  }
+
+  IndexSpec* sp = (IndexSpec*)index;
+  // not while a query uses the index, even if it does not run in concurrent read mode
+  ConcurrentSearchCtx conc;
+  ConcurrentSearchCtx_Init(NULL, &conc, sp);
+  ASSERT_FALSE(DocIdCompaction_CanRun(sp));
+  ConcurrentSearchCtx_Free(&conc);
+
+  ASSERT_TRUE(DocIdCompaction_CanRun(sp));
+  ASSERT_EQ(N - N / 5, DocIdCompaction_Run(sp));
+  ASSERT_EQ(N / 5, sp->docs.maxDocId);
+  ASSERT_EQ(N / 5, sp->stats.numDocuments);
+
+  // the documents keep their order, and their sortable values
+  for (t_docId id = 1; id <= N / 5; ++id) {
+    RSDocumentMetadata* dmd = DocTable_Get(&sp->docs, id);
+    ASSERT_TRUE(dmd != NULL);
+    sprintf(buf, "doc_%zu", id * 5);
+    ASSERT_STREQ(buf, dmd->keyPtr);
+    ASSERT_EQ(id, DocIdMap_Get(&sp->docs.dim, buf, strlen(buf)));
+    ASSERT_EQ(id * 5, RSSortingColumns_Get(sp->docs.sortables, id, 0)->numval);
+  }
+
+  auto res = search(index, "hello");
+  ASSERT_EQ(N / 5, res.size());
+  ASSERT_EQ("doc_5", res[0]);
+  ASSERT_EQ("doc_3000", res.back());
+  ASSERT_EQ(N / 10, search(index, "odd").size());
+  ASSERT_EQ(10, search(index, "@" NUMERIC_FIELD_NAME ":[101 150]").size());
+  ASSERT_EQ(N / 15, search(index, "@" TAG_FIELD_NAME1 ":{b}").size());
+
+  // new documents are given the next id
+  RSDoc* d = RediSearch_CreateDocumentSimple(DOCID1);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello odd", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldNumber(d, NUMERIC_FIELD_NAME, 120, RSFLDTYPE_DEFAULT);
+  ASSERT_EQ(REDISMODULE_OK, RediSearch_SpecAddDocument(index, d));
+  ASSERT_EQ(N / 5 + 1, DocIdMap_Get(&sp->docs.dim, DOCID1, strlen(DOCID1)));
+  res = search(index, "odd");
+  ASSERT_EQ(N / 10 + 1, res.size());
+  ASSERT_EQ(DOCID1, res.back());
+  ASSERT_EQ(11, search(index, "@" NUMERIC_FIELD_NAME ":[101 150]").size());
+
+  RediSearch_DropIndex(index);
+}
@@ -139,6 +139,102 @@ TEST_F(RangeTest, testRangeIterator) {
   NumericRangeTree_Free(t);
 }
 
+TEST_F(RangeTest, testNextLeaf) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 50000;
+  for (size_t i = 0; i < N; i++) {
+    NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % 5000));
+  }
+
+  for (int ascending = 0; ascending < 2; ascending++) {
+    double bound = ascending ? NF_NEGATIVE_INFINITY : NF_INFINITY;
+    double lo, hi, last = bound;
+    size_t nleaves = 0, nentries = 0;
+    do {
+      NumericRange *rng = NumericRangeTree_NextLeaf(t, bound, ascending, &lo, &hi);
+      ASSERT_TRUE(rng != NULL);
+      ASSERT_LT(lo, hi);
+      // leaves are walked in order, each right where the previous one ended
+      ASSERT_EQ(ascending ? lo : hi, last);
+      IndexIterator *it = NewNumericRangeIterator(NULL, rng, NULL);
+      RSIndexResult *res = NULL;
+      while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+        ASSERT_GE(res->num.value, lo);
+        ASSERT_LT(res->num.value, hi);
+        nentries++;
+      }
+      it->Free(it);
+      nleaves++;
+      last = bound = ascending ? hi : lo;
+    } while (ascending ? hi != NF_INFINITY : lo != NF_NEGATIVE_INFINITY);
+
+    ASSERT_GT(nleaves, 1);
+    ASSERT_EQ(nentries, N);
+  }
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testRangeBitmap) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 100000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 0; i < N; i++) {
+    lookup[i + 1] = (double)(1 + prng() % (N / 5));
+    NumericRangeTree_Add(t, i + 1, lookup[i + 1]);
+  }
+
+  struct {
+    double min, max;
+  } rngs[] = {{0, N}, {100.5, N / 5 - 100.5}, {100.5, N / 5 - 100.5}};
+  for (auto &r : rngs) {
+    NumericFilter *flt = NewNumericFilter(r.min, r.max, 1, 1);
+    IndexIterator *it = createNumericIterator(NULL, t, flt);
+    // the filter covers most of the ranges, and these are read from a bitmap
+    ASSERT_TRUE(t->bitmaps != NULL);
+
+    size_t count = 0, xcount = 0;
+    for (size_t i = 1; i <= N; i++) {
+      count += NumericFilter_Match(flt, lookup[i]);
+    }
+    RSIndexResult *res = NULL;
+    t_docId lastId = 0;
+    while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+      ASSERT_GT(res->docId, lastId);
+      ASSERT_TRUE(NumericFilter_Match(flt, lookup[res->docId])) << res->docId;
+      lastId = res->docId;
+      xcount++;
+    }
+    ASSERT_EQ(count, xcount);
+
+    // skipping lands on the next matching document
+    it->Rewind(it->ctx);
+    for (t_docId id = 1; id <= N; id += 997) {
+      int rc = it->SkipTo(it->ctx, id, &res);
+      ASSERT_NE(rc, INDEXREAD_EOF);
+      ASSERT_EQ(rc == INDEXREAD_OK, NumericFilter_Match(flt, lookup[id]) != 0);
+      for (t_docId skipped = id + 1; skipped < res->docId; skipped++) {
+        ASSERT_FALSE(NumericFilter_Match(flt, lookup[skipped]));
+      }
+    }
+    it->Free(it);
+    NumericFilter_Free(flt);
+  }
+  // the same filter reuses its bitmap
+  ASSERT_EQ(array_len(t->bitmaps), 2);
+
+  // records added without splitting ranges are in the bitmaps of the filters they match
+  NumericRangeBitmap *b = t->bitmaps[0];
+  NRN_AddRv rv = NumericRangeTree_Add(t, N + 1, 50);
+  ASSERT_FALSE(rv.changed);
+  ASSERT_EQ(t->bitmaps[0], b);
+  ASSERT_TRUE(DocIdBitmap_Contains(&b->docs, N + 1));
+  ASSERT_FALSE(DocIdBitmap_Contains(&t->bitmaps[1]->docs, N + 1));
+
+  NumericRangeTree_ClearBitmaps(t);
+  ASSERT_TRUE(t->bitmaps == NULL);
+  NumericRangeTree_Free(t);
+}
+
 // int benchmarkNumericRangeTree() {
 //   NumericRangeTree *t = NewNumericRangeTree();
 //   int count = 1;
@@ -77,4 +77,110 @@ TEST_F(ResultProcessorTest, testProcessorChain) {
   QITR_FreeChain(&qitr);
   ASSERT_EQ(2, numFreed);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+#define NUM_BATCH_RESULTS 150
+
+static int gen_Next(ResultProcessor *rp, SearchResult *res) {
+  processor1Ctx *p = static_cast<processor1Ctx *>(rp);
+  if (p->counter >= NUM_BATCH_RESULTS) return RS_RESULT_EOF;
+
+  res->docId = ++p->counter;
+  // scores repeat, so that ties are broken by the id
+  res->score = (double)(res->docId % 40);
+  RLookup_WriteOwnKey(p->kout, &res->rowdata, RS_NumVal(res->docId));
+  return RS_RESULT_OK;
+}
+
+static int evenDoc(const SearchResult *res) {
+  return res->docId % 2 == 0;
+}
+
+static int even_Next(ResultProcessor *rp, SearchResult *res) {
+  int rc;
+  while ((rc = rp->upstream->Next(rp->upstream, res)) == RS_RESULT_OK && !evenDoc(res)) {
+    SearchResult_Clear(res);
+  }
+  return rc;
+}
+
+// Drops the results with odd ids, keeping the rest first in the batch
+static int even_NextBatch(ResultProcessor *rp, SearchResult *results, size_t n, size_t *nread) {
+  int rc = RP_NextBatch(rp->upstream, results, n, nread);
+  size_t nkept = 0;
+  for (size_t ii = 0; ii < *nread; ++ii) {
+    if (!evenDoc(&results[ii])) {
+      SearchResult_Clear(&results[ii]);
+      continue;
+    }
+    std::swap(results[nkept++], results[ii]);
+  }
+  *nread = nkept;
+  return rc;
+}
+
+TEST_F(ResultProcessorTest, testNextBatch) {
+  QueryIterator qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = gen_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey(&lk, "foo", RLOOKUP_F_OCREAT);
+  QITR_PushRP(&qitr, p);
+
+  // processors without NextBatch are read one result at a time
+  SearchResult batch[RP_BATCH_SIZE] = {};
+  size_t n;
+  ASSERT_EQ(RS_RESULT_OK, RP_NextBatch(p, batch, RP_BATCH_SIZE, &n));
+  ASSERT_EQ(RP_BATCH_SIZE, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    ASSERT_EQ(ii + 1, batch[ii].docId);
+    ASSERT_EQ(ii + 1, RLookup_GetItem(p->kout, &batch[ii].rowdata)->numval);
+    SearchResult_Clear(&batch[ii]);
+  }
+  ASSERT_EQ(RS_RESULT_OK, RP_NextBatch(p, batch, RP_BATCH_SIZE, &n));
+  ASSERT_EQ(RP_BATCH_SIZE, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    SearchResult_Clear(&batch[ii]);
+  }
+  ASSERT_EQ(RS_RESULT_EOF, RP_NextBatch(p, batch, RP_BATCH_SIZE, &n));
+  ASSERT_EQ(NUM_BATCH_RESULTS - 2 * RP_BATCH_SIZE, n);
+  for (size_t ii = 0; ii < RP_BATCH_SIZE; ++ii) {
+    SearchResult_Destroy(&batch[ii]);
+  }
+
+  // the sorter reads its upstream in batches
+  p->counter = 0;
+  processor1Ctx *even = new processor1Ctx();
+  even->Next = even_Next;
+  even->NextBatch = even_NextBatch;
+  even->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, even);
+  ResultProcessor *sorter = RPSorter_NewByScore(10);
+  QITR_PushRP(&qitr, sorter);
+
+  SearchResult r = {0};
+  size_t count = 0;
+  double lastScore = 40;
+  t_docId lastId = 0;
+  while (sorter->Next(sorter, &r) == RS_RESULT_OK) {
+    count++;
+    ASSERT_EQ(0, r.docId % 2);
+    ASSERT_LE(r.score, lastScore);
+    if (r.score == lastScore) {
+      ASSERT_GT(r.docId, lastId);
+    }
+    lastScore = r.score;
+    lastId = r.docId;
+    ASSERT_EQ(r.docId, RLookup_GetItem(p->kout, &r.rowdata)->numval);
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+  // each of the scores 38, 36 and 34 is given to three even ids, and 32 comes last
+  ASSERT_EQ(10, count);
+  ASSERT_EQ(32, lastScore);
+  ASSERT_EQ(32, lastId);
+
+  QITR_FreeChain(&qitr);
+  RLookup_Cleanup(&lk);
+}
@@ -1,5 +1,7 @@
 #include <rlookup.h>
 #include <gtest/gtest.h>
+#include "redismock/redismock.h"
+#include "redismock/util.h"
 
 class RLookupTest : public ::testing::Test {};
 
@@ -58,4 +60,43 @@ TEST_F(RLookupTest, testRow) {
   RSValue_Decref(vbar);
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+TEST_F(RLookupTest, testGetHash) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  RMCK::flushdb(ctx);
+  RMCK::hset(ctx, "doc1", "foo", "hello");
+  RMCK::hset(ctx, "doc1", "bar", "42");
+  RMCK::hset(ctx, "doc1", "sv", "sortable");
+
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  // Sortable fields are read from the sorting vector, and are not loaded
+  RLookupKey *svk = RLookup_GetKey(&lk, "sv", RLOOKUP_F_OCREAT);
+  svk->flags |= RLOOKUP_F_SVSRC;
+  RLookupRow rr = {0};
+
+  ASSERT_EQ(REDISMODULE_OK, RLookup_GetHash(&lk, &rr, ctx, RMCK::RString("doc1")));
+  RLookupKey *fook = RLookup_GetKey(&lk, "foo", 0);
+  RLookupKey *bark = RLookup_GetKey(&lk, "bar", 0);
+  ASSERT_TRUE(fook && bark);
+
+  // Values are always loaded as strings
+  size_t len = 0;
+  RSValue *v = RLookup_GetItem(fook, &rr);
+  ASSERT_TRUE(v && RSValue_IsString(v));
+  ASSERT_STREQ("hello", RSValue_StringPtrLen(v, &len));
+  v = RLookup_GetItem(bark, &rr);
+  ASSERT_TRUE(v && RSValue_IsString(v));
+  ASSERT_STREQ("42", RSValue_StringPtrLen(v, &len));
+  ASSERT_EQ(2, len);
+  ASSERT_TRUE(NULL == RLookup_GetItem(svk, &rr));
+
+  // Missing keys cannot be loaded
+  RLookupRow_Wipe(&rr);
+  ASSERT_EQ(REDISMODULE_ERR, RLookup_GetHash(&lk, &rr, ctx, RMCK::RString("nosuchdoc")));
+
+  RLookupRow_Cleanup(&rr);
+  RLookup_Cleanup(&lk);
+  RedisModule_FreeThreadSafeContext(ctx);
+}
@@ -3,6 +3,11 @@
 #include <trie/trie_type.h>
 #include <set>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
 
 typedef std::set<std::string> ElemSet;
 
@@ -41,17 +46,17 @@ static ElemSet trieIterRange(Trie *t, const char *begin, size_t nbegin, const ch
   }
 
   ElemSet foundElements;
-  TrieNode_IterateRange(t->root, r1Ptr, nr1, true, r2Ptr, nr2, false,
-                        [](const rune *u16, size_t nrune, void *ctx) {
-                          size_t n;
-                          char *s = runesToStr(u16, nrune, &n);
-                          std::string xs(s, n);
-                          free(s);
-                          ElemSet *e = (ElemSet *)ctx;
-                          ASSERT_EQ(e->end(), e->find(xs));
-                          e->insert(xs);
-                        },
-                        &foundElements);
+  Trie_IterateRange(t, r1Ptr, nr1, true, r2Ptr, nr2, false,
+                    [](const rune *u16, size_t nrune, void *ctx) {
+                      size_t n;
+                      char *s = runesToStr(u16, nrune, &n);
+                      std::string xs(s, n);
+                      free(s);
+                      ElemSet *e = (ElemSet *)ctx;
+                      ASSERT_EQ(e->end(), e->find(xs));
+                      e->insert(xs);
+                    },
+                    &foundElements);
   return foundElements;
 }
 
@@ -119,3 +124,293 @@ TEST_F(TrieTest, testDeepEntry) {
   ASSERT_EQ(maxbuf, ret.size());
   TrieType_Free(t);
 }
+
+typedef std::vector<std::pair<float, std::string>> ScoredVec;
+
+/* Score every entry of the trie the way Trie_Search does, without pruning anything */
+static void trieSearchAll(TrieNode *n, DFAFilter *fc, dfaNode *dfa, int minDist,
+                          std::vector<rune> &str, const std::vector<rune> &query, size_t qlen,
+                          int maxDist, int prefixMode, ScoredVec &out) {
+  int matched = 0, dist = maxDist + 1;
+  for (t_len ii = 0; ii < n->len; ++ii) {
+    dist = minDist;
+    if (DFAFilter_Step(fc, &dfa, &minDist, n->str[ii], &matched, &dist) == F_STOP) {
+      str.resize(str.size() - ii);
+      return;
+    }
+    str.push_back(n->str[ii]);
+  }
+  if (matched && n->len && __trieNode_isTerminal(n) && !__trieNode_isDeleted(n)) {
+    float score = str == query ? INT_MAX : n->score;
+    if (maxDist > 0) {
+      score *= exp((double)-(2 * dist));
+    }
+    if (prefixMode) {
+      score /= sqrt(1 + (str.size() >= qlen ? str.size() - qlen : qlen - str.size()));
+    }
+    size_t len;
+    char *s = runesToStr(&str[0], str.size(), &len);
+    out.push_back({score, std::string(s, len)});
+    free(s);
+  }
+  for (t_len ii = 0; ii < n->numChildren; ++ii) {
+    trieSearchAll(__trieNode_children(n)[ii], fc, dfa, minDist, str, query, qlen, maxDist,
+                  prefixMode, out);
+  }
+  str.resize(str.size() - n->len);
+}
+
+/* Check that maxChildScore bounds the scores below every node, and return the greatest of them */
+static float checkMaxChildScore(TrieNode *n) {
+  float max = 0;
+  for (t_len ii = 0; ii < n->numChildren; ++ii) {
+    TrieNode *ch = __trieNode_children(n)[ii];
+    max = std::max(max, std::max(ch->score, checkMaxChildScore(ch)));
+  }
+  EXPECT_LE(max, n->maxChildScore);
+  return max;
+}
+
+TEST_F(TrieTest, testSearchTopK) {
+  Trie *t = NewTrie();
+  srand(1337);
+  char buf[16];
+  for (size_t ii = 0; ii < 5000; ++ii) {
+    size_t n = 1 + rand() % 8;
+    for (size_t jj = 0; jj < n; ++jj) {
+      buf[jj] = 'a' + rand() % 5;
+    }
+    // mix in increments and deletes, which both have to keep maxChildScore up to date
+    Trie_InsertStringBuffer(t, buf, n, 1 + rand() % 1000, ii % 3 == 0, NULL);
+    if (ii % 7 == 0) {
+      buf[n / 2 + 1] = '\0';
+      Trie_Delete(t, buf, n / 2 + 1);
+    }
+  }
+
+  checkMaxChildScore(t->root);
+  const char *queries[] = {"a", "ab", "abc", "cad", "eeb", "dacbe", "bbbbbbbb"};
+  for (auto q : queries) {
+    for (int maxDist = 0; maxDist <= 1; ++maxDist) {
+      for (int prefixMode = 0; prefixMode <= 1; ++prefixMode) {
+        size_t qlen;
+        rune *qrunes = strToFoldedRunes(q, &qlen);
+        std::vector<rune> query(qrunes, qrunes + qlen);
+        DFAFilter fc = NewDFAFilter(qrunes, qlen, maxDist, prefixMode);
+        dfaNode *dfa = fc.stack[0];
+        int minDist = fc.distStack[0];
+        ScoredVec all;
+        std::vector<rune> str;
+        trieSearchAll(t->root, &fc, dfa, minDist, str, query, strlen(q), maxDist, prefixMode,
+                      all);
+        std::stable_sort(all.begin(), all.end(),
+                         [](const std::pair<float, std::string> &a,
+                            const std::pair<float, std::string> &b) { return a.first > b.first; });
+        DFAFilter_Free(&fc);
+        free(qrunes);
+
+        for (size_t num : {1, 5, 50}) {
+          Vector *res = Trie_Search(t, q, strlen(q), num, maxDist, prefixMode, 0, 0);
+          ASSERT_EQ(std::min(num, all.size()), Vector_Size(res)) << q;
+          for (size_t ii = 0; ii < Vector_Size(res); ++ii) {
+            TrieSearchResult *e;
+            Vector_Get(res, ii, &e);
+            ASSERT_EQ(all[ii].first, e->score) << q << " " << maxDist << " " << ii;
+            if (e->score == INT_MAX) {
+              ASSERT_EQ(q, std::string(e->str, e->len));
+            }
+            TrieSearchResult_Free(e);
+          }
+          Vector_Free(res);
+        }
+      }
+    }
+  }
+  TrieType_Free(t);
+}
+
+typedef std::map<std::string, std::pair<float, std::string>> EntryMap;
+
+/* The entries Trie_Iterate() finds for the query, with their scores and payloads */
+static EntryMap trieIterEntries(Trie *t, const char *q, int maxDist, int prefixMode) {
+  EntryMap ret;
+  TrieIterator *it = Trie_Iterate(t, q, strlen(q), maxDist, prefixMode);
+  rune *rstr;
+  t_len len;
+  float score;
+  RSPayload payload = {.data = NULL, .len = 0};
+  int dist = 0;
+  while (TrieIterator_Next(it, &rstr, &len, &payload, &score, &dist)) {
+    size_t n;
+    char *s = runesToStr(rstr, len, &n);
+    EXPECT_TRUE(ret.find(s) == ret.end()) << s;
+    ret[s] = {score, std::string(payload.data ? payload.data : "", payload.len)};
+    free(s);
+  }
+  DFAFilter_Free((DFAFilter *)it->ctx);
+  free(it->ctx);
+  TrieIterator_Free(it);
+  return ret;
+}
+
+static std::vector<float> trieSearchScores(Trie *t, const char *q, size_t num, int maxDist,
+                                           int prefixMode) {
+  std::vector<float> ret;
+  Vector *res = Trie_Search(t, q, strlen(q), num, maxDist, prefixMode, 0, 0);
+  for (size_t ii = 0; ii < Vector_Size(res); ++ii) {
+    TrieSearchResult *e;
+    Vector_Get(res, ii, &e);
+    ret.push_back(e->score);
+    TrieSearchResult_Free(e);
+  }
+  Vector_Free(res);
+  return ret;
+}
+
+/* Check that the trie, part of which is frozen, holds the same as the one which is not */
+static void checkSameTrie(Trie *t, Trie *ref) {
+  ASSERT_EQ(ref->size, t->size);
+  const char *queries[] = {"", "a", "ab", "\xc3\xa9", "c\xc3\xa9", "dab", "ddddd"};
+  for (auto q : queries) {
+    for (int maxDist = 0; maxDist <= 1; ++maxDist) {
+      for (int prefixMode = 0; prefixMode <= 1; ++prefixMode) {
+        ASSERT_EQ(trieIterEntries(ref, q, maxDist, prefixMode),
+                  trieIterEntries(t, q, maxDist, prefixMode))
+            << q << " " << maxDist << " " << prefixMode;
+        for (size_t num : {1, 5, 50}) {
+          ASSERT_EQ(trieSearchScores(ref, q, num, maxDist, prefixMode),
+                    trieSearchScores(t, q, num, maxDist, prefixMode))
+              << q << " " << maxDist << " " << prefixMode << " " << num;
+        }
+      }
+    }
+  }
+  ASSERT_EQ(trieIterRange(ref, "b", "d"), trieIterRange(t, "b", "d"));
+  ASSERT_EQ(trieIterRange(ref, "c\xc3\xa9", NULL), trieIterRange(t, "c\xc3\xa9", NULL));
+  ASSERT_EQ(trieIterRange(ref, NULL, "ba"), trieIterRange(t, NULL, "ba"));
+  ASSERT_EQ(trieIterRange(ref, "ab", "ac"), trieIterRange(t, "ab", "ac"));
+  ASSERT_EQ(trieIterRange(ref, "dab", "dab\xc3\xa9"), trieIterRange(t, "dab", "dab\xc3\xa9"));
+
+  EntryMap all = trieIterEntries(ref, "", 0, 1);
+  for (size_t ii = 0; ii < 20; ++ii) {
+    char *s;
+    t_len len;
+    double score;
+    ASSERT_TRUE(Trie_RandomKey(t, &s, &len, &score));
+    auto e = all.find(std::string(s, len));
+    ASSERT_TRUE(e != all.end()) << std::string(s, len);
+    ASSERT_EQ(e->second.first, score);
+    free(s);
+  }
+}
+
+/* Apply the same random inserts, increments and deletes to both tries */
+static void trieRandomOps(Trie *t, Trie *ref, size_t n) {
+  const char *pieces[] = {"a", "b", "c", "d", "\xc3\xa9"};
+  for (size_t ii = 0; ii < n; ++ii) {
+    std::string s;
+    for (size_t len = 1 + rand() % 6; s.size() < len;) {
+      s += pieces[rand() % 5];
+    }
+    float score = 1 + rand() % 1000;
+    int incr = rand() % 3 == 0;
+    std::string p = std::to_string(ii);
+    RSPayload payload = {.data = (char *)p.c_str(), .len = p.size()};
+    RSPayload *pp = rand() % 4 == 0 ? &payload : NULL;
+    ASSERT_EQ(Trie_InsertStringBuffer(ref, s.c_str(), s.size(), score, incr, pp),
+              Trie_InsertStringBuffer(t, s.c_str(), s.size(), score, incr, pp));
+    if (rand() % 5 == 0) {
+      s.resize(s.size() / 2);
+      ASSERT_EQ(Trie_Delete(ref, s.c_str(), s.size()), Trie_Delete(t, s.c_str(), s.size()));
+    }
+  }
+}
+
+TEST_F(TrieTest, testFreeze) {
+  Trie *t = NewTrie(), *ref = NewTrie();
+  srand(1337);
+  trieRandomOps(t, ref, 3000);
+  Trie_Freeze(t);
+  ASSERT_TRUE(t->frozen != NULL);
+  ASSERT_EQ(t->size, FrozenTrie_NumLive(t->frozen));
+  checkSameTrie(t, ref);
+
+  // new strings go to the nodes, and changes to frozen ones are made in place or move them there
+  trieRandomOps(t, ref, 1000);
+  checkSameTrie(t, ref);
+
+  // freezing again merges the nodes with the frozen strings
+  Trie_Freeze(t);
+  ASSERT_EQ(t->size, FrozenTrie_NumLive(t->frozen));
+  checkSameTrie(t, ref);
+
+  // the trie is only frozen by the GC once it stops changing
+  trieRandomOps(t, ref, 100);
+  ASSERT_FALSE(Trie_FreezeIfIdle(t, 1));
+  ASSERT_TRUE(Trie_FreezeIfIdle(t, 1));
+  ASSERT_FALSE(Trie_FreezeIfIdle(t, 1));
+  checkSameTrie(t, ref);
+
+  TrieType_Free(t);
+  TrieType_Free(ref);
+}
+
+/* Feed a string to a filter from its initial state, returning its distance or -1 if it does not
+ * match */
+static int dfaDistance(DFAFilter *fc, const char *s) {
+  size_t len;
+  rune *runes = strToRunes(s, &len);
+  dfaNode *dfa = fc->stack[0];
+  int minDist = fc->distStack[0], matched = 0, dist = -1;
+  for (size_t ii = 0; ii < len; ++ii) {
+    dist = minDist;
+    if (DFAFilter_Step(fc, &dfa, &minDist, runes[ii], &matched, &dist) == F_STOP) {
+      matched = 0;
+      break;
+    }
+  }
+  free(runes);
+  return matched ? dist : -1;
+}
+
+TEST_F(TrieTest, testDFACache) {
+  size_t len;
+  rune *runes = strToFoldedRunes("hello", &len);
+  DFAFilter fc = NewDFAFilter(runes, len, 2, 0);
+  DFAFilter same = NewDFAFilter(runes, len, 2, 1);
+  DFAFilter other = NewDFAFilter(runes, len, 1, 0);
+  DFAFilter exact = NewDFAFilter(runes, len, 0, 0);
+  DFAFilter exact2 = NewDFAFilter(runes, len, 0, 0);
+  free(runes);
+
+  // fuzzy automata are shared by string and distance, whatever the mode
+  ASSERT_EQ(fc.automaton, same.automaton);
+  ASSERT_NE(fc.automaton, other.automaton);
+  ASSERT_NE(exact.automaton, exact2.automaton);
+  ASSERT_EQ(1, dfaDistance(&fc, "hallo"));
+  ASSERT_EQ(2, dfaDistance(&fc, "hel"));
+  ASSERT_EQ(-1, dfaDistance(&other, "hel"));
+  ASSERT_EQ(-1, dfaDistance(&fc, "hallo there"));
+  ASSERT_EQ(1, dfaDistance(&same, "hallo there"));
+  DFAFilter_Free(&same);
+  DFAFilter_Free(&other);
+  DFAFilter_Free(&exact);
+  DFAFilter_Free(&exact2);
+
+  // filters keep using their automaton once it is evicted
+  for (int ii = 0; ii < DFA_CACHE_SIZE; ++ii) {
+    std::string s = "term" + std::to_string(ii);
+    runes = strToFoldedRunes(s.c_str(), &len);
+    DFAFilter f = NewDFAFilter(runes, len, 1, 0);
+    free(runes);
+    DFAFilter_Free(&f);
+  }
+  runes = strToFoldedRunes("hello", &len);
+  DFAFilter again = NewDFAFilter(runes, len, 2, 0);
+  free(runes);
+  ASSERT_NE(fc.automaton, again.automaton);
+  ASSERT_EQ(1, dfaDistance(&fc, "hallo"));
+  ASSERT_EQ(1, dfaDistance(&again, "hallo"));
+  DFAFilter_Free(&fc);
+  DFAFilter_Free(&again);
+}
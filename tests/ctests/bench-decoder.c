@@ -2,44 +2,87 @@
 #include "index.h"
 #include "inverted_index.h"
 #include "spec.h"
+#include "varint.h"
+#include "rmalloc.h"
 #include "rmutil/alloc.h"
 #include "time_sample.h"
 
 #define NUM_ENTRIES 5000000
-#define MY_FLAGS Index_StoreFreqs | Index_StoreFieldFlags
+#define NUM_ITERATIONS 20
 
-static void writeEntry(InvertedIndex *idx, size_t id) {
+static void writeEntry(InvertedIndex *idx, IndexEncoder enc, size_t id) {
   ForwardIndexEntry ent = {0};
   ent.docId = id;
-  ent.docScore = 1.0;
-  ent.fieldMask = RS_FIELDMASK_ALL;
+  ent.fieldMask = 1;
   ent.freq = 3;
   ent.term = "foo";
-  ent.vw = NULL;
   ent.len = 3;
-  InvertedIndex_WriteEntry(idx, &ent);
+  ent.vw = NewVarintVectorWriter(8);
+  VVW_Write(ent.vw, id % 100);
+  VVW_Truncate(ent.vw);
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  VVW_Free(ent.vw);
 }
 
-int main(int argc, char **argv) {
-  RMUTil_InitAlloc();
-  InvertedIndex *idx = NewInvertedIndex(MY_FLAGS, 1);
-  for (size_t ii = 0; ii < NUM_ENTRIES; ++ii) {
-    writeEntry(idx, ii);
+/* Read the index with a term reader, or skip it to every `step`th id if step is not 0. Unless
+ * `buffered` is set, the reader's buffer is dropped so that it decodes one record at a time, as
+ * readers did before buffering */
+static size_t readRecords(InvertedIndex *idx, int buffered, t_docId step) {
+  IndexReader *r = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  if (!buffered) {
+    rm_free(r->buffer);
+    r->buffer = NULL;
+  }
+  RSIndexResult *res;
+  size_t n = 0;
+  if (step) {
+    for (t_docId id = step; IR_SkipTo(r, id, &res) != INDEXREAD_EOF; id += step) {
+      ++n;
+    }
+  } else {
+    while (INDEXREAD_EOF != IR_Read(r, &res)) {
+      ++n;
+    }
+  }
+  IR_Free(r);
+  return n;
+}
+
+static void benchFlags(IndexFlags flags, const char *name) {
+  InvertedIndex *idx = NewInvertedIndex(flags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(flags);
+  for (size_t ii = 1; ii <= NUM_ENTRIES; ++ii) {
+    writeEntry(idx, enc, ii);
   }
 
-  for (size_t ii = 0; ii < 100; ++ii) {
-    IndexReader *r = NewIndexReader(idx, NULL, RS_FIELDMASK_ALL, MY_FLAGS, NULL, 0);
-    IndexIterator *it = NewReadIterator(r);
-    TimeSample ts;
-    TimeSampler_Start(&ts);
-    RSIndexResult *res;
-    while (INDEXREAD_EOF != it->Read(it->ctx, &res)) {
-      TimeSampler_Tick(&ts);
+  static const t_docId steps[] = {0, 10, 1000};
+  for (size_t jj = 0; jj < sizeof(steps) / sizeof(*steps); ++jj) {
+    // the fastest of the iterations, alternating between the two modes
+    long long best[2] = {-1, -1};
+    size_t n = 0;
+    for (size_t ii = 0; ii < NUM_ITERATIONS; ++ii) {
+      for (int mode = 0; mode < 2; ++mode) {
+        TimeSample ts;
+        TimeSampler_Start(&ts);
+        n = readRecords(idx, mode, steps[jj]);
+        TimeSampler_End(&ts);
+        if (best[mode] < 0 || TimeSampler_DurationNS(&ts) < best[mode]) {
+          best[mode] = TimeSampler_DurationNS(&ts);
+        }
+      }
     }
-    TimeSampler_End(&ts);
-    printf("%d iterations in %lldms, %fns/iter\n", ts.num, TimeSampler_DurationMS(&ts),
-           TimeSampler_IterationMS(&ts) * 1000000);
-    ReadIterator_Free(it);
+    printf("%-20s %-7s %zd records: single %.2fns/record, buffered %.2fns/record\n", name,
+           steps[jj] ? "skip" : "read", n, (double)best[0] / n, (double)best[1] / n);
   }
+  InvertedIndex_Free(idx);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  benchFlags(Index_StoreFreqs | Index_StoreFieldFlags, "freqs+flags");
+  benchFlags(Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets,
+             "freqs+flags+offsets");
+  benchFlags(Index_StoreFreqs, "freqs");
+  benchFlags(Index_DocIdsOnly, "docids");
   return 0;
 }
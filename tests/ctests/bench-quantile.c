@@ -0,0 +1,102 @@
+#include "util/quantile.h"
+#include "util/tdigest.h"
+#include "buffer.h"
+#include "rmalloc.h"
+#include "rmutil/alloc.h"
+#include "time_sample.h"
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+
+#define NUM_VALUES 10000000
+#define STREAM_RESOLUTION 500
+
+static double *values;
+static double *sorted;
+
+static int dblCmp(const void *a, const void *b) {
+  double da = *(const double *)a, db = *(const double *)b;
+  return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* Repeat the values of quantile_data.txt, each time shifted by a small random amount so that the
+ * values are not all duplicates */
+static void loadValues(void) {
+  FILE *fp = fopen("./quantile_data.txt", "rb");
+  assert(fp);
+  Buffer buf;
+  Buffer_Init(&buf, 4096);
+  BufferWriter bw = NewBufferWriter(&buf);
+  double d;
+  size_t n = 0;
+  while (fscanf(fp, "%lf", &d) != EOF) {
+    Buffer_Write(&bw, &d, sizeof d);
+    n++;
+  }
+  fclose(fp);
+
+  const double *data = (const double *)buf.data;
+  values = rm_malloc(NUM_VALUES * sizeof(*values));
+  sorted = rm_malloc(NUM_VALUES * sizeof(*sorted));
+  srand(1337);
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    values[ii] = data[ii % n] + (double)rand() / RAND_MAX;
+  }
+  memcpy(sorted, values, NUM_VALUES * sizeof(*values));
+  qsort(sorted, NUM_VALUES, sizeof(*sorted), dblCmp);
+  Buffer_Free(&buf);
+}
+
+/* The distance of the rank of the value from the quantile */
+static double rankError(double value, double q) {
+  size_t lo = 0, hi = NUM_VALUES;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (sorted[mid] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return fabs((double)lo / NUM_VALUES - q);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  loadValues();
+
+  double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  size_t nquantiles = sizeof(quantiles) / sizeof(*quantiles);
+
+  TimeSample ts;
+  QuantStream *qs = NewQuantileStream(quantiles, nquantiles, STREAM_RESOLUTION);
+  TimeSampler_Start(&ts);
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    QS_Insert(qs, values[ii]);
+  }
+  TimeSampler_End(&ts);
+  printf("QS_Insert: %.2fns/value\n", (double)TimeSampler_DurationNS(&ts) / NUM_VALUES);
+
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  TimeSampler_Start(&ts);
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    TD_Add(td, values[ii]);
+  }
+  TimeSampler_End(&ts);
+  printf("TD_Add:    %.2fns/value\n", (double)TimeSampler_DurationNS(&ts) / NUM_VALUES);
+
+  for (size_t ii = 0; ii < nquantiles; ++ii) {
+    double exact = sorted[(size_t)(quantiles[ii] * (NUM_VALUES - 1))];
+    double fromStream = QS_Query(qs, quantiles[ii]);
+    double fromDigest = TD_Quantile(td, quantiles[ii]);
+    printf("%-6g exact %-12g stream %-12g (rank error %.5f) digest %-12g (rank error %.5f)\n",
+           quantiles[ii], exact, fromStream, rankError(fromStream, quantiles[ii]), fromDigest,
+           rankError(fromDigest, quantiles[ii]));
+  }
+
+  QS_Free(qs);
+  TD_Free(td);
+  rm_free(values);
+  rm_free(sorted);
+  return 0;
+}
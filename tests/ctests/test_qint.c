@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 #include "qint.h"
 #include "rmutil/alloc.h"
 
@@ -33,5 +34,26 @@ int main(int argc, char **argv) {
   assert(arr[1] == 456);
   assert(arr[2] == 789);
   Buffer_Free(&b);
+
+  // records of 3 integers, each followed by as many bytes as the last one
+  Buffer_Init(&b, 16);
+  w = NewBufferWriter(&b);
+  for (uint32_t i = 0; i < 200; i++) {
+    qint_encode3(&w, i, i << 12, i % 5);
+    Buffer_Write(&w, "xxxx", i % 5);
+  }
+  uint32_t rows[200][4], blobs[200];
+  r = NewBufferReader(&b);
+  assert(qint_decode_records(&r, 3, 2, rows, blobs, 150) == 150);
+  assert(qint_decode_records(&r, 3, 2, rows + 150, blobs + 150, 100) == 50);
+  assert(BufferReader_AtEnd(&r));
+  for (uint32_t i = 0; i < 200; i++) {
+    assert(rows[i][0] == i);
+    assert(rows[i][1] == i << 12);
+    assert(rows[i][2] == i % 5);
+    assert(!memcmp(b.data + blobs[i], "xxxx", i % 5));
+    assert(i == 199 || blobs[i + 1] > blobs[i] + i % 5);
+  }
+  Buffer_Free(&b);
   return 0;
 }
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "../../src/util/quantile.h"
+#include "../../src/util/tdigest.h"
 #include "../../src/buffer.h"
 #include "../../src/rmutil/alloc.h"
 #include "test_util.h"
 #include <stdint.h>
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
 
 static FILE *fp;
 static Buffer buf;
@@ -28,6 +30,86 @@ static int testBasic() {
   return 0;
 }
 
+// Summarizing the input in parts and merging them keeps the ranks of the quantiles about right
+static int testMerge() {
+  double quantiles[] = {0.50, 0.90, 0.99};
+  QuantStream *parts[4];
+  for (size_t ii = 0; ii < 4; ++ii) {
+    parts[ii] = NewQuantileStream(quantiles, 3, 500);
+  }
+  for (size_t ii = 0; ii < numInput; ++ii) {
+    QS_Insert(parts[ii * 4 / numInput], input[ii]);
+  }
+  for (size_t ii = 1; ii < 4; ++ii) {
+    QS_Merge(parts[0], parts[ii]);
+    QS_Free(parts[ii]);
+  }
+
+  for (size_t ii = 0; ii < 3; ++ii) {
+    double merged = QS_Query(parts[0], quantiles[ii]);
+    size_t below = 0, upto = 0;
+    for (size_t jj = 0; jj < numInput; ++jj) {
+      below += input[jj] < merged;
+      upto += input[jj] <= merged;
+    }
+    printf("%lf: %lf, ranks %lf-%lf\n", quantiles[ii], merged, (double)below / numInput,
+           (double)upto / numInput);
+    ASSERT((double)below / numInput <= quantiles[ii] + 0.03);
+    ASSERT((double)upto / numInput >= quantiles[ii] - 0.03);
+  }
+  // the values still buffered were counted once queried
+  ASSERT_EQUAL(numInput, QS_GetCount(parts[0]));
+  QS_Free(parts[0]);
+  return 0;
+}
+
+// The fraction of the input below the value, and up to it
+static void inputRanks(double value, double *below, double *upto) {
+  size_t nbelow = 0, nupto = 0;
+  for (size_t jj = 0; jj < numInput; ++jj) {
+    nbelow += input[jj] < value;
+    nupto += input[jj] <= value;
+  }
+  *below = (double)nbelow / numInput;
+  *upto = (double)nupto / numInput;
+}
+
+// The digest is most accurate at the tails, and a digest merged from parts is about as accurate
+static int testTDigest() {
+  double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+  double maxErr[] = {0.01, 0.005, 0.002, 0.001};
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  TDigest *parts[4];
+  for (size_t ii = 0; ii < 4; ++ii) {
+    parts[ii] = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  }
+  for (size_t ii = 0; ii < numInput; ++ii) {
+    TD_Add(td, input[ii]);
+    TD_Add(parts[ii * 4 / numInput], input[ii]);
+  }
+  for (size_t ii = 1; ii < 4; ++ii) {
+    TD_Merge(parts[0], parts[ii]);
+    TD_Free(parts[ii]);
+  }
+  ASSERT_EQUAL(numInput, TD_GetCount(td));
+  ASSERT_EQUAL(numInput, TD_GetCount(parts[0]));
+
+  for (size_t ii = 0; ii < sizeof(quantiles) / sizeof(*quantiles); ++ii) {
+    TDigest *digests[] = {td, parts[0]};
+    for (size_t jj = 0; jj < 2; ++jj) {
+      double value = TD_Quantile(digests[jj], quantiles[ii]);
+      double below, upto;
+      inputRanks(value, &below, &upto);
+      printf("%lf: %lf, ranks %lf-%lf\n", quantiles[ii], value, below, upto);
+      ASSERT(below <= quantiles[ii] + maxErr[ii]);
+      ASSERT(upto >= quantiles[ii] - maxErr[ii]);
+    }
+  }
+  TD_Free(td);
+  TD_Free(parts[0]);
+  return 0;
+}
+
 TEST_MAIN({
   RMUTil_InitAlloc();
 
@@ -46,6 +128,8 @@ TEST_MAIN({
   input = (double *)buf.data;
 
   TESTFUNC(testBasic);
+  TESTFUNC(testMerge);
+  TESTFUNC(testTDigest);
 
   Buffer_Free(&buf);
 })
\ No newline at end of file
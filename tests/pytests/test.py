@@ -566,6 +566,36 @@ def testExplain(env):
     expected = ['INTERSECT {', '  UNION {', '    hello', '    +hello(expanded)', '  }', '  UNION {', '    world', '    +world(expanded)', '  }', '  EXACT {', '    what', '    what', '  }', '  UNION {', '    UNION {', '      hello', '      +hello(expanded)', '    }', '    UNION {', '      world', '      +world(expanded)', '    }', '  }', '  UNION {', '    NUMERIC {10.000000 <= @bar <= 100.000000}', '    NUMERIC {200.000000 <= @bar <= 300.000000}', '  }', '}', '']
     env.assertEqual(expected, res)
 
+def testExplainPlan(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH',
+               'schema', 't', 'text', 'n', 'numeric', 'sortable').ok()
+    for i in range(100):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'common rare' if i in (10, 60) else 'common',
+                             'n', i)
+
+    # the most selective term is read first, and the wide filter is tested on its documents
+    q = 'common rare @n:[50 100]'
+    res = env.cmd('ft.explain', 'idx', q, 'verbatim')
+    env.assertEqual(res, 'INTERSECT {\n  rare\n  common\n'
+                         '  NUMERIC {50.000000 <= @n <= 100.000000}(tested)\n}\n')
+    env.expect('ft.search', 'idx', q, 'verbatim', 'nocontent').equal([1L, 'doc60'])
+    env.expect('ft.search', 'idx', 'common rare @n:[0 100]', 'verbatim', 'nocontent', 'sortby', 'n') \
+       .equal([2L, 'doc10', 'doc60'])
+
+    res = env.cmd('ft.profile', 'search', 'idx', q, 'verbatim', 'nocontent')
+    env.assertEqual(res[0], [1L, 'doc60'])
+    iters = res[1][2][1]
+    env.assertEqual(iters[0], 'Intersect iterator')
+    env.assertEqual(iters[-3][:2], ['Term reader', 'rare'])
+    env.assertEqual(iters[-2][:2], ['Term reader', 'common'])
+    env.assertEqual(iters[-1], 'Criteria tester')
+
+    # terms whose positions are checked keep the query's order
+    res = env.cmd('ft.explain', 'idx', '"common rare"', 'verbatim')
+    env.assertEqual(res, 'EXACT {\n  common\n  rare\n}\n')
+
 def testNoIndex(env):
     r = env
     env.assertOk(r.execute_command(
@@ -3206,6 +3236,21 @@ def testNotOnly(env):
   conn.execute_command('HSET', 'b', 'txt1', 'world', 'txt2', 'hello')
   env.expect('ft.search idx !world').equal([1L, 'b', ['txt1', 'world', 'txt2', 'hello']])
 
+def testNegativeQueriesAfterDeletes(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE idx SCHEMA t TEXT').ok()
+  for i in range(100):
+    conn.execute_command('HSET', 'doc%d' % i, 't', 'foo' if i % 2 else 'bar')
+  for i in range(0, 100, 3):
+    conn.execute_command('DEL', 'doc%d' % i)
+
+  # 66 documents are left, half of the deleted ones had foo
+  env.expect('FT.SEARCH', 'idx', '*', 'LIMIT', '0', '0').equal([66L])
+  env.expect('FT.SEARCH', 'idx', '-foo', 'LIMIT', '0', '0').equal([33L])
+  env.expect('FT.SEARCH', 'idx', '~foo', 'LIMIT', '0', '0').equal([66L])
+  res = env.cmd('FT.SEARCH', 'idx', '-bar', 'NOCONTENT', 'LIMIT', '0', '100')
+  env.assertEqual(sorted(res[1:]), sorted(['doc%d' % i for i in range(100) if i % 2 and i % 3]))
+
 def testServerVer(env):
     env.assertTrue(check_server_version(env, "0.0.0"))
     env.assertTrue(not check_server_version(env, "100.0.0"))
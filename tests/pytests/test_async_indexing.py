@@ -0,0 +1,65 @@
+# -*- coding: utf-8 -*-
+
+import time
+from includes import *
+from common import getConnectionByEnv, waitForIndex
+
+
+def asyncStats(env, idx):
+    res = env.cmd('ft.info', idx)
+    if 'async_indexing' not in res:
+        return {}
+    stats = res[res.index('async_indexing') + 1]
+    return {stats[i]: float(stats[i + 1]) for i in range(0, len(stats), 2)}
+
+def waitForAsyncIndexing(env, idx):
+    while asyncStats(env, idx).get('queue_depth', 0) > 0:
+        time.sleep(0.01)
+
+
+def testAsyncIndexing(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.config', 'set', 'ASYNC_INDEXING', 'true').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'tg', 'TAG').ok()
+    waitForIndex(env, 'idx')
+
+    for i in range(1000):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'hello world %d' % i, 'n', i, 'tg', 'a')
+    # updating a queued key does not queue it again
+    conn.execute_command('hset', 'doc0', 't', 'goodbye world')
+    # deleting a queued key drops it from the queue
+    conn.execute_command('del', 'doc1')
+
+    waitForAsyncIndexing(env, 'idx')
+    env.expect('ft.search', 'idx', 'world', 'NOCONTENT', 'LIMIT', 0, 0).equal([999])
+    env.expect('ft.search', 'idx', 'goodbye', 'NOCONTENT').equal([1, 'doc0'])
+    env.expect('ft.search', 'idx', '@n:[1 1]', 'NOCONTENT').equal([0])
+    env.expect('ft.search', 'idx', '@tg:{a}', 'NOCONTENT', 'LIMIT', 0, 0).equal([999])
+
+    stats = asyncStats(env, 'idx')
+    env.assertEqual(stats['queue_depth'], 0)
+    env.assertGreater(stats['batches'], 0)
+    env.assertGreater(stats['docs_indexed'], 0)
+
+    # updates replace the previous version of the document
+    conn.execute_command('hset', 'doc2', 't', 'hello again')
+    waitForAsyncIndexing(env, 'idx')
+    env.expect('ft.search', 'idx', 'again', 'NOCONTENT').equal([1, 'doc2'])
+    env.expect('ft.search', 'idx', 'world', 'NOCONTENT', 'LIMIT', 0, 0).equal([998])
+    env.expect('ft.config', 'set', 'ASYNC_INDEXING', 'false').ok()
+
+
+def testAsyncIndexingDropIndex(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.config', 'set', 'ASYNC_INDEXING', 'true').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    waitForIndex(env, 'idx')
+
+    for i in range(1000):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'hello world')
+    # the queue is discarded along with the index
+    env.expect('ft.dropindex', 'idx').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    waitForIndex(env, 'idx')
+    env.expect('ft.search', 'idx', 'hello', 'NOCONTENT', 'LIMIT', 0, 0).equal([1000])
+    env.expect('ft.config', 'set', 'ASYNC_INDEXING', 'false').ok()
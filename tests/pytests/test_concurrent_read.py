@@ -0,0 +1,88 @@
+# -*- coding: utf-8 -*-
+
+import threading
+from includes import *
+from common import getConnectionByEnv, waitForIndex
+
+
+def createIndex(env, conn, ndocs):
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE',
+               'tg', 'TAG').ok()
+    waitForIndex(env, 'idx')
+    for i in range(ndocs):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'hello world %d' % i, 'n', i,
+                             'tg', 'even' if i % 2 == 0 else 'odd')
+
+
+def testConcurrentReadSearch():
+    env = Env(moduleArgs='CONCURRENT_READ_MODE')
+    if env.env == 'existing-env':
+        env.skip()
+    conn = getConnectionByEnv(env)
+    createIndex(env, conn, 1000)
+
+    env.expect('ft.config', 'get', 'CONCURRENT_READ_MODE').equal([['CONCURRENT_READ_MODE', 'true']])
+    env.expect('ft.search', 'idx', 'world', 'NOCONTENT', 'LIMIT', 0, 0).equal([1000])
+    env.expect('ft.search', 'idx', '@n:[10 12]', 'SORTBY', 'n', 'NOCONTENT').equal(
+        [3, 'doc10', 'doc11', 'doc12'])
+    env.expect('ft.search', 'idx', '@tg:{odd} @n:[0 5]', 'SORTBY', 'n').equal(
+        [3, 'doc1', ['n', '1', 't', 'hello world 1', 'tg', 'odd'],
+         'doc3', ['n', '3', 't', 'hello world 3', 'tg', 'odd'],
+         'doc5', ['n', '5', 't', 'hello world 5', 'tg', 'odd']])
+    env.expect('ft.search', 'idx', '@n:[7 7]', 'RETURN', 1, 't').equal(
+        [1, 'doc7', ['t', 'hello world 7']])
+
+    res = env.cmd('ft.aggregate', 'idx', '*', 'GROUPBY', 1, '@tg',
+                  'REDUCE', 'COUNT', 0, 'AS', 'c', 'SORTBY', 2, '@tg', 'ASC')
+    env.assertEqual(res[1:], [['tg', 'even', 'c', '500'], ['tg', 'odd', 'c', '500']])
+    res = env.cmd('ft.aggregate', 'idx', '@n:[0 2]', 'LOAD', 1, '@t', 'SORTBY', 2, '@n', 'ASC')
+    env.assertEqual(res[1:], [['n', '0', 't', 'hello world 0'], ['n', '1', 't', 'hello world 1'],
+                              ['n', '2', 't', 'hello world 2']])
+
+    # cursors and profiling keep running under the global lock
+    res, cursor = env.cmd('ft.aggregate', 'idx', '*', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    env.assertEqual(len(res), 11)
+    env.assertNotEqual(cursor, 0)
+    env.cmd('ft.cursor', 'del', 'idx', cursor)
+    env.assertEqual(env.cmd('ft.profile', 'search', 'idx', 'world', 'LIMIT', 0, 0)[0], [1000])
+
+    # errors are reported from the search threads
+    env.expect('ft.search', 'idx', '@nosuchfield:[0 1]').error()
+    env.expect('ft.search', 'nosuchidx', 'hello').error().contains('no such index')
+
+
+def testConcurrentReadWrites():
+    env = Env(moduleArgs='CONCURRENT_READ_MODE')
+    if env.env == 'existing-env':
+        env.skip()
+    conn = getConnectionByEnv(env)
+    createIndex(env, conn, 100)
+
+    # writes and queries interleave, and queries see every completed write
+    def write():
+        wconn = getConnectionByEnv(env)
+        for i in range(100, 2000):
+            wconn.execute_command('hset', 'doc%d' % i, 't', 'hello world %d' % i, 'n', i,
+                                  'tg', 'even' if i % 2 == 0 else 'odd')
+    writer = threading.Thread(target=write)
+    writer.start()
+    last = 0
+    while writer.is_alive():
+        total = env.cmd('ft.search', 'idx', '@n:[0 +inf]', 'NOCONTENT', 'LIMIT', 0, 0)[0]
+        env.assertGreaterEqual(total, last)
+        last = total
+    writer.join()
+    env.expect('ft.search', 'idx', '@n:[0 +inf]', 'NOCONTENT', 'LIMIT', 0, 0).equal([2000])
+    env.expect('ft.search', 'idx', 'world', 'NOCONTENT', 'LIMIT', 0, 0).equal([2000])
+
+    for i in range(0, 2000, 2):
+        conn.execute_command('del', 'doc%d' % i)
+    env.expect('ft.search', 'idx', '@tg:{even}', 'NOCONTENT', 'LIMIT', 0, 0).equal([0])
+    env.expect('ft.search', 'idx', '@tg:{odd}', 'NOCONTENT', 'LIMIT', 0, 0).equal([1000])
+
+    # the index can be dropped and recreated under the same name
+    env.expect('ft.dropindex', 'idx').ok()
+    env.expect('ft.search', 'idx', 'world').error().contains('no such index')
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    waitForIndex(env, 'idx')
+    env.expect('ft.search', 'idx', 'world', 'NOCONTENT', 'LIMIT', 0, 0).equal([1000])
@@ -155,6 +155,7 @@ def testInitConfig(env):
     test_arg_true('NOGC')
     test_arg_true('SAFEMODE')
     test_arg_true('CONCURRENT_WRITE_MODE')
+    test_arg_true('CONCURRENT_READ_MODE')
     test_arg_true('NO_MEM_POOLS')
     
     # String arguments
@@ -271,3 +271,123 @@ def testGFreeEmpryTerms(env):
     env.expect('FT.DEBUG', 'GC_FORCEINVOKE', 'idx')
     env.expect('FT.DEBUG', 'DUMP_TERMS', 'idx').equal([])
 
+
+def testForkGCBatchesIndexes(env):
+    if env.isCluster():
+        raise unittest.SkipTest()
+    env.expect('ft.config', 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.expect('ft.create', 'idx1', 'ON', 'HASH', 'PREFIX', 1, 'a:', 'schema', 'title', 'text').ok()
+    env.expect('ft.create', 'idx2', 'ON', 'HASH', 'PREFIX', 1, 'b:', 'schema', 'title', 'text').ok()
+    waitForIndex(env, 'idx1')
+    waitForIndex(env, 'idx2')
+    for i in range(10):
+        env.cmd('hset', 'a:%d' % i, 'title', 'hello world')
+        env.cmd('hset', 'b:%d' % i, 'title', 'hello world')
+    env.assertEqual(env.cmd('del', 'a:0', 'b:0'), 2)
+
+    # a single fork collects every index which has deleted documents
+    env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx1')
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx1', 'world'), [long(i) for i in range(2, 11)])
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx2', 'world'), [long(i) for i in range(2, 11)])
+
+    res = env.cmd('ft.info', 'idx2')
+    gcStats = res[res.index('gc_stats') + 1]
+    env.assertEqual(float(gcStats[gcStats.index('gc_batched_cycles') + 1]), 1)
+
+def testIncrementalGC():
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL')
+    if env.isCluster():
+        raise unittest.SkipTest()
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH',
+                         'schema', 'title', 'text', 'id', 'numeric', 't', 'tag'))
+    waitForIndex(env, 'idx')
+    for i in range(300):
+        env.cmd('hset', 'doc%d' % i, 'title', 'hello world', 'id', i, 't', 'tag1')
+
+    # deleted docs are spread over all the blocks of the inverted indexes
+    for i in range(0, 300, 100):
+        env.assertEqual(env.cmd('del', 'doc%d' % i), 1)
+
+    for i in range(10):
+        env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+
+    expected = [long(i) for i in range(1, 301) if (i - 1) % 100 != 0]
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'world'), expected)
+    env.assertEqual(sorted(sum(env.cmd('ft.debug', 'DUMP_NUMIDX', 'idx', 'id'), [])), expected)
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_TAGIDX', 'idx', 't'), [['tag1', expected]])
+
+    res = env.cmd('ft.info', 'idx')
+    gcStats = res[res.index('gc_stats') + 1]
+    gcStats = {gcStats[i]: gcStats[i + 1] for i in range(0, len(gcStats), 2)}
+    env.assertEqual(float(gcStats['pending_deleted_docs']), 0)
+    env.assertGreater(float(gcStats['total_passes']), 0)
+    env.assertGreater(float(gcStats['blocks_repaired']), 0)
+
+def testIncrementalGCFreesEmptyTermsAndTags():
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL')
+    if env.isCluster():
+        raise unittest.SkipTest()
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH',
+                         'schema', 'title', 'text', 'id', 'numeric', 't', 'tag'))
+    waitForIndex(env, 'idx')
+    env.cmd('hset', 'doc1', 'title', 'hello world', 'id', 1, 't', 'tag1')
+    env.cmd('hset', 'doc2', 'title', 'hello there', 'id', 2, 't', 'tag2')
+    env.assertEqual(env.cmd('del', 'doc2'), 1)
+
+    for i in range(10):
+        env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+
+    env.assertEqual(sorted(env.cmd('ft.debug', 'DUMP_TERMS', 'idx')), ['hello', 'world'])
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_TAGIDX', 'idx', 't'), [['tag1', [1L]]])
+    env.expect('ft.search', 'idx', '@id:[2 2]', 'NOCONTENT').equal([0])
+
+def testIncrementalGCSlicesTagValues():
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL GC_SLICE_TIME_US 1')
+    if env.isCluster():
+        raise unittest.SkipTest()
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 't', 'tag'))
+    waitForIndex(env, 'idx')
+    for i in range(2000):
+        env.cmd('hset', 'doc%d' % i, 't', 'tag%d' % i)
+    for i in range(0, 2000, 2):
+        env.assertEqual(env.cmd('del', 'doc%d' % i), 1)
+
+    # every slice repairs a single block, so the visit of the tag values resumes many times, and
+    # values added meanwhile restart it
+    for i in range(10000):
+        if i == 100:
+            env.cmd('hset', 'new', 't', 'newtag')
+        env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+        res = env.cmd('ft.info', 'idx')
+        gcStats = res[res.index('gc_stats') + 1]
+        gcStats = {gcStats[j]: gcStats[j + 1] for j in range(0, len(gcStats), 2)}
+        if float(gcStats['pending_deleted_docs']) == 0:
+            break
+    env.assertGreater(float(gcStats['total_slices']), 1000)
+
+    tags = env.cmd('ft.debug', 'DUMP_TAGIDX', 'idx', 't')
+    env.assertEqual(sorted(t[0] for t in tags),
+                    sorted(['tag%d' % i for i in range(1, 2000, 2)] + ['newtag']))
+
+def testIncrementalGCAfterDocIdCompaction():
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL')
+    if env.isCluster():
+        raise unittest.SkipTest()
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text'))
+    waitForIndex(env, 'idx')
+    for i in range(300):
+        env.cmd('hset', 'doc%d' % i, 'title', 'hello world')
+    for i in range(0, 300, 100):
+        env.assertEqual(env.cmd('del', 'doc%d' % i), 1)
+
+    # the deleted ids the GC holds belong to live documents once the ids are compacted
+    env.assertEqual(env.cmd('ft.debug', 'COMPACT_DOCIDS', 'idx'), 3)
+    res = env.cmd('ft.info', 'idx')
+    gcStats = res[res.index('gc_stats') + 1]
+    gcStats = {gcStats[i]: gcStats[i + 1] for i in range(0, len(gcStats), 2)}
+    env.assertEqual(float(gcStats['pending_deleted_docs']), 0)
+
+    for i in range(10):
+        env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+    env.assertEqual(len(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'world')), 297)
+    env.expect('ft.search', 'idx', 'hello', 'NOCONTENT', 'LIMIT', 0, 0).equal([297L])
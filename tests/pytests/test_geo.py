@@ -92,6 +92,34 @@ def testGeoDistanceSimple(env):
              'GROUPBY', '1', '@distance',
              'SORTBY', 2, '@distance', 'ASC').equal(res)
 
+def testGeoFilterShapes(env):
+  env.skipOnCluster()
+  env.expect('ft.create', 'idx', 'schema', 'location', 'geo').ok()
+  env.expect('FT.ADD', 'idx', 'geo1', '1', 'FIELDS', 'location', '1.22,4.56').ok()
+  env.expect('FT.ADD', 'idx', 'geo2', '1', 'FIELDS', 'location', '1.24,4.56').ok()
+  env.expect('FT.ADD', 'idx', 'geo3', '1', 'FIELDS', 'location', '1.23,4.55').ok()
+  env.expect('FT.ADD', 'idx', 'geo4', '1', 'FIELDS', 'location', '1.23,4.57').ok()
+
+  res = env.cmd('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'BOX', 1.2, 4.5, 1.235, 4.6, 'nocontent')
+  env.assertEqual(res[0], 3L)
+  env.assertEqual(sorted(res[1:]), ['geo1', 'geo3', 'geo4'])
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'BOX', 1.3, 4.5, 1.4, 4.6,
+             'nocontent').equal([0L])
+  # a triangle holding geo2 and geo3 only
+  res = env.cmd('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'POLYGON', 3,
+                1.21, 4.54, 1.26, 4.54, 1.26, 4.59, 'nocontent')
+  env.assertEqual(res[0], 2L)
+  env.assertEqual(sorted(res[1:]), ['geo2', 'geo3'])
+
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'BOX', 1.3, 4.5, 1.2, 4.6).error() \
+     .contains('Invalid GeoFilter box')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'BOX', 1.3, 95, 1.4, 96).error() \
+     .contains('Invalid GeoFilter lat/lon')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'POLYGON', 2, 1, 1, 2, 2).error() \
+     .contains('Invalid GeoFilter polygon')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'location', 'POLYGON', 3, 1, 1, 2, 2).error() \
+     .contains('POLYGON requires 6 coordinates')
+
 from hotels import hotels
 def testGeoDistanceFile(env):
   env.expect('ft.create', 'idx', 'schema', 'name', 'text', 'location', 'geo').ok()
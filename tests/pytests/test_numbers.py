@@ -84,4 +84,47 @@ def testRangeParentsConfig(env):
 
 		# reset with old ranges parents param
 		env.cmd('ft.drop', 'idx0')
-		env.expect('ft.config', 'set', '_NUMERIC_RANGES_PARENTS', '2').equal('OK')
\ No newline at end of file
+		env.expect('ft.config', 'set', '_NUMERIC_RANGES_PARENTS', '2').equal('OK')
+
+def testSortByRanges(env):
+	# searches sorted by a sortable numeric field read the numeric index in order
+	env.skipOnCluster()
+	conn = getConnectionByEnv(env)
+	env.cmd('ft.create', 'idx', 'SCHEMA', 'n', 'numeric', 'sortable', 't', 'tag')
+	ndocs = 20000
+	for i in range(ndocs):
+		if i % 10 == 0:
+			conn.execute_command('hset', 'doc%d' % i, 't', 'none')
+		else:
+			conn.execute_command('hset', 'doc%d' % i, 'n', (i * 7919) % 1000, 't', 'even' if i % 2 == 0 else 'odd')
+
+	def expected(tag, asc, offset, num):
+		docs = [i for i in range(ndocs) if tag is None or
+				(tag == 'none' and i % 10 == 0) or
+				(tag == 'even' and i % 2 == 0 and i % 10 != 0) or
+				(tag == 'odd' and i % 2 == 1)]
+		# documents without a value are first in ascending order, and last in descending order
+		keyed = [(None if i % 10 == 0 else (i * 7919) % 1000, i) for i in docs]
+		missing = [i for v, i in keyed if v is None]
+		valued = sorted([(v, i) for v, i in keyed if v is not None], key=lambda x: x[0], reverse=not asc)
+		order = missing + [i for v, i in valued] if asc else [i for v, i in valued] + missing
+		return len(docs), order[offset:offset + num]
+
+	for tag in [None, 'even', 'odd', 'none']:
+		query = '*' if tag is None else '@t:{%s}' % tag
+		for asc in [True, False]:
+			for offset, num in [(0, 10), (1500, 20), (19990, 20)]:
+				res = env.cmd('ft.search', 'idx', query, 'SORTBY', 'n', 'ASC' if asc else 'DESC',
+							  'LIMIT', offset, num, 'RETURN', 1, 'n')
+				total, order = expected(tag, asc, offset, num)
+				env.assertEqual(res[0], total)
+				# ties may come in any order
+				values = [None if i % 10 == 0 else str((i * 7919) % 1000) for i in order]
+				env.assertEqual([dict(zip(r[::2], r[1::2])).get('n') for r in res[2::2]], values)
+
+	# deleted documents are neither returned nor counted
+	for i in range(0, ndocs, 3):
+		conn.execute_command('del', 'doc%d' % i)
+	res = env.cmd('ft.search', 'idx', '*', 'SORTBY', 'n', 'ASC', 'LIMIT', 0, 5, 'NOCONTENT')
+	env.assertEqual(res[0], ndocs - len(range(0, ndocs, 3)))
+	env.assertEqual(res[1:], ['doc10', 'doc20', 'doc40', 'doc50', 'doc70'])
@@ -0,0 +1,74 @@
+# -*- coding: utf-8 -*-
+
+from includes import *
+from common import getConnectionByEnv, waitForIndex, toSortedFlatList
+
+
+def testPersistIndexContents(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.config', 'set', 'PERSIST_INDEXES', 'true').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT', 'SORTABLE',
+               'n', 'NUMERIC', 'tg', 'TAG').ok()
+
+    conn.execute_command('hset', 'doc1', 't', 'hello world', 'n', 1, 'tg', 'a')
+    conn.execute_command('hset', 'doc2', 't', 'hello there', 'n', 2, 'tg', 'b')
+    conn.execute_command('hset', 'doc3', 't', 'goodbye world', 'n', 3, 'tg', 'a,b')
+    # deleting a document leaves a hole in the doc ids, reindexing would close it
+    conn.execute_command('del', 'doc1')
+
+    for _ in env.retry_with_rdb_reload():
+        waitForIndex(env, 'idx')
+        env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc2').equal(2)
+        env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc3').equal(3)
+        env.expect('ft.debug', 'DUMP_INVIDX', 'idx', 'world').equal([3])
+        env.expect('ft.search', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc2'])
+        env.expect('ft.search', 'idx', '@n:[2 3]', 'SORTBY', 'n', 'DESC', 'NOCONTENT') \
+           .equal([2, 'doc3', 'doc2'])
+        env.expect('ft.search', 'idx', '@tg:{a}', 'NOCONTENT').equal([1, 'doc3'])
+        env.expect('ft.search', 'idx', '*', 'SORTBY', 't', 'NOCONTENT') \
+           .equal([2, 'doc3', 'doc2'])
+
+    # updates after loading are indexed as usual
+    conn.execute_command('hset', 'doc4', 't', 'hello again', 'n', 4, 'tg', 'c')
+    env.expect('ft.search', 'idx', 'hello', 'NOCONTENT', 'SORTBY', 'n') \
+       .equal([2, 'doc2', 'doc4'])
+
+
+def testNoPersistReindexes(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.config', 'set', 'PERSIST_INDEXES', 'false').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+
+    conn.execute_command('hset', 'doc1', 't', 'hello world')
+    conn.execute_command('hset', 'doc2', 't', 'hello there')
+    conn.execute_command('del', 'doc1')
+
+    for _ in env.retry_with_rdb_reload():
+        waitForIndex(env, 'idx')
+        env.expect('ft.search', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc2'])
+
+
+def testUnknownContentVersionReindexes(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.config', 'set', 'PERSIST_INDEXES', 'true').ok()
+    env.expect('ft.create', 'idx', 'SCHEMA', 't', 'TEXT', 'SORTABLE',
+               'n', 'NUMERIC', 'tg', 'TAG').ok()
+
+    conn.execute_command('hset', 'doc1', 't', 'hello world', 'n', 1, 'tg', 'a')
+    conn.execute_command('hset', 'doc2', 't', 'hello there', 'n', 2, 'tg', 'b')
+    conn.execute_command('hset', 'doc3', 't', 'goodbye world', 'n', 3, 'tg', 'a,b')
+    conn.execute_command('del', 'doc1')
+
+    # contents saved with a version this module does not know are skipped on load
+    env.expect('ft.debug', 'SET_CONTENT_ENCVER', 1000).ok()
+    try:
+        for _ in env.retry_with_rdb_reload():
+            waitForIndex(env, 'idx')
+            # the index was rebuilt from the keyspace, which closes the hole left by doc1
+            env.assertContains(env.cmd('ft.debug', 'DOCIDTOID', 'idx', 'doc3'), [1, 2])
+            env.expect('ft.search', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc2'])
+            env.expect('ft.search', 'idx', '@n:[2 3]', 'SORTBY', 'n', 'DESC', 'NOCONTENT') \
+               .equal([2, 'doc3', 'doc2'])
+            env.expect('ft.search', 'idx', '@tg:{a}', 'NOCONTENT').equal([1, 'doc3'])
+    finally:
+        env.expect('ft.debug', 'SET_CONTENT_ENCVER', 1).ok()
@@ -198,3 +198,21 @@ def testScoreError(env):
     waitForIndex(env, 'idx')
     env.expect('ft.add idx doc1 0.01 fields title hello').ok()
     env.expect('ft.search idx hello EXPLAINSCORE').error().contains('EXPLAINSCORE must be accompanied with WITHSCORES')
+
+def testBlockMaxPruning(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create idx ON HASH schema title text').ok()
+    waitForIndex(env, 'idx')
+    for i in range(1000):
+        title = 'hello hello hello world' if i % 300 == 0 else 'hello world'
+        conn.execute_command('HSET', 'doc%d' % i, 'title', title)
+
+    for scorer in ['TFIDF', 'TFIDF.DOCNORM', 'BM25']:
+        expected = env.cmd('ft.search', 'idx', 'hello|world', 'SCORER', scorer, 'WITHSCORES', 'NOCONTENT')
+        env.expect('ft.config', 'set', 'BLOCK_MAX_PRUNING', 'true').ok()
+        res = env.cmd('ft.search', 'idx', 'hello|world', 'SCORER', scorer, 'WITHSCORES', 'NOCONTENT')
+        env.expect('ft.config', 'set', 'BLOCK_MAX_PRUNING', 'false').ok()
+        # the results are the same, only the total may be lower
+        env.assertEqual(res[1:], expected[1:])
+        env.assertLessEqual(res[0], expected[0])